@@ -18,28 +18,23 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow& EdgeWindowOut)
 {
     for (;;)
     {
-        TypeEdgeWindowsHeap::item_type* pItem = m_EdgeWindowsHeap.cutTop();
+        const uint32_t dwWindowIdxSelf = m_EdgeWindowsHeap.cutTop();
+        std::vector<uint32_t>& windowsList = GetWindowsList(m_EdgeList[m_WindowPool[dwWindowIdxSelf].dwEdgeIdx]);
 
-        uint32_t dwIdxSelf = FLAG_INVALIDDWORD;
-        for (uint32_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
+        for (uint32_t i = 0; i < windowsList.size(); ++i)
         {
-            if (!pItem->m_data.pEdge->WindowsList[i].pHeapItem)
-            {
-                continue;
-            }
+            const uint32_t dwWindowIdx = windowsList[i];
 
-            if (pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem)
+            // when searching for a window adjacent to the popped off (from the heap) window, skip the window itself on the edge
+            // and the windows that have already been propagated
+            if (dwWindowIdx == dwWindowIdxSelf || !m_EdgeWindowsHeap.isInHeap(dwWindowIdx))
             {
-                // here we get a byproduct, because we actually need the idx of the popped off window itself
-                dwIdxSelf = i;
-
-                // when searching for a window adjacent to the popped off (from the heap) window, skip the window itself on the edge
                 continue;
             }
 
             // in pWindowLeft and pWindowRight, one is the the popped off window itself, the other one is the possible found adjacent window
-            EdgeWindow* pWindowLeft = &(pItem->m_data);
-            EdgeWindow* pWindowRight = &(pItem->m_data.pEdge->WindowsList[i].theWindow);
+            EdgeWindow* pWindowLeft = &m_WindowPool[dwWindowIdxSelf];
+            EdgeWindow* pWindowRight = &m_WindowPool[dwWindowIdx];
 
             if ((pWindowLeft->b0 == pWindowRight->b1 || pWindowLeft->b1 == pWindowRight->b0) /*&&
                  (pWindowLeft->dwFaceIdxPropagatedFrom == pWindowRight->dwFaceIdxPropagatedFrom)*/)
@@ -294,30 +289,13 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow& EdgeWindowOut)
                 {
                     // allow the merge
 
-                    if (dwIdxSelf == FLAG_INVALIDDWORD)
-                    {
-                        // the idx of the popped off window is not yet set, so search for it here
-                        // we only need to search from i + 1 (rather than from 0), because the previous ones have already been searched
-
-                        for (uint32_t t = i + 1; t < pItem->m_data.pEdge->WindowsList.size(); ++t)
-                            if (pItem->m_data.pEdge->WindowsList[t].pHeapItem == pItem)
-                            {
-                                dwIdxSelf = t;
-
-                                break;
-                            }
-                    }
-
                     // remove the found adjacent window from the heap and from the edge it is on
-                    m_EdgeWindowsHeap.remove(pItem->m_data.pEdge->WindowsList[i].pHeapItem);
-                    delete pItem->m_data.pEdge->WindowsList[i].pHeapItem;
-                    pItem->m_data.pEdge->WindowsList.erase(pItem->m_data.pEdge->WindowsList.begin() + ptrdiff_t(i));
-                    if (dwIdxSelf > i)
-                    {
-                        --dwIdxSelf;
-                    }
+                    m_EdgeWindowsHeap.remove(dwWindowIdx);
+                    m_WindowPool.Remove(dwWindowIdx);
+                    windowsList.erase(windowsList.begin() + ptrdiff_t(i));
 
-                    EdgeWindow* pTheWindow = &(pItem->m_data.pEdge->WindowsList[dwIdxSelf].theWindow);
+                    // the popped off window becomes the merged window
+                    EdgeWindow* pTheWindow = &m_WindowPool[dwWindowIdxSelf];
 
                     pTheWindow->b0 = b0pie;
                     pTheWindow->b1 = b1pie;
@@ -327,17 +305,10 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow& EdgeWindowOut)
                     pTheWindow->d1 = SqrtMin0(SquredD2Dist(DVector2(b1pie, 0), spie));
                     pTheWindow->ksi = ksi;
                     pTheWindow->dwPseuSrcVertexIdx = FLAG_INVALIDDWORD;
-                    pTheWindow->pPseuSrcVertex = nullptr;
-                    /*pTheWindow->pHeapItem = nullptr ;
-
-                    EdgeWindowOut = *pTheWindow ;
-                    delete pItem ;
+                    /*EdgeWindowOut = *pTheWindow ;
                     return ;*/
 
-                    pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem =
-                        new TypeEdgeWindowsHeap::item_type(std::min(pTheWindow->d0, pTheWindow->d1) + pTheWindow->dPseuSrcToSrcDistance, *pTheWindow);
-                    m_EdgeWindowsHeap.insert(pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem);
-                    delete pItem;
+                    m_EdgeWindowsHeap.insert(dwWindowIdxSelf, pTheWindow->GetMinDistanceToSrc());
 
                     // continue to pop the next window in heap and test whether any merge is possible                    
                     goto l_outter_while_again;
@@ -345,26 +316,7 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow& EdgeWindowOut)
             }
         }
 
-        if (dwIdxSelf == FLAG_INVALIDDWORD)
-        {
-            for (size_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
-            {
-                if (pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem)
-                {
-                    pItem->m_data.pEdge->WindowsList[i].pHeapItem = nullptr;
-                    break;
-                }
-            }
-
-            EdgeWindowOut = pItem->m_data;
-            delete pItem;
-            return;
-        }
-
-        pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem = nullptr;
-        EdgeWindowOut = pItem->m_data;
-        delete pItem;
-
+        EdgeWindowOut = m_WindowPool[dwWindowIdxSelf];
         return;
 
     l_outter_while_again:
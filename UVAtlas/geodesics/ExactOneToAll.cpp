@@ -14,18 +14,29 @@
 
 using namespace GeodesicDist;
 
-CExactOneToAll::CExactOneToAll()
+CExactOneToAll::CExactOneToAll() :
+    m_dwRunId(0),
+    m_pStats(nullptr)
 {
-    m_EdgeWindowsHeap.SetManageMode(Isochart::AUTOMATIC);
 }
 
 void CExactOneToAll::SetSrcVertexIdx(const uint32_t dwSrcVertexIdx)
 {
     m_dwSrcVertexIdx = dwSrcVertexIdx;
 
-    while (!m_EdgeWindowsHeap.empty())
+    m_EdgeWindowsHeap.clear();
+    m_WindowPool.Clear();
+
+    // a new run id makes the windows lists of all edges stale, so they are emptied when first used rather than here
+    if (++m_dwRunId == 0)
     {
-        delete m_EdgeWindowsHeap.cutTop();
+        // the run id wrapped around, a stale list could look current
+        for (size_t i = 0; i < m_EdgeList.size(); ++i)
+        {
+            m_EdgeList[i].WindowsList.clear();
+            m_EdgeList[i].dwRunId = 0;
+        }
+        m_dwRunId = 1;
     }
 
     for (size_t i = 0; i < m_VertexList.size(); ++i)
@@ -36,36 +47,40 @@ void CExactOneToAll::SetSrcVertexIdx(const uint32_t dwSrcVertexIdx)
         m_VertexList[i].bShadowBoundary = false;
     }
 
-    for (uint32_t i = 0; i < m_EdgeList.size(); ++i)
+    // the initial windows lie on the edges opposite to the source in its adjacent faces,
+    // they are added in the order of the edge indices
+    const std::vector<Face*>& srcFaces = m_VertexList[dwSrcVertexIdx].facesAdj;
+    m_SrcOpposingEdges.clear();
+    for (size_t i = 0; i < srcFaces.size(); ++i)
     {
-        Edge& thisEdge = m_EdgeList[i];
+        m_SrcOpposingEdges.push_back(srcFaces[i]->GetOpposingEdgeIdx(dwSrcVertexIdx));
+    }
+    std::sort(m_SrcOpposingEdges.begin(), m_SrcOpposingEdges.end());
+    m_SrcOpposingEdges.erase(std::unique(m_SrcOpposingEdges.begin(), m_SrcOpposingEdges.end()), m_SrcOpposingEdges.end());
 
-        thisEdge.WindowsList.clear();
+    for (size_t j = 0; j < m_SrcOpposingEdges.size(); ++j)
+    {
+        const uint32_t i = m_SrcOpposingEdges[j];
+        Edge& thisEdge = m_EdgeList[i];
 
-        if (!thisEdge.HasVertexIdx(dwSrcVertexIdx) &&
-            (
-            (thisEdge.pAdjFace0 && thisEdge.pAdjFace0->HasVertexIdx(dwSrcVertexIdx))
-                ||
-                (thisEdge.pAdjFace1 && thisEdge.pAdjFace1->HasVertexIdx(dwSrcVertexIdx))
-                )
-            )
+        if (!thisEdge.HasVertexIdx(dwSrcVertexIdx))
         {
             EdgeWindow tmpEdgeWindow;
 
             // generate a window covering the whole edge as one of the initial windows
-            tmpEdgeWindow.SetEdgeIdx(m_EdgeList, i);
+            tmpEdgeWindow.dwEdgeIdx = i;
             tmpEdgeWindow.dPseuSrcToSrcDistance = 0;
             tmpEdgeWindow.b0 = 0;
-            tmpEdgeWindow.b1 = tmpEdgeWindow.pEdge->dEdgeLength;
-            tmpEdgeWindow.d0 = sqrt(SquredD3Dist(*tmpEdgeWindow.pEdge->pVertex0, m_VertexList[dwSrcVertexIdx]));
-            tmpEdgeWindow.d1 = sqrt(SquredD3Dist(*tmpEdgeWindow.pEdge->pVertex1, m_VertexList[dwSrcVertexIdx]));
-            ParameterizePt3ToPt2(*tmpEdgeWindow.pEdge->pVertex0, *tmpEdgeWindow.pEdge->pVertex1, m_VertexList[dwSrcVertexIdx], tmpEdgeWindow.dv2Src);
-            tmpEdgeWindow.SetPseuSrcVertexIdx(m_VertexList, dwSrcVertexIdx);
-            tmpEdgeWindow.SetMarkFromEdgeVertexIdx(m_VertexList, tmpEdgeWindow.pEdge->dwVertexIdx0);
-            if (tmpEdgeWindow.pEdge->pAdjFace0->HasVertexIdx(dwSrcVertexIdx))
-                tmpEdgeWindow.SetFaceIdxPropagatedFrom(m_FaceList, tmpEdgeWindow.pEdge->dwAdjFaceIdx0);
+            tmpEdgeWindow.b1 = thisEdge.dEdgeLength;
+            tmpEdgeWindow.d0 = sqrt(SquredD3Dist(*thisEdge.pVertex0, m_VertexList[dwSrcVertexIdx]));
+            tmpEdgeWindow.d1 = sqrt(SquredD3Dist(*thisEdge.pVertex1, m_VertexList[dwSrcVertexIdx]));
+            ParameterizePt3ToPt2(*thisEdge.pVertex0, *thisEdge.pVertex1, m_VertexList[dwSrcVertexIdx], tmpEdgeWindow.dv2Src);
+            tmpEdgeWindow.dwPseuSrcVertexIdx = dwSrcVertexIdx;
+            tmpEdgeWindow.dwMarkFromEdgeVertexIdx = thisEdge.dwVertexIdx0;
+            if (thisEdge.pAdjFace0->HasVertexIdx(dwSrcVertexIdx))
+                tmpEdgeWindow.dwFaceIdxPropagatedFrom = thisEdge.dwAdjFaceIdx0;
             else
-                tmpEdgeWindow.SetFaceIdxPropagatedFrom(m_FaceList, tmpEdgeWindow.pEdge->dwAdjFaceIdx1);
+                tmpEdgeWindow.dwFaceIdxPropagatedFrom = thisEdge.dwAdjFaceIdx1;
 
             AddWindowToHeapAndEdge(tmpEdgeWindow);
         }
@@ -74,56 +89,87 @@ void CExactOneToAll::SetSrcVertexIdx(const uint32_t dwSrcVertexIdx)
     m_VertexList[m_dwSrcVertexIdx].dGeoDistanceToSrc = 0;
 }
 
+// put a new window into the pool, the heap and the windows list of its edge
+void CExactOneToAll::StoreWindow(const EdgeWindow& WindowToStore)
+{
+    uint32_t dwWindowIdx = m_WindowPool.Add(WindowToStore);
+
+    m_EdgeWindowsHeap.insert(dwWindowIdx, WindowToStore.GetMinDistanceToSrc());
+    GetWindowsList(m_EdgeList[WindowToStore.dwEdgeIdx]).push_back(dwWindowIdx);
+}
+
 void CExactOneToAll::AddWindowToHeapAndEdge(const EdgeWindow& WindowToAdd)
 {
     // add the new window to heap and the edge
-    TypeEdgeWindowsHeap::item_type* pItem =
-        new TypeEdgeWindowsHeap::item_type(std::min(WindowToAdd.d0, WindowToAdd.d1) + WindowToAdd.dPseuSrcToSrcDistance, WindowToAdd);
-
-    m_EdgeWindowsHeap.insert(pItem);
-    WindowToAdd.pEdge->WindowsList.push_back(Edge::WindowListElement(pItem, WindowToAdd));
+    StoreWindow(WindowToAdd);
 
     // update the geodesic distance on vertices affected by this new window
-    WindowToAdd.pMarkFromEdgeVertex->dGeoDistanceToSrc =
-        std::min(WindowToAdd.pMarkFromEdgeVertex->dGeoDistanceToSrc, WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance);
-    WindowToAdd.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = 0;
-    if (WindowToAdd.pMarkFromEdgeVertex->dGeoDistanceToSrc == (WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance))
+    Edge* pEdge = &m_EdgeList[WindowToAdd.dwEdgeIdx];
+    Vertex* pMarkFromEdgeVertex = &m_VertexList[WindowToAdd.dwMarkFromEdgeVertexIdx];
+
+    pMarkFromEdgeVertex->dGeoDistanceToSrc =
+        std::min(pMarkFromEdgeVertex->dGeoDistanceToSrc, WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance);
+    pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = 0;
+    if (pMarkFromEdgeVertex->dGeoDistanceToSrc == (WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance))
     {
-        WindowToAdd.pMarkFromEdgeVertex->pEdgeReportedGeoDist = WindowToAdd.pEdge;
+        pMarkFromEdgeVertex->pEdgeReportedGeoDist = pEdge;
     }
 
-    WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc =
-        std::min(WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc, WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance);
-    WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dLengthOfWindowEdgeToThisVertex = 0;
-    if (WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc == (WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance))
+    pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc =
+        std::min(pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc, WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance);
+    pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dLengthOfWindowEdgeToThisVertex = 0;
+    if (pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc == (WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance))
     {
-        WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->pEdgeReportedGeoDist = WindowToAdd.pEdge;
+        pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->pEdgeReportedGeoDist = pEdge;
     }
 }
 
-// pop off one window from the heap and unreference the corresponding one on the edge
+// pop off one window from the heap, the window stays on its edge
 void CExactOneToAll::CutHeapTopData(EdgeWindow& EdgeWindowOut)
 {
-    TypeEdgeWindowsHeap::item_type* pItem = m_EdgeWindowsHeap.cutTop();
+    EdgeWindowOut = m_WindowPool[m_EdgeWindowsHeap.cutTop()];
+}
+
+HRESULT CExactOneToAll::Run()
+{
+    return InternalRun();
+}
 
-    for (size_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
-        if (pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem)
+HRESULT CExactOneToAll::RunMany(const uint32_t* pdwSources, size_t dwSourceCount, double* pdDistances)
+{
+    const size_t dwVertexCount = m_VertexList.size();
+
+    for (size_t i = 0; i < dwSourceCount; ++i)
+    {
+        SetSrcVertexIdx(pdwSources[i]);
+
+        HRESULT hr = InternalRun();
+        if (FAILED(hr))
         {
-            pItem->m_data.pEdge->WindowsList[i].pHeapItem = nullptr;
-            break;
+            return hr;
         }
 
-    EdgeWindowOut = pItem->m_data;
+        double* pdRow = pdDistances + i * dwVertexCount;
+        for (size_t j = 0; j < dwVertexCount; ++j)
+        {
+            pdRow[j] = m_VertexList[j].dGeoDistanceToSrc;
+        }
+    }
 
-    delete pItem;
+    return S_OK;
 }
 
-void CExactOneToAll::Run()
+size_t CExactOneToAll::GetWindowBytes() const
 {
-    InternalRun();
+    size_t dwBytes = m_WindowPool.GetCapacityBytes() + m_EdgeWindowsHeap.GetCapacityBytes();
+    for (size_t i = 0; i < m_EdgeList.size(); ++i)
+    {
+        dwBytes += sizeof(uint32_t) * m_EdgeList[i].WindowsList.capacity();
+    }
+    return dwBytes;
 }
 
-void CExactOneToAll::InternalRun()
+HRESULT CExactOneToAll::InternalRun()
 {
     DVector2 w0, w1, w2, e0, e1, e2;
     uint32_t dwFacePropagateTo, dwThirdPtIdxOnFacePropagateTo, dwEdgeIdxPropagateTo0, dwEdgeIdxPropagateTo1, dwPtE1Idx;
@@ -133,14 +179,23 @@ void CExactOneToAll::InternalRun()
     DVector2 w0_to_e0_e2, w0_to_e1_e2, w1_to_e0_e2, w1_to_e1_e2;
     bool bW2W0OnE0E2, bW2W0OnE1E2, bW2W1OnE0E2, bW2W1OnE1E2;
 
+    Isochart::CIsochartCancelPoll cancel(m_pStats);
+
     // the main propagation loop
     while (!m_EdgeWindowsHeap.empty())
     {
+        HRESULT hr = cancel.Poll();
+        if (FAILED(hr))
+        {
+            // the remaining windows are freed by the next SetSrcVertexIdx
+            return hr;
+        }
+
         tmpWindow0.dwEdgeIdx = FLAG_INVALIDDWORD;
 
         CutHeapTopData(WindowToBePropagated);
 
-        if (!WindowToBePropagated.pEdge->pAdjFace0 || !WindowToBePropagated.pEdge->pAdjFace1)
+        if (!m_EdgeList[WindowToBePropagated.dwEdgeIdx].pAdjFace0 || !m_EdgeList[WindowToBePropagated.dwEdgeIdx].pAdjFace1)
         {
             // this is a boundary edge, no need to propagate
             continue;
@@ -152,9 +207,9 @@ void CExactOneToAll::InternalRun()
             continue;
         }
 
-        //pPtE0 = WindowToBePropagated.pMarkFromEdgeVertex;
+        //pPtE0 = &m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx];
 
-        dwFacePropagateTo = WindowToBePropagated.pEdge->GetAnotherFaceIdx(WindowToBePropagated.dwFaceIdxPropagatedFrom);
+        dwFacePropagateTo = m_EdgeList[WindowToBePropagated.dwEdgeIdx].GetAnotherFaceIdx(WindowToBePropagated.dwFaceIdxPropagatedFrom);
         pFacePropageteTo = &m_FaceList[dwFacePropagateTo];
 
         pFacePropageteTo->GetOtherTwoEdges(WindowToBePropagated.dwEdgeIdx, &pEdge0, &pEdge1);
@@ -168,7 +223,7 @@ void CExactOneToAll::InternalRun()
         dwThirdPtIdxOnFacePropagateTo = pEdge0->GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
         pThridPtOnFacePropagateTo = &m_VertexList[dwThirdPtIdxOnFacePropagateTo];
 
-        dwPtE1Idx = WindowToBePropagated.pEdge->GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
+        dwPtE1Idx = m_EdgeList[WindowToBePropagated.dwEdgeIdx].GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
         pPtE1 = &m_VertexList[dwPtE1Idx];
 
         w0.x = WindowToBePropagated.b0;
@@ -183,13 +238,13 @@ void CExactOneToAll::InternalRun()
         w2 = WindowToBePropagated.dv2Src;
 
         e0.x = e0.y = 0;
-        e1.x = WindowToBePropagated.pEdge->dEdgeLength;
+        e1.x = m_EdgeList[WindowToBePropagated.dwEdgeIdx].dEdgeLength;
         e1.y = 0;
         if (w1.x > e1.x)
         {
             w1.x = e1.x;
         }
-        ParameterizePt3ToPt2(*WindowToBePropagated.pMarkFromEdgeVertex,
+        ParameterizePt3ToPt2(m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx],
             *pPtE1,
             *pThridPtOnFacePropagateTo, e2);
         e2.y = -e2.y;
@@ -220,10 +275,10 @@ void CExactOneToAll::InternalRun()
                 if (w0.x == e0.x)
                     tmpWindow0.b1 = pEdge0->dEdgeLength;
 
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo0);
+                tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo0;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.d0 = sqrt(SquredD2Dist(w2, e2));
                 if (w0.x == e0.x)
@@ -235,10 +290,10 @@ void CExactOneToAll::InternalRun()
                     tmpWindow0.d1 = sqrt(SquredD2Dist(w0_to_e0_e2, w2));
                 }
                 ParameterizePt2ToPt2(e2, e0, w2, tmpWindow0.dv2Src);
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -252,10 +307,10 @@ void CExactOneToAll::InternalRun()
                 if (w1.x == e1.x)
                     tmpWindow0.b1 = pEdge1->dEdgeLength;
 
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo1);
+                tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo1;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.d0 = sqrt(SquredD2Dist(w2, e2));
                 if (w1.x == e1.x)
@@ -267,10 +322,10 @@ void CExactOneToAll::InternalRun()
                     tmpWindow0.d1 = sqrt(SquredD2Dist(w1_to_e1_e2, w2));
                 }
                 ParameterizePt2ToPt2(e2, e1, w2, tmpWindow0.dv2Src);
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -282,9 +337,9 @@ void CExactOneToAll::InternalRun()
         // this is the second figure shown in the mail
         else if (bW2W0OnE1E2 && bW2W1OnE1E2)
         {
-            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-            tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo1);
-            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+            tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+            tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo1;
+            tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
             tmpWindow0.b0 = sqrt(SquredD2Dist(w0_to_e1_e2, e2));
             if (tmpWindow0.b0 < double(FLT_EPSILON))
@@ -303,32 +358,32 @@ void CExactOneToAll::InternalRun()
             }
             ParameterizePt2ToPt2(e2, e1, w2, tmpWindow0.dv2Src);
             tmpWindow0.d0 = sqrt(SquredD2Dist(w0_to_e1_e2, w2));
-            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+            tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
             tmpWindow0.ksi = WindowToBePropagated.ksi;
-            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+            tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
 
             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
             {
                 ProcessNewWindow(&tmpWindow0);
             }
 
-            if (w0.x == e0.x && WindowToBePropagated.pMarkFromEdgeVertex->IsSaddleBoundary())
+            if (w0.x == e0.x && m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx].IsSaddleBoundary())
             {
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwMarkFromEdgeVertexIdx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo1);
+                tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwMarkFromEdgeVertexIdx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo1;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d0;
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.b1 = sqrt(SquredD2Dist(w0_to_e1_e2, e2));
                 tmpWindow0.d0 = pEdge0->dEdgeLength;
                 tmpWindow0.d1 = sqrt(SquredD2Dist(w0_to_e1_e2, e0));
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
                 //ParameterizePt2ToPt2( e2, e1, e0, tmpWindow0.dv2Src ) ;
-                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, *pPtE1, *WindowToBePropagated.pMarkFromEdgeVertex, tmpWindow0.dv2Src);
+                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, *pPtE1, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx], tmpWindow0.dv2Src);
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -382,17 +437,17 @@ void CExactOneToAll::InternalRun()
                         {
                             //EdgeWindow newWindow ;
 
-                            tmpWindow0.SetEdgeIdx(m_EdgeList, shadowEdges[v]);
-                            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, shadowFaces[v]);
-                            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, tmpWindow0.pEdge->dwVertexIdx0);
-                            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwMarkFromEdgeVertexIdx);
+                            tmpWindow0.dwEdgeIdx = shadowEdges[v];
+                            tmpWindow0.dwFaceIdxPropagatedFrom = shadowFaces[v];
+                            tmpWindow0.dwMarkFromEdgeVertexIdx = m_EdgeList[tmpWindow0.dwEdgeIdx].dwVertexIdx0;
+                            tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwMarkFromEdgeVertexIdx;
                             tmpWindow0.b0 = 0;
-                            tmpWindow0.b1 = tmpWindow0.pEdge->dEdgeLength;
-                            tmpWindow0.d0 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex0, *WindowToBePropagated.pMarkFromEdgeVertex));
-                            tmpWindow0.d1 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex1, *WindowToBePropagated.pMarkFromEdgeVertex));
+                            tmpWindow0.b1 = m_EdgeList[tmpWindow0.dwEdgeIdx].dEdgeLength;
+                            tmpWindow0.d0 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx]));
+                            tmpWindow0.d1 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx]));
                             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d0;
-                            ParameterizePt3ToPt2(*tmpWindow0.pEdge->pVertex0, *tmpWindow0.pEdge->pVertex1, *tmpWindow0.pPseuSrcVertex, tmpWindow0.dv2Src);
-                            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                            ParameterizePt3ToPt2(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, *m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[tmpWindow0.dwPseuSrcVertexIdx], tmpWindow0.dv2Src);
+                            tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
                             tmpWindow0.ksi = WindowToBePropagated.ksi;
 
                             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
@@ -408,9 +463,9 @@ void CExactOneToAll::InternalRun()
         // this is the third figure shown in the mail
         else if (bW2W0OnE0E2 && bW2W1OnE0E2)
         {
-            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-            tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo0);
-            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+            tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+            tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo0;
+            tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
             tmpWindow0.b0 = sqrt(SquredD2Dist(w1_to_e0_e2, e2));
             if (tmpWindow0.b0 < double(FLT_EPSILON))
@@ -429,10 +484,10 @@ void CExactOneToAll::InternalRun()
             }
             ParameterizePt2ToPt2(e2, e0, w2, tmpWindow0.dv2Src);
             tmpWindow0.d0 = sqrt(SquredD2Dist(w1_to_e0_e2, w2));
-            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+            tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
             tmpWindow0.ksi = WindowToBePropagated.ksi;
-            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+            tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
 
             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
             {
@@ -441,19 +496,19 @@ void CExactOneToAll::InternalRun()
 
             if (w1.x == e1.x && pPtE1->IsSaddleBoundary())
             {
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, dwPtE1Idx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo0);
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwPseuSrcVertexIdx = dwPtE1Idx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo0;
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d1;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.b1 = sqrt(SquredD2Dist(w1_to_e0_e2, e2));
                 tmpWindow0.d0 = pEdge1->dEdgeLength;
                 tmpWindow0.d1 = sqrt(SquredD2Dist(w1_to_e0_e2, e1));
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
-                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, *WindowToBePropagated.pMarkFromEdgeVertex, *pPtE1, tmpWindow0.dv2Src);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
+                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx], *pPtE1, tmpWindow0.dv2Src);
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -468,7 +523,7 @@ void CExactOneToAll::InternalRun()
                     Edge* pBridgeEdge = pEdge1;
                     Face* pShadowFace = pBridgeEdge->GetAnotherFace(dwFacePropagateTo);
                     uint32_t dwShadowFace = pBridgeEdge->GetAnotherFaceIdx(dwFacePropagateTo);
-                    uint32_t dwE1 = WindowToBePropagated.pEdge->GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
+                    uint32_t dwE1 = m_EdgeList[WindowToBePropagated.dwEdgeIdx].GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
                     Edge* pShadowEdge = pShadowFace->GetOpposingEdge(dwE1);
                     uint32_t dwShadowEdge = pShadowFace->GetOpposingEdgeIdx(dwE1);
 
@@ -508,17 +563,17 @@ void CExactOneToAll::InternalRun()
                         {
                             //EdgeWindow newWindow ;
 
-                            tmpWindow0.SetEdgeIdx(m_EdgeList, shadowEdges[v]);
-                            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, shadowFaces[v]);
-                            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, tmpWindow0.pEdge->dwVertexIdx0);
-                            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, dwE1);
+                            tmpWindow0.dwEdgeIdx = shadowEdges[v];
+                            tmpWindow0.dwFaceIdxPropagatedFrom = shadowFaces[v];
+                            tmpWindow0.dwMarkFromEdgeVertexIdx = m_EdgeList[tmpWindow0.dwEdgeIdx].dwVertexIdx0;
+                            tmpWindow0.dwPseuSrcVertexIdx = dwE1;
                             tmpWindow0.b0 = 0;
-                            tmpWindow0.b1 = tmpWindow0.pEdge->dEdgeLength;
-                            tmpWindow0.d0 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex0, m_VertexList[dwE1]));
-                            tmpWindow0.d1 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex1, m_VertexList[dwE1]));
+                            tmpWindow0.b1 = m_EdgeList[tmpWindow0.dwEdgeIdx].dEdgeLength;
+                            tmpWindow0.d0 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, m_VertexList[dwE1]));
+                            tmpWindow0.d1 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[dwE1]));
                             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d1;
-                            ParameterizePt3ToPt2(*tmpWindow0.pEdge->pVertex0, *tmpWindow0.pEdge->pVertex1, *tmpWindow0.pPseuSrcVertex, tmpWindow0.dv2Src);
-                            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                            ParameterizePt3ToPt2(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, *m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[tmpWindow0.dwPseuSrcVertexIdx], tmpWindow0.dv2Src);
+                            tmpWindow0.dwEdgeIdxPropagatedFrom = WindowToBePropagated.dwEdgeIdx;
                             tmpWindow0.ksi = WindowToBePropagated.ksi;
 
                             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
@@ -543,37 +598,38 @@ void CExactOneToAll::InternalRun()
                     Edge* pEdge;
                     pEdge = m_VertexList[i].edgesAdj[j];
 
-                    for (size_t l = 0; l < pEdge->WindowsList.size(); ++l)
+                    const std::vector<uint32_t>& windowsList = GetWindowsList(*pEdge);
+                    for (size_t l = 0; l < windowsList.size(); ++l)
                     {
-                        EdgeWindow& theWindow = pEdge->WindowsList[l].theWindow;
+                        const EdgeWindow& theWindow = m_WindowPool[windowsList[l]];
 
                         if (theWindow.dwMarkFromEdgeVertexIdx == i)
                         {
-                            if (theWindow.b0 < theWindow.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex)
+                            if (theWindow.b0 < m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex)
                             {
-                                theWindow.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = theWindow.b0;
-                                theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc = theWindow.d0 + theWindow.dPseuSrcToSrcDistance;
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex = theWindow.b0;
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc = theWindow.d0 + theWindow.dPseuSrcToSrcDistance;
                             }
-                            else if (theWindow.b0 == theWindow.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex)
+                            else if (theWindow.b0 == m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex)
                             {
-                                theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc =
-                                    std::min(theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc, theWindow.d0 + theWindow.dPseuSrcToSrcDistance);
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc =
+                                    std::min(m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc, theWindow.d0 + theWindow.dPseuSrcToSrcDistance);
                             }
 
-                            if (theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc == (theWindow.d0 + theWindow.dPseuSrcToSrcDistance))
+                            if (m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc == (theWindow.d0 + theWindow.dPseuSrcToSrcDistance))
                             {
-                                theWindow.pMarkFromEdgeVertex->pEdgeReportedGeoDist = theWindow.pEdge;
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].pEdgeReportedGeoDist = &m_EdgeList[theWindow.dwEdgeIdx];
                             }
                         }
                         else
                         {
                             Vertex* pAnotherPt = &m_VertexList[i];
-                            if (theWindow.b1 > (theWindow.pEdge->dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
+                            if (theWindow.b1 > (m_EdgeList[theWindow.dwEdgeIdx].dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
                             {
-                                pAnotherPt->dLengthOfWindowEdgeToThisVertex = theWindow.pEdge->dEdgeLength - theWindow.b1;
+                                pAnotherPt->dLengthOfWindowEdgeToThisVertex = m_EdgeList[theWindow.dwEdgeIdx].dEdgeLength - theWindow.b1;
                                 pAnotherPt->dGeoDistanceToSrc = theWindow.d1 + theWindow.dPseuSrcToSrcDistance;
                             }
-                            else if (theWindow.b1 == (theWindow.pEdge->dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
+                            else if (theWindow.b1 == (m_EdgeList[theWindow.dwEdgeIdx].dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
                             {
                                 pAnotherPt->dGeoDistanceToSrc =
                                     std::min(pAnotherPt->dGeoDistanceToSrc, theWindow.d1 + theWindow.dPseuSrcToSrcDistance);
@@ -581,7 +637,7 @@ void CExactOneToAll::InternalRun()
 
                             if (pAnotherPt->dGeoDistanceToSrc == theWindow.d1 + theWindow.dPseuSrcToSrcDistance)
                             {
-                                pAnotherPt->pEdgeReportedGeoDist = theWindow.pEdge;
+                                pAnotherPt->pEdgeReportedGeoDist = &m_EdgeList[theWindow.dwEdgeIdx];
                             }
                         }
                     }
@@ -589,6 +645,8 @@ void CExactOneToAll::InternalRun()
             }
         }
     }
+
+    return S_OK;
 }
 
 void CExactOneToAll::ProcessNewWindow(EdgeWindow* pNewEdgeWindow)
@@ -596,6 +654,9 @@ void CExactOneToAll::ProcessNewWindow(EdgeWindow* pNewEdgeWindow)
     std::vector<EdgeWindow> NewWindowsList;
     NewWindowsList.push_back(*pNewEdgeWindow);
 
+    // the windows split off below stay on the edge of the first new window
+    std::vector<uint32_t>& windowsList = GetWindowsList(m_EdgeList[pNewEdgeWindow->dwEdgeIdx]);
+
     size_t j = 0;
 
     while (j < NewWindowsList.size())
@@ -608,24 +669,18 @@ void CExactOneToAll::ProcessNewWindow(EdgeWindow* pNewEdgeWindow)
 
         bNewWindowNotAvailable = false;
 
-        for (i = 0; i < pNewEdgeWindow->pEdge->WindowsList.size(); ++i)
+        for (i = 0; i < windowsList.size(); ++i)
         {
-            TypeEdgeWindowsHeap::item_type* pExistingWindowItem;
+            const uint32_t dwExistingWindowIdx = windowsList[i];
 
             bExistingWindowChanged = false;
             bNewWindowChanged = false;
             bExistingWindowNotAvailable = false;
 
-            // get a copy of current window on edge
-            pExistingWindowItem =
-                new TypeEdgeWindowsHeap::item_type(
-                    std::min(pNewEdgeWindow->pEdge->WindowsList[i].theWindow.d0, pNewEdgeWindow->pEdge->WindowsList[i].theWindow.d1) + pNewEdgeWindow->pEdge->WindowsList[i].theWindow.dPseuSrcToSrcDistance,
-                    pNewEdgeWindow->pEdge->WindowsList[i].theWindow
-                );
-
-            // the copy of current window on edge is then tested with the new window for intersection
-            // after this test, the copy is possibly changed
-            IntersectWindow(&pExistingWindowItem->m_data,
+            // the current window on edge is tested with the new window for intersection
+            // after this test, the window is possibly changed, the heap still has its old weight
+            EdgeWindow& ExistingWindow = m_WindowPool[dwExistingWindowIdx];
+            IntersectWindow(&ExistingWindow,
                 pNewEdgeWindow, &bExistingWindowChanged, &bNewWindowChanged, &bExistingWindowNotAvailable, &bNewWindowNotAvailable);
 
             if (m_NewExistingWindow.b1 - m_NewExistingWindow.b0 > 0) // m_NewExistingWindow is modified in IntersectWindow
@@ -637,100 +692,65 @@ void CExactOneToAll::ProcessNewWindow(EdgeWindow* pNewEdgeWindow)
                 pNewEdgeWindow = &NewWindowsList[j];
             }
 
-            bool bDontDelete;
-            bDontDelete = false;
-
-            // after the intersection operation, if the existing window has been changed, 
-            // remove the old one from the heap (if it is in heap) and update the one on edge
+            // after the intersection operation, if the existing window has been changed,
+            // remove it from the heap (if it is in heap) and insert it again with its new weight
             if (bExistingWindowChanged)
             {
-                // whether the window is in heap
-                if (pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem)
+                bool bInHeap = m_EdgeWindowsHeap.isInHeap(dwExistingWindowIdx);
+                if (bInHeap)
                 {
-                    // get the item in heap and remove it from the heap
-                    TypeEdgeWindowsHeap::item_type* pHeapItem = pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem;
-
-                    m_EdgeWindowsHeap.remove(pHeapItem);
-                    delete pHeapItem;
+                    m_EdgeWindowsHeap.remove(dwExistingWindowIdx);
+                }
 
-                    // if the existing window still available (b0<b1), we insert the updated one into heap again
-                    // and update the one on edge correspondingly
-                    if (!bExistingWindowNotAvailable)
-                    {
-                        pNewEdgeWindow->pEdge->WindowsList[i].theWindow = pExistingWindowItem->m_data;
-                        pExistingWindowItem->m_weight = std::min(pExistingWindowItem->m_data.d0, pExistingWindowItem->m_data.d1) + pExistingWindowItem->m_data.dPseuSrcToSrcDistance;
-                        m_EdgeWindowsHeap.insert(pExistingWindowItem);
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = pExistingWindowItem;
-                        bDontDelete = true;
-                    }
-                    else
+                // if the existing window still available (b0<b1), it stays on the edge
+                if (!bExistingWindowNotAvailable)
+                {
+                    if (bInHeap)
                     {
-                        // we set a flag here, that this window on edge is to be removed
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = reinterpret_cast<TypeEdgeWindowsHeap::item_type*>(FLAG_INVALID_SIZE_T);
+                        m_EdgeWindowsHeap.insert(dwExistingWindowIdx, ExistingWindow.GetMinDistanceToSrc());
                     }
                 }
                 else
                 {
-                    // the window is not in heap, so we just update the one on edge
-                    if (!bExistingWindowNotAvailable)
-                    {
-                        pNewEdgeWindow->pEdge->WindowsList[i].theWindow = pExistingWindowItem->m_data;
-                    }
-                    else
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = reinterpret_cast<TypeEdgeWindowsHeap::item_type*>(FLAG_INVALID_SIZE_T);
+                    // we set a flag here, that this window on edge is to be removed
+                    m_WindowPool.Remove(dwExistingWindowIdx);
+                    windowsList[i] = FLAG_INVALIDDWORD;
                 }
             }
 
-            if (!bDontDelete)
-                delete pExistingWindowItem;
-
             // if the new window is already unavailable during this iteration, we break ;
             if (bNewWindowNotAvailable)
                 break;
         }
 
-        i = 0;
-        while (i < pNewEdgeWindow->pEdge->WindowsList.size())
-        {
-            // test the remove flag set above, and erase the invalidated window from this edge
-            if (reinterpret_cast<size_t>(pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem) == FLAG_INVALID_SIZE_T)
-            {
-                pNewEdgeWindow->pEdge->WindowsList.erase(pNewEdgeWindow->pEdge->WindowsList.begin() + ptrdiff_t(i));
-            }
-            else
-            {
-                ++i;
-            }
-        }
+        // erase the invalidated windows from this edge
+        windowsList.erase(
+            std::remove(windowsList.begin(), windowsList.end(), FLAG_INVALIDDWORD),
+            windowsList.end());
 
         if (WindowToBeInserted.b1 - WindowToBeInserted.b0 > 0)
         {
-            TypeEdgeWindowsHeap::item_type* pNewWindowItem =
-                new TypeEdgeWindowsHeap::item_type(std::min(WindowToBeInserted.d0, WindowToBeInserted.d1) + WindowToBeInserted.dPseuSrcToSrcDistance, WindowToBeInserted);
-
-            m_EdgeWindowsHeap.insert(pNewWindowItem);
-
-            WindowToBeInserted.pEdge->WindowsList.push_back(Edge::WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
+            StoreWindow(WindowToBeInserted);
 
             // update the geodesic distance on vertices affected by this new window
             if (WindowToBeInserted.b0 < 0.01)
             {
-                if ((WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance) < WindowToBeInserted.pMarkFromEdgeVertex->dGeoDistanceToSrc)
+                if ((WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance) < m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc)
                 {
-                    WindowToBeInserted.pMarkFromEdgeVertex->dGeoDistanceToSrc = WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance;
-                    WindowToBeInserted.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = WindowToBeInserted.b0;
-                    WindowToBeInserted.pMarkFromEdgeVertex->pEdgeReportedGeoDist = WindowToBeInserted.pEdge;
+                    m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc = WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance;
+                    m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex = WindowToBeInserted.b0;
+                    m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].pEdgeReportedGeoDist = &m_EdgeList[WindowToBeInserted.dwEdgeIdx];
                 }
             }
 
-            Vertex* pAnotherPt = WindowToBeInserted.pEdge->GetAnotherVertex(WindowToBeInserted.dwMarkFromEdgeVertexIdx);
-            if (WindowToBeInserted.b1 > (WindowToBeInserted.pEdge->dEdgeLength - 0.01))
+            Vertex* pAnotherPt = m_EdgeList[WindowToBeInserted.dwEdgeIdx].GetAnotherVertex(WindowToBeInserted.dwMarkFromEdgeVertexIdx);
+            if (WindowToBeInserted.b1 > (m_EdgeList[WindowToBeInserted.dwEdgeIdx].dEdgeLength - 0.01))
             {
                 if ((WindowToBeInserted.d1 + WindowToBeInserted.dPseuSrcToSrcDistance) < pAnotherPt->dGeoDistanceToSrc)
                 {
                     pAnotherPt->dGeoDistanceToSrc = WindowToBeInserted.d1 + WindowToBeInserted.dPseuSrcToSrcDistance;
-                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = WindowToBeInserted.pEdge->dEdgeLength - WindowToBeInserted.b1;
-                    pAnotherPt->pEdgeReportedGeoDist = WindowToBeInserted.pEdge;
+                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = m_EdgeList[WindowToBeInserted.dwEdgeIdx].dEdgeLength - WindowToBeInserted.b1;
+                    pAnotherPt->pEdgeReportedGeoDist = &m_EdgeList[WindowToBeInserted.dwEdgeIdx];
                 }
             }
         }
@@ -739,32 +759,27 @@ void CExactOneToAll::ProcessNewWindow(EdgeWindow* pNewEdgeWindow)
         // add it to the edge and heap
         if (!bNewWindowNotAvailable/*pNewEdgeWindow->b0 < pNewEdgeWindow->b1*/)
         {
-            TypeEdgeWindowsHeap::item_type* pNewWindowItem =
-                new TypeEdgeWindowsHeap::item_type(std::min(pNewEdgeWindow->d0, pNewEdgeWindow->d1) + pNewEdgeWindow->dPseuSrcToSrcDistance, *pNewEdgeWindow);
-
-            m_EdgeWindowsHeap.insert(pNewWindowItem);
-
-            pNewEdgeWindow->pEdge->WindowsList.push_back(Edge::WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
+            StoreWindow(*pNewEdgeWindow);
 
             // update the geodesic distance on vertices affected by this new window
             if (pNewEdgeWindow->b0 < 0.01)
             {
-                if ((pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance) < pNewEdgeWindow->pMarkFromEdgeVertex->dGeoDistanceToSrc)
+                if ((pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance) < m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc)
                 {
-                    pNewEdgeWindow->pMarkFromEdgeVertex->dGeoDistanceToSrc = pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance;
-                    pNewEdgeWindow->pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = pNewEdgeWindow->b0;
-                    pNewEdgeWindow->pMarkFromEdgeVertex->pEdgeReportedGeoDist = pNewEdgeWindow->pEdge;
+                    m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc = pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance;
+                    m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex = pNewEdgeWindow->b0;
+                    m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].pEdgeReportedGeoDist = &m_EdgeList[pNewEdgeWindow->dwEdgeIdx];
                 }
             }
 
-            Vertex* pAnotherPt = pNewEdgeWindow->pEdge->GetAnotherVertex(pNewEdgeWindow->dwMarkFromEdgeVertexIdx);
-            if (pNewEdgeWindow->b1 > (pNewEdgeWindow->pEdge->dEdgeLength - 0.01))
+            Vertex* pAnotherPt = m_EdgeList[pNewEdgeWindow->dwEdgeIdx].GetAnotherVertex(pNewEdgeWindow->dwMarkFromEdgeVertexIdx);
+            if (pNewEdgeWindow->b1 > (m_EdgeList[pNewEdgeWindow->dwEdgeIdx].dEdgeLength - 0.01))
             {
                 if ((pNewEdgeWindow->d1 + pNewEdgeWindow->dPseuSrcToSrcDistance) < pAnotherPt->dGeoDistanceToSrc)
                 {
                     pAnotherPt->dGeoDistanceToSrc = pNewEdgeWindow->d1 + pNewEdgeWindow->dPseuSrcToSrcDistance;
-                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = pNewEdgeWindow->pEdge->dEdgeLength - pNewEdgeWindow->b1;
-                    pAnotherPt->pEdgeReportedGeoDist = pNewEdgeWindow->pEdge;
+                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = m_EdgeList[pNewEdgeWindow->dwEdgeIdx].dEdgeLength - pNewEdgeWindow->b1;
+                    pAnotherPt->pEdgeReportedGeoDist = &m_EdgeList[pNewEdgeWindow->dwEdgeIdx];
                 }
             }
         }
@@ -801,16 +816,15 @@ void CExactOneToAll::IntersectWindow(EdgeWindow* pExistingWindow,
     if (pExistingWindow->dwMarkFromEdgeVertexIdx != pNewWindow->dwMarkFromEdgeVertexIdx)
     {
         pNewWindow->dwMarkFromEdgeVertexIdx = pExistingWindow->dwMarkFromEdgeVertexIdx;
-        pNewWindow->pMarkFromEdgeVertex = pExistingWindow->pMarkFromEdgeVertex;
         std::swap(pNewWindow->d0, pNewWindow->d1);
         std::swap(pNewWindow->b0, pNewWindow->b1);
-        pNewWindow->b0 = std::max<double>(pNewWindow->pEdge->dEdgeLength - pNewWindow->b0, 0);
+        pNewWindow->b0 = std::max<double>(m_EdgeList[pNewWindow->dwEdgeIdx].dEdgeLength - pNewWindow->b0, 0);
         if (pNewWindow->b0 < double(FLT_EPSILON))
         {
             pNewWindow->b0 = 0;
         }
-        pNewWindow->b1 = pNewWindow->pEdge->dEdgeLength - pNewWindow->b1;
-        pNewWindow->dv2Src.x = pNewWindow->pEdge->dEdgeLength - pNewWindow->dv2Src.x;
+        pNewWindow->b1 = m_EdgeList[pNewWindow->dwEdgeIdx].dEdgeLength - pNewWindow->b1;
+        pNewWindow->dv2Src.x = m_EdgeList[pNewWindow->dwEdgeIdx].dEdgeLength - pNewWindow->dv2Src.x;
     }
 
     double a = std::min(std::min(std::min(pExistingWindow->b0, pExistingWindow->b1), pNewWindow->b0), pNewWindow->b1);
@@ -857,15 +871,15 @@ void CExactOneToAll::IntersectWindow(EdgeWindow* pExistingWindow,
             m_NewExistingWindow.b1 = pNewWindow->b0;
             m_NewExistingWindow.dv2Src = pExistingWindow->dv2Src;
             m_NewExistingWindow.d0 = pExistingWindow->d0;
-            m_NewExistingWindow.SetEdgeIdx(m_EdgeList, pExistingWindow->dwEdgeIdx);
-            m_NewExistingWindow.SetFaceIdxPropagatedFrom(m_FaceList, pExistingWindow->dwFaceIdxPropagatedFrom);
-            m_NewExistingWindow.SetMarkFromEdgeVertexIdx(m_VertexList, pExistingWindow->dwMarkFromEdgeVertexIdx);
-            m_NewExistingWindow.SetPseuSrcVertexIdx(m_VertexList, pExistingWindow->dwPseuSrcVertexIdx);
+            m_NewExistingWindow.dwEdgeIdx = pExistingWindow->dwEdgeIdx;
+            m_NewExistingWindow.dwFaceIdxPropagatedFrom = pExistingWindow->dwFaceIdxPropagatedFrom;
+            m_NewExistingWindow.dwMarkFromEdgeVertexIdx = pExistingWindow->dwMarkFromEdgeVertexIdx;
+            m_NewExistingWindow.dwPseuSrcVertexIdx = pExistingWindow->dwPseuSrcVertexIdx;
             m_NewExistingWindow.d1 = sqrt(SquredD2Dist(DVector2(m_NewExistingWindow.b1, 0), m_NewExistingWindow.dv2Src));
             m_NewExistingWindow.dPseuSrcToSrcDistance = pExistingWindow->dPseuSrcToSrcDistance;
 
             m_NewExistingWindow.ksi = pExistingWindow->ksi;
-            m_NewExistingWindow.pEdgePropagatedFrom = pExistingWindow->pEdgePropagatedFrom;
+            m_NewExistingWindow.dwEdgeIdxPropagatedFrom = pExistingWindow->dwEdgeIdxPropagatedFrom;
 
             pExistingWindow->b0 = pNewWindow->b0;
             pExistingWindow->d0 = sqrt(SquredD2Dist(DVector2(pExistingWindow->b0, 0), ExistingWindowSrc));
@@ -890,15 +904,15 @@ void CExactOneToAll::IntersectWindow(EdgeWindow* pExistingWindow,
             m_AnotherNewWindow.b1 = pExistingWindow->b0;
             m_AnotherNewWindow.dv2Src = pNewWindow->dv2Src;
             m_AnotherNewWindow.d0 = pNewWindow->d0;
-            m_AnotherNewWindow.SetEdgeIdx(m_EdgeList, pNewWindow->dwEdgeIdx);
-            m_AnotherNewWindow.SetFaceIdxPropagatedFrom(m_FaceList, pNewWindow->dwFaceIdxPropagatedFrom);
-            m_AnotherNewWindow.SetMarkFromEdgeVertexIdx(m_VertexList, pNewWindow->dwMarkFromEdgeVertexIdx);
-            m_AnotherNewWindow.SetPseuSrcVertexIdx(m_VertexList, pNewWindow->dwPseuSrcVertexIdx);
+            m_AnotherNewWindow.dwEdgeIdx = pNewWindow->dwEdgeIdx;
+            m_AnotherNewWindow.dwFaceIdxPropagatedFrom = pNewWindow->dwFaceIdxPropagatedFrom;
+            m_AnotherNewWindow.dwMarkFromEdgeVertexIdx = pNewWindow->dwMarkFromEdgeVertexIdx;
+            m_AnotherNewWindow.dwPseuSrcVertexIdx = pNewWindow->dwPseuSrcVertexIdx;
             m_AnotherNewWindow.d1 = sqrt(SquredD2Dist(DVector2(m_AnotherNewWindow.b1, 0), m_AnotherNewWindow.dv2Src));
             m_AnotherNewWindow.dPseuSrcToSrcDistance = pNewWindow->dPseuSrcToSrcDistance;
 
             m_AnotherNewWindow.ksi = pNewWindow->ksi;
-            m_AnotherNewWindow.pEdgePropagatedFrom = pNewWindow->pEdgePropagatedFrom;
+            m_AnotherNewWindow.dwEdgeIdxPropagatedFrom = pNewWindow->dwEdgeIdxPropagatedFrom;
 
             pNewWindow->b0 = pExistingWindow->b0;
             pNewWindow->d0 = sqrt(SquredD2Dist(DVector2(pNewWindow->b0, 0), NewWindowSrc));
@@ -1086,20 +1100,20 @@ void CExactOneToAll::GenerateWindowsAroundSaddleOrBoundaryVertex(const EdgeWindo
     {
         EdgeWindow tmpWindow;
 
-        tmpWindow.SetEdgeIdx(m_EdgeList, m_VertexList[dwSaddleOrBoundaryVertexId].facesAdj[i]->GetOpposingEdgeIdx(dwSaddleOrBoundaryVertexId));
-        tmpWindow.SetFaceIdxPropagatedFrom(m_FaceList, static_cast<uint32_t>(reinterpret_cast<intptr_t>(m_VertexList[dwSaddleOrBoundaryVertexId].facesAdj[i]) - reinterpret_cast<intptr_t>(&m_FaceList[0])) / sizeof(Face));
-        tmpWindow.SetMarkFromEdgeVertexIdx(m_VertexList, tmpWindow.pEdge->dwVertexIdx0);
-        tmpWindow.SetPseuSrcVertexIdx(m_VertexList, dwSaddleOrBoundaryVertexId);
+        tmpWindow.dwEdgeIdx = m_VertexList[dwSaddleOrBoundaryVertexId].facesAdj[i]->GetOpposingEdgeIdx(dwSaddleOrBoundaryVertexId);
+        tmpWindow.dwFaceIdxPropagatedFrom = static_cast<uint32_t>(reinterpret_cast<intptr_t>(m_VertexList[dwSaddleOrBoundaryVertexId].facesAdj[i]) - reinterpret_cast<intptr_t>(&m_FaceList[0])) / sizeof(Face);
+        tmpWindow.dwMarkFromEdgeVertexIdx = m_EdgeList[tmpWindow.dwEdgeIdx].dwVertexIdx0;
+        tmpWindow.dwPseuSrcVertexIdx = dwSaddleOrBoundaryVertexId;
         tmpWindow.b0 = 0;
-        tmpWindow.b1 = tmpWindow.pEdge->dEdgeLength;
-        tmpWindow.d0 = sqrt(SquredD3Dist(*tmpWindow.pEdge->pVertex0, m_VertexList[dwSaddleOrBoundaryVertexId]));
-        tmpWindow.d1 = sqrt(SquredD3Dist(*tmpWindow.pEdge->pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId]));
+        tmpWindow.b1 = m_EdgeList[tmpWindow.dwEdgeIdx].dEdgeLength;
+        tmpWindow.d0 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow.dwEdgeIdx].pVertex0, m_VertexList[dwSaddleOrBoundaryVertexId]));
+        tmpWindow.d1 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow.dwEdgeIdx].pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId]));
         tmpWindow.dPseuSrcToSrcDistance = (iwindow.dwMarkFromEdgeVertexIdx == dwSaddleOrBoundaryVertexId ? iwindow.d0 : iwindow.d1)
             + iwindow.dPseuSrcToSrcDistance;
-        ParameterizePt3ToPt2(*tmpWindow.pEdge->pVertex0, *tmpWindow.pEdge->pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId], tmpWindow.dv2Src);
+        ParameterizePt3ToPt2(*m_EdgeList[tmpWindow.dwEdgeIdx].pVertex0, *m_EdgeList[tmpWindow.dwEdgeIdx].pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId], tmpWindow.dv2Src);
 
         tmpWindow.ksi = iwindow.ksi;
-        tmpWindow.pEdgePropagatedFrom = iwindow.pEdge;
+        tmpWindow.dwEdgeIdxPropagatedFrom = iwindow.dwEdgeIdx;
 
         tmpWindow.dwTag = 1;
 
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "datatypes.h"
+#include "isochartstats.h"
 
 namespace GeodesicDist
 {
@@ -24,11 +25,26 @@ namespace GeodesicDist
         size_t m_dwNumFaces;
         size_t  m_dwNumVertices;
         uint32_t m_dwSrcVertexIdx;
+        uint32_t m_dwRunId;
+        Isochart::CIsochartStats* m_pStats;
 
         EdgeWindow m_AnotherNewWindow;
         EdgeWindow m_NewExistingWindow;
 
+        CEdgeWindowPool m_WindowPool;
         TypeEdgeWindowsHeap m_EdgeWindowsHeap;
+        std::vector<uint32_t> m_SrcOpposingEdges;
+
+        // the windows list of an edge in the current run
+        std::vector<uint32_t>& GetWindowsList(Edge& edge)
+        {
+            if (edge.dwRunId != m_dwRunId)
+            {
+                edge.WindowsList.clear();
+                edge.dwRunId = m_dwRunId;
+            }
+            return edge.WindowsList;
+        }
 
         virtual void CutHeapTopData(EdgeWindow& EdgeWindowOut);
         void ProcessNewWindow(EdgeWindow* pNewEdgeWindow);
@@ -41,8 +57,9 @@ namespace GeodesicDist
         void GenerateWindowsAroundSaddleOrBoundaryVertex(const EdgeWindow& WindowToBePropagated,
             const uint32_t dwSaddleOrBoundaryVertexId,
             std::vector<EdgeWindow>& WindowsOut);
-        void InternalRun();
+        HRESULT InternalRun();
         void AddWindowToHeapAndEdge(const EdgeWindow& WindowToAdd);
+        void StoreWindow(const EdgeWindow& WindowToStore);
 
     public:
         TypeEdgeList m_EdgeList;
@@ -58,8 +75,18 @@ namespace GeodesicDist
         // set the source vertex index before run
         void SetSrcVertexIdx(const uint32_t dwSrcVertexIdx);
 
-        // run the algorithm
-        void Run();
+        // optional source of cancellation polled while the algorithm runs
+        void SetCancellation(Isochart::CIsochartStats* pStats) { m_pStats = pStats; }
+
+        // run the algorithm, returns the cancellation result if it stopped early
+        HRESULT Run();
+
+        // run the algorithm from each source in turn on the same topology
+        // pdDistances receives dwSourceCount rows of m_VertexList.size() distances, DBL_MAX for unreached vertices
+        HRESULT RunMany(const uint32_t* pdwSources, size_t dwSourceCount, double* pdDistances);
+
+        // bytes held by the windows of the last run, which are kept for the next one
+        size_t GetWindowBytes() const;
     };
 
 }
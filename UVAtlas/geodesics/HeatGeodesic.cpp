@@ -0,0 +1,711 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - HeatGeodesic.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+/*
+    Reference:
+        [CWW13] CRANE K., WEISCHEDEL C., WARDETZKY M.:
+        Geodesics in heat: a new approach to computing distance based on heat flow.
+        ACM Transactions on Graphics 32, 5 (2013)
+
+        [Dav06] DAVIS T.:
+        Direct Methods for Sparse Linear Systems.
+        SIAM (2006)
+*/
+
+#include "pch.h"
+#include "HeatGeodesic.h"
+
+using namespace GeodesicDist;
+using namespace DirectX;
+
+namespace
+{
+    // parts of the vertex set this small are not dissected further
+    const size_t DISSECTION_LEAF_SIZE = 32;
+
+    // a pivot this small relative to the diagonal of its row means the system is singular,
+    // e.g. the mesh has more than one connected piece
+    const double PIVOT_TOLERANCE = 1e-12;
+
+    const uint32_t NO_PARENT = FLAG_INVALIDDWORD;
+
+    inline DVector3 LoadDVector3(const XMFLOAT3& v)
+    {
+        DVector3 res;
+        res.x = double(v.x);
+        res.y = double(v.y);
+        res.z = double(v.z);
+        return res;
+    }
+}
+
+CHeatGeodesic::CHeatGeodesic() :
+    m_dwVertexCount(0),
+    m_pStats(nullptr),
+    m_memory(nullptr, Isochart::ISOCHART_MEMORY_GEODESIC_DISTANCE)
+{
+}
+
+void CHeatGeodesic::Clear()
+{
+    m_dwVertexCount = 0;
+    m_Perm.clear();
+    m_InvPerm.clear();
+    m_Lp.clear();
+    m_Li.clear();
+    m_HeatLx.clear();
+    m_DirichletHeatLx.clear();
+    m_PotentialLx.clear();
+    m_FaceVerts.clear();
+    m_FaceArea.clear();
+    m_FaceGrad.clear();
+    m_memory.Release();
+}
+
+HRESULT CHeatGeodesic::Init(
+    const XMFLOAT3* pPositions,
+    size_t dwVertexCount,
+    const uint32_t* pdwIndices,
+    size_t dwFaceCount,
+    size_t dwMaxFactorEntries)
+{
+    Clear();
+
+    if (!pPositions || !pdwIndices || !dwVertexCount || !dwFaceCount || dwVertexCount >= NO_PARENT)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (size_t i = 0; i < dwFaceCount * 3; ++i)
+    {
+        if (pdwIndices[i] >= dwVertexCount)
+        {
+            return E_INVALIDARG;
+        }
+    }
+
+    const size_t n = dwVertexCount;
+    m_dwVertexCount = n;
+    HRESULT hr = S_OK;
+
+    // the per face data and the vertex order are charged before they are allocated,
+    // a budget too small for them leaves the distances to the one-to-all sweep
+    if (FAILED(m_memory.Add(
+        dwFaceCount * 3 * (sizeof(uint32_t) + sizeof(DVector3))
+        + dwFaceCount * sizeof(double)
+        + n * 2 * sizeof(uint32_t))))
+    {
+        Clear();
+        return S_FALSE;
+    }
+
+    try
+    {
+        // 1. the area of each face and the gradients of its three hat functions,
+        //    the gradient of vertex i is N x e_i / |N|^2 with e_i the edge opposite to i
+        m_FaceVerts.assign(pdwIndices, pdwIndices + dwFaceCount * 3);
+        m_FaceArea.resize(dwFaceCount);
+        m_FaceGrad.resize(dwFaceCount * 3);
+
+        std::vector<double> mass(n, 0.0);
+        for (size_t f = 0; f < dwFaceCount; ++f)
+        {
+            const uint32_t* pdwFace = pdwIndices + f * 3;
+            DVector3 pt[3] = { LoadDVector3(pPositions[pdwFace[0]]), LoadDVector3(pPositions[pdwFace[1]]), LoadDVector3(pPositions[pdwFace[2]]) };
+
+            DVector3 edge[3], normal;
+            double dMaxEdge2 = 0;
+            for (size_t i = 0; i < 3; ++i)
+            {
+                DVector3Minus(pt[(i + 2) % 3], pt[(i + 1) % 3], edge[i]);
+                dMaxEdge2 = std::max(dMaxEdge2, DVector3Dot(edge[i], edge[i]));
+            }
+            DVector3Cross(edge[2], edge[0], normal);
+
+            const double dNormal2 = DVector3Dot(normal, normal);
+            if (sqrt(dNormal2) <= DBL_EPSILON * dMaxEdge2)
+            {
+                // degenerate face, it adds nothing to either system
+                m_FaceArea[f] = 0;
+                continue;
+            }
+
+            m_FaceArea[f] = 0.5 * sqrt(dNormal2);
+            for (size_t i = 0; i < 3; ++i)
+            {
+                DVector3Cross(normal, edge[i], m_FaceGrad[f * 3 + i]);
+                DVector3ScalarMul(m_FaceGrad[f * 3 + i], 1.0 / dNormal2);
+                mass[pdwFace[i]] += m_FaceArea[f] / 3;
+            }
+        }
+
+        // 2. vertex adjacency, each row sorted, and the boundary vertices, those on an edge of one face
+        std::vector<uint64_t> pairs;
+        pairs.reserve(dwFaceCount * 6);
+        for (size_t f = 0; f < dwFaceCount; ++f)
+        {
+            const uint32_t* pdwFace = pdwIndices + f * 3;
+            for (size_t i = 0; i < 3; ++i)
+            {
+                const uint64_t a = std::min(pdwFace[i], pdwFace[(i + 1) % 3]);
+                const uint64_t b = std::max(pdwFace[i], pdwFace[(i + 1) % 3]);
+                if (a != b)
+                {
+                    pairs.push_back((a << 32) | b);
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        std::vector<bool> boundary(n, false);
+        bool bHasBoundary = false;
+        for (size_t p = 0; p < pairs.size(); )
+        {
+            size_t q = p + 1;
+            while (q < pairs.size() && pairs[q] == pairs[p])
+            {
+                q++;
+            }
+            if (q == p + 1)
+            {
+                boundary[size_t(pairs[p] >> 32)] = true;
+                boundary[size_t(uint32_t(pairs[p]))] = true;
+                bHasBoundary = true;
+            }
+            p = q;
+        }
+
+        const size_t dwUndirected = pairs.size();
+        for (size_t p = 0; p < dwUndirected; ++p)
+        {
+            pairs.push_back((pairs[p] << 32) | (pairs[p] >> 32));
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        std::vector<size_t> adjStart(n + 1, 0);
+        std::vector<uint32_t> adj(pairs.size());
+        for (size_t p = 0; p < pairs.size(); ++p)
+        {
+            adjStart[size_t(pairs[p] >> 32) + 1]++;
+            adj[p] = uint32_t(pairs[p]);
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            adjStart[i + 1] += adjStart[i];
+        }
+        std::vector<uint64_t>().swap(pairs);
+
+        // 3. the cotangent Laplacian, entry ij is the integral of grad(phi_i) . grad(phi_j)
+        std::vector<double> stiffness(adj.size(), 0.0);
+        std::vector<double> stiffnessDiag(n, 0.0);
+        std::vector<double> heatStiffnessDiag(n, 0.0);
+        for (size_t f = 0; f < dwFaceCount; ++f)
+        {
+            if (m_FaceArea[f] == 0)
+            {
+                continue;
+            }
+
+            const uint32_t* pdwFace = pdwIndices + f * 3;
+            for (size_t i = 0; i < 3; ++i)
+            {
+                const DVector3& gi = m_FaceGrad[f * 3 + i];
+                stiffnessDiag[pdwFace[i]] += m_FaceArea[f] * DVector3Dot(gi, gi);
+
+                for (size_t j = 0; j < 3; ++j)
+                {
+                    if (j == i)
+                    {
+                        continue;
+                    }
+                    const uint32_t* pdwRow = adj.data() + adjStart[pdwFace[i]];
+                    const uint32_t* pdwRowEnd = adj.data() + adjStart[pdwFace[i] + 1];
+                    const uint32_t* pdwCol = std::lower_bound(pdwRow, pdwRowEnd, pdwFace[j]);
+                    assert(pdwCol != pdwRowEnd && *pdwCol == pdwFace[j]);
+
+                    stiffness[size_t(pdwCol - adj.data())] += m_FaceArea[f] * DVector3Dot(gi, m_FaceGrad[f * 3 + j]);
+                }
+            }
+        }
+
+        // Obtuse triangles give positive off-diagonal entries, (M + tL) is then no M-matrix and
+        // the heat can turn negative far from the source, where it is tiny. The heat step drops
+        // those entries so the heat stays positive, its gradient only has to point the right way
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t p = adjStart[i]; p < adjStart[i + 1]; ++p)
+            {
+                heatStiffnessDiag[i] -= std::min(stiffness[p], 0.0);
+            }
+        }
+
+        // the time step is the squared mean edge length
+        double dEdgeLengthSum = 0;
+        size_t dwEdgeCount = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const DVector3 pt = LoadDVector3(pPositions[i]);
+            for (size_t p = adjStart[i]; p < adjStart[i + 1]; ++p)
+            {
+                if (adj[p] > i)
+                {
+                    DVector3 edge;
+                    DVector3Minus(LoadDVector3(pPositions[adj[p]]), pt, edge);
+                    dEdgeLengthSum += edge.Length();
+                    dwEdgeCount++;
+                }
+            }
+        }
+        const double dMeanEdgeLength = dwEdgeCount ? dEdgeLengthSum / double(dwEdgeCount) : 0;
+        const double dTime = dMeanEdgeLength * dMeanEdgeLength;
+
+        // 4. order the vertices by nested dissection to keep the fill of the factors low
+        m_Perm.resize(n);
+        m_InvPerm.resize(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            m_Perm[i] = uint32_t(i);
+        }
+        {
+            std::vector<uint32_t> tags(n, 0);
+            uint32_t dwTag = 0;
+            Dissect(pPositions, adjStart, adj, tags, dwTag, m_Perm.data(), m_Perm.data() + n);
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            m_InvPerm[m_Perm[i]] = uint32_t(i);
+        }
+
+        // 5. the lower triangles of the systems by rows in the new order. The potential is
+        //    only defined up to a constant, so the last vertex is pinned to make L definite.
+        //    The Dirichlet heat is pinned to 0 on the boundary
+        std::vector<size_t> rowStart(n + 1, 0);
+        std::vector<uint32_t> rowCols;
+        std::vector<double> heatValues, dirichletValues, potentialValues;
+        std::vector<double> heatDiag(n), dirichletDiag(n), potentialDiag(n);
+        rowCols.reserve(adj.size() / 2);
+        heatValues.reserve(adj.size() / 2);
+        potentialValues.reserve(adj.size() / 2);
+        if (bHasBoundary)
+        {
+            dirichletValues.reserve(adj.size() / 2);
+        }
+        for (size_t k = 0; k < n; ++k)
+        {
+            const uint32_t v = m_Perm[k];
+            const bool bPinned = (k == n - 1);
+            for (size_t p = adjStart[v]; p < adjStart[v + 1]; ++p)
+            {
+                const uint32_t j = m_InvPerm[adj[p]];
+                if (j < k)
+                {
+                    rowCols.push_back(j);
+                    heatValues.push_back(dTime * std::min(stiffness[p], 0.0));
+                    potentialValues.push_back(bPinned ? 0 : stiffness[p]);
+                    if (bHasBoundary)
+                    {
+                        dirichletValues.push_back((boundary[v] || boundary[adj[p]]) ? 0 : heatValues.back());
+                    }
+                }
+            }
+            rowStart[k + 1] = rowCols.size();
+            heatDiag[k] = mass[v] + dTime * heatStiffnessDiag[v];
+            dirichletDiag[k] = boundary[v] ? 1 : heatDiag[k];
+            potentialDiag[k] = bPinned ? 1 : stiffnessDiag[v];
+        }
+
+        // 6. elimination tree
+        std::vector<uint32_t> parent(n, NO_PARENT);
+        {
+            std::vector<uint32_t> ancestor(n, NO_PARENT);
+            for (size_t k = 0; k < n; ++k)
+            {
+                for (size_t p = rowStart[k]; p < rowStart[k + 1]; ++p)
+                {
+                    uint32_t i = rowCols[p];
+                    while (i != NO_PARENT && i < k)
+                    {
+                        const uint32_t dwNext = ancestor[i];
+                        ancestor[i] = uint32_t(k);
+                        if (dwNext == NO_PARENT)
+                        {
+                            parent[i] = uint32_t(k);
+                        }
+                        i = dwNext;
+                    }
+                }
+            }
+        }
+
+        // 7. column counts of the factors, row k of L is the reach of row k of the system in the tree
+        Isochart::CIsochartCancelPoll cancel(m_pStats);
+        std::vector<size_t> colCount(n, 1);
+        size_t dwEntries = n;
+        {
+            std::vector<uint32_t> flags(n, NO_PARENT);
+            std::vector<uint32_t> pattern(n);
+            for (size_t k = 0; k < n; ++k)
+            {
+                hr = cancel.Poll();
+                if (FAILED(hr))
+                {
+                    Clear();
+                    return hr;
+                }
+
+                const size_t top = EliminationReach(uint32_t(k), rowStart, rowCols, parent, flags, pattern);
+                for (size_t p = top; p < n; ++p)
+                {
+                    colCount[pattern[p]]++;
+                }
+
+                dwEntries += n - top;
+                if (dwEntries > dwMaxFactorEntries)
+                {
+                    Clear();
+                    return S_FALSE;
+                }
+            }
+        }
+
+        // the factors share one pattern, each entry costs its row index and one value per system
+        const size_t dwSystems = bHasBoundary ? 3 : 2;
+        if (FAILED(m_memory.Add(
+            (n + 1) * sizeof(size_t)
+            + dwEntries * (sizeof(uint32_t) + dwSystems * sizeof(double)))))
+        {
+            Clear();
+            return S_FALSE;
+        }
+
+        m_Lp.resize(n + 1);
+        m_Lp[0] = 0;
+        for (size_t k = 0; k < n; ++k)
+        {
+            m_Lp[k + 1] = m_Lp[k] + colCount[k];
+        }
+        m_Li.resize(m_Lp[n]);
+        m_HeatLx.resize(m_Lp[n]);
+        m_PotentialLx.resize(m_Lp[n]);
+        if (bHasBoundary)
+        {
+            m_DirichletHeatLx.resize(m_Lp[n]);
+        }
+
+        // 8. numeric factorization of the systems
+        hr = Factor(rowStart, rowCols, heatValues, heatDiag, parent, m_HeatLx);
+        if (hr == S_OK && bHasBoundary)
+        {
+            hr = Factor(rowStart, rowCols, dirichletValues, dirichletDiag, parent, m_DirichletHeatLx);
+        }
+        if (hr == S_OK)
+        {
+            hr = Factor(rowStart, rowCols, potentialValues, potentialDiag, parent, m_PotentialLx);
+        }
+        if (hr != S_OK)
+        {
+            Clear();
+            return hr;
+        }
+
+        for (size_t i = 0; i < m_FaceVerts.size(); ++i)
+        {
+            m_FaceVerts[i] = m_InvPerm[m_FaceVerts[i]];
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        Clear();
+        return E_OUTOFMEMORY;
+    }
+
+    return S_OK;
+}
+
+// Orders the vertices in [pdwBegin, pdwEnd): the range is split at the median of its longest extent,
+// the vertices of the upper half adjacent to the lower half go last and both halves are dissected in turn.
+// No fill can join the two halves, so it stays close to O(n log n) on a surface mesh.
+void CHeatGeodesic::Dissect(
+    const XMFLOAT3* pPositions,
+    const std::vector<size_t>& adjStart,
+    const std::vector<uint32_t>& adj,
+    std::vector<uint32_t>& tags,
+    uint32_t& dwTag,
+    uint32_t* pdwBegin,
+    uint32_t* pdwEnd)
+{
+    const size_t dwCount = size_t(pdwEnd - pdwBegin);
+    if (dwCount <= DISSECTION_LEAF_SIZE)
+    {
+        return;
+    }
+
+    float fMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float fMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (const uint32_t* pdw = pdwBegin; pdw < pdwEnd; ++pdw)
+    {
+        const float* pfPos = &pPositions[*pdw].x;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            fMin[i] = std::min(fMin[i], pfPos[i]);
+            fMax[i] = std::max(fMax[i], pfPos[i]);
+        }
+    }
+
+    size_t dwAxis = 0;
+    for (size_t i = 1; i < 3; ++i)
+    {
+        if (fMax[i] - fMin[i] > fMax[dwAxis] - fMin[dwAxis])
+        {
+            dwAxis = i;
+        }
+    }
+    uint32_t* pdwMiddle = pdwBegin + dwCount / 2;
+    std::nth_element(pdwBegin, pdwMiddle, pdwEnd,
+        [pPositions, dwAxis](uint32_t a, uint32_t b)
+        {
+            return (&pPositions[a].x)[dwAxis] < (&pPositions[b].x)[dwAxis];
+        });
+
+    ++dwTag;
+    for (const uint32_t* pdw = pdwBegin; pdw < pdwMiddle; ++pdw)
+    {
+        tags[*pdw] = dwTag;
+    }
+
+    uint32_t* pdwSeparator = std::partition(pdwMiddle, pdwEnd,
+        [&](uint32_t v)
+        {
+            for (size_t p = adjStart[v]; p < adjStart[v + 1]; ++p)
+            {
+                if (tags[adj[p]] == dwTag)
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+
+    Dissect(pPositions, adjStart, adj, tags, dwTag, pdwBegin, pdwMiddle);
+    Dissect(pPositions, adjStart, adj, tags, dwTag, pdwMiddle, pdwSeparator);
+}
+
+// Nonzero pattern of row k of L, in pattern[top, n) in an order that solves row k up-looking.
+// See [Dav06], section 4.1.
+size_t CHeatGeodesic::EliminationReach(
+    uint32_t k,
+    const std::vector<size_t>& rowStart,
+    const std::vector<uint32_t>& rowCols,
+    const std::vector<uint32_t>& parent,
+    std::vector<uint32_t>& flags,
+    std::vector<uint32_t>& pattern) const
+{
+    size_t top = m_dwVertexCount;
+    flags[k] = k;
+
+    for (size_t p = rowStart[k]; p < rowStart[k + 1]; ++p)
+    {
+        // walk up the tree to the first vertex already in the pattern, k is an ancestor of every column of row k
+        size_t len = 0;
+        for (uint32_t i = rowCols[p]; flags[i] != k; i = parent[i])
+        {
+            assert(parent[i] != NO_PARENT);
+            pattern[len++] = i;
+            flags[i] = k;
+        }
+
+        while (len > 0)
+        {
+            pattern[--top] = pattern[--len];
+        }
+    }
+
+    return top;
+}
+
+// Up-looking Cholesky factorization, row k of L is solved from the rows above it.
+// Returns S_FALSE if the system is not positive definite.
+HRESULT CHeatGeodesic::Factor(
+    const std::vector<size_t>& rowStart,
+    const std::vector<uint32_t>& rowCols,
+    const std::vector<double>& rowValues,
+    const std::vector<double>& diagonal,
+    const std::vector<uint32_t>& parent,
+    std::vector<double>& Lx)
+{
+    const size_t n = m_dwVertexCount;
+
+    std::vector<size_t> next(m_Lp.begin(), m_Lp.end() - 1);
+    std::vector<double> x(n, 0.0);
+    std::vector<uint32_t> flags(n, NO_PARENT);
+    std::vector<uint32_t> pattern(n);
+
+    Isochart::CIsochartCancelPoll cancel(m_pStats);
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        HRESULT hr = cancel.Poll();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        const size_t top = EliminationReach(uint32_t(k), rowStart, rowCols, parent, flags, pattern);
+        for (size_t p = rowStart[k]; p < rowStart[k + 1]; ++p)
+        {
+            x[rowCols[p]] = rowValues[p];
+        }
+
+        double d = diagonal[k];
+        for (size_t p = top; p < n; ++p)
+        {
+            const uint32_t i = pattern[p];
+            const double lki = x[i] / Lx[m_Lp[i]];
+            x[i] = 0;
+            for (size_t q = m_Lp[i] + 1; q < next[i]; ++q)
+            {
+                x[m_Li[q]] -= Lx[q] * lki;
+            }
+            d -= lki * lki;
+
+            const size_t q = next[i]++;
+            m_Li[q] = uint32_t(k);
+            Lx[q] = lki;
+        }
+
+        if (!(d > diagonal[k] * PIVOT_TOLERANCE))
+        {
+            return S_FALSE;
+        }
+
+        const size_t q = next[k]++;
+        m_Li[q] = uint32_t(k);
+        Lx[q] = sqrt(d);
+    }
+
+    return S_OK;
+}
+
+// pdX = (L L^T)^-1 pdX
+void CHeatGeodesic::Solve(const std::vector<double>& Lx, double* pdX) const
+{
+    const size_t n = m_dwVertexCount;
+
+    for (size_t j = 0; j < n; ++j)
+    {
+        const double xj = pdX[j] / Lx[m_Lp[j]];
+        pdX[j] = xj;
+        for (size_t p = m_Lp[j] + 1; p < m_Lp[j + 1]; ++p)
+        {
+            pdX[m_Li[p]] -= Lx[p] * xj;
+        }
+    }
+
+    for (size_t j = n; j-- > 0;)
+    {
+        double xj = pdX[j];
+        for (size_t p = m_Lp[j] + 1; p < m_Lp[j + 1]; ++p)
+        {
+            xj -= Lx[p] * pdX[m_Li[p]];
+        }
+        pdX[j] = xj / Lx[m_Lp[j]];
+    }
+}
+
+HRESULT CHeatGeodesic::Run(uint32_t dwSrcVertexIdx, Workspace& workspace, double* pdDistances) const
+{
+    if (!IsFactored())
+    {
+        return E_UNEXPECTED;
+    }
+    if (dwSrcVertexIdx >= m_dwVertexCount || !pdDistances)
+    {
+        return E_INVALIDARG;
+    }
+
+    const size_t n = m_dwVertexCount;
+    try
+    {
+        workspace.heat.assign(n, 0.0);
+        workspace.potential.assign(n, 0.0);
+        if (!m_DirichletHeatLx.empty())
+        {
+            workspace.dirichletHeat.assign(n, 0.0);
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    double* pdHeat = workspace.heat.data();
+    double* pdPotential = workspace.potential.data();
+
+    // 1. diffuse heat from the source, (M + tL) u = delta
+    pdHeat[m_InvPerm[dwSrcVertexIdx]] = 1;
+    Solve(m_HeatLx, pdHeat);
+
+    if (!m_DirichletHeatLx.empty())
+    {
+        double* pdDirichletHeat = workspace.dirichletHeat.data();
+        pdDirichletHeat[m_InvPerm[dwSrcVertexIdx]] = 1;
+        Solve(m_DirichletHeatLx, pdDirichletHeat);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            pdHeat[i] = 0.5 * (pdHeat[i] + pdDirichletHeat[i]);
+        }
+    }
+
+    // 2. the unit field X = -grad(u) / |grad(u)| of each face, integrated against the hat functions
+    for (size_t f = 0; f < m_FaceArea.size(); ++f)
+    {
+        if (m_FaceArea[f] == 0)
+        {
+            continue;
+        }
+
+        const uint32_t* pdwFace = m_FaceVerts.data() + f * 3;
+        const DVector3* pGrad = m_FaceGrad.data() + f * 3;
+
+        DVector3 grad;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            grad.x += pdHeat[pdwFace[i]] * pGrad[i].x;
+            grad.y += pdHeat[pdwFace[i]] * pGrad[i].y;
+            grad.z += pdHeat[pdwFace[i]] * pGrad[i].z;
+        }
+
+        const double dLength = grad.Length();
+        if (!(dLength > 0))
+        {
+            // the heat underflowed this far from the source
+            continue;
+        }
+
+        const double dScale = -m_FaceArea[f] / dLength;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            pdPotential[pdwFace[i]] += dScale * DVector3Dot(grad, pGrad[i]);
+        }
+    }
+
+    // 3. the potential whose gradient fits X best, L phi = div(X), shifted to be 0 at the source
+    pdPotential[n - 1] = 0;
+    Solve(m_PotentialLx, pdPotential);
+
+    const double dSrcPotential = pdPotential[m_InvPerm[dwSrcVertexIdx]];
+    for (size_t i = 0; i < n; ++i)
+    {
+        pdDistances[i] = std::max(0.0, pdPotential[m_InvPerm[i]] - dSrcPotential);
+    }
+
+    return S_OK;
+}
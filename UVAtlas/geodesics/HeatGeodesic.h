@@ -0,0 +1,118 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - HeatGeodesic.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "datatypes.h"
+#include "isochartstats.h"
+
+namespace GeodesicDist
+{
+    // Approximate geodesic distances by the heat method of [CWW13]:
+    // heat is diffused from the source for a short time t, the normalized
+    // negative gradient of the heat gives the direction of the distance
+    // field, and the distance is the potential best fitting that direction.
+    //
+    // Both linear systems, (M + tL) for the heat and L for the potential,
+    // depend only on the mesh, so Init factors them once and each source
+    // costs two pairs of triangular solves. L is the cotangent Laplacian,
+    // M the lumped mass matrix and t the squared mean edge length. On a mesh
+    // with boundary the heat is the mean of the Neumann and the Dirichlet
+    // solutions, which costs a third factor and solve. The heat step drops
+    // the positive off-diagonal weights of obtuse triangles so that the heat
+    // stays positive far from the source.
+    class CHeatGeodesic
+    {
+    public:
+        // buffers of one run, a thread keeps one for all the sources it computes
+        struct Workspace
+        {
+            std::vector<double> heat;
+            std::vector<double> dirichletHeat;
+            std::vector<double> potential;
+        };
+
+        CHeatGeodesic();
+
+        // optional statistics collector, polled for cancellation while the systems are factored
+        // and charged with the factors and the per face data for as long as they are held
+        void SetStats(Isochart::CIsochartStats* pStats)
+        {
+            m_pStats = pStats;
+            m_memory.SetStats(pStats);
+        }
+
+        // build and factor the systems of the mesh. Returns S_FALSE, and leaves the object
+        // unusable, if the factors would hold more than dwMaxFactorEntries entries, the memory
+        // budget of the statistics collector refuses them or the mesh is not one connected
+        // surface, which a one-to-all sweep handles instead
+        HRESULT Init(
+            const DirectX::XMFLOAT3* pPositions,
+            size_t dwVertexCount,
+            const uint32_t* pdwIndices,
+            size_t dwFaceCount,
+            size_t dwMaxFactorEntries);
+
+        bool IsFactored() const { return !m_Lp.empty(); }
+
+        // pdDistances receives the distance of each vertex to the source
+        HRESULT Run(uint32_t dwSrcVertexIdx, Workspace& workspace, double* pdDistances) const;
+
+    private:
+        void Clear();
+
+        void Dissect(
+            const DirectX::XMFLOAT3* pPositions,
+            const std::vector<size_t>& adjStart,
+            const std::vector<uint32_t>& adj,
+            std::vector<uint32_t>& tags,
+            uint32_t& dwTag,
+            uint32_t* pdwBegin,
+            uint32_t* pdwEnd);
+
+        HRESULT Factor(
+            const std::vector<size_t>& rowStart,
+            const std::vector<uint32_t>& rowCols,
+            const std::vector<double>& rowValues,
+            const std::vector<double>& diagonal,
+            const std::vector<uint32_t>& parent,
+            std::vector<double>& Lx);
+
+        size_t EliminationReach(
+            uint32_t k,
+            const std::vector<size_t>& rowStart,
+            const std::vector<uint32_t>& rowCols,
+            const std::vector<uint32_t>& parent,
+            std::vector<uint32_t>& flags,
+            std::vector<uint32_t>& pattern) const;
+
+        void Solve(const std::vector<double>& Lx, double* pdX) const;
+
+        size_t m_dwVertexCount;
+        Isochart::CIsochartStats* m_pStats;
+        Isochart::CIsochartMemoryCharge m_memory;
+
+        // vertex order of the factors, m_Perm[new] = old and m_InvPerm[old] = new
+        std::vector<uint32_t> m_Perm;
+        std::vector<uint32_t> m_InvPerm;
+
+        // lower triangular factors by columns, sharing one pattern, the diagonal is the first entry of a column.
+        // m_DirichletHeatLx is empty if the mesh has no boundary
+        std::vector<size_t> m_Lp;
+        std::vector<uint32_t> m_Li;
+        std::vector<double> m_HeatLx;
+        std::vector<double> m_DirichletHeatLx;
+        std::vector<double> m_PotentialLx;
+
+        // per face: the vertices in the factor order, the area and the gradients of the three hat functions
+        std::vector<uint32_t> m_FaceVerts;
+        std::vector<double> m_FaceArea;
+        std::vector<DVector3> m_FaceGrad;
+    };
+}
@@ -93,21 +93,20 @@ namespace GeodesicDist
     typedef std::vector<Face> TypeFaceList;
 
     // the windows heap, in each iteration, the window with minimal to-source-distance is popped off the heap and propagated
-    typedef CMinHeap<double, EdgeWindow> TypeEdgeWindowsHeap;
+    // the heap holds indices into the CEdgeWindowPool of the engine
+    typedef CMinHeap<double> TypeEdgeWindowsHeap;
 
     // one window on an edge (see the paper)
+    // the window refers to the mesh by indices only, so it is plain data that can be copied and pooled freely
     struct EdgeWindow
     {
         uint32_t dwTag;
 
         uint32_t dwEdgeIdx;                                 // which edge this window is on, this is the index in TypeEdgeList (following are in the similar pattern)
-        Edge* pEdge;                                       // pointer to that edge in TypeEdgeList
-
         uint32_t dwMarkFromEdgeVertexIdx;                   // b0 count from this edge vertex
-        Vertex* pMarkFromEdgeVertex;                       // pointer to that vertex
-
-        uint32_t dwPseuSrcVertexIdx;                        // the pseudo source vertex index
-        Vertex* pPseuSrcVertex;                            // pointer to that vertex
+        uint32_t dwPseuSrcVertexIdx;                        // the pseudo source vertex index (FLAG_INVALIDDWORD for a merged window)
+        uint32_t dwFaceIdxPropagatedFrom;                   // which face this window is propagated from, this is used to determine the next face the window will propagate to
+        uint32_t dwEdgeIdxPropagatedFrom;                   // the edge that contain the window that produced this window
 
         double b0, b1;                                     // b0, b1, d0, d1 of the window, see the paper
         double d0, d1;
@@ -115,49 +114,71 @@ namespace GeodesicDist
 
         double dPseuSrcToSrcDistance;                      // the distance from the pseudo source to the real source
 
-        uint32_t dwFaceIdxPropagatedFrom;                   // which face this window is propagated from, this is used to determine the next face the window will propagate to
-        Face* pFacePropagatedFrom;                         // pointer to that face
-
-        Edge* pEdgePropagatedFrom;                         // pointer to the edge that contain the window that produced this window
-
         double ksi;                                        // the accumulated error used in approximate algorithm
 
         EdgeWindow()
         {
             memset(this, 0, sizeof(EdgeWindow));
         }
-        EdgeWindow(const EdgeWindow& R)
+
+        // the weight of the window in the windows heap
+        double GetMinDistanceToSrc() const
         {
-            memcpy(this, &R, sizeof(EdgeWindow));
+            return std::min(d0, d1) + dPseuSrcToSrcDistance;
         }
-        // trick constructor
-        EdgeWindow(const uint32_t R)
+    };
+
+    // the storage of all the windows of one propagation
+    // the edges and the windows heap refer to a window by its index in the pool, and the slots of
+    // removed windows are handed out again, so windows are not allocated one by one
+    // Clear() keeps the storage, so an engine reuses it for every source vertex
+    class CEdgeWindowPool
+    {
+    public:
+        // may throw std::bad_alloc when the storage has to grow
+        uint32_t Add(const EdgeWindow& window)
         {
-            if (R == 0)
-                memset(this, 0, sizeof(EdgeWindow));
+            if (!m_FreeList.empty())
+            {
+                uint32_t dwIdx = m_FreeList.back();
+                m_FreeList.pop_back();
+                m_Windows[dwIdx] = window;
+                return dwIdx;
+            }
+
+            m_Windows.push_back(window);
+            return static_cast<uint32_t>(m_Windows.size() - 1);
         }
 
-        // setting an index also assigns appropriate pointer to the corresponding pointer field 
-        void SetEdgeIdx(TypeEdgeList& EdgeList, const uint32_t index)
+        void Remove(const uint32_t dwIdx)
         {
-            this->dwEdgeIdx = index;
-            this->pEdge = &(EdgeList[index]);
+            m_FreeList.push_back(dwIdx);
         }
-        void SetPseuSrcVertexIdx(TypeVertexList& VertexList, const uint32_t index)
+
+        void Clear()
+        {
+            m_Windows.clear();
+            m_FreeList.clear();
+        }
+
+        EdgeWindow& operator[](const uint32_t dwIdx)
         {
-            this->dwPseuSrcVertexIdx = index;
-            this->pPseuSrcVertex = (index < VertexList.size()) ? &(VertexList[index]) : nullptr;
+            return m_Windows[dwIdx];
         }
-        void SetMarkFromEdgeVertexIdx(TypeVertexList& VertexList, const uint32_t index)
+
+        const EdgeWindow& operator[](const uint32_t dwIdx) const
         {
-            this->dwMarkFromEdgeVertexIdx = index;
-            this->pMarkFromEdgeVertex = &(VertexList[index]);
+            return m_Windows[dwIdx];
         }
-        void SetFaceIdxPropagatedFrom(TypeFaceList& FaceList, const uint32_t index)
+
+        size_t GetCapacityBytes() const
         {
-            this->dwFaceIdxPropagatedFrom = index;
-            this->pFacePropagatedFrom = &(FaceList[index]);
+            return sizeof(EdgeWindow) * m_Windows.capacity() + sizeof(uint32_t) * m_FreeList.capacity();
         }
+
+    private:
+        std::vector<EdgeWindow> m_Windows;
+        std::vector<uint32_t> m_FreeList;
     };
 
     struct Edge
@@ -255,22 +276,10 @@ namespace GeodesicDist
             return ((!pAdjFace0) || (!pAdjFace1));
         }
 
-        struct WindowListElement
-        {
-            TypeEdgeWindowsHeap::item_type* pHeapItem;
-            EdgeWindow theWindow;
-
-            WindowListElement(const TypeEdgeWindowsHeap::item_type* heapItem, const EdgeWindow& win)
-            {
-                this->pHeapItem = const_cast<TypeEdgeWindowsHeap::item_type*>(heapItem);
-                this->theWindow = win;
-            }
-            WindowListElement() : pHeapItem(nullptr) { }
-        };
-
-        // on the edge, there is a windows list, which stores windows that has propagated onto this edge
-        // in addition, it also stores a reference to the same window in the windows heap, so we can modify the one stored in the heap (modification during window intersection)
-        std::vector<WindowListElement> WindowsList;
+        // on the edge, there is a windows list, which stores the pool indices of windows that has propagated onto this edge
+        // the windows heap refers to the same pool entries, so a window modified during window intersection is seen by both
+        std::vector<uint32_t> WindowsList;
+        uint32_t dwRunId;                                  // the run the windows list belongs to, the list is stale (and emptied on first use) in any other run
     };
 
     struct Face
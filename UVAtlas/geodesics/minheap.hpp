@@ -8,42 +8,169 @@
 //-------------------------------------------------------------------------------------
 
 #pragma once
-#include "maxheap.hpp"
 
-// the "wrapper" class that reverse the ">" and "<" comparison operations
-template <class _Ty1>
-class _ReverseComparison
+namespace GeodesicDist
 {
-public:
-    _ReverseComparison()
-    {
-        memset(&m_data, 0, sizeof(_Ty1));
-    }
-    _ReverseComparison(const _Ty1& R)
-    {
-        m_data = R;
-    }
+    const uint32_t NOT_IN_MIN_HEAP = uint32_t(-1);
 
-    _ReverseComparison& operator=(const _ReverseComparison& R)
-    {
-        m_data = R.m_data;
-        return *this;
-    }
-    bool operator>(const _ReverseComparison& R)
+    // CMinHeap is a binary min-heap of indices, such as the indices of windows
+    // in a CEdgeWindowPool.
+    // -The weight is stored next to the index in the heap array, so comparing
+    //  two nodes does not touch the data the indices refer to.
+    // -The position of each index is kept in a second array, so an index can be
+    //  removed from the middle of the heap without searching for it.
+    // -The heap grows with the largest index inserted and clear() keeps the
+    //  arrays, so one heap serves many propagations.
+    // -Nodes move exactly as they did in the CMaxHeap based heap this replaces,
+    //  so indices of equal weight still leave the heap in the same order.
+    template <class _Ty>
+    class CMinHeap
     {
-        return m_data < R.m_data;
-    }
-    bool operator<(const _ReverseComparison& R)
-    {
-        return m_data > R.m_data;
-    }
+    public:
+        typedef _Ty weight_type;
 
-private:
-    _Ty1 m_data;
-};
+        bool isInHeap(uint32_t dwIndex) const
+        {
+            return dwIndex < m_Position.size() && m_Position[dwIndex] != NOT_IN_MIN_HEAP;
+        }
 
-// the CMinHeap is actually a CMaxHeap, except the first template parameter is wrapped by _ReverseComparison
-template <class _Ty1, class _Ty2>
-class CMinHeap : public Isochart::CMaxHeap<_ReverseComparison<_Ty1>, _Ty2>
-{
-};
+        // may throw std::bad_alloc when the arrays have to grow
+        void insert(uint32_t dwIndex, weight_type weight)
+        {
+            if (dwIndex >= m_Position.size())
+            {
+                m_Position.resize(size_t(dwIndex) + 1, NOT_IN_MIN_HEAP);
+            }
+            assert(m_Position[dwIndex] == NOT_IN_MIN_HEAP);
+
+            m_Nodes.push_back(Node{ weight, dwIndex });
+            m_Position[dwIndex] = static_cast<uint32_t>(m_Nodes.size() - 1);
+            upheap(m_Nodes.size() - 1);
+        }
+
+        uint32_t cutTop()
+        {
+            assert(!m_Nodes.empty());
+            uint32_t dwIndex = m_Nodes[0].dwIndex;
+            removeAt(0);
+            return dwIndex;
+        }
+
+        void remove(uint32_t dwIndex)
+        {
+            assert(isInHeap(dwIndex));
+            removeAt(m_Position[dwIndex]);
+        }
+
+        void clear()
+        {
+            for (size_t i = 0; i < m_Nodes.size(); ++i)
+            {
+                m_Position[m_Nodes[i].dwIndex] = NOT_IN_MIN_HEAP;
+            }
+            m_Nodes.clear();
+        }
+
+        size_t size() const
+        {
+            return m_Nodes.size();
+        }
+
+        bool empty() const
+        {
+            return m_Nodes.empty();
+        }
+
+        size_t GetCapacityBytes() const
+        {
+            return sizeof(Node) * m_Nodes.capacity() + sizeof(uint32_t) * m_Position.capacity();
+        }
+
+    private:
+        struct Node
+        {
+            weight_type weight;
+            uint32_t dwIndex;
+        };
+
+        void swapnode(size_t i, size_t j)
+        {
+            if (i == j)
+                return;
+
+            std::swap(m_Nodes[i], m_Nodes[j]);
+            m_Position[m_Nodes[i].dwIndex] = static_cast<uint32_t>(i);
+            m_Position[m_Nodes[j].dwIndex] = static_cast<uint32_t>(j);
+        }
+
+        void removeAt(size_t i)
+        {
+            size_t last = m_Nodes.size() - 1;
+            swapnode(i, last);
+
+            weight_type removedWeight = m_Nodes[last].weight;
+            m_Position[m_Nodes[last].dwIndex] = NOT_IN_MIN_HEAP;
+            m_Nodes.pop_back();
+
+            if (i < m_Nodes.size())
+            {
+                if (removedWeight < m_Nodes[i].weight)
+                {
+                    downheap(i);
+                }
+                else
+                {
+                    upheap(i);
+                }
+            }
+        }
+
+        void downheap(size_t i)
+        {
+            const size_t size = m_Nodes.size();
+            for (;;)
+            {
+                size_t smaller = i;
+                size_t left = (i << 1) + 1;
+                size_t right = (i << 1) + 2;
+
+                weight_type minweight = m_Nodes[i].weight;
+
+                if (left < size && m_Nodes[left].weight < minweight)
+                {
+                    smaller = left;
+                    minweight = m_Nodes[left].weight;
+                }
+                if (right < size && m_Nodes[right].weight < minweight)
+                {
+                    smaller = right;
+                }
+
+                if (smaller == i)
+                {
+                    break;
+                }
+                swapnode(i, smaller);
+                i = smaller;
+            }
+        }
+
+        void upheap(size_t i)
+        {
+            while (i > 0)
+            {
+                size_t parent = (i - 1) >> 1;
+                if (!(m_Nodes[i].weight < m_Nodes[parent].weight))
+                {
+                    break;
+                }
+                swapnode(i, parent);
+                i = parent;
+            }
+        }
+
+    private:
+        std::vector<Node> m_Nodes;
+        std::vector<uint32_t> m_Position;
+    };
+}
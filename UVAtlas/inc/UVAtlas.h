@@ -25,9 +25,13 @@
 #include <wsl/winadapter.h>
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <DirectXMath.h>
@@ -59,6 +63,12 @@ namespace DirectX
     // UVATLAS_DEFAULT - Meshes with more than 25k faces go through fast, meshes with fewer than 25k faces go through quality
     // UVATLAS_GEODESIC_FAST - Uses approximations to improve charting speed at the cost of added stretch or more charts.
     // UVATLAS_GEODESIC_QUALITY - Provides better quality charts, but requires more time and memory than fast.
+    // UVATLAS_GEODESIC_HEAT - Uses the heat method, which factors a sparse system per chart, for smooth geodesic distances.
+    //     Up to about 10k faces it costs a little more than fast and much less than quality. On larger meshes it can take
+    //     two to three times as long as fast. It smooths out fine noise, so noisy surfaces can get many more charts and
+    //     more stretch than with fast. Charts it cannot handle, and meshes with IMT, use the fast approach.
+    // UVATLAS_INDEPENDENT_COMPONENTS - Partitions each connected component of the mesh as an independent job, in parallel,
+    //     with its own stretch criterion and merge pass. All charts still go to one atlas. Ignored when maxChartNumber is not 0.
     enum UVATLAS : unsigned int
     {
         UVATLAS_DEFAULT = 0x00,
@@ -66,10 +76,183 @@ namespace DirectX
         UVATLAS_GEODESIC_QUALITY = 0x02,
         UVATLAS_LIMIT_MERGE_STRETCH = 0x04,
         UVATLAS_LIMIT_FACE_STRETCH = 0x08,
+        UVATLAS_INDEPENDENT_COMPONENTS = 0x10,
+        UVATLAS_GEODESIC_HEAT = 0x20,
     };
 
     static const float UVATLAS_DEFAULT_CALLBACK_FREQUENCY = 0.0001f;
 
+    // Wall-clock time in seconds and number of invocations of one processing stage.
+    // peakBytes is the largest tracked memory total seen while the stage ran, and
+    // currentBytes the total still held when it last finished.
+    struct UVAtlasStageStats
+    {
+        double seconds;
+        size_t calls;
+        size_t currentBytes;
+        size_t peakBytes;
+    };
+
+    // Tracked memory of one kind of working data, in bytes
+    struct UVAtlasMemoryStats
+    {
+        size_t currentBytes;
+        size_t peakBytes;
+    };
+
+    // Begin or end of one unit of per-chart work, recorded only when requested
+    // through UVAtlasStats::traceEvents.
+    //
+    //  name      - Sub-step being traced, e.g. "Partition" or "OptimizeChartL2Stretch".
+    //              Points to a static string.
+    //  timestamp - Seconds since the start of the UVAtlas call.
+    //  threadId  - Id of the thread that did the work, the same for all events
+    //              of one thread for the lifetime of the process.
+    //  faceCount - Number of faces of the chart(s) being processed.
+    //  begin     - true for the start of the sub-step, false for its end.
+    struct UVAtlasTraceEvent
+    {
+        const char* name;
+        double timestamp;
+        uint32_t threadId;
+        size_t faceCount;
+        bool begin;
+    };
+
+    // Optional statistics reported by UVAtlasCreate, UVAtlasPartition and UVAtlasPack.
+    // All members except traceEvents and memoryBudget are reset at the start of
+    // each call.
+    //
+    //  rootChartBuild     - Building the root chart and separating the initial charts.
+    //  parameterizeCharts - Recursive partitioning and parameterization of the chart heap.
+    //  optimizeStretch    - L2 squared stretch optimization over all charts.
+    //  mergeCharts        - Merging of small charts.
+    //                       With UVATLAS_INDEPENDENT_COMPONENTS, optimizeStretch and mergeCharts
+    //                       sum the time of all components, which run in parallel, and are
+    //                       also part of the wall-clock time of parameterizeCharts.
+    //  packCharts         - Packing the charts into the atlas.
+    //  vertexRemap        - Computing the output vertex remap after partitioning.
+    //  chartsCreated      - Number of charts created, including intermediate charts.
+    //  bipartitions       - Number of chart bipartitions attempted.
+    //  geodesicSources    - Number of single-source geodesic distance solves.
+    //  repackIterations   - Number of iterations used by the atlas packer.
+    //  atlasUtilization   - Ratio of the packed chart area to the atlas area.
+    //  traceEvents        - Optional, set by the caller. If not nullptr, begin/end
+    //                       events of the per-chart work are appended to this vector.
+    //                       Tracing adds a lock per event, so leave it nullptr when
+    //                       only the timings are needed.
+    //  geodesicDistanceMemory - Landmark to vertex geodesic distance arrays and matrices.
+    //  vertexAdjacencyMemory  - Per-vertex adjacency lists of all live charts.
+    //  isomapMemory           - Dense Isomap matrices, eigen buffers and embeddings.
+    //  geodesicWindowMemory   - Exact geodesic engine topology and edge window lists.
+    //  totalMemory            - Sum of the above. std::vector growth is measured by
+    //                           capacity once each structure is built, the other
+    //                           buffers are charged before they are allocated.
+    //  memoryBudget       - Optional, set by the caller. If not 0, any tracked
+    //                       allocation that would push totalMemory.currentBytes
+    //                       above this many bytes fails the call with E_OUTOFMEMORY.
+    struct UVAtlasStats
+    {
+        UVAtlasStageStats rootChartBuild;
+        UVAtlasStageStats parameterizeCharts;
+        UVAtlasStageStats optimizeStretch;
+        UVAtlasStageStats mergeCharts;
+        UVAtlasStageStats packCharts;
+        UVAtlasStageStats vertexRemap;
+        size_t chartsCreated;
+        size_t bipartitions;
+        size_t geodesicSources;
+        size_t repackIterations;
+        double atlasUtilization;
+        std::vector<UVAtlasTraceEvent>* traceEvents = nullptr;
+        UVAtlasMemoryStats geodesicDistanceMemory;
+        UVAtlasMemoryStats vertexAdjacencyMemory;
+        UVAtlasMemoryStats isomapMemory;
+        UVAtlasMemoryStats geodesicWindowMemory;
+        UVAtlasMemoryStats totalMemory;
+        size_t memoryBudget = 0;
+    };
+
+    // Optional cooperative cancellation of UVAtlasCreate, UVAtlasPartition and
+    // UVAtlasPack. It is polled every few hundred iterations of the long running
+    // loops, including inside the geodesic distance solver, the eigen solver and
+    // the packer, so a call stops within milliseconds of being cancelled.
+    //
+    //  cancel   - Optional. If not nullptr, storing true to it from any thread
+    //             makes the call return E_ABORT.
+    //  deadline - Optional. If not zero (the default value), the call returns
+    //             HRESULT_FROM_WIN32(ERROR_TIMEOUT) once std::chrono::steady_clock
+    //             passes it.
+    struct UVAtlasCancellation
+    {
+        const std::atomic<bool>* cancel = nullptr;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // One mesh of UVAtlasCreateBatch. The inputs have the meaning of the
+    // UVAtlasCreate parameters with the same names, the outputs are filled in
+    // by UVAtlasCreateBatch.
+    struct UVAtlasBatchMesh
+    {
+        // Inputs
+        const XMFLOAT3*             positions;
+        size_t                      nVerts;
+        const void*                 indices;
+        DXGI_FORMAT                 indexFormat;
+        size_t                      nFaces;
+        size_t                      maxChartNumber;
+        float                       maxStretch;
+        size_t                      width;
+        size_t                      height;
+        float                       gutter;
+        const uint32_t*             adjacency;
+        const uint32_t*             falseEdgeAdjacency;     // Optional
+        const float*                pIMTArray;              // Optional
+        UVATLAS                     options;
+        UVAtlasStats*               statsOut;               // Optional
+
+        // Outputs
+        HRESULT                     hr;
+        std::vector<UVAtlasVertex>  vMeshOutVertexBuffer;
+        std::vector<uint8_t>        vMeshOutIndexBuffer;
+        std::vector<uint32_t>       vFacePartitioning;
+        std::vector<uint32_t>       vVertexRemapArray;
+        float                       maxStretchOut;
+        size_t                      numChartsOut;
+    };
+
+    // Optional context for UVAtlasCreate and UVAtlasPartition that keeps their
+    // internal buffers between calls. A process unwrapping many meshes can pass
+    // the same context to each call, so the buffers of one call are reused by
+    // the next one instead of being freed and allocated again. It may be used by
+    // calls on several threads at once, and must outlive them.
+    class UVAtlasContext
+    {
+    public:
+        UVAtlasContext() noexcept(false);
+        ~UVAtlasContext();
+
+        UVAtlasContext(UVAtlasContext&&) noexcept;
+        UVAtlasContext& operator=(UVAtlasContext&&) noexcept;
+
+        UVAtlasContext(UVAtlasContext const&) = delete;
+        UVAtlasContext& operator=(UVAtlasContext const&) = delete;
+
+        // Frees the retained buffers. No call may be using the context.
+        void __cdecl Reset() noexcept;
+
+        // Bytes retained for reuse by later calls
+        size_t __cdecl GetRetainedBytes() const noexcept;
+
+        // Internal state, only used by the UVAtlas implementation
+        class Impl;
+
+        Impl* __cdecl GetImpl() const noexcept { return pImpl.get(); }
+
+    private:
+        std::unique_ptr<Impl> pImpl;
+    };
+
     //============================================================================
     //
     // UVAtlas apis
@@ -135,6 +318,10 @@ namespace DirectX
     //  numChartsOut - A location to store the number of charts created, or if the
     //                 maximum number of charts was too low, this gives the minimum
     //                 number of charts needed to create an atlas.
+    //  statsOut - A location to store per-stage timings and counters, see UVAtlasStats.
+    //  cancellation - A cancellation flag and deadline polled while the call runs,
+    //                 see UVAtlasCancellation.
+    //  context - Keeps internal buffers for reuse by later calls, see UVAtlasContext.
 
     HRESULT __cdecl UVAtlasCreate(
         _In_reads_(nVerts)                  const XMFLOAT3* positions,
@@ -159,7 +346,33 @@ namespace DirectX
         _Inout_opt_ std::vector<uint32_t>* pvFacePartitioning = nullptr,
         _Inout_opt_ std::vector<uint32_t>* pvVertexRemapArray = nullptr,
         _Out_opt_                           float* maxStretchOut = nullptr,
-        _Out_opt_                           size_t* numChartsOut = nullptr);
+        _Out_opt_                           size_t* numChartsOut = nullptr,
+        _Out_opt_                           UVAtlasStats* statsOut = nullptr,
+        _In_opt_                            const UVAtlasCancellation* cancellation = nullptr,
+        _Inout_opt_                         UVAtlasContext* context = nullptr);
+
+    // This function runs UVAtlasCreate on many meshes at once, each with its own
+    // result in its UVAtlasBatchMesh. A small mesh gives too little work to
+    // fill the cores on its own, so meshes are spread over the threads one per
+    // thread. Meshes big enough to keep all threads busy are done first, one at a
+    // time.
+    //
+    // Returns S_OK if every mesh succeeded. Otherwise returns the failure of
+    // statusCallBack or cancellation, which also stops the meshes not started
+    // yet, or else the first failed mesh in the order given.
+    //
+    //  statusCallBack - Called with the fraction of all faces of the batch in
+    //                   meshes that are done. It is only called on the thread
+    //                   that called UVAtlasCreateBatch, which reports the meshes
+    //                   finished by the other threads after each mesh of its own.
+    //  callbackFrequency - How much that fraction changes between two callbacks.
+    //  cancellation - Applies to the whole batch, see UVAtlasCancellation.
+    HRESULT __cdecl UVAtlasCreateBatch(
+        _Inout_updates_(nMeshes)    UVAtlasBatchMesh* meshes,
+        _In_                        size_t nMeshes,
+        _In_opt_                    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+        _In_                        float callbackFrequency,
+        _In_opt_                    const UVAtlasCancellation* cancellation = nullptr);
 
     // This has the same exact arguments as Create, except that it does not perform the
     // final packing step. This method allows one to get a partitioning out, and possibly
@@ -206,7 +419,58 @@ namespace DirectX
         _Inout_opt_                 std::vector<uint32_t>* pvVertexRemapArray,
         _Inout_                     std::vector<uint32_t>& vPartitionResultAdjacency,
         _Out_opt_                   float* maxStretchOut = nullptr,
-        _Out_opt_                   size_t* numChartsOut = nullptr);
+        _Out_opt_                   size_t* numChartsOut = nullptr,
+        _Out_opt_                   UVAtlasStats* statsOut = nullptr,
+        _In_opt_                    const UVAtlasCancellation* cancellation = nullptr,
+        _Inout_opt_                 UVAtlasContext* context = nullptr);
+
+    // This partitions a mesh too large to be partitioned at once, and has the same
+    // outputs as Partition with a maxChartNumber of 0. The faces are split into
+    // segments of at most maxSegmentFaces faces: small connected components are
+    // grouped, bigger ones are halved along their longest axis. Faces joined by a
+    // false edge stay in the same segment. Each segment is partitioned on its own,
+    // so the working set of the partitioner is bounded by the segment size rather
+    // than the mesh size. The result of each segment is written to a temporary
+    // file and read back at the end to build the outputs; the input arrays and
+    // the outputs for the whole mesh are still held in memory.
+    //
+    // Charts never cross a segment border. Each segment is partitioned as a mesh
+    // of its own, in which the border edges have no neighbor, so they are chart
+    // boundaries on both sides, like the edges between two charts. A split hint
+    // only tells which edges of one mesh may be cut and cannot carry a border
+    // between two separately partitioned meshes, so none is used. The outputs
+    // are meant to be passed to Pack. maxStretchOut is the largest stretch of
+    // any segment.
+    //
+    //  maxSegmentFaces - The maximum number of faces in one segment. A set of
+    //                    faces joined by false edges larger than this is still
+    //                    kept in one segment.
+
+    HRESULT __cdecl UVAtlasPartitionSegmented(
+        _In_reads_(nVerts)          const XMFLOAT3* positions,
+        _In_                        size_t nVerts,
+        _When_(indexFormat == DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces * 3 * sizeof(uint16_t)))
+        _When_(indexFormat != DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces * 3 * sizeof(uint32_t))) const void* indices,
+        _In_                        DXGI_FORMAT indexFormat,
+        _In_                        size_t nFaces,
+        _In_                        size_t maxSegmentFaces,
+        _In_                        float maxStretch,
+        _In_reads_(nFaces * 3)        const uint32_t* adjacency,
+        _In_reads_opt_(nFaces * 3)    const uint32_t* falseEdgeAdjacency,
+        _In_reads_opt_(nFaces * 3)    const float* pIMTArray,
+        _In_opt_ std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+        _In_                        float callbackFrequency,
+        _In_                        UVATLAS options,
+        _Inout_                     std::vector<UVAtlasVertex>& vMeshOutVertexBuffer,
+        _Inout_                     std::vector<uint8_t>& vMeshOutIndexBuffer,
+        _Inout_opt_                 std::vector<uint32_t>* pvFacePartitioning,
+        _Inout_opt_                 std::vector<uint32_t>* pvVertexRemapArray,
+        _Inout_                     std::vector<uint32_t>& vPartitionResultAdjacency,
+        _Out_opt_                   float* maxStretchOut = nullptr,
+        _Out_opt_                   size_t* numChartsOut = nullptr,
+        _Out_opt_                   UVAtlasStats* statsOut = nullptr,
+        _In_opt_                    const UVAtlasCancellation* cancellation = nullptr,
+        _Inout_opt_                 UVAtlasContext* context = nullptr);
 
     // This takes the face partitioning result from Partition and packs it into an
     // atlas of the given size. pPartitionResultAdjacency should be derived from
@@ -220,7 +484,9 @@ namespace DirectX
         _In_                    float gutter,
         _In_                    const std::vector<uint32_t>& vPartitionResultAdjacency,
         _In_opt_                std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-        _In_                    float callbackFrequency);
+        _In_                    float callbackFrequency,
+        _Out_opt_               UVAtlasStats* statsOut = nullptr,
+        _In_opt_                const UVAtlasCancellation* cancellation = nullptr);
 
 
     //============================================================================
@@ -361,6 +627,14 @@ namespace DirectX
         _In_reads_(nNewVerts)                   const uint32_t* vertexRemap,
         _Out_writes_bytes_(nNewVerts* stride)   void* vbout) noexcept;
 
+    // Formats trace events collected through UVAtlasStats::traceEvents as Chrome
+    // trace-event JSON, which can be loaded in chrome://tracing or Perfetto to
+    // see how the chart work was scheduled across threads.
+    HRESULT __cdecl UVAtlasFormatChromeTrace(
+        _In_reads_(nEvents)                     const UVAtlasTraceEvent* events,
+        _In_                                    size_t nEvents,
+        _Inout_                                 std::string& json);
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-dynamic-exception-spec"
@@ -0,0 +1,174 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - indexedheap.hpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace Isochart
+{
+    const uint32_t NOT_IN_INDEXED_HEAP = 0xffffffff;
+    const size_t INDEXED_HEAP_ARITY = 4;
+
+    // CIndexedMinHeap is a min-priority queue of the indices 0..n-1, ordered by
+    // a float array owned by the caller, as Dijkstra's algorithm keeps its
+    // distances.
+    // -The heap and the position of each index are two flat arrays, so there
+    //  are no heap items to allocate and no pointers to follow.
+    // -Each node has 4 children, which halves the depth of a binary heap, and
+    //  the children are next to each other in memory.
+    // -reset() keeps the arrays when they are large enough, so one heap serves
+    //  many searches.
+    // -A key may only decrease while its index is in the heap. Call decrease()
+    //  after lowering it.
+    template <class _Ty>
+    class CIndexedMinHeap
+    {
+    public:
+        typedef _Ty weight_type;
+
+        CIndexedMinHeap() :
+            m_pKeys(nullptr),
+            m_dwCapacity(0),
+            m_dwSize(0)
+        {
+        }
+
+        CIndexedMinHeap(CIndexedMinHeap const&) = delete;
+        CIndexedMinHeap& operator=(CIndexedMinHeap const&) = delete;
+
+        bool reset(size_t dwIndexCount, const weight_type* pKeys)
+        {
+            if (m_dwCapacity < dwIndexCount)
+            {
+                m_pHeap.reset(new (std::nothrow) uint32_t[dwIndexCount]);
+                m_pPosition.reset(new (std::nothrow) uint32_t[dwIndexCount]);
+                if (!m_pHeap || !m_pPosition)
+                {
+                    m_pHeap.reset();
+                    m_pPosition.reset();
+                    m_dwCapacity = 0;
+                    return false;
+                }
+                m_dwCapacity = dwIndexCount;
+            }
+
+            std::fill_n(m_pPosition.get(), dwIndexCount, NOT_IN_INDEXED_HEAP);
+            m_pKeys = pKeys;
+            m_dwSize = 0;
+            return true;
+        }
+
+        bool isInHeap(uint32_t dwIndex) const
+        {
+            return m_pPosition[dwIndex] != NOT_IN_INDEXED_HEAP;
+        }
+
+        void insert(uint32_t dwIndex)
+        {
+            assert(!isInHeap(dwIndex) && m_dwSize < m_dwCapacity);
+            upheap(m_dwSize++, dwIndex);
+        }
+
+        void decrease(uint32_t dwIndex)
+        {
+            assert(isInHeap(dwIndex));
+            upheap(m_pPosition[dwIndex], dwIndex);
+        }
+
+        bool cutTop(uint32_t& dwIndex)
+        {
+            if (m_dwSize == 0)
+            {
+                return false;
+            }
+
+            dwIndex = m_pHeap[0];
+            m_pPosition[dwIndex] = NOT_IN_INDEXED_HEAP;
+            if (--m_dwSize > 0)
+            {
+                downheap(0, m_pHeap[m_dwSize]);
+            }
+            return true;
+        }
+
+        size_t size() const
+        {
+            return m_dwSize;
+        }
+
+        bool empty() const
+        {
+            return (m_dwSize == 0);
+        }
+
+    private:
+        void place(size_t dwPos, uint32_t dwIndex)
+        {
+            m_pHeap[dwPos] = dwIndex;
+            m_pPosition[dwIndex] = static_cast<uint32_t>(dwPos);
+        }
+
+        // Moves the hole at dwPos up until dwIndex fits into it
+        void upheap(size_t dwPos, uint32_t dwIndex)
+        {
+            weight_type key = m_pKeys[dwIndex];
+            while (dwPos > 0)
+            {
+                size_t dwParent = (dwPos - 1) / INDEXED_HEAP_ARITY;
+                if (!(key < m_pKeys[m_pHeap[dwParent]]))
+                {
+                    break;
+                }
+                place(dwPos, m_pHeap[dwParent]);
+                dwPos = dwParent;
+            }
+            place(dwPos, dwIndex);
+        }
+
+        // Moves the hole at dwPos down until dwIndex fits into it
+        void downheap(size_t dwPos, uint32_t dwIndex)
+        {
+            weight_type key = m_pKeys[dwIndex];
+            for (;;)
+            {
+                size_t dwChild = dwPos * INDEXED_HEAP_ARITY + 1;
+                if (dwChild >= m_dwSize)
+                {
+                    break;
+                }
+
+                size_t dwEnd = std::min(dwChild + INDEXED_HEAP_ARITY, m_dwSize);
+                size_t dwSmallest = dwChild;
+                weight_type smallestKey = m_pKeys[m_pHeap[dwChild]];
+                for (size_t i = dwChild + 1; i < dwEnd; i++)
+                {
+                    if (m_pKeys[m_pHeap[i]] < smallestKey)
+                    {
+                        dwSmallest = i;
+                        smallestKey = m_pKeys[m_pHeap[i]];
+                    }
+                }
+
+                if (!(smallestKey < key))
+                {
+                    break;
+                }
+                place(dwPos, m_pHeap[dwSmallest]);
+                dwPos = dwSmallest;
+            }
+            place(dwPos, dwIndex);
+        }
+
+    private:
+        std::unique_ptr<uint32_t[]> m_pHeap;
+        std::unique_ptr<uint32_t[]> m_pPosition;
+        const weight_type* m_pKeys;
+        size_t m_dwCapacity;
+        size_t m_dwSize;
+    };
+}
@@ -15,6 +15,8 @@
 
 #pragma once
 
+#include "isochartstats.h"
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdouble-promotion"
@@ -71,6 +73,8 @@ namespace Isochart
         }
 
     public:
+        // Returns false if out of memory, or if pStats was cancelled, which
+        // is polled once per O(n) step.
         _Success_(return)
             static bool
             GetEigen(
@@ -79,7 +83,8 @@ namespace Isochart
                 _Out_writes_(dwMaxRange) value_type* pEigenValue,
                 _Out_writes_(dwDimension* dwMaxRange) value_type* pEigenVector,
                 size_t dwMaxRange,
-                value_type epsilon = 1.0e-6f)
+                value_type epsilon = 1.0e-6f,
+                CIsochartStats* pStats = nullptr)
         {
             // 1. check argument
             if (!pMatrix || !pEigenValue || !pEigenVector)
@@ -108,6 +113,8 @@ namespace Isochart
 
             value_type** pRowHeader = rowHeader.get();
 
+            CIsochartCancelPoll cancel(pStats);
+
             VectorZero(pSubDiagVec, dwDimension);
             VectorAssign(pInitialMatrix, pMatrix, dwDimension * dwDimension);
 
@@ -123,6 +130,9 @@ namespace Isochart
 
             for (size_t i = dwDimension - 1; i > 0; i--)
             {
+                if (FAILED(cancel.Poll()))
+                    return false;
+
                 value_type total = 0;
                 value_type h = 0;
                 for (size_t j = 0; j < i; j++)
@@ -159,6 +169,9 @@ namespace Isochart
                     // compute p = A * u / H, Used property of symmetric Matrix
                     for (size_t j = 0; j < i; j++)
                     {
+                        if (FAILED(cancel.Poll()))
+                            return false;
+
                         pRowHeader[j][i] = pU[j];
                         pP[j] += pRowHeader[j][j] * pU[j];
                         for (size_t k = 0; k < j; k++)
@@ -219,6 +232,9 @@ namespace Isochart
             //= Q - (u/H) * (u' * Q); ( n*n +n multiplication )
             for (size_t i = 0; i < dwDimension - 1; i++)
             {
+                if (FAILED(cancel.Poll()))
+                    return false;
+
                 pEigenValue[i] = pRowHeader[i][i];
                 pRowHeader[i][i] = 1.0;
 
@@ -229,6 +245,9 @@ namespace Isochart
                     //Q - (u/H) * (u' * Q); ( n*n +n multiplication )
                     for (size_t j = 0; j < currentDim; j++)
                     {
+                        if (FAILED(cancel.Poll()))
+                            return false;
+
                         value_type delta = 0.0;
 
                         for (size_t k = 0; k < currentDim; k++)
@@ -279,6 +298,9 @@ namespace Isochart
                 // Iteration to zero the  subdiagal item e[j]
                 for (;;)
                 {
+                    if (FAILED(cancel.Poll()))
+                        return false;
+
                     size_t n;
                     for (n = j; n < dwDimension; n++)
                     {
@@ -385,6 +407,9 @@ namespace Isochart
                             size_t  next;
                             for (size_t k = n - 1; k > j; k--)
                             {
+                                if (FAILED(cancel.Poll()))
+                                    return false;
+
                                 next = k - 1;
                                 pSubDiagVec[next] = value_type(lastC * pSubDiagVec[next]);
                                 tt = value_type(IsochartSqrt(lastpq * lastpq + extra * extra));
@@ -10,13 +10,26 @@
 #include "pch.h"
 #include "UVAtlas.h"
 #include "isochart.h"
+#include "isochartstats.h"
+#include "bufferpool.h"
 #include "UVAtlasRepacker.h"
 
 #include <cstdarg>
+#include <cstdio>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace Isochart;
 using namespace DirectX;
 
+class DirectX::UVAtlasContext::Impl
+{
+public:
+    CIsochartBufferPool pool;
+};
+
 namespace
 {
     template<typename IndexType>
@@ -240,6 +253,32 @@ namespace
     }
 
 
+    //---------------------------------------------------------------------------------
+    // Applies the caller's inputs to stats. Returns the collector to pass down, or
+    // nullptr if neither statistics nor cancellation were requested.
+    CIsochartStats* InitStats(
+        CIsochartStats& stats,
+        _In_opt_ const UVAtlasStats* statsOut,
+        _In_opt_ const UVAtlasCancellation* cancellation)
+    {
+        if (statsOut)
+        {
+            if (statsOut->traceEvents)
+            {
+                stats.EnableTrace();
+            }
+            stats.SetMemoryBudget(statsOut->memoryBudget);
+        }
+
+        if (cancellation)
+        {
+            stats.SetCancellation(*cancellation);
+        }
+
+        return (statsOut || cancellation) ? &stats : nullptr;
+    }
+
+
     //---------------------------------------------------------------------------------
     HRESULT UVAtlasPartitionInt(
         _In_reads_(nVerts)          const XMFLOAT3* positions,
@@ -263,7 +302,9 @@ namespace
         _Inout_                     std::vector<uint32_t>& vPartitionResultAdjacency,
         _Out_opt_                   float* maxStretchOut,
         _Out_opt_                   size_t* numChartsOut,
-        _In_                        unsigned int uStageInfo)
+        _In_                        unsigned int uStageInfo,
+        _In_opt_                    CIsochartStats* pStats,
+        _In_opt_                    CIsochartBufferPool* pBufferPool)
     {
         if (!positions || !nVerts || !indices || !nFaces)
             return E_INVALIDARG;
@@ -354,7 +395,9 @@ namespace
             statusCallBack,
             callbackFrequency,
             falseEdgeAdjacency,
-            options);
+            options,
+            pStats,
+            pBufferPool);
         if (FAILED(hr))
             return hr;
 
@@ -373,15 +416,18 @@ namespace
 
         std::unique_ptr<uint32_t[]> forwardRemapArray;
         size_t outMeshNumVertices = 0;
-        if (DXGI_FORMAT_R16_UINT == indexFormat)
         {
-            hr = UVAtlasGetRealVertexRemap<uint16_t>(nFaces, nVerts, reinterpret_cast<const uint16_t*>(indices), reinterpret_cast<uint16_t*>(vOutIndexBuffer.data()),
-                &outMeshNumVertices, vOutVertexRemapArray, forwardRemapArray);
-        }
-        else
-        {
-            hr = UVAtlasGetRealVertexRemap<uint32_t>(nFaces, nVerts, reinterpret_cast<const uint32_t*>(indices), reinterpret_cast<uint32_t*>(vOutIndexBuffer.data()),
-                &outMeshNumVertices, vOutVertexRemapArray, forwardRemapArray);
+            CIsochartStatsTimer timer(pStats, ISOCHART_STATS_VERTEX_REMAP);
+            if (DXGI_FORMAT_R16_UINT == indexFormat)
+            {
+                hr = UVAtlasGetRealVertexRemap<uint16_t>(nFaces, nVerts, reinterpret_cast<const uint16_t*>(indices), reinterpret_cast<uint16_t*>(vOutIndexBuffer.data()),
+                    &outMeshNumVertices, vOutVertexRemapArray, forwardRemapArray);
+            }
+            else
+            {
+                hr = UVAtlasGetRealVertexRemap<uint32_t>(nFaces, nVerts, reinterpret_cast<const uint32_t*>(indices), reinterpret_cast<uint32_t*>(vOutIndexBuffer.data()),
+                    &outMeshNumVertices, vOutVertexRemapArray, forwardRemapArray);
+            }
         }
         if (FAILED(hr))
             return hr;
@@ -464,7 +510,8 @@ namespace
         _In_                    const std::vector<uint32_t>& vPartitionResultAdjacency,
         _In_opt_                LPISOCHARTCALLBACK statusCallback,
         float                   callbackFrequency,
-        _In_                    unsigned int uStageInfo)
+        _In_                    unsigned int uStageInfo,
+        _In_opt_                CIsochartStats* pStats)
     {
         if (!width || !height)
             return E_INVALIDARG;
@@ -516,55 +563,927 @@ namespace
         std::vector<UVAtlasVertex> vTempVertexBuffer;
         try
         {
-            vTempIndexBuffer.resize(vMeshIndexBuffer.size());
-            vTempVertexBuffer.resize(nVerts);
+            vTempIndexBuffer.resize(vMeshIndexBuffer.size());
+            vTempVertexBuffer.resize(nVerts);
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        auto pIsoVerts = vTempVertexBuffer.data();
+
+        // first transfer mesh position data into a vertex buffer that matches what
+        // isochartpack is expecting (x,y,z,u,v)
+        for (size_t i = 0; i < nVerts; i++)
+        {
+            pIsoVerts[i] = vMeshVertexBuffer[i];
+        }
+
+        // copy index buffer for isochartpack
+        memcpy(vTempIndexBuffer.data(), vMeshIndexBuffer.data(), vTempIndexBuffer.size());
+
+        hr = IsochartRepacker::isochartpack2(&vTempVertexBuffer,
+            nVerts,
+            &vTempIndexBuffer,
+            nFaces,
+            vPartitionResultAdjacency.data(),
+            width,
+            height,
+            gutter,
+            uStageInfo,
+            statusCallback,
+            callbackFrequency,
+            5,
+            pStats);
+        if (FAILED(hr))
+            return hr;
+
+        // encode new texture coordinates in mesh
+        {
+            auto pOutVerts = vTempVertexBuffer.data();
+
+            for (size_t i = 0; i < nVerts; i++)
+            {
+                vMeshVertexBuffer[i].uv.x = pOutVerts[i].uv.x;
+                vMeshVertexBuffer[i].uv.y = pOutVerts[i].uv.y;
+            }
+        }
+
+        return S_OK;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Meshes with at least this many faces keep every thread of the parallel chart
+    // loops busy on their own. UVAtlasCreateBatch runs them one at a time and
+    // spreads the smaller ones over the threads.
+    const size_t BATCH_SHARED_MESH_FACES = 20000;
+
+    // Reports the progress of UVAtlasCreateBatch as the fraction of its faces in
+    // finished meshes. Meshes finish on any thread and only add their faces,
+    // the callback is made by Report on the thread that called UVAtlasCreateBatch.
+    class CBatchProgress
+    {
+    public:
+        CBatchProgress(
+            std::function<HRESULT __cdecl(float percentComplete)>& statusCallBack,
+            float callbackFrequency,
+            size_t nTotalFaces) :
+            m_statusCallBack(statusCallBack),
+            m_fFrequency(callbackFrequency),
+            m_fLastReported(0),
+            m_nTotalFaces(nTotalFaces),
+            m_nReportedFaces(0),
+            m_nDoneFaces(0)
+        {
+        }
+
+        CBatchProgress(CBatchProgress const&) = delete;
+        CBatchProgress& operator=(CBatchProgress const&) = delete;
+
+        void AddDone(size_t nFaces)
+        {
+            m_nDoneFaces += nFaces;
+        }
+
+        // Only called on the thread that called UVAtlasCreateBatch
+        HRESULT Report()
+        {
+            if (!m_statusCallBack)
+                return S_OK;
+
+            const size_t nDoneFaces = m_nDoneFaces;
+            if (nDoneFaces == m_nReportedFaces)
+                return S_OK;
+
+            const float fDone = m_nTotalFaces ? float(nDoneFaces) / float(m_nTotalFaces) : 1.f;
+            if (fDone - m_fLastReported < m_fFrequency && nDoneFaces != m_nTotalFaces)
+                return S_OK;
+
+            m_fLastReported = fDone;
+            m_nReportedFaces = nDoneFaces;
+            return m_statusCallBack(fDone);
+        }
+
+    private:
+        std::function<HRESULT __cdecl(float percentComplete)>& m_statusCallBack;
+        float m_fFrequency;
+        float m_fLastReported;
+        size_t m_nTotalFaces;
+        size_t m_nReportedFaces;
+        std::atomic<size_t> m_nDoneFaces;
+    };
+
+    //---------------------------------------------------------------------------------
+    HRESULT UVAtlasCreateBatchMesh(
+        UVAtlasBatchMesh& mesh,
+        _In_opt_ const UVAtlasCancellation* cancellation,
+        _Inout_opt_ UVAtlasContext* context)
+    {
+        return UVAtlasCreate(mesh.positions,
+            mesh.nVerts,
+            mesh.indices,
+            mesh.indexFormat,
+            mesh.nFaces,
+            mesh.maxChartNumber,
+            mesh.maxStretch,
+            mesh.width,
+            mesh.height,
+            mesh.gutter,
+            mesh.adjacency,
+            mesh.falseEdgeAdjacency,
+            mesh.pIMTArray,
+            nullptr,
+            UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+            mesh.options,
+            mesh.vMeshOutVertexBuffer,
+            mesh.vMeshOutIndexBuffer,
+            &mesh.vFacePartitioning,
+            &mesh.vVertexRemapArray,
+            &mesh.maxStretchOut,
+            &mesh.numChartsOut,
+            mesh.statsOut,
+            cancellation,
+            context);
+    }
+
+
+    //---------------------------------------------------------------------------------
+    // UVAtlasPartitionSegmented writes the result of each segment to a temporary
+    // file, so the working set of the partitioner is bounded by the segment size.
+    // The caller's input and the whole-mesh outputs built by AssembleSegments
+    // stay resident.
+    class CSegmentFile
+    {
+    public:
+        CSegmentFile() noexcept : m_fp(nullptr) {}
+
+        ~CSegmentFile()
+        {
+            if (m_fp)
+                fclose(m_fp);
+        }
+
+        CSegmentFile(CSegmentFile const&) = delete;
+        CSegmentFile& operator=(CSegmentFile const&) = delete;
+
+        HRESULT Open() noexcept
+        {
+            m_fp = tmpfile();
+            if (!m_fp)
+            {
+                DPF(0, "Cannot create a temporary file for the mesh segments");
+                return E_FAIL;
+            }
+            return S_OK;
+        }
+
+        HRESULT Rewind() noexcept
+        {
+            return (fflush(m_fp) == 0 && fseek(m_fp, 0, SEEK_SET) == 0) ? S_OK : E_FAIL;
+        }
+
+        template<typename T>
+        HRESULT Write(const T& data) noexcept
+        {
+            return (fwrite(&data, sizeof(T), 1, m_fp) == 1) ? S_OK : E_FAIL;
+        }
+
+        template<typename T>
+        HRESULT Write(const std::vector<T>& data) noexcept
+        {
+            return (data.empty() || fwrite(data.data(), sizeof(T), data.size(), m_fp) == data.size()) ? S_OK : E_FAIL;
+        }
+
+        template<typename T>
+        HRESULT Read(T& data) noexcept
+        {
+            return (fread(&data, sizeof(T), 1, m_fp) == 1) ? S_OK : E_FAIL;
+        }
+
+        // Reads count items, data is resized to hold them
+        template<typename T>
+        HRESULT Read(std::vector<T>& data, size_t count) noexcept
+        {
+            try
+            {
+                data.resize(count);
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+            return (!count || fread(data.data(), sizeof(T), count, m_fp) == count) ? S_OK : E_FAIL;
+        }
+
+    private:
+        FILE* m_fp;
+    };
+
+    // Precedes the arrays of one segment in the segment file
+    struct SEGMENTHEADER
+    {
+        uint32_t nVerts;        // input vertices used by the segment
+        uint32_t nFaces;
+        uint32_t nOutVerts;     // vertices after partitioning the segment
+        uint32_t nCharts;
+        float maxStretch;
+    };
+
+    // Faces sorted along one axis to halve a segment. All faces of a unit,
+    // the set of faces joined by false edges, get the same key.
+    struct SEGMENTFACE
+    {
+        float key;
+        uint32_t unit;
+        uint32_t face;
+
+        bool operator<(const SEGMENTFACE& other) const
+        {
+            if (key != other.key)
+                return key < other.key;
+            if (unit != other.unit)
+                return unit < other.unit;
+            return face < other.face;
+        }
+    };
+
+    // Union-find over faces. The root of a set is its smallest face.
+    uint32_t FindRootFace(_Inout_ uint32_t* pParents, uint32_t face)
+    {
+        while (pParents[face] != face)
+        {
+            pParents[face] = pParents[pParents[face]];
+            face = pParents[face];
+        }
+        return face;
+    }
+
+    void JoinFaces(_Inout_ uint32_t* pParents, uint32_t face1, uint32_t face2)
+    {
+        face1 = FindRootFace(pParents, face1);
+        face2 = FindRootFace(pParents, face2);
+        if (face1 < face2)
+            pParents[face2] = face1;
+        else
+            pParents[face1] = face2;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Splits the faces into segments of at most maxSegmentFaces faces. Connected
+    // components are grouped until a segment is full, a bigger component is
+    // halved along the longest axis of its face centers until the halves fit.
+    // A unit is never split, so a unit bigger than maxSegmentFaces makes a
+    // bigger segment. faceOrder gets the faces segment by segment, ascending
+    // within each one, and segmentStart the position of each segment in
+    // faceOrder followed by nFaces.
+    template<typename IndexType>
+    HRESULT SegmentFaces(
+        _In_reads_(nVerts)          const XMFLOAT3* positions,
+        _In_                        size_t nVerts,
+        _In_reads_(nFaces * 3)      const IndexType* pIndexData,
+        _In_                        size_t nFaces,
+        _In_                        size_t maxSegmentFaces,
+        _In_reads_(nFaces * 3)      const uint32_t* adjacency,
+        _In_reads_opt_(nFaces * 3)  const uint32_t* falseEdgeAdjacency,
+        _Inout_                     std::vector<uint32_t>& faceOrder,
+        _Inout_                     std::vector<size_t>& segmentStart)
+    {
+        std::unique_ptr<uint32_t[]> components(new (std::nothrow) uint32_t[nFaces]);
+        std::unique_ptr<uint32_t[]> units(new (std::nothrow) uint32_t[nFaces]);
+        std::unique_ptr<uint32_t[]> componentEnd(new (std::nothrow) uint32_t[nFaces + 1]);
+        if (!components || !units || !componentEnd)
+            return E_OUTOFMEMORY;
+
+        uint32_t* pComponents = components.get();
+        uint32_t* pUnits = units.get();
+        uint32_t* pComponentEnd = componentEnd.get();
+
+        // 1. Find connected components and units
+        for (uint32_t i = 0; i < nFaces; i++)
+        {
+            pComponents[i] = i;
+            pUnits[i] = i;
+        }
+
+        for (uint32_t i = 0; i < nFaces; i++)
+        {
+            for (size_t j = 0; j < 3; j++)
+            {
+                const uint32_t neighbor = adjacency[i * 3 + j];
+                if (neighbor >= nFaces)
+                    continue;
+
+                JoinFaces(pComponents, i, neighbor);
+                if (falseEdgeAdjacency && falseEdgeAdjacency[i * 3 + j] != uint32_t(-1))
+                {
+                    JoinFaces(pUnits, i, neighbor);
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < nFaces; i++)
+        {
+            pComponents[i] = FindRootFace(pComponents, i);
+            pUnits[i] = FindRootFace(pUnits, i);
+        }
+
+        // 2. Sort the faces by component, ascending within each one. Afterwards
+        // pComponentEnd[root] is the end of the component in faceOrder.
+        try
+        {
+            faceOrder.resize(nFaces);
+            segmentStart.clear();
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        memset(pComponentEnd, 0, sizeof(uint32_t) * (nFaces + 1));
+        for (size_t i = 0; i < nFaces; i++)
+        {
+            pComponentEnd[pComponents[i] + 1]++;
+        }
+        for (size_t i = 0; i < nFaces; i++)
+        {
+            pComponentEnd[i + 1] += pComponentEnd[i];
+        }
+        for (uint32_t i = 0; i < nFaces; i++)
+        {
+            faceOrder[pComponentEnd[pComponents[i]]++] = i;
+        }
+
+        // 3. Group small components, halve big ones
+        auto unitCenter = [&](uint32_t face, size_t axis) -> float
+        {
+            const uint32_t root = pUnits[face];
+            float fCenter = 0.f;
+            for (size_t k = 0; k < 3; k++)
+            {
+                const size_t v = pIndexData[root * 3 + k];
+                if (v < nVerts)
+                {
+                    fCenter += (&positions[v].x)[axis];
+                }
+            }
+            return fCenter;
+        };
+
+        std::vector<SEGMENTFACE> sortFaces;
+        std::vector<std::pair<size_t, size_t>> ranges;
+
+        try
+        {
+            bool bGroupOpen = false;
+            size_t begin = 0;
+            while (begin < nFaces)
+            {
+                const size_t end = pComponentEnd[pComponents[faceOrder[begin]]];
+                if (end - begin <= maxSegmentFaces)
+                {
+                    // Start a new segment unless the component fits into the last one
+                    if (!bGroupOpen || end - segmentStart.back() > maxSegmentFaces)
+                    {
+                        segmentStart.push_back(begin);
+                        bGroupOpen = true;
+                    }
+                    begin = end;
+                    continue;
+                }
+
+                // Halve the component, the halves go to segments of their own
+                bGroupOpen = false;
+                ranges.emplace_back(begin, end);
+                while (!ranges.empty())
+                {
+                    const size_t b = ranges.back().first;
+                    const size_t e = ranges.back().second;
+                    ranges.pop_back();
+
+                    size_t split = e;
+                    if (e - b > maxSegmentFaces)
+                    {
+                        float fMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+                        float fMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+                        for (size_t i = b; i < e; i++)
+                        {
+                            for (size_t a = 0; a < 3; a++)
+                            {
+                                const float fCenter = unitCenter(faceOrder[i], a);
+                                fMin[a] = std::min(fMin[a], fCenter);
+                                fMax[a] = std::max(fMax[a], fCenter);
+                            }
+                        }
+
+                        size_t axis = 0;
+                        for (size_t a = 1; a < 3; a++)
+                        {
+                            if (fMax[a] - fMin[a] > fMax[axis] - fMin[axis])
+                                axis = a;
+                        }
+
+                        sortFaces.resize(e - b);
+                        for (size_t i = b; i < e; i++)
+                        {
+                            const uint32_t face = faceOrder[i];
+                            sortFaces[i - b] = { unitCenter(face, axis), pUnits[face], face };
+                        }
+                        std::sort(sortFaces.begin(), sortFaces.end());
+                        for (size_t i = b; i < e; i++)
+                        {
+                            faceOrder[i] = sortFaces[i - b].face;
+                        }
+
+                        // Split at the median, moved to the closest unit border
+                        const size_t mid = (e - b) / 2;
+                        size_t after = mid;
+                        while (after < e - b && sortFaces[after].unit == sortFaces[after - 1].unit)
+                            after++;
+                        size_t before = mid;
+                        while (before > 0 && sortFaces[before].unit == sortFaces[before - 1].unit)
+                            before--;
+
+                        if (after < e - b && (before == 0 || after - mid <= mid - before))
+                            split = b + after;
+                        else if (before > 0)
+                            split = b + before;
+                    }
+
+                    if (split == e)
+                    {
+                        // Fits, or is one unit
+                        segmentStart.push_back(b);
+                    }
+                    else
+                    {
+                        ranges.emplace_back(split, e);
+                        ranges.emplace_back(b, split);
+                    }
+                }
+
+                begin = end;
+            }
+
+            segmentStart.push_back(nFaces);
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        for (size_t s = 0; s + 1 < segmentStart.size(); s++)
+        {
+            std::sort(faceOrder.begin() + ptrdiff_t(segmentStart[s]), faceOrder.begin() + ptrdiff_t(segmentStart[s + 1]));
+        }
+
+        return S_OK;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Partitions each segment as a mesh of its own and writes the result to file.
+    // The adjacency of a face to faces of other segments is removed, so charts
+    // end at the segment borders.
+    template<typename IndexType>
+    HRESULT PartitionSegments(
+        _In_reads_(nVerts)          const XMFLOAT3* positions,
+        _In_                        size_t nVerts,
+        _In_reads_(nFaces * 3)      const IndexType* pIndexData,
+        _In_                        size_t nFaces,
+        _In_                        float maxStretch,
+        _In_reads_(nFaces * 3)      const uint32_t* adjacency,
+        _In_reads_opt_(nFaces * 3)  const uint32_t* falseEdgeAdjacency,
+        _In_reads_opt_(nFaces * 3)  const float* pIMTArray,
+        _In_opt_                    LPISOCHARTCALLBACK& statusCallBack,
+        _In_                        float callbackFrequency,
+        _In_                        unsigned int options,
+        _In_                        const std::vector<uint32_t>& faceOrder,
+        _In_                        const std::vector<size_t>& segmentStart,
+        _Inout_                     CSegmentFile& file,
+        _In_opt_                    CIsochartStats* pStats,
+        _In_opt_                    CIsochartBufferPool* pBufferPool)
+    {
+        std::unique_ptr<uint32_t[]> faceLocal(new (std::nothrow) uint32_t[nFaces]);
+        std::unique_ptr<uint32_t[]> vertLocal(new (std::nothrow) uint32_t[nVerts]);
+        if (!faceLocal || !vertLocal)
+            return E_OUTOFMEMORY;
+
+        uint32_t* pFaceLocal = faceLocal.get();
+        uint32_t* pVertLocal = vertLocal.get();
+        memset(pFaceLocal, 0xff, sizeof(uint32_t) * nFaces);
+        memset(pVertLocal, 0xff, sizeof(uint32_t) * nVerts);
+
+        std::vector<uint32_t> segVerts;
+        std::vector<XMFLOAT3> segPositions;
+        std::vector<uint32_t> segIndices;
+        std::vector<uint32_t> segAdjacency;
+        std::vector<uint32_t> segFalseEdges;
+        std::vector<float> segIMT;
+
+        std::vector<UVAtlasVertex> vOutVertexBuffer;
+        std::vector<uint8_t> vOutIndexBuffer;
+        std::vector<uint32_t> vOutFacePartitioning;
+        std::vector<uint32_t> vOutVertexRemapArray;
+        std::vector<uint32_t> vOutAdjacency;
+
+        for (size_t s = 0; s + 1 < segmentStart.size(); s++)
+        {
+            const size_t begin = segmentStart[s];
+            const size_t segFaces = segmentStart[s + 1] - begin;
+
+            for (size_t j = 0; j < segFaces; j++)
+            {
+                pFaceLocal[faceOrder[begin + j]] = static_cast<uint32_t>(j);
+            }
+
+            // 1. Build the mesh of the segment
+            try
+            {
+                segVerts.clear();
+                segPositions.clear();
+                segIndices.resize(segFaces * 3);
+                segAdjacency.resize(segFaces * 3);
+                if (falseEdgeAdjacency)
+                {
+                    segFalseEdges.resize(segFaces * 3);
+                }
+                if (pIMTArray)
+                {
+                    segIMT.resize(segFaces * 3);
+                }
+
+                for (size_t j = 0; j < segFaces; j++)
+                {
+                    const uint32_t face = faceOrder[begin + j];
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        const size_t v = pIndexData[face * 3 + k];
+                        if (v >= nVerts)
+                        {
+                            DPF(0, "Face %u uses vertex %zu, but the mesh has %zu vertices", face, v, nVerts);
+                            return HRESULT_E_INVALID_DATA;
+                        }
+
+                        if (pVertLocal[v] == uint32_t(-1))
+                        {
+                            pVertLocal[v] = static_cast<uint32_t>(segVerts.size());
+                            segVerts.push_back(static_cast<uint32_t>(v));
+                            segPositions.push_back(positions[v]);
+                        }
+                        segIndices[j * 3 + k] = pVertLocal[v];
+
+                        // A neighbor in another segment maps to -1, so the border edge is
+                        // a boundary of the segment mesh and ends the charts on this side
+                        const uint32_t neighbor = adjacency[face * 3 + k];
+                        segAdjacency[j * 3 + k] = (neighbor < nFaces) ? pFaceLocal[neighbor] : uint32_t(-1);
+
+                        if (falseEdgeAdjacency)
+                        {
+                            // Units are never split, so a false edge stays inside the segment
+                            segFalseEdges[j * 3 + k] = (falseEdgeAdjacency[face * 3 + k] != uint32_t(-1)) ?
+                                segAdjacency[j * 3 + k] : uint32_t(-1);
+                        }
+
+                        if (pIMTArray)
+                        {
+                            segIMT[j * 3 + k] = pIMTArray[face * 3 + k];
+                        }
+                    }
+                }
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            // 2. Partition it, reporting progress as the fraction of all faces
+            LPISOCHARTCALLBACK segCallBack;
+            if (statusCallBack)
+            {
+                const float fDone = float(begin) / float(nFaces);
+                const float fSize = float(segFaces) / float(nFaces);
+                segCallBack = [&statusCallBack, fDone, fSize](float percentComplete) -> HRESULT
+                {
+                    return statusCallBack(fDone + percentComplete * fSize);
+                };
+            }
+
+            float segStretch = 0.f;
+            size_t segCharts = 0;
+            HRESULT hr = UVAtlasPartitionInt(segPositions.data(),
+                segPositions.size(),
+                segIndices.data(),
+                DXGI_FORMAT_R32_UINT,
+                segFaces,
+                0,
+                maxStretch,
+                segAdjacency.data(),
+                falseEdgeAdjacency ? segFalseEdges.data() : nullptr,
+                pIMTArray ? segIMT.data() : nullptr,
+                segCallBack,
+                std::min(1.f, callbackFrequency * float(nFaces) / float(segFaces)),
+                options,
+                vOutVertexBuffer,
+                vOutIndexBuffer,
+                &vOutFacePartitioning,
+                &vOutVertexRemapArray,
+                vOutAdjacency,
+                &segStretch,
+                &segCharts,
+                MAKE_STAGE(2U, 0U, 2U),
+                pStats,
+                pBufferPool);
+            if (FAILED(hr))
+                return hr;
+
+            // 3. Write the result
+            SEGMENTHEADER header;
+            header.nVerts = static_cast<uint32_t>(segVerts.size());
+            header.nFaces = static_cast<uint32_t>(segFaces);
+            header.nOutVerts = static_cast<uint32_t>(vOutVertexBuffer.size());
+            header.nCharts = static_cast<uint32_t>(segCharts);
+            header.maxStretch = segStretch;
+
+            if (FAILED(hr = file.Write(header))
+                || FAILED(hr = file.Write(segVerts))
+                || FAILED(hr = file.Write(vOutVertexBuffer))
+                || FAILED(hr = file.Write(vOutVertexRemapArray))
+                || FAILED(hr = file.Write(vOutIndexBuffer))
+                || FAILED(hr = file.Write(vOutFacePartitioning))
+                || FAILED(hr = file.Write(vOutAdjacency)))
+            {
+                DPF(0, "Cannot write the partitioning of a mesh segment");
+                return hr;
+            }
+
+            for (size_t j = 0; j < segFaces; j++)
+            {
+                pFaceLocal[faceOrder[begin + j]] = uint32_t(-1);
+            }
+            for (const uint32_t v : segVerts)
+            {
+                pVertLocal[v] = uint32_t(-1);
+            }
+        }
+
+        return S_OK;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Reads the segments back from file and builds the outputs of the whole mesh.
+    // As in UVAtlasPartitionInt, output vertex i is input vertex i for i < nVerts,
+    // and the vertices split by partitioning follow them.
+    template<typename IndexType>
+    HRESULT AssembleSegments(
+        _In_reads_(nVerts)          const XMFLOAT3* positions,
+        _In_                        size_t nVerts,
+        _In_                        size_t nFaces,
+        _In_                        const std::vector<uint32_t>& faceOrder,
+        _In_                        const std::vector<size_t>& segmentStart,
+        _Inout_                     CSegmentFile& file,
+        _Inout_                     std::vector<UVAtlasVertex>& vMeshOutVertexBuffer,
+        _Inout_                     std::vector<uint8_t>& vMeshOutIndexBuffer,
+        _Inout_opt_                 std::vector<uint32_t>* pvFacePartitioning,
+        _Inout_opt_                 std::vector<uint32_t>* pvVertexRemapArray,
+        _Inout_                     std::vector<uint32_t>& vPartitionResultAdjacency,
+        _Out_opt_                   float* maxStretchOut,
+        _Out_opt_                   size_t* numChartsOut)
+    {
+        HRESULT hr = file.Rewind();
+        if (FAILED(hr))
+            return hr;
+
+        std::vector<UVAtlasVertex> vOutVertexBuffer;
+        std::vector<uint8_t> vOutIndexBuffer;
+        std::vector<uint32_t> vOutVertexRemapArray;
+        std::vector<uint32_t> vOutFacePartitioning;
+        std::vector<uint32_t> vOutAdjacency;
+        std::vector<bool> claimed;
+
+        std::vector<uint32_t> segVerts;
+        std::vector<UVAtlasVertex> segVertexBuffer;
+        std::vector<uint32_t> segVertexRemap;
+        std::vector<uint32_t> segIndices;
+        std::vector<uint32_t> segFacePartitioning;
+        std::vector<uint32_t> segAdjacency;
+        std::vector<uint32_t> outVertIds;
+
+        size_t numCharts = 0;
+        float maxChartingStretch = 0.f;
+
+        try
+        {
+            vOutVertexBuffer.resize(nVerts);
+            vOutVertexRemapArray.resize(nVerts);
+            vOutIndexBuffer.resize(nFaces * 3 * sizeof(IndexType));
+            vOutFacePartitioning.resize(nFaces);
+            vOutAdjacency.resize(nFaces * 3);
+            claimed.resize(nVerts, false);
+
+            for (size_t i = 0; i < nVerts; i++)
+            {
+                vOutVertexBuffer[i].pos = positions[i];
+                vOutVertexBuffer[i].uv = XMFLOAT2(0.f, 0.f);
+                vOutVertexRemapArray[i] = static_cast<uint32_t>(i);
+            }
+
+            auto pOutIndices = reinterpret_cast<IndexType*>(vOutIndexBuffer.data());
+
+            for (size_t s = 0; s + 1 < segmentStart.size(); s++)
+            {
+                const size_t begin = segmentStart[s];
+                const size_t segFaces = segmentStart[s + 1] - begin;
+
+                SEGMENTHEADER header;
+                if (FAILED(hr = file.Read(header))
+                    || header.nFaces != segFaces
+                    || FAILED(hr = file.Read(segVerts, header.nVerts))
+                    || FAILED(hr = file.Read(segVertexBuffer, header.nOutVerts))
+                    || FAILED(hr = file.Read(segVertexRemap, header.nOutVerts))
+                    || FAILED(hr = file.Read(segIndices, segFaces * 3))
+                    || FAILED(hr = file.Read(segFacePartitioning, segFaces))
+                    || FAILED(hr = file.Read(segAdjacency, segFaces * 3)))
+                {
+                    DPF(0, "Cannot read the partitioning of a mesh segment");
+                    return FAILED(hr) ? hr : E_FAIL;
+                }
+
+                // The first output vertex of an input vertex keeps its index,
+                // the others are added at the end
+                outVertIds.resize(header.nOutVerts);
+                for (size_t o = 0; o < header.nOutVerts; o++)
+                {
+                    const uint32_t v = segVerts[segVertexRemap[o]];
+                    if (!claimed[v])
+                    {
+                        claimed[v] = true;
+                        vOutVertexBuffer[v].uv = segVertexBuffer[o].uv;
+                        outVertIds[o] = v;
+                        continue;
+                    }
+
+                    const size_t id = vOutVertexBuffer.size();
+                    if ((sizeof(IndexType) == sizeof(uint16_t) && id >= UINT16_MAX) || id >= UINT32_MAX)
+                    {
+                        DPF(0, "Partitioning splits too many vertices for the index format");
+                        return HRESULT_E_ARITHMETIC_OVERFLOW;
+                    }
+
+                    UVAtlasVertex vertex;
+                    vertex.pos = positions[v];
+                    vertex.uv = segVertexBuffer[o].uv;
+                    vOutVertexBuffer.push_back(vertex);
+                    vOutVertexRemapArray.push_back(v);
+                    outVertIds[o] = static_cast<uint32_t>(id);
+                }
+
+                for (size_t j = 0; j < segFaces; j++)
+                {
+                    const uint32_t face = faceOrder[begin + j];
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        pOutIndices[face * 3 + k] = static_cast<IndexType>(outVertIds[segIndices[j * 3 + k]]);
+
+                        const uint32_t neighbor = segAdjacency[j * 3 + k];
+                        vOutAdjacency[face * 3 + k] = (neighbor < segFaces) ? faceOrder[begin + neighbor] : uint32_t(-1);
+                    }
+                    vOutFacePartitioning[face] = segFacePartitioning[j] + static_cast<uint32_t>(numCharts);
+                }
+
+                numCharts += header.nCharts;
+                maxChartingStretch = std::max(maxChartingStretch, header.maxStretch);
+            }
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        std::swap(vMeshOutVertexBuffer, vOutVertexBuffer);
+        std::swap(vMeshOutIndexBuffer, vOutIndexBuffer);
+
+        if (maxStretchOut)
+        {
+            *maxStretchOut = maxChartingStretch;
         }
-        catch (std::bad_alloc&)
+
+        if (numChartsOut)
         {
-            return E_OUTOFMEMORY;
+            *numChartsOut = numCharts;
         }
 
-        auto pIsoVerts = vTempVertexBuffer.data();
+        if (pvFacePartitioning)
+        {
+            std::swap(*pvFacePartitioning, vOutFacePartitioning);
+        }
 
-        // first transfer mesh position data into a vertex buffer that matches what
-        // isochartpack is expecting (x,y,z,u,v)
-        for (size_t i = 0; i < nVerts; i++)
+        if (pvVertexRemapArray)
         {
-            pIsoVerts[i] = vMeshVertexBuffer[i];
+            std::swap(*pvVertexRemapArray, vOutVertexRemapArray);
         }
 
-        // copy index buffer for isochartpack
-        memcpy(vTempIndexBuffer.data(), vMeshIndexBuffer.data(), vTempIndexBuffer.size());
+        std::swap(vPartitionResultAdjacency, vOutAdjacency);
 
-        hr = IsochartRepacker::isochartpack2(&vTempVertexBuffer,
-            nVerts,
-            &vTempIndexBuffer,
-            nFaces,
-            vPartitionResultAdjacency.data(),
-            width,
-            height,
-            gutter,
-            uStageInfo,
-            statusCallback,
-            callbackFrequency);
+        return S_OK;
+    }
+
+    //---------------------------------------------------------------------------------
+    template<typename IndexType>
+    HRESULT UVAtlasPartitionSegmentedInt(
+        _In_reads_(nVerts)          const XMFLOAT3* positions,
+        _In_                        size_t nVerts,
+        _In_reads_(nFaces * 3)      const IndexType* pIndexData,
+        _In_                        size_t nFaces,
+        _In_                        size_t maxSegmentFaces,
+        _In_                        float maxStretch,
+        _In_reads_(nFaces * 3)      const uint32_t* adjacency,
+        _In_reads_opt_(nFaces * 3)  const uint32_t* falseEdgeAdjacency,
+        _In_reads_opt_(nFaces * 3)  const float* pIMTArray,
+        _In_opt_                    LPISOCHARTCALLBACK& statusCallBack,
+        _In_                        float callbackFrequency,
+        _In_                        unsigned int options,
+        _Inout_                     std::vector<UVAtlasVertex>& vMeshOutVertexBuffer,
+        _Inout_                     std::vector<uint8_t>& vMeshOutIndexBuffer,
+        _Inout_opt_                 std::vector<uint32_t>* pvFacePartitioning,
+        _Inout_opt_                 std::vector<uint32_t>* pvVertexRemapArray,
+        _Inout_                     std::vector<uint32_t>& vPartitionResultAdjacency,
+        _Out_opt_                   float* maxStretchOut,
+        _Out_opt_                   size_t* numChartsOut,
+        _In_opt_                    CIsochartStats* pStats,
+        _In_opt_                    CIsochartBufferPool* pBufferPool)
+    {
+        std::vector<uint32_t> faceOrder;
+        std::vector<size_t> segmentStart;
+        HRESULT hr = SegmentFaces(positions, nVerts, pIndexData, nFaces, maxSegmentFaces,
+            adjacency, falseEdgeAdjacency, faceOrder, segmentStart);
         if (FAILED(hr))
             return hr;
 
-        // encode new texture coordinates in mesh
-        {
-            auto pOutVerts = vTempVertexBuffer.data();
+        CSegmentFile file;
+        hr = file.Open();
+        if (FAILED(hr))
+            return hr;
 
-            for (size_t i = 0; i < nVerts; i++)
-            {
-                vMeshVertexBuffer[i].uv.x = pOutVerts[i].uv.x;
-                vMeshVertexBuffer[i].uv.y = pOutVerts[i].uv.y;
-            }
+        // Without a context the segments still share one pool, so its buffers
+        // are reused from one segment to the next
+        std::unique_ptr<CIsochartBufferPool> segmentPool;
+        if (!pBufferPool)
+        {
+            segmentPool.reset(new (std::nothrow) CIsochartBufferPool);
+            pBufferPool = segmentPool.get();
         }
 
-        return S_OK;
+        hr = PartitionSegments(positions, nVerts, pIndexData, nFaces, maxStretch,
+            adjacency, falseEdgeAdjacency, pIMTArray, statusCallBack, callbackFrequency, options,
+            faceOrder, segmentStart, file, pStats, pBufferPool);
+        if (FAILED(hr))
+            return hr;
+
+        segmentPool.reset();
+
+        return AssembleSegments<IndexType>(positions, nVerts, nFaces, faceOrder, segmentStart, file,
+            vMeshOutVertexBuffer, vMeshOutIndexBuffer, pvFacePartitioning, pvVertexRemapArray,
+            vPartitionResultAdjacency, maxStretchOut, numChartsOut);
+    }
+
+
+    //---------------------------------------------------------------------------------
+    CIsochartBufferPool* GetBufferPool(_In_opt_ const UVAtlasContext* context) noexcept
+    {
+        auto pImpl = context ? context->GetImpl() : nullptr;
+        return pImpl ? &pImpl->pool : nullptr;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// UVAtlasContext
+//-------------------------------------------------------------------------------------
+
+DirectX::UVAtlasContext::UVAtlasContext() noexcept(false) :
+    pImpl(std::make_unique<Impl>())
+{
+}
+
+DirectX::UVAtlasContext::~UVAtlasContext() = default;
+
+DirectX::UVAtlasContext::UVAtlasContext(UVAtlasContext&&) noexcept = default;
+
+DirectX::UVAtlasContext& DirectX::UVAtlasContext::operator=(UVAtlasContext&&) noexcept = default;
+
+void __cdecl DirectX::UVAtlasContext::Reset() noexcept
+{
+    if (pImpl)
+    {
+        pImpl->pool.Clear();
     }
 }
 
+size_t __cdecl DirectX::UVAtlasContext::GetRetainedBytes() const noexcept
+{
+    return pImpl ? pImpl->pool.GetRetainedBytes() : 0;
+}
+
 
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
@@ -588,9 +1507,15 @@ HRESULT __cdecl DirectX::UVAtlasPartition(
     std::vector<uint32_t>* pvVertexRemapArray,
     std::vector<uint32_t>& vPartitionResultAdjacency,
     float* maxStretchOut,
-    size_t* numChartsOut)
+    size_t* numChartsOut,
+    UVAtlasStats* statsOut,
+    const UVAtlasCancellation* cancellation,
+    UVAtlasContext* context)
 {
-    return UVAtlasPartitionInt(positions,
+    CIsochartStats stats;
+    CIsochartStats* pStats = InitStats(stats, statsOut, cancellation);
+
+    HRESULT hr = UVAtlasPartitionInt(positions,
         nVerts,
         indices,
         indexFormat,
@@ -612,8 +1537,101 @@ HRESULT __cdecl DirectX::UVAtlasPartition(
         numChartsOut,
         (maxChartNumber == 0) ?
         MAKE_STAGE(2U, 0U, 2U) :
-        MAKE_STAGE(3U, 0U, 3U));
+        MAKE_STAGE(3U, 0U, 3U),
+        pStats,
+        GetBufferPool(context));
+
+    if (statsOut)
+    {
+        stats.Export(*statsOut);
+    }
+
+    return hr;
+}
+
+
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasPartitionSegmented(
+    const XMFLOAT3* positions,
+    size_t nVerts,
+    const void* indices,
+    DXGI_FORMAT indexFormat,
+    size_t nFaces,
+    size_t maxSegmentFaces,
+    float maxStretch,
+    const uint32_t* adjacency,
+    const uint32_t* falseEdgeAdjacency,
+    const float* pIMTArray,
+    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+    float callbackFrequency,
+    UVATLAS options,
+    std::vector<UVAtlasVertex>& vMeshOutVertexBuffer,
+    std::vector<uint8_t>& vMeshOutIndexBuffer,
+    std::vector<uint32_t>* pvFacePartitioning,
+    std::vector<uint32_t>* pvVertexRemapArray,
+    std::vector<uint32_t>& vPartitionResultAdjacency,
+    float* maxStretchOut,
+    size_t* numChartsOut,
+    UVAtlasStats* statsOut,
+    const UVAtlasCancellation* cancellation,
+    UVAtlasContext* context)
+{
+    if (!positions || !nVerts || !indices || !nFaces || !maxSegmentFaces)
+        return E_INVALIDARG;
+
+    if (!adjacency)
+    {
+        DPF(0, "Input adjacency pointer cannot be nullptr. Use DirectXMesh to compute it");
+        return E_INVALIDARG;
+    }
+
+    switch (indexFormat)
+    {
+    case DXGI_FORMAT_R16_UINT:
+        if (nVerts >= UINT16_MAX)
+            return E_INVALIDARG;
+        break;
+
+    case DXGI_FORMAT_R32_UINT:
+        if (nVerts >= UINT32_MAX)
+            return E_INVALIDARG;
+        break;
+
+    default:
+        return E_INVALIDARG;
+    }
+
+    if ((uint64_t(nFaces) * 3) >= UINT32_MAX)
+        return HRESULT_E_ARITHMETIC_OVERFLOW;
+
+    CIsochartStats stats;
+    CIsochartStats* pStats = InitStats(stats, statsOut, cancellation);
+
+    HRESULT hr;
+    if (DXGI_FORMAT_R16_UINT == indexFormat)
+    {
+        hr = UVAtlasPartitionSegmentedInt(positions, nVerts, reinterpret_cast<const uint16_t*>(indices),
+            nFaces, maxSegmentFaces, maxStretch, adjacency, falseEdgeAdjacency, pIMTArray,
+            statusCallBack, callbackFrequency, options,
+            vMeshOutVertexBuffer, vMeshOutIndexBuffer, pvFacePartitioning, pvVertexRemapArray,
+            vPartitionResultAdjacency, maxStretchOut, numChartsOut, pStats, GetBufferPool(context));
+    }
+    else
+    {
+        hr = UVAtlasPartitionSegmentedInt(positions, nVerts, reinterpret_cast<const uint32_t*>(indices),
+            nFaces, maxSegmentFaces, maxStretch, adjacency, falseEdgeAdjacency, pIMTArray,
+            statusCallBack, callbackFrequency, options,
+            vMeshOutVertexBuffer, vMeshOutIndexBuffer, pvFacePartitioning, pvVertexRemapArray,
+            vPartitionResultAdjacency, maxStretchOut, numChartsOut, pStats, GetBufferPool(context));
+    }
+
+    if (statsOut)
+    {
+        stats.Export(*statsOut);
+    }
 
+    return hr;
 }
 
 
@@ -628,9 +1646,14 @@ HRESULT __cdecl DirectX::UVAtlasPack(
     float gutter,
     const std::vector<uint32_t>& vPartitionResultAdjacency,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-    float callbackFrequency)
+    float callbackFrequency,
+    UVAtlasStats* statsOut,
+    const UVAtlasCancellation* cancellation)
 {
-    return UVAtlasPackInt(vMeshVertexBuffer,
+    CIsochartStats stats;
+    CIsochartStats* pStats = InitStats(stats, statsOut, cancellation);
+
+    HRESULT hr = UVAtlasPackInt(vMeshVertexBuffer,
         vMeshIndexBuffer,
         indexFormat,
         width,
@@ -639,8 +1662,15 @@ HRESULT __cdecl DirectX::UVAtlasPack(
         vPartitionResultAdjacency,
         statusCallBack,
         callbackFrequency,
-        MAKE_STAGE(1, 0, 1)
-    );
+        MAKE_STAGE(1, 0, 1),
+        pStats);
+
+    if (statsOut)
+    {
+        stats.Export(*statsOut);
+    }
+
+    return hr;
 }
 
 
@@ -668,11 +1698,17 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
     std::vector<uint32_t>* pvFacePartitioning,
     std::vector<uint32_t>* pvVertexRemapArray,
     float* maxStretchOut,
-    size_t* numChartsOut)
+    size_t* numChartsOut,
+    UVAtlasStats* statsOut,
+    const UVAtlasCancellation* cancellation,
+    UVAtlasContext* context)
 {
     std::vector<uint32_t> vFacePartitioning;
     std::vector<uint32_t> vAdjacencyOut;
 
+    CIsochartStats stats;
+    CIsochartStats* pStats = InitStats(stats, statsOut, cancellation);
+
     HRESULT hr = UVAtlasPartitionInt(positions,
         nVerts,
         indices,
@@ -695,9 +1731,11 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
         numChartsOut,
         (maxChartNumber == 0) ?
         MAKE_STAGE(3U, 0U, 2U) :
-        MAKE_STAGE(4U, 0U, 3U));
+        MAKE_STAGE(4U, 0U, 3U),
+        pStats,
+        GetBufferPool(context));
     if (FAILED(hr))
-        return hr;
+        goto LEnd;
 
     hr = UVAtlasPackInt(vMeshOutVertexBuffer,
         vMeshOutIndexBuffer,
@@ -710,15 +1748,162 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
         callbackFrequency,
         (maxChartNumber == 0) ?
         MAKE_STAGE(3U, 2U, 1U) :
-        MAKE_STAGE(4U, 3U, 1U));
+        MAKE_STAGE(4U, 3U, 1U),
+        pStats);
     if (FAILED(hr))
-        return hr;
+        goto LEnd;
 
     if (pvFacePartitioning)
     {
         std::swap(*pvFacePartitioning, vFacePartitioning);
     }
 
+LEnd:
+    if (statsOut)
+    {
+        stats.Export(*statsOut);
+    }
+
+    return hr;
+}
+
+
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasCreateBatch(
+    UVAtlasBatchMesh* meshes,
+    size_t nMeshes,
+    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+    float callbackFrequency,
+    const UVAtlasCancellation* cancellation)
+{
+    if (!nMeshes)
+        return S_OK;
+
+    if (!meshes)
+        return E_POINTER;
+
+    if (nMeshes >= INT32_MAX)
+        return E_INVALIDARG;
+
+    // Biggest meshes first. The ones run alone come out as a prefix, and the
+    // threads sharing the others end with small meshes, which balance well.
+    std::vector<uint32_t> order;
+    try
+    {
+        order.resize(nMeshes);
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    size_t nTotalFaces = 0;
+    for (size_t i = 0; i < nMeshes; i++)
+    {
+        order[i] = static_cast<uint32_t>(i);
+        nTotalFaces += meshes[i].nFaces;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [meshes](uint32_t a, uint32_t b) { return meshes[a].nFaces > meshes[b].nFaces; });
+
+    size_t nOwnMeshes = 0;
+    while (nOwnMeshes < nMeshes && meshes[order[nOwnMeshes]].nFaces >= BATCH_SHARED_MESH_FACES)
+        nOwnMeshes++;
+
+    CIsochartStats cancel;
+    if (cancellation)
+    {
+        cancel.SetCancellation(*cancellation);
+    }
+
+    // Buffers freed by one mesh are reused by the next ones
+    std::unique_ptr<UVAtlasContext> context;
+    try
+    {
+        context = std::make_unique<UVAtlasContext>();
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    CBatchProgress progress(statusCallBack, callbackFrequency, nTotalFaces);
+    std::atomic<HRESULT> hrAbort(S_OK);
+
+    // The callback and the cancellation stop the meshes that have not started
+    // yet, failures of single meshes stay with them
+    auto report = [&]()
+    {
+        HRESULT hr = progress.Report();
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            hrAbort.compare_exchange_strong(hrExpected, hr);
+        }
+    };
+
+    auto createMesh = [&](UVAtlasBatchMesh& mesh, bool bCallingThread)
+    {
+        HRESULT hr = hrAbort;
+        if (SUCCEEDED(hr))
+        {
+            hr = cancel.CheckCancel();
+        }
+
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            hrAbort.compare_exchange_strong(hrExpected, hr);
+            mesh.hr = hrAbort;
+            return;
+        }
+
+        mesh.hr = UVAtlasCreateBatchMesh(mesh, cancellation, context.get());
+
+        progress.AddDone(mesh.nFaces);
+        if (bCallingThread)
+        {
+            report();
+        }
+    };
+
+    // 1. Big meshes, each using all threads in its own parallel regions
+    for (size_t i = 0; i < nOwnMeshes; i++)
+    {
+        createMesh(meshes[order[i]], true);
+    }
+
+    // 2. Small meshes, one per thread. The parallel regions inside UVAtlasCreate
+    //    are nested in this one, so unless nesting is enabled each runs on the
+    //    thread that picked up the mesh. The calling thread is thread 0 of the
+    //    team, it reports the meshes of all threads after each of its own.
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int i = static_cast<int>(nOwnMeshes); i < static_cast<int>(nMeshes); i++)
+    {
+#ifdef _OPENMP
+        const bool bCallingThread = (omp_get_thread_num() == 0);
+#else
+        const bool bCallingThread = true;
+#endif
+        createMesh(meshes[order[static_cast<size_t>(i)]], bCallingThread);
+    }
+
+    // The meshes finished by the other threads after the last one of this thread
+    if (SUCCEEDED(hrAbort))
+    {
+        report();
+    }
+
+    if (FAILED(hrAbort))
+        return hrAbort;
+
+    for (size_t i = 0; i < nMeshes; i++)
+    {
+        if (FAILED(meshes[i].hr))
+            return meshes[i].hr;
+    }
+
     return S_OK;
 }
 
@@ -1830,6 +3015,54 @@ HRESULT __cdecl DirectX::UVAtlasApplyRemap(
 }
 
 
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasFormatChromeTrace(
+    const UVAtlasTraceEvent* events,
+    size_t nEvents,
+    std::string& json)
+{
+    if (!events && nEvents > 0)
+        return E_INVALIDARG;
+
+    try
+    {
+        json.clear();
+        json.reserve(64 + nEvents * 128);
+        json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        char buff[256] = {};
+        for (size_t j = 0; j < nEvents; ++j)
+        {
+            const UVAtlasTraceEvent& event = events[j];
+
+            // Trace-event timestamps are in microseconds. Event names are the
+            // static sub-step names from the library, so need no escaping.
+            int len = snprintf(buff, sizeof(buff),
+                "%s\n{\"name\":\"%.64s\",\"cat\":\"isochart\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"faces\":%zu}}",
+                j ? "," : "",
+                event.name ? event.name : "",
+                event.begin ? 'B' : 'E',
+                event.timestamp * 1000000.0,
+                event.threadId,
+                event.faceCount);
+            if (len < 0 || size_t(len) >= sizeof(buff))
+                return E_FAIL;
+
+            json.append(buff, size_t(len));
+        }
+
+        json += "\n]}\n";
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    return S_OK;
+}
+
+
 //-------------------------------------------------------------------------------------
 #ifdef _DEBUG
 _Use_decl_annotations_
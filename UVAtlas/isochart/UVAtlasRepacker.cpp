@@ -29,20 +29,29 @@ HRESULT IsochartRepacker::isochartpack2(
     unsigned int Stage,
     LPISOCHARTCALLBACK pCallback,
     float Frequency,
-    size_t iNumRotate)
+    size_t iNumRotate,
+    CIsochartStats* pStats)
 {
     HRESULT hr = S_OK;
 
     if (Width < 1 || Height < 1 || Gutter < 1 || iNumRotate <= 0)
         return E_INVALIDARG;
 
+    CIsochartStatsTimer timer(pStats, ISOCHART_STATS_PACK_CHARTS);
+    CIsochartTraceScope trace(pStats, "Repack", FaceCount);
+
+    double percentOur = 0;
+    size_t iterationTimes = 0;
+
     CUVAtlasRepacker repacker(pvVertexArray, VertexCount, pvIndexFaceArray,
         FaceCount, pdwAdjacency, iNumRotate, Width, Height, Gutter,
-        nullptr, nullptr, nullptr, nullptr, nullptr);
+        &percentOur, nullptr, nullptr, nullptr, &iterationTimes);
 
     if (!repacker.SetCallback(pCallback, Frequency))
         return E_INVALIDARG;
 
+    repacker.SetCancellation(pStats);
+
     unsigned int dwTotalStage = STAGE_TOTAL(Stage);
     unsigned int dwDoneStage = STAGE_DONE(Stage);
 
@@ -52,6 +61,12 @@ HRESULT IsochartRepacker::isochartpack2(
     if (FAILED(hr = repacker.Repack()))
         return hr;
 
+    if (pStats)
+    {
+        pStats->AddRepackIterations(iterationTimes);
+        pStats->SetAtlasUtilization(percentOur);
+    }
+
     return S_OK;
 }
 
@@ -265,6 +280,12 @@ bool CUVAtlasRepacker::SetCallback(LPISOCHARTCALLBACK pCallback, float Frequency
     return true;
 }
 
+// makes the packing loops stop once the call is cancelled
+void CUVAtlasRepacker::SetCancellation(CIsochartStats* pStats)
+{
+    m_callbackSchemer.SetCancellation(pStats);
+}
+
 // added for checking and setting parameters for managing stages in progress
 bool CUVAtlasRepacker::SetStage(unsigned int TotalStageCount, unsigned int DoneStageCount)
 {
@@ -1036,9 +1057,14 @@ HRESULT CUVAtlasRepacker::PrepareChartsInfo()
 
     std::vector<XMFLOAT2> OutVec;
 
+    HRESULT hr = S_OK;
+
     // iterate each chart to tessellate it
     for (uint32_t i = 0; i < m_iNumCharts; i++)
     {
+        if (FAILED(hr = m_callbackSchemer.CheckPointAdapt()))
+            return hr;
+
         // find best angle to rotate the chart to the best position
         try
         {
@@ -1312,13 +1338,13 @@ void CUVAtlasRepacker::PutChart(uint32_t index)
 
         m_currRotate = int(i);
 
+        // A tie is put on the top or bottom side. It used to take rand(), which
+        // is shared by all threads and was nonzero, so the same side, nearly always.
         int PutSide = 0;
         if (m_currAspectRatio > m_AspectRatio) // put on left or right side
             PutSide = 0;
-        else if (m_currAspectRatio < m_AspectRatio)
-            PutSide = 1;
         else
-            PutSide = int(floorf(float(rand()) + 0.5f));
+            PutSide = 1;
 
         if (PutSide == 0) // put on left or right side
         {
@@ -11,6 +11,7 @@
 
 #include "callbackschemer.h"
 #include "isochart.h"
+#include "isochartstats.h"
 
 namespace IsochartRepacker
 {
@@ -122,6 +123,9 @@ namespace IsochartRepacker
                                         the	chart into atlas. The default value
                                         is 5 which means the chart rotates one
                                         time every 90 / 5 degrees.
+            [in]	pStats			-	Optional collector of the packing time,
+                                        iteration count and space utilization,
+                                        also polled for cancellation.
 
         Return Value:
             If the function succeeds, the return value is S_OK; otherwise,
@@ -140,7 +144,8 @@ namespace IsochartRepacker
         _In_                       unsigned int Stage,
         _In_opt_                   Isochart::LPISOCHARTCALLBACK pCallback = nullptr,
         _In_                       float Frequency = 0.01f,
-        _In_                       size_t iNumRotate = 5);
+        _In_                       size_t iNumRotate = 5,
+        _In_opt_                   Isochart::CIsochartStats* pStats = nullptr);
 
     class CUVAtlasRepacker
     {
@@ -163,6 +168,7 @@ namespace IsochartRepacker
         ~CUVAtlasRepacker();
 
         bool SetCallback(Isochart::LPISOCHARTCALLBACK pCallback, float Frequency);
+        void SetCancellation(Isochart::CIsochartStats* pStats);
         bool SetStage(unsigned int TotalStageCount, unsigned int DoneStageCount);
         HRESULT Repack();
 
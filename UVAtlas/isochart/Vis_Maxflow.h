@@ -163,7 +163,6 @@ namespace Isochart
                 , parent_node(no_parent), parent_edge(no_parent)
                 , m_iFlag(0), depth(0)
             {
-                edges.reserve(m_expect_degree);
             }
 
             cap_type capacity;
@@ -218,8 +217,6 @@ namespace Isochart
 
             int get_depth() const { return depth; }
 
-            static size_t m_expect_degree;
-
         protected:
             node_id parent_node;    // parent node on the tree
             edge_id parent_edge;    // the edge to parent node. always s->t
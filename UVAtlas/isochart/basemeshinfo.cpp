@@ -40,7 +40,8 @@ CBaseMeshInfo::CBaseMeshInfo() :
     fExpectMinAvgL2SquaredStretch(FACE_MIN_L2_STRETCH),
     fRatioOfSigToGeo(0),
     bIsFaceAdjacenctArrayReady(false),
-    pdwSplitHint(nullptr)
+    pdwSplitHint(nullptr),
+    pBufferPool(nullptr)
 {
 }
 
@@ -127,7 +128,7 @@ HRESULT CBaseMeshInfo::Initialize(
 
     if (pdwFaceAdjacentArrayIn)
     {
-        pdwFaceAdjacentArray = new (std::nothrow) uint32_t[3 * dwFaceCount];
+        pdwFaceAdjacentArray = AllocateArray<uint32_t>(pBufferPool, 3 * dwFaceCount);
         if (!pdwFaceAdjacentArray)
         {
             Free();
@@ -146,12 +147,12 @@ HRESULT CBaseMeshInfo::Initialize(
 
 void CBaseMeshInfo::Free()
 {
-    SAFE_DELETE_ARRAY(pVertPosition)
-        SAFE_DELETE_ARRAY(pFaceNormalArray)
-        SAFE_DELETE_ARRAY(pfFaceAreaArray)
-        SAFE_DELETE_ARRAY(pdwFaceAdjacentArray)
-        SAFE_DELETE_ARRAY(pFaceCanonicalUVCoordinate)
-        SAFE_DELETE_ARRAY(pFaceCanonicalParamAxis)
+    FreeArray(pBufferPool, pVertPosition);
+    FreeArray(pBufferPool, pFaceNormalArray);
+    FreeArray(pBufferPool, pfFaceAreaArray);
+    FreeArray(pBufferPool, pdwFaceAdjacentArray);
+    FreeArray(pBufferPool, pFaceCanonicalUVCoordinate);
+    FreeArray(pBufferPool, pFaceCanonicalParamAxis);
 
         pfIMTArray = nullptr;
 
@@ -165,7 +166,7 @@ void CBaseMeshInfo::Free()
 
 HRESULT CBaseMeshInfo::CopyAndScaleInputVertices()
 {
-    pVertPosition = new (std::nothrow) XMFLOAT3[dwVertexCount];
+    pVertPosition = AllocateArray<XMFLOAT3>(pBufferPool, dwVertexCount);
     if (!pVertPosition)
     {
         return E_OUTOFMEMORY;
@@ -185,25 +186,45 @@ HRESULT CBaseMeshInfo::CopyAndScaleInputVertices()
     float* pfMaxVector = &vMaxCoords.x;
     float* pfMinVector = &vMinCoords.x;
 
-    auto pVertexBuffer = static_cast<uint8_t*>(const_cast<void*>(pVertexArray));
-    float* pVertexCoord = nullptr;
+    auto pVertexBuffer = static_cast<const uint8_t*>(pVertexArray);
+    const bool bParallel = (dwFaceCount >= PARALLEL_PREPROCESS_MIN_FACES);
 
-    for (size_t i = 0; i < dwVertexCount; i++)
+    // Each thread bounds its share of vertices, then the boxes are merged.
+    // The comparisons skip NaNs, so the result doesn't depend on the order.
+#pragma omp parallel if (bParallel)
     {
-        pVertexCoord = reinterpret_cast<float*>(pVertexBuffer);
+        float fLocalMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float fLocalMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+#pragma omp for
+        for (int i = 0; i < static_cast<int>(dwVertexCount); i++)
+        {
+            auto pVertexCoord = reinterpret_cast<const float*>(pVertexBuffer + size_t(i) * dwVertexStride);
+            for (size_t j = 0; j < 3; j++)
+            {
+                if (fLocalMin[j] > pVertexCoord[j])
+                {
+                    fLocalMin[j] = pVertexCoord[j];
+                }
+                if (fLocalMax[j] < pVertexCoord[j])
+                {
+                    fLocalMax[j] = pVertexCoord[j];
+                }
+            }
+        }
+
+#pragma omp critical (CBaseMeshInfo_BoundingBox)
         for (size_t j = 0; j < 3; j++)
         {
-            if (pfMinVector[j] > pVertexCoord[j])
+            if (pfMinVector[j] > fLocalMin[j])
             {
-                pfMinVector[j] = pVertexCoord[j];
+                pfMinVector[j] = fLocalMin[j];
             }
-            if (pfMaxVector[j] < pVertexCoord[j])
+            if (pfMaxVector[j] < fLocalMax[j])
             {
-                pfMaxVector[j] = pVertexCoord[j];
+                pfMaxVector[j] = fLocalMax[j];
             }
-
         }
-        pVertexBuffer += dwVertexStride;
     }
 
     XMFLOAT3 vCenter;
@@ -226,17 +247,14 @@ HRESULT CBaseMeshInfo::CopyAndScaleInputVertices()
     scale = ISOCHART_MODELSCALE / scale;
 
     DPF(0, "Scale factor is %f", double(scale));
-    pVertexBuffer = static_cast<uint8_t*>(const_cast<void*>(pVertexArray));
-    pVertexCoord = nullptr;
 
-    for (size_t i = 0; i < dwVertexCount; i++)
+#pragma omp parallel for if (bParallel)
+    for (int i = 0; i < static_cast<int>(dwVertexCount); i++)
     {
-        pVertexCoord = static_cast<float*>(static_cast<void*>(pVertexBuffer));
+        auto pVertexCoord = reinterpret_cast<const float*>(pVertexBuffer + size_t(i) * dwVertexStride);
         XMVECTOR vVertPos = XMVectorSet(pVertexCoord[0], pVertexCoord[1], pVertexCoord[2], 0);
         vVertPos = XMVectorScale(XMVectorSubtract(vVertPos, vvCenter), scale);
         XMStoreFloat3(&pVertPosition[i], vVertPos);
-
-        pVertexBuffer += dwVertexStride;
     }
 
     XMVECTOR vvMaxCoords = XMLoadFloat3(&vMaxCoords);
@@ -256,21 +274,21 @@ HRESULT CBaseMeshInfo::ComputeInputFaceAttributes(
 {
     assert(pdwFaceIndexArrayIn != nullptr);
 
-    pFaceNormalArray = new (std::nothrow) XMFLOAT3[dwFaceCount];
+    pFaceNormalArray = AllocateArray<XMFLOAT3>(pBufferPool, dwFaceCount);
     if (!pFaceNormalArray)
     {
         Free();
         return E_OUTOFMEMORY;
     }
 
-    pfFaceAreaArray = new (std::nothrow) float[dwFaceCount];
+    pfFaceAreaArray = AllocateArray<float>(pBufferPool, dwFaceCount);
     if (!pfFaceAreaArray)
     {
         Free();
         return E_OUTOFMEMORY;
     }
 
-    pdwFaceAdjacentArray = new (std::nothrow) uint32_t[3 * dwFaceCount];
+    pdwFaceAdjacentArray = AllocateArray<uint32_t>(pBufferPool, 3 * dwFaceCount);
     if (!pdwFaceAdjacentArray)
     {
         Free();
@@ -280,14 +298,14 @@ HRESULT CBaseMeshInfo::ComputeInputFaceAttributes(
     // Need to use face canonical coordinates.
     if (pfIMTArray)
     {
-        pFaceCanonicalUVCoordinate = new (std::nothrow) XMFLOAT2[3 * dwFaceCount];
+        pFaceCanonicalUVCoordinate = AllocateArray<XMFLOAT2>(pBufferPool, 3 * dwFaceCount);
         if (!pFaceCanonicalUVCoordinate)
         {
             Free();
             return E_OUTOFMEMORY;
         }
 
-        pFaceCanonicalParamAxis = new (std::nothrow) XMFLOAT3[2 * dwFaceCount];
+        pFaceCanonicalParamAxis = AllocateArray<XMFLOAT3>(pBufferPool, 2 * dwFaceCount);
         if (!pFaceCanonicalParamAxis)
         {
             Free();
@@ -295,32 +313,28 @@ HRESULT CBaseMeshInfo::ComputeInputFaceAttributes(
         }
     }
 
-    XMFLOAT2* pCoordinate = pFaceCanonicalUVCoordinate;
-    XMFLOAT3* pAxis = pFaceCanonicalParamAxis;
-
-    // Compute the normal and area of each face
-    const INDEXTYPE* pFace
-        = static_cast<INDEXTYPE*>(const_cast<void*>(pdwFaceIndexArrayIn));
-    fMeshArea = 0;
+    // Compute the normal and area of each face. Faces are independent, so
+    // large meshes spread them over threads.
+    const INDEXTYPE* pFaces = static_cast<const INDEXTYPE*>(pdwFaceIndexArrayIn);
 
-    for (size_t i = 0; i < dwFaceCount; i++)
+#pragma omp parallel for if (dwFaceCount >= PARALLEL_PREPROCESS_MIN_FACES)
+    for (int i = 0; i < static_cast<int>(dwFaceCount); i++)
     {
+        const INDEXTYPE* pFace = pFaces + size_t(i) * 3;
         XMVECTOR v0 = XMVectorSubtract(XMLoadFloat3(&pVertPosition[pFace[1]]), XMLoadFloat3(&pVertPosition[pFace[0]]));
         XMVECTOR v1 = XMVectorSubtract(XMLoadFloat3(&pVertPosition[pFace[2]]), XMLoadFloat3(&pVertPosition[pFace[0]]));
-        XMFLOAT3* pFaceNormal = pFaceNormalArray + i;
 
         XMVECTOR vFaceNormal = XMVector3Cross(v0, v1);
-        XMStoreFloat3(pFaceNormal, vFaceNormal);
         float area = XMVectorGetX(XMVector3Length(vFaceNormal));
 
         pfFaceAreaArray[i] = area * 0.5f;
-        fMeshArea += pfFaceAreaArray[i];
         if (area > 0.f)
             vFaceNormal = XMVectorDivide(vFaceNormal, XMVectorReplicate(area));
-        XMStoreFloat3(pFaceNormal, vFaceNormal);
+        XMStoreFloat3(pFaceNormalArray + i, vFaceNormal);
 
         if (pFaceCanonicalUVCoordinate)
         {
+            XMFLOAT2* pCoordinate = pFaceCanonicalUVCoordinate + size_t(i) * 3;
             CaculateCanonicalCoordinates(
                 pVertPosition + pFace[0],
                 pVertPosition + pFace[1],
@@ -328,12 +342,15 @@ HRESULT CBaseMeshInfo::ComputeInputFaceAttributes(
                 pCoordinate,
                 pCoordinate + 1,
                 pCoordinate + 2,
-                pAxis);
-
-            pCoordinate += 3;
-            pAxis += 2;
+                pFaceCanonicalParamAxis + size_t(i) * 2);
         }
-        pFace += 3;
+    }
+
+    // Sum areas in face order, so the total is the same on any thread count
+    fMeshArea = 0;
+    for (size_t i = 0; i < dwFaceCount; i++)
+    {
+        fMeshArea += pfFaceAreaArray[i];
     }
 
     if (pdwFaceAdjacentArrayIn)
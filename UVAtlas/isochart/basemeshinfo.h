@@ -10,6 +10,7 @@
 #pragma once
 
 #include "isochart.h"
+#include "bufferpool.h"
 
 // The original mesh information shared by CIsochartEngine methods
 namespace Isochart
@@ -77,6 +78,10 @@ namespace Isochart
         bool bIsFaceAdjacenctArrayReady;
 
         const uint32_t* pdwSplitHint;	// specified by user, all the edges can be splitted has the corresponding adjacency -1
+
+        // Pool of the arrays above and of the per-chart work buffers, nullptr
+        // to use the heap. Only changed while no array is allocated.
+        CIsochartBufferPool* pBufferPool;
     private:
         HRESULT CopyAndScaleInputVertices();
 
@@ -0,0 +1,432 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - bufferpool.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+namespace Isochart
+{
+    // Requests below this size share the smallest size class
+    const size_t BUFFER_POOL_MIN_BLOCK = 64;
+
+    // Each power of two is split into this many size classes, so a block is
+    // at most 25% larger than the request it serves
+    const size_t BUFFER_POOL_CLASSES_PER_OCTAVE = 4;
+
+    // Classes for every exponent a size_t can hold
+    const size_t BUFFER_POOL_CLASS_COUNT = sizeof(size_t) * 8 * BUFFER_POOL_CLASSES_PER_OCTAVE;
+
+    // Threads are spread over this many free lists, each with its own lock
+    const size_t BUFFER_POOL_SHARD_COUNT = 16;
+
+    // Bytes a shard keeps in released blocks, in all and of one size class.
+    // Child charts are smaller than their parents and mostly fall into other
+    // classes, so blocks past these limits go back to the heap instead of
+    // waiting, unused, for the pool to be cleared.
+    const size_t BUFFER_POOL_MAX_SHARD_BYTES = 4 * 1024 * 1024;
+    const size_t BUFFER_POOL_MAX_CLASS_BYTES = 1024 * 1024;
+
+    // Shard of the calling thread, assigned round robin on first use. Threads
+    // of nested or serialized parallel regions all report thread number 0, so
+    // the OpenMP thread number can't be used for this.
+    inline size_t GetBufferPoolShard() noexcept
+    {
+        static std::atomic<size_t> s_dwNextShard(0);
+        static thread_local size_t s_dwShard = (s_dwNextShard++) % BUFFER_POOL_SHARD_COUNT;
+        return s_dwShard;
+    }
+
+    // CIsochartBufferPool keeps the buffers released to it, sorted by size
+    // class, and hands them out again to later requests of the same class.
+    // Each shard keeps at most BUFFER_POOL_MAX_SHARD_BYTES, and at most
+    // BUFFER_POOL_MAX_CLASS_BYTES of one class, the rest is freed at once.
+    // -Every engine owns one, so the small buffers of the intermediate charts
+    //  are reused by the charts made after them and released in bulk when
+    //  the engine is freed.
+    // -A DirectX::UVAtlasContext owns one that replaces the engine's, so the
+    //  buffers of one call are also reused by the next call.
+    // Charts are processed in parallel, so all methods are thread safe. A thread
+    // releases blocks to its own shard and allocates from it first, so threads
+    // rarely wait for each other, and only take blocks from the other shards
+    // before going to the heap.
+    class CIsochartBufferPool
+    {
+    public:
+        CIsochartBufferPool()
+        {
+            for (size_t i = 0; i < BUFFER_POOL_SHARD_COUNT; i++)
+            {
+                m_shards[i].lock.clear();
+                memset(m_shards[i].pFreeBlocks, 0, sizeof(m_shards[i].pFreeBlocks));
+                memset(m_shards[i].cbClassRetained, 0, sizeof(m_shards[i].cbClassRetained));
+                m_shards[i].cbRetained = 0;
+            }
+        }
+
+        ~CIsochartBufferPool()
+        {
+            Clear();
+        }
+
+        CIsochartBufferPool(CIsochartBufferPool const&) = delete;
+        CIsochartBufferPool& operator=(CIsochartBufferPool const&) = delete;
+
+        // Returns a buffer of at least cbSize bytes, aligned like operator new,
+        // or nullptr if out of memory.
+        void* Allocate(size_t cbSize) noexcept
+        {
+            size_t cbClass = 0;
+            const size_t dwClass = GetSizeClass(cbSize, cbClass);
+
+            BLOCK_HEADER* pBlock = nullptr;
+            if (dwClass < BUFFER_POOL_CLASS_COUNT)
+            {
+                const size_t dwShard = GetBufferPoolShard();
+                for (size_t i = 0; i < BUFFER_POOL_SHARD_COUNT && !pBlock; i++)
+                {
+                    pBlock = m_shards[(dwShard + i) % BUFFER_POOL_SHARD_COUNT].Take(dwClass, cbClass);
+                }
+            }
+
+            if (!pBlock)
+            {
+                if (cbClass > SIZE_MAX - sizeof(BLOCK_HEADER))
+                {
+                    return nullptr;
+                }
+
+                pBlock = static_cast<BLOCK_HEADER*>(
+                    ::operator new(sizeof(BLOCK_HEADER) + cbClass, std::nothrow));
+                if (!pBlock)
+                {
+                    return nullptr;
+                }
+                pBlock->dwClass = dwClass;
+                pBlock->cbSize = cbClass;
+            }
+
+            pBlock->pNext = nullptr;
+            return pBlock + 1;
+        }
+
+        // Keeps a buffer returned by Allocate() for reuse, or frees it if its
+        // shard already holds as much as it may
+        void Release(void* p) noexcept
+        {
+            if (!p)
+            {
+                return;
+            }
+
+            auto pBlock = static_cast<BLOCK_HEADER*>(p) - 1;
+            if (pBlock->dwClass >= BUFFER_POOL_CLASS_COUNT
+                || !m_shards[GetBufferPoolShard()].Put(pBlock))
+            {
+                ::operator delete(pBlock);
+            }
+        }
+
+        // Frees all retained buffers. Buffers still allocated are not affected.
+        void Clear() noexcept
+        {
+            for (size_t i = 0; i < BUFFER_POOL_SHARD_COUNT; i++)
+            {
+                m_shards[i].Clear();
+            }
+        }
+
+        // Bytes held in released buffers, waiting to be reused
+        size_t GetRetainedBytes() const noexcept
+        {
+            size_t cbRetained = 0;
+            for (size_t i = 0; i < BUFFER_POOL_SHARD_COUNT; i++)
+            {
+                m_shards[i].Lock();
+                cbRetained += m_shards[i].cbRetained;
+                m_shards[i].Unlock();
+            }
+            return cbRetained;
+        }
+
+    private:
+        // Keeps the buffer behind it as aligned as the heap block, up to 16 bytes
+        struct alignas(16) BLOCK_HEADER
+        {
+            size_t dwClass;
+            size_t cbSize;
+            BLOCK_HEADER* pNext;
+        };
+
+        // Free lists of the threads assigned to one shard
+        struct SHARD
+        {
+            mutable std::atomic_flag lock;
+            BLOCK_HEADER* pFreeBlocks[BUFFER_POOL_CLASS_COUNT];
+            size_t cbClassRetained[BUFFER_POOL_CLASS_COUNT];
+            size_t cbRetained;
+
+            void Lock() const noexcept
+            {
+                while (lock.test_and_set(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            void Unlock() const noexcept
+            {
+                lock.clear(std::memory_order_release);
+            }
+
+            BLOCK_HEADER* Take(size_t dwClass, size_t cbClass) noexcept
+            {
+                Lock();
+                BLOCK_HEADER* pBlock = pFreeBlocks[dwClass];
+                if (pBlock)
+                {
+                    pFreeBlocks[dwClass] = pBlock->pNext;
+                    cbClassRetained[dwClass] -= cbClass;
+                    cbRetained -= cbClass;
+                }
+                Unlock();
+                return pBlock;
+            }
+
+            // Returns false, keeping nothing, if the block would exceed the limits
+            bool Put(BLOCK_HEADER* pBlock) noexcept
+            {
+                const size_t dwClass = pBlock->dwClass;
+                const size_t cbSize = pBlock->cbSize;
+
+                Lock();
+                const bool bKeep = cbSize <= BUFFER_POOL_MAX_CLASS_BYTES - cbClassRetained[dwClass]
+                    && cbSize <= BUFFER_POOL_MAX_SHARD_BYTES - cbRetained;
+                if (bKeep)
+                {
+                    pBlock->pNext = pFreeBlocks[dwClass];
+                    pFreeBlocks[dwClass] = pBlock;
+                    cbClassRetained[dwClass] += cbSize;
+                    cbRetained += cbSize;
+                }
+                Unlock();
+                return bKeep;
+            }
+
+            void Clear() noexcept
+            {
+                Lock();
+                for (size_t i = 0; i < BUFFER_POOL_CLASS_COUNT; i++)
+                {
+                    BLOCK_HEADER* pBlock = pFreeBlocks[i];
+                    while (pBlock)
+                    {
+                        BLOCK_HEADER* pNext = pBlock->pNext;
+                        ::operator delete(pBlock);
+                        pBlock = pNext;
+                    }
+                    pFreeBlocks[i] = nullptr;
+                    cbClassRetained[i] = 0;
+                }
+                cbRetained = 0;
+                Unlock();
+            }
+        };
+
+        // A request of n bytes, where 2^(e+2) < n <= 2^(e+3), is rounded up
+        // to m * 2^e with m in 5..8. Returns BUFFER_POOL_CLASS_COUNT and the
+        // request itself when the rounded size would overflow.
+        static size_t GetSizeClass(size_t cbSize, size_t& cbClass) noexcept
+        {
+            const size_t n = std::max(cbSize, BUFFER_POOL_MIN_BLOCK) - 1;
+
+            size_t dwLog2 = 0;
+            while ((n >> dwLog2) > 1)
+            {
+                dwLog2++;
+            }
+
+            const size_t dwExp = dwLog2 - 2;
+            const size_t m = (n >> dwExp) + 1;
+            if (m > (SIZE_MAX >> dwExp))
+            {
+                cbClass = cbSize;
+                return BUFFER_POOL_CLASS_COUNT;
+            }
+
+            cbClass = m << dwExp;
+            return dwExp * BUFFER_POOL_CLASSES_PER_OCTAVE + (m - 5);
+        }
+
+        SHARD m_shards[BUFFER_POOL_SHARD_COUNT];
+    };
+
+    // Allocates an uninitialized array of dwCount T from pPool, or from the
+    // heap when pPool is nullptr. Returns nullptr if out of memory.
+    template <typename T>
+    T* AllocateArray(CIsochartBufferPool* pPool, size_t dwCount) noexcept
+    {
+        static_assert(std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value,
+            "Pooled arrays must not need construction or destruction, use NewArray");
+
+        if (!pPool)
+        {
+            return new (std::nothrow) T[dwCount];
+        }
+
+        if (dwCount > SIZE_MAX / sizeof(T))
+        {
+            return nullptr;
+        }
+        return static_cast<T*>(pPool->Allocate(dwCount * sizeof(T)));
+    }
+
+    // Frees an array from AllocateArray() with the same pPool, and clears p
+    template <typename T>
+    void FreeArray(CIsochartBufferPool* pPool, T*& p) noexcept
+    {
+        if (!p)
+        {
+            return;
+        }
+
+        if (pPool)
+        {
+            pPool->Release(p);
+        }
+        else
+        {
+            delete[] p;
+        }
+        p = nullptr;
+    }
+
+    // Room in front of a NewArray() array for its element count, keeping the
+    // array as aligned as the block
+    const size_t BUFFER_POOL_ARRAY_COOKIE = 16;
+
+    // Allocates an array of dwCount default constructed T from pPool, or from
+    // the heap when pPool is nullptr. Returns nullptr if out of memory.
+    template <typename T>
+    T* NewArray(CIsochartBufferPool* pPool, size_t dwCount) noexcept
+    {
+        static_assert(std::is_nothrow_default_constructible<T>::value, "Pooled arrays must construct without throwing");
+        static_assert(alignof(T) <= BUFFER_POOL_ARRAY_COOKIE, "Pooled arrays are aligned to 16 bytes at most");
+
+        if (!pPool)
+        {
+            return new (std::nothrow) T[dwCount];
+        }
+
+        if (dwCount > (SIZE_MAX - BUFFER_POOL_ARRAY_COOKIE) / sizeof(T))
+        {
+            return nullptr;
+        }
+
+        auto pBuffer = static_cast<uint8_t*>(pPool->Allocate(BUFFER_POOL_ARRAY_COOKIE + dwCount * sizeof(T)));
+        if (!pBuffer)
+        {
+            return nullptr;
+        }
+
+        *reinterpret_cast<size_t*>(pBuffer) = dwCount;
+        auto p = reinterpret_cast<T*>(pBuffer + BUFFER_POOL_ARRAY_COOKIE);
+        for (size_t i = 0; i < dwCount; i++)
+        {
+            new (p + i) T;
+        }
+        return p;
+    }
+
+    // Destroys an array from NewArray() with the same pPool, and clears p
+    template <typename T>
+    void DeleteArray(CIsochartBufferPool* pPool, T*& p) noexcept
+    {
+        if (!p)
+        {
+            return;
+        }
+
+        if (pPool)
+        {
+            auto pBuffer = reinterpret_cast<uint8_t*>(p) - BUFFER_POOL_ARRAY_COOKIE;
+            const size_t dwCount = *reinterpret_cast<size_t*>(pBuffer);
+            for (size_t i = 0; i < dwCount; i++)
+            {
+                p[i].~T();
+            }
+            pPool->Release(pBuffer);
+        }
+        else
+        {
+            delete[] p;
+        }
+        p = nullptr;
+    }
+
+    // Standard allocator drawing from a CIsochartBufferPool, or from the heap
+    // when the pool is nullptr. Throws std::bad_alloc like std::allocator.
+    template <typename T>
+    class CBufferPoolAllocator
+    {
+    public:
+        typedef T value_type;
+
+        explicit CBufferPoolAllocator(CIsochartBufferPool* pPool) noexcept :
+            m_pPool(pPool)
+        {
+        }
+
+        template <typename U>
+        CBufferPoolAllocator(const CBufferPoolAllocator<U>& other) noexcept :
+            m_pPool(other.GetPool())
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            if (n > SIZE_MAX / sizeof(T))
+            {
+                throw std::bad_alloc();
+            }
+
+            void* p = m_pPool ? m_pPool->Allocate(n * sizeof(T)) : ::operator new(n * sizeof(T), std::nothrow);
+            if (!p)
+            {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, size_t) noexcept
+        {
+            if (m_pPool)
+            {
+                m_pPool->Release(p);
+            }
+            else
+            {
+                ::operator delete(p);
+            }
+        }
+
+        CIsochartBufferPool* GetPool() const noexcept { return m_pPool; }
+
+        template <typename U>
+        bool operator==(const CBufferPoolAllocator<U>& other) const noexcept { return m_pPool == other.GetPool(); }
+
+        template <typename U>
+        bool operator!=(const CBufferPoolAllocator<U>& other) const noexcept { return m_pPool != other.GetPool(); }
+
+    private:
+        CIsochartBufferPool* m_pPool;
+    };
+}
@@ -10,9 +10,16 @@
 #pragma once
 
 #include "isochart.h"
+#include "isochartstats.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace Isochart
 {
+    // Minimum time in milliseconds between two callbacks fired by check points alone
+    const unsigned int CHECKPOINT_INTERVAL_MS = 10;
 
     // CCallbackSchemer provides methods to simplify the callback implementation.
     // Terms: 
@@ -38,6 +45,9 @@ namespace Isochart
     //	Only check if caller want to report.
     // -FinishWorkAdapt()
     //	Finish a sub-task.
+    // -SetCancellation()
+    //	Make the methods above also fail once the call is cancelled, whether or
+    //  not a callback was set.
     //
     // Example:
     // 	-A main task A has 2 sub-tasks: B, C
@@ -50,20 +60,55 @@ namespace Isochart
     //	2.1 InitCallbackAdapt(100, 0.65f, 0.35); // Init task C.
     //  2.2 UpdateCallbackAdapt(1)...UpdateCallbackAdapt(1)... // Perform task C 
     //  2.3 FinishWorkAdapt() //Finish task C
+    //
+    // Threading:
+    // -InitCallBackAdapt(), FinishWorkAdapt(), SetCallback(), SetCancellation()
+    //  and SetStage() are only called by the thread driving the engine, outside
+    //  parallel regions.
+    // -UpdateCallbackAdapt() and CheckPointAdapt() may be called from any thread
+    //  of an OpenMP team. Each worker accumulates its steps privately and only
+    //  adds them to the shared atomic count in batches, so the counters don't
+    //  bounce between cores. Workers of teams nested in another active team
+    //  add their steps to the shared count directly.
+    // -The callback itself only runs on the driving thread: at most once per
+    //  m_dwCallbackDelta steps of progress, and at most once per
+    //  CHECKPOINT_INTERVAL_MS for check points. A failure it returns is remembered
+    //  and returned to every thread on its next update or check point, so the
+    //  workers stop promptly.
 
     class CCallbackSchemer
     {
     public:
         CCallbackSchemer() :
             m_pCallback(nullptr),
+            m_fCallbackFrequence(0),
+            m_dwTotalWork(0),
+            m_dwWorkDone(0),
+            m_dwNextCallback(0),
+            m_dwCallbackDelta(1),
+            m_dwWaitPoint(0),
+            m_dwFlushThreshold(1),
+            m_fPercentScale(0),
+            m_fBase(0),
             m_dwTotalStage(0),
-            m_dwDoneStage(0)
+            m_dwDoneStage(0),
+            m_fPercentOfAllTasks(0),
+            m_hrAbort(S_OK),
+            m_pCancelStats(nullptr)
         {}
 
+        CCallbackSchemer(CCallbackSchemer const&) = delete;
+        CCallbackSchemer& operator=(CCallbackSchemer const&) = delete;
+
         void SetCallback(
             LPISOCHARTCALLBACK pCallback,
             float Frequency);
 
+        void SetCancellation(CIsochartStats* pStats)
+        {
+            m_pCancelStats = (pStats && pStats->IsCancellable()) ? pStats : nullptr;
+        }
+
         void SetStage(
             unsigned int TotalStageCount,
             unsigned int DoneStageCount);
@@ -85,20 +130,31 @@ namespace Isochart
         float PercentInAllStage();
 
     private:
+        // Steps a worker thread has done but not yet added to m_dwWorkDone.
+        // Padded so neighbouring threads never write the same cache line.
+        struct PendingWork
+        {
+            size_t dwPending;
+            char padding[64 - sizeof(size_t)];
+        };
+
+        bool IsCallbackThread() const { return std::this_thread::get_id() == m_callbackThread; }
+        size_t AddWork(size_t dwDone);
+        HRESULT FireCallback();
+        HRESULT CheckCancel() { return m_pCancelStats ? m_pCancelStats->CheckCancel() : S_OK; }
 
         LPISOCHARTCALLBACK m_pCallback; // Callback function
         float m_fCallbackFrequence;// The frequency to call callback function.
 
         size_t m_dwTotalWork;	// Steps of current sub-task.
-        size_t m_dwWorkDone;		// Steps have been completed in the sub-task.
+        std::atomic<size_t> m_dwWorkDone;	// Steps have been completed in the sub-task.
         size_t m_dwNextCallback;	// The next point to call callback function.
         size_t m_dwCallbackDelta;// The frequence to call callback, indicate hwo 
                                 // many steps should be done before next callback
         size_t m_dwWaitPoint;	// When sub-task reach this point, don't update the
                                 // rate of progress until FinishWorkAdapt 
-        size_t m_dwWaitCount;	// Work with m_dwWaitPoint. keep the frequence of 
-                                // calling callback, but not update rate of progress
-        bool m_bIsWaitToFinish;	// Inidicate sub-task has reached to wait point.
+        size_t m_dwFlushThreshold; // Steps a worker thread batches before adding
+                                // them to m_dwWorkDone
 
         float m_fPercentScale;	// One step of sub-task can complete how many work 
                                 //(in percent)of main work 
@@ -110,6 +166,11 @@ namespace Isochart
 
         float m_fPercentOfAllTasks;
 
+        std::thread::id m_callbackThread;   // The only thread calling m_pCallback
+        std::chrono::steady_clock::time_point m_lastCallback;
+        std::atomic<HRESULT> m_hrAbort;     // First failure returned by m_pCallback
+        std::vector<PendingWork> m_pendingWork; // One per OpenMP thread
+        CIsochartStats* m_pCancelStats;     // Cancellation checked on every update
     };
 
     inline void CCallbackSchemer::SetCallback(
@@ -118,6 +179,19 @@ namespace Isochart
     {
         m_pCallback = pCallback;
         m_fCallbackFrequence = Frequency;
+        m_hrAbort = S_OK;
+
+#ifdef _OPENMP
+        try
+        {
+            m_pendingWork.resize(static_cast<size_t>(omp_get_max_threads()));
+        }
+        catch (std::bad_alloc&)
+        {
+            // Workers fall back to adding their steps to m_dwWorkDone directly
+            m_pendingWork.clear();
+        }
+#endif
     }
 
     inline void CCallbackSchemer::SetStage(
@@ -130,7 +204,7 @@ namespace Isochart
 
     inline float CCallbackSchemer::PercentInAllStage()
     {
-        float fPercent = m_fBase + float(m_dwWorkDone) * m_fPercentScale;
+        float fPercent = m_fBase + float(std::min<size_t>(m_dwWorkDone, m_dwWaitPoint)) * m_fPercentScale;
         return (float(m_dwDoneStage) * 1.0f) / float(m_dwTotalStage) + fPercent / float(m_dwTotalStage);
     }
 
@@ -144,12 +218,20 @@ namespace Isochart
             return;
         }
 
+        m_callbackThread = std::this_thread::get_id();
+        m_lastCallback = std::chrono::steady_clock::now();
+
         // dwTaskWork steps in current sub-task
         m_dwTotalWork = dwTaskWork;
         m_dwWorkDone = 0;
+        for (auto& pending : m_pendingWork)
+        {
+            pending.dwPending = 0;
+        }
 
         if (0 == dwTaskWork)
         {
+            m_dwWaitPoint = 0;
             return;
         }
         // Call callback function per m_dwCallbackDelta steps
@@ -163,21 +245,70 @@ namespace Isochart
 
         m_dwNextCallback = m_dwCallbackDelta;
 
+        // Batch a share of one callback interval per worker, so the callback
+        // thread still sees progress at roughly the requested frequency.
+        m_dwFlushThreshold = std::max<size_t>(1, m_dwCallbackDelta / std::max<size_t>(1, m_pendingWork.size()));
+
         // One step in current sub-task finished how many percent time of main task
         m_fPercentScale = 1.0f / float(dwTaskWork) * fPercentOfAllTasks;
 
-        m_bIsWaitToFinish = false;
-        m_dwWaitPoint = dwTaskWork - m_dwCallbackDelta;
+        m_dwWaitPoint = dwTaskWork - std::min(dwTaskWork, m_dwCallbackDelta);
 
         m_fBase = fBase;
         m_fPercentOfAllTasks = fPercentOfAllTasks;
     }
 
+    inline size_t CCallbackSchemer::AddWork(size_t dwDone)
+    {
+#ifdef _OPENMP
+        // The slots are indexed by the thread number, which is only unique in
+        // one team. A team of one thread is nested in another parallel region,
+        // and with nested parallelism enabled several teams run at once, so
+        // below an active outer team the steps go to the shared count directly.
+        if (!IsCallbackThread() && omp_get_num_threads() > 1 && omp_get_active_level() == 1)
+        {
+            auto dwThread = static_cast<size_t>(omp_get_thread_num());
+            if (dwThread < m_pendingWork.size())
+            {
+                size_t& dwPending = m_pendingWork[dwThread].dwPending;
+                dwPending += dwDone;
+                if (dwPending < m_dwFlushThreshold)
+                {
+                    return m_dwWorkDone.load(std::memory_order_relaxed);
+                }
+                dwDone = dwPending;
+                dwPending = 0;
+            }
+        }
+#endif
+        return m_dwWorkDone.fetch_add(dwDone, std::memory_order_relaxed) + dwDone;
+    }
+
+    inline HRESULT CCallbackSchemer::FireCallback()
+    {
+        m_lastCallback = std::chrono::steady_clock::now();
+
+        HRESULT hr = m_pCallback(PercentInAllStage());
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            m_hrAbort.compare_exchange_strong(hrExpected, hr);
+        }
+        return hr;
+    }
+
     inline HRESULT CCallbackSchemer::UpdateCallbackDirectly(float fPercent)
     {
-        if (!m_pCallback)
+        HRESULT hr = CheckCancel();
+        if (FAILED(hr) || !m_pCallback)
         {
-            return S_OK;
+            return hr;
+        }
+
+        hr = m_hrAbort;
+        if (FAILED(hr) || !IsCallbackThread())
+        {
+            return hr;
         }
 
         if (fPercent > 1.0f) fPercent = 1.0f;
@@ -185,86 +316,84 @@ namespace Isochart
 
         float fRealPercent = m_fBase + m_fPercentOfAllTasks * fPercent;
         fRealPercent = (float(m_dwDoneStage) * 1.0f) / float(m_dwTotalStage) + fRealPercent / float(m_dwTotalStage);
-        return m_pCallback(fRealPercent);
+
+        m_lastCallback = std::chrono::steady_clock::now();
+        hr = m_pCallback(fRealPercent);
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            m_hrAbort.compare_exchange_strong(hrExpected, hr);
+        }
+        return hr;
     }
 
     inline HRESULT CCallbackSchemer::UpdateCallbackAdapt(size_t dwDone)
     {
-        if (!m_pCallback || 0 == dwDone)
+        HRESULT hr = CheckCancel();
+        if (FAILED(hr) || !m_pCallback || 0 == dwDone)
         {
-            return S_OK;
+            return hr;
         }
 
-        bool bFire = false;
-
-        // Has reached to wait point, not update current progress, but still check 
-        // if caller want to abort.
-        if (m_bIsWaitToFinish)
+        hr = m_hrAbort;
+        if (FAILED(hr))
         {
-            // Keep the frequency to call callback function
-            m_dwWaitCount += dwDone;
-            if (m_dwWaitCount >= m_dwCallbackDelta)
-            {
-                while (m_dwWaitCount >= m_dwCallbackDelta)
-                {
-                    m_dwWaitCount -= m_dwCallbackDelta;
-                }
-                bFire = true;
-            }
+            return hr;
         }
-        else
-        {
-            m_dwWorkDone += dwDone;
 
-            // if reach to the wait point,  set wait flag, initialize m_dwWaitCount 
-            // to control the frequency to call callback function
-            if (m_dwWorkDone >= m_dwWaitPoint)
-            {
-                m_dwWorkDone = m_dwWaitPoint;
-                bFire = true;
-                m_bIsWaitToFinish = true;
-                m_dwWaitCount = 0;
-            }
-            // Not reach the wait point yet, update progress.
-            else
-            {
-                while (m_dwWorkDone > m_dwNextCallback)
-                {
-                    bFire = true;
-                    m_dwNextCallback += m_dwCallbackDelta;
-                }
-            }
-        }
-        if (bFire)
+        size_t dwWorkDone = AddWork(dwDone);
+        if (!IsCallbackThread() || dwWorkDone < m_dwNextCallback)
         {
-            return m_pCallback(PercentInAllStage());
+            return S_OK;
         }
 
-        return S_OK;
+        // Once past the wait point the reported progress stays put until
+        // FinishWorkAdapt, but the callback keeps its frequency so the caller
+        // can still abort.
+        m_dwNextCallback = dwWorkDone - dwWorkDone % m_dwCallbackDelta + m_dwCallbackDelta;
+        return FireCallback();
     }
 
 
     inline HRESULT CCallbackSchemer::CheckPointAdapt()
     {
-        if (!m_pCallback)
+        HRESULT hr = CheckCancel();
+        if (FAILED(hr) || !m_pCallback)
         {
-            return S_OK;
+            return hr;
+        }
+
+        hr = m_hrAbort;
+        if (FAILED(hr) || !IsCallbackThread())
+        {
+            return hr;
         }
 
         // Not update progress, only check if caller want to abort.
-        return m_pCallback(PercentInAllStage());
+        if (std::chrono::steady_clock::now() - m_lastCallback < std::chrono::milliseconds(CHECKPOINT_INTERVAL_MS))
+        {
+            return S_OK;
+        }
+        return FireCallback();
     }
 
     inline HRESULT CCallbackSchemer::FinishWorkAdapt()
     {
-        if (!m_pCallback)
+        HRESULT hr = CheckCancel();
+        if (FAILED(hr) || !m_pCallback)
         {
-            return S_OK;
+            return hr;
+        }
+
+        hr = m_hrAbort;
+        if (FAILED(hr))
+        {
+            return hr;
         }
 
         m_dwWorkDone = m_dwTotalWork; // Indicate current sub-task has finished.
-        return m_pCallback(
-            PercentInAllStage());
+        m_dwWaitPoint = m_dwTotalWork;
+        return FireCallback();
     }
 
 }
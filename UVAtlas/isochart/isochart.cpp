@@ -311,7 +311,9 @@ HRESULT Isochart::isochartpartition(
     LPISOCHARTCALLBACK pCallback,
     float Frequency,
     const uint32_t* pSplitHint,
-    unsigned int dwOptions)
+    unsigned int dwOptions,
+    CIsochartStats* pStats,
+    CIsochartBufferPool* pBufferPool)
 {
     unsigned int dwTotalStage = STAGE_TOTAL(Stage);
     unsigned int dwDoneStage = STAGE_DONE(Stage);
@@ -343,6 +345,8 @@ HRESULT Isochart::isochartpartition(
         }
     }
     pEngine->SetStage(dwTotalStage, dwDoneStage);
+    pEngine->SetStats(pStats);
+    pEngine->SetBufferPool(pBufferPool);
 
     // 4. Initialize isochart engine
     if (FAILED(hr = pEngine->Initialize(
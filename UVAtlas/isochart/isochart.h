@@ -26,6 +26,9 @@
 
 namespace Isochart
 {
+    class CIsochartBufferPool;
+    class CIsochartStats;
+
     typedef float FLOAT3[IMT_DIM]; // Used to define IMT matrix
 
     // User-specified callback. Return E_FAIL to abort ongoing task
@@ -45,9 +48,13 @@ namespace Isochart
         _OPTION_ISOCHART_GEODESIC_FAST = 0x01,
 
         // all internal geodesic distance computation tries to use the new approach implemented in geodesicdist.lib (except IMT is specified), this is precise but slower
-        _OPTION_ISOCHART_GEODESIC_QUALITY = 0x02
+        _OPTION_ISOCHART_GEODESIC_QUALITY = 0x02,
+
+        // all internal geodesic distance computation tries to use the heat method (except IMT is specified), the [KS98] approach is used
+        // for charts whose factors would exceed HEAT_GEODESIC_MAX_FACTOR_ENTRIES
+        _OPTION_ISOCHART_GEODESIC_HEAT = 0x20
     };
-    const unsigned int _OPTIONMASK_ISOCHART_GEODESIC = _OPTION_ISOCHART_GEODESIC_FAST | _OPTION_ISOCHART_GEODESIC_QUALITY;
+    const unsigned int _OPTIONMASK_ISOCHART_GEODESIC = _OPTION_ISOCHART_GEODESIC_FAST | _OPTION_ISOCHART_GEODESIC_QUALITY | _OPTION_ISOCHART_GEODESIC_HEAT;
 
     HRESULT
         isochart(
@@ -102,7 +109,9 @@ namespace Isochart
                                                                                               // CAN be splitted, set the that ajacency to -1.
                                                                                               // Usually, it's easier for user to specified the edge that CAN NOT be
                                                                                               // splitted, make sure to validate the input
-            _In_                                        unsigned int dwOptions = _OPTION_ISOCHART_DEFAULT);
+            _In_                                        unsigned int dwOptions = _OPTION_ISOCHART_DEFAULT,
+            _In_opt_                                    CIsochartStats* pStats = nullptr,
+            _In_opt_                                    CIsochartBufferPool* pBufferPool = nullptr);
 
 
     // Class IIsochartEngine for the advanced usage
@@ -155,6 +164,17 @@ namespace Isochart
             unsigned int TotalStageCount,
             unsigned int DoneStageCount) noexcept = 0;
 
+        // Set the per-stage statistics collector, nullptr to disable collection.
+        // Its cancellation, if any, is polled while the engine runs.
+        virtual HRESULT SetStats(
+            CIsochartStats* pStats) noexcept = 0;
+
+        // Set the pool of the engine's buffers and chart topology, nullptr for
+        // the engine's own pool, which Free() empties. Can only be changed
+        // before Initialize() or after Free().
+        virtual HRESULT SetBufferPool(
+            CIsochartBufferPool* pBufferPool) noexcept = 0;
+
         virtual HRESULT ExportPartitionResult(
             std::vector<DirectX::UVAtlasVertex>* pvVertexArrayOut,
             std::vector<uint8_t>* pvFaceIndexArrayOut,
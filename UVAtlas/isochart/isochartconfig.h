@@ -155,4 +155,28 @@ namespace Isochart
     // Larger value will generate larger pixel size. After experiment, 0.5 is a good estimation.
     const float STANDARD_SPACE_RATE = 0.5f;
 
+    ////////////////////////////////////////////////////////////////////
+    ////////////////Parallel Preprocessing Configuration////////////////
+    ////////////////////////////////////////////////////////////////////
+
+    // Per-face and per-vertex loops that prepare a mesh for partitioning run
+    // on several threads only for meshes with at least this many faces. On
+    // smaller ones, starting the threads costs more than it saves.
+    const size_t PARALLEL_PREPROCESS_MIN_FACES = 65536;
+
+    // The landmark sources of a chart's geodesic distances run on several
+    // threads only for charts with at least this many vertices. Each thread
+    // but the first builds its own one-to-all engine.
+    const size_t PARALLEL_GEODESIC_MIN_VERTICES = 2048;
+
+    ////////////////////////////////////////////////////////////////////
+    ////////////////Heat Method Geodesic Configuration//////////////////
+    ////////////////////////////////////////////////////////////////////
+
+    // Largest number of entries in each Cholesky factor of the heat method
+    // (8 bytes per entry and factor, plus 4 for the shared pattern; a chart
+    // with boundary has three factors, otherwise two). Charts needing more
+    // use the [KS98] approach.
+    const size_t HEAT_GEODESIC_MAX_FACTOR_ENTRIES = 16 * 1024 * 1024;
+
 }
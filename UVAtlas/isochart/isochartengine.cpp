@@ -11,6 +11,7 @@
 #include "isochartengine.h"
 #include "isochart.h"
 #include "isochartmesh.h"
+#include "workscheduler.h"
 
 using namespace DirectX;
 using namespace Isochart;
@@ -18,13 +19,7 @@ using namespace Isochart;
 // Create instance of the class which implements the IIsochartEngine interface
 IIsochartEngine* IIsochartEngine::CreateIsochartEngine()
 {
-    auto pEngine = new (std::nothrow) CIsochartEngine;
-    if (pEngine && FAILED(pEngine->CreateEngineMutex()))
-    {
-        delete pEngine;
-        pEngine = nullptr;
-    }
-    return pEngine;
+    return new (std::nothrow) CIsochartEngine;
 }
 
 // Destroy the engine instance
@@ -36,12 +31,12 @@ void IIsochartEngine::ReleaseIsochartEngine(
 
 
 CIsochartEngine::CIsochartEngine() :
+    m_pStats(nullptr),
     m_state(ISOCHART_ST_UNINITILAIZED),
-#ifdef WIN32
-    m_hMutex(nullptr),
-#endif
+    m_bBusy(false),
     m_dwOptions(_OPTION_ISOCHART_DEFAULT)
 {
+    m_baseInfo.pBufferPool = &m_bufferPool;
 }
 
 CIsochartEngine::~CIsochartEngine()
@@ -56,26 +51,8 @@ CIsochartEngine::~CIsochartEngine()
         std::this_thread::yield();
 #endif
     }
-
-#ifdef WIN32
-    if (m_hMutex)
-    {
-        CloseHandle(m_hMutex);
-    }
-#endif
 }
 
-HRESULT CIsochartEngine::CreateEngineMutex()
-{
-#ifdef WIN32
-    m_hMutex = CreateMutexEx(nullptr, nullptr, CREATE_MUTEX_INITIAL_OWNER, SYNCHRONIZE);
-    if (!m_hMutex)
-    {
-        return HRESULT_FROM_WIN32(GetLastError());
-    }
-#endif
-    return S_OK;
-}
 // ------------------------------------------------------------------------
 // Initialize the isochart engine. Must be called before Partition, Optimize & Pack.
 //-pMinChartNumber
@@ -194,6 +171,9 @@ HRESULT CIsochartEngine::Free() noexcept
     ReleaseFinalCharts();
     ReleaseInitialCharts();
 
+    // Everything is back in the pool now, hand it to the heap at once
+    m_bufferPool.Clear();
+
     m_state = ISOCHART_ST_UNINITILAIZED;
 
     LeaveExclusiveSection();
@@ -282,102 +262,190 @@ HRESULT CIsochartEngine::InitializeCurrentChartHeap()
 
 #ifdef _OPENMP
 HRESULT CIsochartEngine::ParameterizeChartsInHeapParallelized(
+    CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
+    std::vector<CIsochartMesh*>& finalChartList,
     bool bFirstTime,
     size_t MaxChartNumber)
 {
     // 3.1 If Any charts needed to be partitioned
 
     /// Parallelization:
-    /// 1st Move heap to vector `parent`
-    /// 2nd run through parent in parallel, add children to `children`
-    /// 3rd children = parent, goto 2nd
-    std::vector<CIsochartMesh*> parent;
-    while (!m_currentChartHeap.empty())
-        parent.emplace_back(m_currentChartHeap.cutTopData());
+    /// Every chart in the heap is a work item of a work-stealing scheduler.
+    /// The children of a chart are pushed as soon as its Partition() returns,
+    /// so a thread never waits for the other charts of the same level. When a
+    /// few big charts dominate, the idle threads steal their children.
+    CWorkStealingScheduler<CIsochartMesh*> scheduler;
+    HRESULT hr = scheduler.Init(static_cast<size_t>(omp_get_max_threads()));
+    if (FAILED(hr))
+        return hr;
 
-    HRESULT hrOut = S_OK;
-    while (!parent.empty() && !FAILED(hrOut))
+    // Seed the deques with the charts in the heap. The biggest charts go last,
+    // so each thread starts with its biggest one.
+    std::vector<CIsochartMesh*> seeds;
+    try
     {
-        std::vector<CIsochartMesh*> children;
+        seeds.reserve(currentChartHeap.size());
+        while (!currentChartHeap.empty())
+            seeds.emplace_back(currentChartHeap.cutTopData());
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    std::stable_sort(seeds.begin(), seeds.end(),
+        [](CIsochartMesh* a, CIsochartMesh* b) { return a->GetFaceNumber() < b->GetFaceNumber(); });
+
+    std::atomic<HRESULT> hrOut(S_OK);
+    for (size_t i = 0; i < seeds.size(); i++)
+    {
+        hr = scheduler.Push(i, &seeds[i], 1);
+        if (FAILED(hr))
+        {
+            // The charts already pushed are dropped by the workers below
+            hrOut = hr;
+            for (; i < seeds.size(); i++)
+            {
+                if (!seeds[i]->IsInitChart())
+                    delete seeds[i];
+            }
+            break;
+        }
+    }
+
+    const size_t dwFirstFinalChart = finalChartList.size();
+
+    // Guards finalChartList. A lock of this call, not a global critical
+    // section, so concurrent engines don't wait for each other.
+    omp_lock_t finalChartLock;
+    omp_init_lock(&finalChartLock);
+
 #pragma omp parallel
+    {
+        const auto dwWorker = static_cast<size_t>(omp_get_thread_num());
+        std::vector<CIsochartMesh*> children;
+
+        // Records the first failure and drops the chart, so after a failure
+        // the remaining charts are only freed
+        auto dropChart = [&](CIsochartMesh* pChart, HRESULT hrChart)
         {
+            HRESULT hrExpected = S_OK;
+            hrOut.compare_exchange_strong(hrExpected, hrChart);
+            if (!pChart->IsInitChart())
+                delete pChart;
+            scheduler.Finish();
+        };
+
+        CIsochartMesh* pChart = nullptr;
+        while (scheduler.Pop(dwWorker, pChart))
+        {
+            assert(pChart != nullptr);
+            _Analysis_assume_(pChart != nullptr);
 
-            std::vector<CIsochartMesh*> children_thrd;
-#pragma omp for
-            for (int n = 0; n < static_cast<int>(parent.size()); ++n)
+            // Process current chart, if it's needed to be partitioned again,
+            // Just partition it.
+            HRESULT hrChart = hrOut;
+            if (SUCCEEDED(hrChart))
             {
-                if (FAILED(hrOut)) // for the other threads
-                    break;
+                hrChart = pChart->Partition(); /// Adds children to pChart->m_children						// hotspot
+            }
 
-                auto pChart = parent[n];
-                assert(pChart != nullptr);
-                _Analysis_assume_(pChart != nullptr);
+            if (FAILED(hrChart))
+            {
+                dropChart(pChart, hrChart);
+                continue;
+            }
 
-                // Process current chart, if it's needed to be partitioned again,
-                // Just partition it.
-                HRESULT hr = pChart->Partition(); /// Adds children to pChart->m_children						// hotspot
-                if (FAILED(hr))
+            // If current chart has been partitoned, just push its children to be
+            // processed later.
+            if (pChart->HasChildren())
+            {
+                try
+                {
+                    children.clear();
+                    for (uint32_t i = 0; i < pChart->GetChildrenCount(); i++)
+                    {
+                        assert(pChart->GetChild(i) != nullptr);
+                        children.emplace_back(pChart->GetChild(i));
+                    }
+                    hrChart = scheduler.Push(dwWorker, children.data(), children.size());
+                }
+                catch (std::bad_alloc&)
                 {
-                    hrOut = hr; // doesn't need pragma atomic as all changes to hrOut are to set it to FAILED
-                    break;
+                    hrChart = E_OUTOFMEMORY;
                 }
 
-                // If current chart has been partitoned, just children add to heap to be
-                // processed later.
-                if (pChart->HasChildren())
+                if (FAILED(hrChart))
                 {
-                    /// Add children to children vector to be ran in the following parallelization run
-                    for (uint32_t i = 0; i < pChart->GetChildrenCount(); i++)
-                    {
-                        CIsochartMesh* pChild = pChart->GetChild(i);
-                        assert(pChild != nullptr);
+                    dropChart(pChart, hrChart);
+                    continue;
+                }
 
-                        if (pChild->GetVertexNumber() == 4 && (pChild->GetVertexBuffer()[0]).dwIDInRootMesh == 228)
-                        {
-                            DPF(3, "hello...");
-                        }
+                pChart->UnlinkAllChildren();
+                if (!pChart->IsInitChart())
+                    delete pChart;
+            }
+            else // A right parameterization (with acceptable face overturn) has been gotten, add current chart to final Chart List
+            {
+                // The exception must not leave the lock held
+                omp_set_lock(&finalChartLock);
+                try
+                {
+                    finalChartList.push_back(pChart);
+                }
+                catch (std::bad_alloc&)
+                {
+                    hrChart = E_OUTOFMEMORY;
+                }
+                omp_unset_lock(&finalChartLock);
 
-                        children_thrd.emplace_back(pChild);
-                    }
-                    pChart->UnlinkAllChildren();
-                    if (!pChart->IsInitChart())
-                        delete pChart;
+                if (FAILED(hrChart))
+                {
+                    dropChart(pChart, hrChart);
+                    continue;
                 }
-                else // A right parameterization (with acceptable face overturn) has been gotten, add current chart to final Chart List
+
+                if (bFirstTime)
                 {
-                    try
-                    {
-#pragma omp critical
-                        m_finalChartList.push_back(pChart);
-                    }
-                    catch (std::bad_alloc&)
+                    hrChart = m_callbackSchemer.UpdateCallbackAdapt(pChart->GetFaceNumber());
+                    if (FAILED(hrChart))
                     {
-                        hrOut = E_OUTOFMEMORY;
+                        HRESULT hrExpected = S_OK;
+                        hrOut.compare_exchange_strong(hrExpected, hrChart);
                     }
                 }
             }
-#pragma omp critical
-            {
-                children.insert(children.end(), children_thrd.begin(), children_thrd.end());
-                // std::move(children_thrd.begin(), children_thrd.end(), std::back_inserter(children)); // Might be faster if the objects in vector have move constructor. Needs testing
-            }
+            scheduler.Finish();
         }
-        parent = children;
     }
 
+    omp_destroy_lock(&finalChartLock);
+
+    if (FAILED(hrOut))
+        return hrOut;
+
+    // Charts are finished in whatever order the threads get to them. Order the
+    // new final charts by their first face, which belongs to no other chart, so
+    // the result does not depend on the number of threads.
+    std::sort(finalChartList.begin() + static_cast<ptrdiff_t>(dwFirstFinalChart), finalChartList.end(),
+        [](CIsochartMesh* a, CIsochartMesh* b)
+        {
+            return a->GetFaceBuffer()[0].dwIDInRootMesh < b->GetFaceBuffer()[0].dwIDInRootMesh;
+        });
+
     // 3.2 Update status
     if (bFirstTime)
     {
-        HRESULT hr = m_callbackSchemer.FinishWorkAdapt();
+        hr = m_callbackSchemer.FinishWorkAdapt();
         if (FAILED(hr))
             return hr;
 
         if (dwExpectChartCount > 0)
         {
             size_t dwStep = 0;
-            if (MaxChartNumber > m_currentChartHeap.size())
+            if (MaxChartNumber > currentChartHeap.size())
             {
-                dwStep = MaxChartNumber - m_currentChartHeap.size();
+                dwStep = MaxChartNumber - currentChartHeap.size();
             }
             m_callbackSchemer.InitCallBackAdapt(dwStep, 0.70f, 0.40f);
         }
@@ -393,14 +461,16 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeapParallelized(
 #else
 
 HRESULT CIsochartEngine::ParameterizeChartsInHeap(
+    CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
+    std::vector<CIsochartMesh*>& finalChartList,
     bool bFirstTime,
     size_t MaxChartNumber)
 {
     // 3.1 If Any charts needed to be partitioned
-    while (!m_currentChartHeap.empty())
+    while (!currentChartHeap.empty())
     {
-        DPF(1, "Processed charts number is : %zu", m_finalChartList.size() + m_currentChartHeap.size());
-        auto pChart = m_currentChartHeap.cutTopData();
+        DPF(1, "Processed charts number is : %zu", finalChartList.size() + currentChartHeap.size());
+        auto pChart = currentChartHeap.cutTopData();
         assert(pChart != nullptr);
         _Analysis_assume_(pChart != nullptr);
 
@@ -416,7 +486,7 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeap(
         // processed later.
         if (pChart->HasChildren())
         {
-            if (FAILED(hr = AddChildrenToCurrentChartHeap(pChart)))
+            if (FAILED(hr = AddChildrenToCurrentChartHeap(currentChartHeap, pChart)))
             {
                 delete pChart;
                 return hr;
@@ -436,7 +506,7 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeap(
         {
             try
             {
-                m_finalChartList.push_back(pChart);
+                finalChartList.push_back(pChart);
             }
             catch (std::bad_alloc&)
             {
@@ -462,9 +532,9 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeap(
         if (dwExpectChartCount > 0)
         {
             size_t dwStep = 0;
-            if (MaxChartNumber > m_currentChartHeap.size())
+            if (MaxChartNumber > currentChartHeap.size())
             {
-                dwStep = MaxChartNumber - m_currentChartHeap.size();
+                dwStep = MaxChartNumber - currentChartHeap.size();
             }
             m_callbackSchemer.InitCallBackAdapt(dwStep, 0.70f, 0.40f);
         }
@@ -478,7 +548,9 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeap(
 }
 #endif
 
-HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
+HRESULT CIsochartEngine::GenerateNewChartsToParameterize(
+    CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
+    std::vector<CIsochartMesh*>& finalChartList)
 {
     CIsochartMesh* pChartWithMaxL2Stretch = nullptr;
     uint32_t dwMaxIdx = 0;
@@ -487,17 +559,17 @@ HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
     {
         float fMaxStretch;
         dwMaxIdx = CIsochartMesh::GetChartWidthLargestGeoAvgStretch(
-            m_finalChartList,
+            finalChartList,
             fMaxStretch);
     }
     else
     {
         dwMaxIdx =
-            CIsochartMesh::GetBestPartitionCanidate(m_finalChartList);
+            CIsochartMesh::GetBestPartitionCanidate(finalChartList);
     }
     assert(INVALID_INDEX != dwMaxIdx);
 
-    pChartWithMaxL2Stretch = m_finalChartList[dwMaxIdx];
+    pChartWithMaxL2Stretch = finalChartList[dwMaxIdx];
     assert(pChartWithMaxL2Stretch != nullptr);
 
     HRESULT hr = pChartWithMaxL2Stretch->Bipartition3D();
@@ -510,7 +582,7 @@ HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
         if (pChartWithMaxL2Stretch->HasChildren())
         {
             if (FAILED(
-                hr = AddChildrenToCurrentChartHeap(pChartWithMaxL2Stretch)))
+                hr = AddChildrenToCurrentChartHeap(currentChartHeap, pChartWithMaxL2Stretch)))
             {
                 delete pChartWithMaxL2Stretch;
                 return hr;
@@ -524,7 +596,7 @@ HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
             }
         }
     }
-    m_finalChartList.erase(m_finalChartList.begin() + ptrdiff_t(dwMaxIdx));
+    finalChartList.erase(finalChartList.begin() + ptrdiff_t(dwMaxIdx));
     return S_OK;
 }
 
@@ -547,10 +619,13 @@ HRESULT CIsochartEngine::OptimizeParameterizedCharts(
 
         m_baseInfo.fExpectAvgL2SquaredStretch = fExpectAvgL2SquaredStretch;
         // Optimize siginal stretch, but don't break geometric stretch criterion
-        FAILURE_RETURN(
-            CIsochartMesh::OptimizeAllL2SquaredStretch(
-                m_finalChartList,
-                true));
+        {
+            CIsochartStatsTimer timer(m_pStats, ISOCHART_STATS_OPTIMIZE_STRETCH);
+            FAILURE_RETURN(
+                CIsochartMesh::OptimizeAllL2SquaredStretch(
+                    m_finalChartList,
+                    true));
+        }
 
         // computer geometric stretch after optimize signal stretch
         CIsochartMesh::ComputeGeoAvgL2Stretch(
@@ -592,13 +667,15 @@ HRESULT CIsochartEngine::OptimizeParameterizedCharts(
     return hr;
 }
 
-float CIsochartEngine::GetCurrentStretchCriteria()
+float CIsochartEngine::GetCurrentStretchCriteria(
+    std::vector<CIsochartMesh*>& finalChartList,
+    float fMeshArea)
 {
     if (IsIMTSpecified())
     {
         float fMaxStretch = 0;
         CIsochartMesh::GetChartWidthLargestGeoAvgStretch(
-            m_finalChartList,
+            finalChartList,
             fMaxStretch);
 
         return fMaxStretch;
@@ -606,7 +683,8 @@ float CIsochartEngine::GetCurrentStretchCriteria()
     else
     {
         return CIsochartMesh::CalOptimalAvgL2SquaredStretch(
-            m_finalChartList);
+            finalChartList,
+            fMeshArea);
     }
 }
 
@@ -650,6 +728,61 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
     // 2.2 Chart Number Criterion
     dwExpectChartCount = MaxChartNumber;
 
+    // 3. Partition and 4. MergeChart
+    if ((m_dwOptions & UVATLAS_INDEPENDENT_COMPONENTS)
+        && dwExpectChartCount == 0
+        && m_initChartList.size() > 1)
+    {
+        FAILURE_RETURN(PartitionComponentsIndependently());
+    }
+    else
+    {
+        FAILURE_RETURN(PartitionAllCharts(MaxChartNumber, ChartNumberOut, MaxChartStretchOut));
+    }
+
+    // 5. Optimize parameterized charts.
+    float fCurrAvgL2SquaredStretch = INFINITE_STRETCH;
+    FAILURE_RETURN(
+        OptimizeParameterizedCharts(Stretch, fCurrAvgL2SquaredStretch));
+
+    // 6. Export current partition result by set the attribute id of each face
+    // in original mesh
+    if (pFaceAttributeIDOut)
+    {
+        hr = ExportCurrentCharts(
+            m_finalChartList,
+            pFaceAttributeIDOut);
+    }
+
+    ChartNumberOut = m_finalChartList.size();
+    MaxChartStretchOut =
+        CIsochartMesh::ConvertToExternalStretch(
+            fCurrAvgL2SquaredStretch,
+            IsIMTSpecified());
+
+    // detect closed surfaces which have not been correctly partitioned.
+    for (size_t i = 0; i < m_finalChartList.size(); ++i)
+    {
+        if (m_finalChartList[i]->GetVertexNumber() > 0
+            && !m_finalChartList[i]->HasBoundaryVertex())
+        {
+            DPF(0, "UVAtlas Internal error: Closed surface not correctly partitioned");
+            return E_FAIL;
+        }
+    }
+
+    return hr;
+}
+
+// Steps 3 and 4 of PartitionByGlobalAvgL2Stretch when all charts share one
+// chart heap, one stretch criterion and one merge pass.
+HRESULT CIsochartEngine::PartitionAllCharts(
+    size_t MaxChartNumber,
+    size_t& ChartNumberOut,
+    float& MaxChartStretchOut)
+{
+    HRESULT hr = S_OK;
+
     // 3. Partition
     FAILURE_RETURN(InitializeCurrentChartHeap());
     float fCurrAvgL2SquaredStretch = INFINITE_STRETCH;
@@ -663,11 +796,14 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
     do
     {
         // 3.1. Generate initial parameterization for charts in current chart heap
+        {
+            CIsochartStatsTimer timer(m_pStats, ISOCHART_STATS_PARAMETERIZE);
 #ifdef _OPENMP
-        hr = ParameterizeChartsInHeapParallelized(bCountParition, MaxChartNumber);
+            hr = ParameterizeChartsInHeapParallelized(m_currentChartHeap, m_finalChartList, bCountParition, MaxChartNumber);
 #else
-        hr = ParameterizeChartsInHeap(bCountParition, MaxChartNumber);
+            hr = ParameterizeChartsInHeap(m_currentChartHeap, m_finalChartList, bCountParition, MaxChartNumber);
 #endif
+        }
         if (FAILED(hr))
             return hr;
 
@@ -677,16 +813,19 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
 
         // 3.2 Optimize all charts with right parameterization
         // chart 2d area will be compted in this function
-        FAILURE_RETURN(
-            CIsochartMesh::OptimizeAllL2SquaredStretch(
-                m_finalChartList,
-                false));
+        {
+            CIsochartStatsTimer timer(m_pStats, ISOCHART_STATS_OPTIMIZE_STRETCH);
+            FAILURE_RETURN(
+                CIsochartMesh::OptimizeAllL2SquaredStretch(
+                    m_finalChartList,
+                    false));
+        }
 
         // 3.3
         // For geometric case, get current optical average L^2 Squared Stretch
         // For signal case, get max average L^2 Squared stretch around the
         // Charts
-        fCurrAvgL2SquaredStretch = GetCurrentStretchCriteria();
+        fCurrAvgL2SquaredStretch = GetCurrentStretchCriteria(m_finalChartList, m_baseInfo.fMeshArea);
 
         if (dwExpectChartCount != 0)
         {
@@ -718,7 +857,7 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
             || m_finalChartList.size() < dwExpectChartCount)
         {
             FAILURE_RETURN(
-                GenerateNewChartsToParameterize());
+                GenerateNewChartsToParameterize(m_currentChartHeap, m_finalChartList));
         }
 
         // 3.7 Update status
@@ -746,12 +885,16 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
         dwLastChartNumber = m_finalChartList.size();
         m_callbackSchemer.InitCallBackAdapt((2 + m_finalChartList.size()), 0.20f, 0.80f);
 
-        if (FAILED(
+        {
+            CIsochartStatsTimer timer(m_pStats, ISOCHART_STATS_MERGE_CHARTS);
             hr = CIsochartMesh::MergeSmallCharts(
                 m_finalChartList,
                 dwExpectChartCount,
                 m_baseInfo,
-                m_callbackSchemer)))
+                m_baseInfo.fMeshArea,
+                m_callbackSchemer);
+        }
+        if (FAILED(hr))
         {
             return hr;
         }
@@ -762,40 +905,227 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
             return hr;
     }
 
-    // 5. Optimize parameterized charts.
-    FAILURE_RETURN(
-        OptimizeParameterizedCharts(Stretch, fCurrAvgL2SquaredStretch));
+    return S_OK;
+}
 
-    // 6. Export current partition result by set the attribute id of each face
-    // in original mesh
-    if (pFaceAttributeIDOut)
+// Steps 3 and 4 of PartitionByGlobalAvgL2Stretch when each initial chart, that
+// is each connected component of the mesh, is partitioned as an independent
+// job: it has its own chart heap, reaches the stretch criterion on its own and
+// is merged only with itself. The components run in parallel and nothing but
+// the callback is shared between them. Only partitioning by stretch can be
+// split this way, a maximum chart number is a criterion for the whole mesh.
+HRESULT CIsochartEngine::PartitionComponentsIndependently()
+{
+    if (ISOCHART_ST_INITIALIZED != m_state)
     {
-        hr = ExportCurrentCharts(
-            m_finalChartList,
-            pFaceAttributeIDOut);
+        // Partition has every been called. Need to do some clean.
+        ReleaseCurrentCharts();
+        ReleaseFinalCharts();
     }
 
-    ChartNumberOut = m_finalChartList.size();
-    MaxChartStretchOut =
-        CIsochartMesh::ConvertToExternalStretch(
-            fCurrAvgL2SquaredStretch,
-            IsIMTSpecified());
+    const size_t dwComponentCount = m_initChartList.size();
 
-    // detect closed surfaces which have not been correctly partitioned.
-    for (size_t i = 0; i < m_finalChartList.size(); ++i)
+    std::vector<std::vector<CIsochartMesh*>> componentCharts;
+    std::vector<uint32_t> order;
+
+    // Each component times its own optimize and merge passes, the driving
+    // thread adds them to the stats
+    std::vector<ISOCHARTSTAGETIME> optimizeTimes;
+    std::vector<ISOCHARTSTAGETIME> mergeTimes;
+    try
     {
-        if (m_finalChartList[i]->GetVertexNumber() > 0
-            && !m_finalChartList[i]->HasBoundaryVertex())
+        componentCharts.resize(dwComponentCount);
+        order.resize(dwComponentCount);
+        if (m_pStats)
         {
-            DPF(0, "UVAtlas Internal error: Closed surface not correctly partitioned");
-            return E_FAIL;
+            optimizeTimes.resize(dwComponentCount, ISOCHARTSTAGETIME());
+            mergeTimes.resize(dwComponentCount, ISOCHARTSTAGETIME());
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // Start with the biggest components, so a big one isn't left for last
+    for (uint32_t i = 0; i < dwComponentCount; i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&](uint32_t a, uint32_t b)
+        {
+            return m_initChartList[a]->GetFaceNumber() > m_initChartList[b]->GetFaceNumber();
+        });
+
+    m_callbackSchemer.InitCallBackAdapt(m_baseInfo.dwFaceCount, 0.80f, 0);
+
+    HRESULT hr = S_OK;
+    {
+        CIsochartStatsTimer timer(m_pStats, ISOCHART_STATS_PARAMETERIZE);
+
+        std::atomic<HRESULT> hrOut(S_OK);
+
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < static_cast<int>(dwComponentCount); i++)
+        {
+            if (FAILED(hrOut))
+                // 'break' isn't allowed in an OpenMP for loop
+                continue;
+
+            const size_t dwComponent = order[size_t(i)];
+            CIsochartMesh* pComponent = m_initChartList[dwComponent];
+
+            HRESULT hrComponent = PartitionComponent(
+                pComponent,
+                componentCharts[dwComponent],
+                m_pStats ? &optimizeTimes[dwComponent] : nullptr,
+                m_pStats ? &mergeTimes[dwComponent] : nullptr);
+            if (SUCCEEDED(hrComponent))
+            {
+                hrComponent = m_callbackSchemer.UpdateCallbackAdapt(pComponent->GetFaceNumber());
+            }
+            if (FAILED(hrComponent))
+            {
+                HRESULT hrExpected = S_OK;
+                hrOut.compare_exchange_strong(hrExpected, hrComponent);
+            }
+        }
+
+        hr = hrOut;
+    }
+
+    // The components ran in parallel, so these are the sums of their times
+    // and are also part of the parameterize stage's wall-clock time
+    if (m_pStats)
+    {
+        for (size_t i = 0; i < dwComponentCount; i++)
+        {
+            m_pStats->AddStageTime(ISOCHART_STATS_OPTIMIZE_STRETCH, optimizeTimes[i]);
+            m_pStats->AddStageTime(ISOCHART_STATS_MERGE_CHARTS, mergeTimes[i]);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = m_callbackSchemer.FinishWorkAdapt();
+    }
+
+    // Gather the charts in the order of the components, so the result does
+    // not depend on the number of threads.
+    if (SUCCEEDED(hr))
+    {
+        size_t dwChartCount = 0;
+        for (size_t i = 0; i < dwComponentCount; i++)
+        {
+            dwChartCount += componentCharts[i].size();
+        }
+
+        try
+        {
+            m_finalChartList.reserve(dwChartCount);
+        }
+        catch (std::bad_alloc&)
+        {
+            hr = E_OUTOFMEMORY;
+        }
+    }
+
+    for (size_t i = 0; i < dwComponentCount; i++)
+    {
+        if (SUCCEEDED(hr))
+        {
+            m_finalChartList.insert(m_finalChartList.end(), componentCharts[i].cbegin(), componentCharts[i].cend());
+        }
+        else
+        {
+            ReleaseFinalCharts(componentCharts[i]);
+        }
+    }
+
+    DPF(0, "Charts of %zu components %zu", dwComponentCount, m_finalChartList.size());
+    return hr;
+}
+
+// Partitions one component until its charts reach the stretch criterion, then
+// merges its small charts. Runs on the calling thread only, finalChartList is
+// empty on failure. The time of the optimize and merge passes is added to
+// pOptimizeTime and pMergeTime unless they are nullptr. The merge doesn't add
+// to the progress, which counts the faces of the finished components.
+HRESULT CIsochartEngine::PartitionComponent(
+    CIsochartMesh* pComponent,
+    std::vector<CIsochartMesh*>& finalChartList,
+    ISOCHARTSTAGETIME* pOptimizeTime,
+    ISOCHARTSTAGETIME* pMergeTime)
+{
+    // The stretch of the component is averaged over its own area, so that the
+    // charts of all components together still reach the criterion
+    const float fComponentArea = pComponent->GetChart3DArea();
+
+    CMaxHeap<float, CIsochartMesh*> currentChartHeap;
+    currentChartHeap.SetManageMode(AUTOMATIC);
+    if (!currentChartHeap.insertData(pComponent, 0))
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    HRESULT hr = S_OK;
+    do
+    {
+        // 3.1 Generate initial parameterization for the charts in the heap
+#ifdef _OPENMP
+        hr = ParameterizeChartsInHeapParallelized(currentChartHeap, finalChartList, false, 0);
+#else
+        hr = ParameterizeChartsInHeap(currentChartHeap, finalChartList, false, 0);
+#endif
+        if (FAILED(hr))
+            break;
+
+        // 3.2 Optimize all charts with right parameterization
+        {
+            CIsochartStageTimeScope timer(pOptimizeTime);
+            hr = CIsochartMesh::OptimizeAllL2SquaredStretch(finalChartList, false);
+        }
+        if (FAILED(hr))
+            break;
+
+        // 3.6 If the component doesn't reach the expected stretch criteria,
+        // Selete a canidate to parition and parameterize the children.
+        if (!CIsochartMesh::IsReachExpectedTotalAvgL2SqrStretch(
+            GetCurrentStretchCriteria(finalChartList, fComponentArea),
+            fExpectAvgL2SquaredStretch))
+        {
+            hr = GenerateNewChartsToParameterize(currentChartHeap, finalChartList);
+            if (FAILED(hr))
+                break;
         }
+
+        hr = m_callbackSchemer.CheckPointAdapt();
+    } while (SUCCEEDED(hr) && !currentChartHeap.empty());
+
+    // 4. MergeChart, only with the charts of this component
+    if (SUCCEEDED(hr))
+    {
+        CIsochartStageTimeScope timer(pMergeTime);
+        hr = CIsochartMesh::MergeSmallCharts(
+            finalChartList,
+            0,
+            m_baseInfo,
+            fComponentArea,
+            m_callbackSchemer,
+            false);
     }
 
+    if (FAILED(hr))
+    {
+        ReleaseCurrentCharts(currentChartHeap);
+        ReleaseFinalCharts(finalChartList);
+    }
     return hr;
 }
 
 HRESULT CIsochartEngine::AddChildrenToCurrentChartHeap(
+    CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
     CIsochartMesh* pChart)
 {
     HRESULT hr = S_OK;
@@ -810,7 +1140,7 @@ HRESULT CIsochartEngine::AddChildrenToCurrentChartHeap(
             DPF(3, "hello...");
         }
 
-        if (!m_currentChartHeap.insertData(pChild, 0))
+        if (!currentChartHeap.insertData(pChild, 0))
         {
             return E_OUTOFMEMORY;
         }
@@ -870,12 +1200,16 @@ HRESULT CIsochartEngine::Pack(
 
     m_callbackSchemer.InitCallBackAdapt(m_finalChartList.size() + 1, 0.95f, 0);
 
-    if (FAILED(hr = CIsochartMesh::PackingCharts(
-        m_finalChartList,
-        Width,
-        Height,
-        Gutter,
-        m_callbackSchemer)))
+    {
+        CIsochartStatsTimer timer(m_pStats, ISOCHART_STATS_PACK_CHARTS);
+        hr = CIsochartMesh::PackingCharts(
+            m_finalChartList,
+            Width,
+            Height,
+            Gutter,
+            m_callbackSchemer);
+    }
+    if (FAILED(hr))
     {
         goto LEnd;
     }
@@ -1019,6 +1353,66 @@ HRESULT CIsochartEngine::SetStage(
 
 }
 
+// -------------------------------------------------------------------------------
+//  function    SetStats
+//
+//   Description:   set the collector of per-stage timings and counters,
+//                  which also carries the cancellation of the call.
+//
+//   returns    S_OK if successful, else failure code
+//
+HRESULT CIsochartEngine::SetStats(
+    CIsochartStats* pStats) noexcept
+{
+    HRESULT hr = S_OK;
+
+    // 1. Try to enter exclusive section
+    if (FAILED(hr = TryEnterExclusiveSection()))
+    {
+        return hr;
+    }
+
+    m_pStats = pStats;
+    m_callbackSchemer.SetCancellation(pStats);
+
+    LeaveExclusiveSection();
+
+    return hr;
+}
+
+// -------------------------------------------------------------------------------
+//  function    SetBufferPool
+//
+//   Description:   set the pool the mesh arrays, chart topology and per-chart
+//                  work buffers are allocated from, so they can be reused by
+//                  later calls. nullptr restores the engine's own pool.
+//
+//   returns    S_OK if successful, else failure code
+//
+HRESULT CIsochartEngine::SetBufferPool(
+    CIsochartBufferPool* pBufferPool) noexcept
+{
+    HRESULT hr = S_OK;
+
+    // 1. Buffers must be freed to the pool they were allocated from
+    if (m_state != ISOCHART_ST_UNINITILAIZED)
+    {
+        return E_UNEXPECTED;
+    }
+
+    // 2. Try to enter exclusive section
+    if (FAILED(hr = TryEnterExclusiveSection()))
+    {
+        return hr;
+    }
+
+    m_baseInfo.pBufferPool = pBufferPool ? pBufferPool : &m_bufferPool;
+
+    LeaveExclusiveSection();
+
+    return hr;
+}
+
 HRESULT CIsochartEngine::ExportPartitionResult(
     std::vector<UVAtlasVertex>* pvVertexArrayOut,
     std::vector<uint8_t>* pvFaceIndexArrayOut,
@@ -1216,6 +1610,8 @@ HRESULT CIsochartEngine::ApplyInitEngine(
 {
     HRESULT hr = S_OK;
 
+    CIsochartStatsTimer timer(m_pStats, ISOCHART_STATS_ROOT_CHART);
+
     // 1. Build Root Chart
     auto pRootChart = new (std::nothrow) CIsochartMesh(baseInfo, m_callbackSchemer, *this);
     if (!pRootChart)
@@ -1333,9 +1729,15 @@ HRESULT CIsochartEngine::ApplyInitEngine(
 //
 void CIsochartEngine::ReleaseCurrentCharts()
 {
-    while (!m_currentChartHeap.empty())
+    ReleaseCurrentCharts(m_currentChartHeap);
+}
+
+void CIsochartEngine::ReleaseCurrentCharts(
+    CMaxHeap<float, CIsochartMesh*>& currentChartHeap)
+{
+    while (!currentChartHeap.empty())
     {
-        CIsochartMesh* pChart = m_currentChartHeap.cutTopData();
+        CIsochartMesh* pChart = currentChartHeap.cutTopData();
         assert(pChart != nullptr);
         _Analysis_assume_(pChart != nullptr);
         // Don't delete charts that also in init chart list here.
@@ -1353,9 +1755,15 @@ void CIsochartEngine::ReleaseCurrentCharts()
 
 void CIsochartEngine::ReleaseFinalCharts()
 {
-    for (size_t i = 0; i < m_finalChartList.size(); i++)
+    ReleaseFinalCharts(m_finalChartList);
+}
+
+void CIsochartEngine::ReleaseFinalCharts(
+    std::vector<CIsochartMesh*>& finalChartList)
+{
+    for (size_t i = 0; i < finalChartList.size(); i++)
     {
-        CIsochartMesh* pChart = m_finalChartList[i];
+        CIsochartMesh* pChart = finalChartList[i];
         // Don't delete charts that also in init chart list here.
         if (pChart && !pChart->IsInitChart())
         {
@@ -1363,7 +1771,7 @@ void CIsochartEngine::ReleaseFinalCharts()
         }
 
     }
-    m_finalChartList.clear();
+    finalChartList.clear();
 }
 
 // -----------------------------------------------------------------------------
@@ -1804,31 +2212,14 @@ HRESULT CIsochartEngine::FillExportFaceAdjacencyBuffer(
 
 HRESULT CIsochartEngine::TryEnterExclusiveSection()
 {
-#ifdef WIN32
-    // Other thread is using this object.
-    if (WaitForSingleObjectEx(m_hMutex, 0, FALSE) == WAIT_OBJECT_0)
-    {
-        return S_OK;
-    }
-    else
-    {
-        return E_ABORT;
-    }
-#else
-    return m_mutex.try_lock() ? S_OK : E_ABORT;
-#endif
+    // Fails if another thread is in a public method of this object
+    bool bBusy = false;
+    return m_bBusy.compare_exchange_strong(bBusy, true) ? S_OK : E_ABORT;
 }
 
 void  CIsochartEngine::LeaveExclusiveSection()
 {
-#ifdef WIN32
-    if (m_hMutex)
-    {
-        ReleaseMutex(m_hMutex);
-    }
-#else
-    m_mutex.unlock();
-#endif
+    m_bBusy = false;
 }
 
 
@@ -1846,7 +2237,9 @@ bool Isochart::CheckInitializeParameters(
     UNREFERENCED_PARAMETER(FaceCount);
     UNREFERENCED_PARAMETER(pIMTArray);
 
-    if ((dwOptions & _OPTION_ISOCHART_GEODESIC_FAST) && (dwOptions & _OPTION_ISOCHART_GEODESIC_QUALITY))
+    // at most one geodesic distance algorithm can be chosen
+    const unsigned int dwGeodesic = dwOptions & _OPTIONMASK_ISOCHART_GEODESIC;
+    if (dwGeodesic & (dwGeodesic - 1))
         return false;
 
     // 1. Vertex buffer
@@ -11,6 +11,7 @@
 
 #include "basemeshinfo.h"
 #include "callbackschemer.h"
+#include "isochartstats.h"
 #include "maxheap.hpp"
 
 
@@ -65,6 +66,12 @@ namespace Isochart
             unsigned int TotalStageCount,
             unsigned int DoneStageCount) noexcept override;
 
+        HRESULT SetStats(
+            CIsochartStats* pStats) noexcept override;
+
+        HRESULT SetBufferPool(
+            CIsochartBufferPool* pBufferPool) noexcept override;
+
         HRESULT ExportPartitionResult(
             std::vector<DirectX::UVAtlasVertex>* pvVertexArrayOut,
             std::vector<uint8_t>* pvFaceIndexArrayOut,
@@ -79,7 +86,6 @@ namespace Isochart
             size_t FaceCount,
             const uint32_t* pdwFaceAdjacentArrayIn) noexcept override;
 
-        HRESULT CreateEngineMutex();
     private:
         enum EngineState
         {
@@ -113,6 +119,7 @@ namespace Isochart
         // Internal partiton
         HRESULT InitializeCurrentChartHeap();
         HRESULT AddChildrenToCurrentChartHeap(
+            CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
             CIsochartMesh* pChart);
 
         HRESULT PartitionByGlobalAvgL2Stretch(
@@ -121,22 +128,43 @@ namespace Isochart
             size_t& ChartNumberOut,
             float& MaxChartStretchOut,
             uint32_t* pFaceAttributeIDOut);
+
+        HRESULT PartitionAllCharts(
+            size_t MaxChartNumber,
+            size_t& ChartNumberOut,
+            float& MaxChartStretchOut);
+
+        HRESULT PartitionComponentsIndependently();
+
+        HRESULT PartitionComponent(
+            CIsochartMesh* pComponent,
+            std::vector<CIsochartMesh*>& finalChartList,
+            ISOCHARTSTAGETIME* pOptimizeTime,
+            ISOCHARTSTAGETIME* pMergeTime);
 #ifdef _OPENMP
         HRESULT ParameterizeChartsInHeapParallelized(
+            CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
+            std::vector<CIsochartMesh*>& finalChartList,
             bool bFirstTime,
             size_t MaxChartNumber);
 #else
         HRESULT ParameterizeChartsInHeap(
+            CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
+            std::vector<CIsochartMesh*>& finalChartList,
             bool bFirstTime,
             size_t MaxChartNumber);
 #endif
-        HRESULT GenerateNewChartsToParameterize();
+        HRESULT GenerateNewChartsToParameterize(
+            CMaxHeap<float, CIsochartMesh*>& currentChartHeap,
+            std::vector<CIsochartMesh*>& finalChartList);
 
         HRESULT OptimizeParameterizedCharts(
             float Stretch,
             float& fFinalGeoAvgL2Stretch);
 
-        float GetCurrentStretchCriteria();
+        float GetCurrentStretchCriteria(
+            std::vector<CIsochartMesh*>& finalChartList,
+            float fMeshArea);
 
         // ExportXXXX
         HRESULT ExportCurrentCharts(
@@ -197,8 +225,12 @@ namespace Isochart
         void ReleaseInitialCharts();
 
         void ReleaseCurrentCharts();
+        static void ReleaseCurrentCharts(
+            CMaxHeap<float, CIsochartMesh*>& currentChartHeap);
 
         void ReleaseFinalCharts();
+        static void ReleaseFinalCharts(
+            std::vector<CIsochartMesh*>& finalChartList);
 
         // Following methods guarantee Isochart instance is running an exclusive
         // task.
@@ -220,12 +252,19 @@ namespace Isochart
         }
 
     private:
+        // Pool of the buffers and chart topology, unless the caller set one.
+        // Declared first, so it outlives everything allocated from it.
+        CIsochartBufferPool m_bufferPool;
+
         // Basic information needed for parameterization.
         CBaseMeshInfo m_baseInfo;
 
         // Manage callback operation.
         CCallbackSchemer m_callbackSchemer;
 
+        // Per-stage statistics, nullptr if the caller didn't request them.
+        CIsochartStats* m_pStats;
+
         // The charts to be partitioned
         CMaxHeap<float, CIsochartMesh*> m_currentChartHeap;
 
@@ -240,11 +279,9 @@ namespace Isochart
 
         EngineState m_state;	// Indicate internal state.
 
-#ifdef WIN32
-        HANDLE m_hMutex;
-#else
-        std::mutex m_mutex;
-#endif
+        // Set while a public method runs. Only rejects a second call into the
+        // same engine, different engines never wait on each other.
+        std::atomic<bool> m_bBusy;
 
         unsigned int m_dwOptions;
 
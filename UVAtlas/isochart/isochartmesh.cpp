@@ -43,6 +43,10 @@
         Computing geodesics on manifolds.
         In Proceedings of Nat'l Academy Sciences(1998),
         pp. 8431-8435
+
+        [CWW13] CRANE K., WEISCHEDEL C., WARDETZKY M.:
+        Geodesics in heat: a new approach to computing distance based on heat flow.
+        ACM Transactions on Graphics 32, 5 (2013)
 */
 
 #include "pch.h"
@@ -99,6 +103,12 @@ CIsochartMesh::CIsochartMesh(
     m_dwFaceNumber(0),
     m_pFaces(nullptr),
     m_dwEdgeNumber(0),
+    m_edges(CBufferPoolAllocator<ISOCHARTEDGE>(baseInfo.pBufferPool)),
+    m_dwAdjacencySize(0),
+    m_pdwAdjacency(nullptr),
+    m_pfGeodesicDistance(nullptr),
+    m_pdwNextVertIDOnPath(nullptr),
+    m_pdwBoundaryBits(nullptr),
     m_pFather(nullptr),
     m_fBoxDiagLen(0),
     m_fParamStretchL2(0),
@@ -114,8 +124,14 @@ CIsochartMesh::CIsochartMesh(
     m_bIsParameterized(false),
     m_bOptimizedL2Stretch(false),
     m_bOrderedLandmark(false),
-    m_bNeedToClean(false)
+    m_bNeedToClean(false),
+    m_adjacencyMemory(IsochartEngine.m_pStats, ISOCHART_MEMORY_VERTEX_ADJACENCY),
+    m_windowMemory(IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_WINDOWS)
 {
+    if (m_IsochartEngine.m_pStats)
+    {
+        m_IsochartEngine.m_pStats->AddChartsCreated(1);
+    }
 }
 
 CIsochartMesh::~CIsochartMesh()
@@ -134,10 +150,14 @@ void CIsochartMesh::DeleteChildren()
 
 void CIsochartMesh::Free()
 {
-    SAFE_DELETE_ARRAY(m_pVerts)
-        SAFE_DELETE_ARRAY(m_pFaces)
-
-        DestroyPakingInfoBuffer();
+    DeleteArray(m_baseInfo.pBufferPool, m_pVerts);
+    FreeArray(m_baseInfo.pBufferPool, m_pFaces);
+    FreeArray(m_baseInfo.pBufferPool, m_pdwAdjacency);
+    m_dwAdjacencySize = 0;
+    m_adjacencyMemory.Release();
+    FreeVertexSweepArrays();
+
+    DestroyPakingInfoBuffer();
     DeleteChildren();
 }
 
@@ -233,19 +253,17 @@ namespace
         size_t dwFaceCount)
     {
         const INDEXTYPE* pFacesInBase =
-            static_cast<INDEXTYPE*>(const_cast<void*>(pFaceIndexArray));
-
-        ISOCHARTFACE* pFace = pFaceBuffer;
-        const INDEXTYPE* pFacesIn = pFacesInBase;
+            static_cast<const INDEXTYPE*>(pFaceIndexArray);
 
-        for (uint32_t i = 0; i < dwFaceCount; i++)
+#pragma omp parallel for if (dwFaceCount >= PARALLEL_PREPROCESS_MIN_FACES)
+        for (int i = 0; i < static_cast<int>(dwFaceCount); i++)
         {
-            pFace->dwID = pFace->dwIDInRootMesh = i;
+            ISOCHARTFACE* pFace = pFaceBuffer + i;
+            const INDEXTYPE* pFacesIn = pFacesInBase + size_t(i) * 3;
+            pFace->dwID = pFace->dwIDInRootMesh = static_cast<uint32_t>(i);
             pFace->dwVertexID[0] = pFacesIn[0];
             pFace->dwVertexID[1] = pFacesIn[1];
             pFace->dwVertexID[2] = pFacesIn[2];
-            pFace++;
-            pFacesIn += 3;
         }
     }
 }
@@ -270,27 +288,28 @@ HRESULT CIsochartMesh::BuildRootChart(
     assert(dwFaceCount > 0);
 
     // 1. allocate resource of root Mesh
-    pChart->m_pFaces = new (std::nothrow) ISOCHARTFACE[dwFaceCount];
+    pChart->m_pFaces = AllocateArray<ISOCHARTFACE>(baseInfo.pBufferPool, dwFaceCount);
     if (!pChart->m_pFaces)
     {
         return E_OUTOFMEMORY;
     }
 
-    pChart->m_pVerts = new (std::nothrow) ISOCHARTVERTEX[dwVertexCount];
+    pChart->m_pVerts = NewArray<ISOCHARTVERTEX>(baseInfo.pBufferPool, dwVertexCount);
     if (!pChart->m_pVerts)
     {
-        SAFE_DELETE_ARRAY(pChart->m_pFaces)
-            return E_OUTOFMEMORY;
+        FreeArray(baseInfo.pBufferPool, pChart->m_pFaces);
+        return E_OUTOFMEMORY;
     }
 
     // 2. fill in the basic information of the mesh.
     pChart->m_dwFaceNumber = dwFaceCount;
     pChart->m_dwVertNumber = dwVertexCount;
 
-    for (uint32_t i = 0; i < dwVertexCount; i++)
+#pragma omp parallel for if (dwFaceCount >= PARALLEL_PREPROCESS_MIN_FACES)
+    for (int i = 0; i < static_cast<int>(dwVertexCount); i++)
     {
-        pChart->m_pVerts[i].dwID = i;
-        pChart->m_pVerts[i].dwIDInRootMesh = i;
+        pChart->m_pVerts[i].dwID = static_cast<uint32_t>(i);
+        pChart->m_pVerts[i].dwIDInRootMesh = static_cast<uint32_t>(i);
     }
 
     if (DXGI_FORMAT_R32_UINT == IndexFormat)
@@ -633,9 +652,9 @@ HRESULT CIsochartMesh::ReBuildRootChartByAdjacence()
 
     if (dwNewVertCount != m_dwVertNumber)
     {
-        SAFE_DELETE_ARRAY(m_pVerts)
-            m_dwVertNumber = dwNewVertCount;
-        m_pVerts = new (std::nothrow) ISOCHARTVERTEX[m_dwVertNumber];
+        DeleteArray(m_baseInfo.pBufferPool, m_pVerts);
+        m_dwVertNumber = dwNewVertCount;
+        m_pVerts = NewArray<ISOCHARTVERTEX>(m_baseInfo.pBufferPool, m_dwVertNumber);
         if (!m_pVerts)
         {
             return E_OUTOFMEMORY;
@@ -722,6 +741,8 @@ HRESULT CIsochartMesh::Partition()
 {
     assert(m_bVertImportanceDone);
 
+    CIsochartTraceScope trace(m_IsochartEngine.m_pStats, "Partition", m_dwFaceNumber);
+
     HRESULT hr = S_OK;
 
     // With/without IMT, pfVertGeodesicDistance contains geodesic distance.
@@ -732,6 +753,10 @@ HRESULT CIsochartMesh::Partition()
     float* pfVertCombineDistance = nullptr;
     float* pfVertMappingCoord = nullptr;
 
+    // Charges for the three arrays above, released with them on return
+    CIsochartMemoryCharge distanceMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_DISTANCE);
+    CIsochartMemoryCharge coordMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_ISOMAP);
+
     size_t dwBoundaryNumber = 0;
     bool bIsSimpleChart = false;
     bool bSpecialShape = false;
@@ -773,7 +798,9 @@ HRESULT CIsochartMesh::Partition()
         dwMaxEigenDimension,
         &pfVertGeodesicDistance,
         &pfVertCombineDistance,
-        &pfVertMappingCoord)) || bIsLikePlane)
+        &pfVertMappingCoord,
+        distanceMemory,
+        coordMemory)) || bIsLikePlane)
     {
         goto LEnd;
     }
@@ -821,15 +848,15 @@ LEnd:
     if (!IsIMTSpecified())
     {
         assert(pfVertGeodesicDistance == pfVertCombineDistance);
-        SAFE_DELETE_ARRAY(pfVertGeodesicDistance)
+        FreeArray(m_baseInfo.pBufferPool, pfVertGeodesicDistance);
     }
     else
     {
-        SAFE_DELETE_ARRAY(pfVertGeodesicDistance)
-            SAFE_DELETE_ARRAY(pfVertCombineDistance)
+        FreeArray(m_baseInfo.pBufferPool, pfVertGeodesicDistance);
+        FreeArray(m_baseInfo.pBufferPool, pfVertCombineDistance);
     }
-    SAFE_DELETE_ARRAY(pfVertMappingCoord)
-        return hr;
+    FreeArray(m_baseInfo.pBufferPool, pfVertMappingCoord);
+    return hr;
 }
 
 HRESULT CIsochartMesh::ComputeBiParitionLandmark()
@@ -920,6 +947,11 @@ HRESULT CIsochartMesh::Bipartition3D()
 
     HRESULT hr = S_OK;
 
+    if (m_IsochartEngine.m_pStats)
+    {
+        m_IsochartEngine.m_pStats->AddBipartitions(1);
+    }
+
     FAILURE_RETURN(ComputeBiParitionLandmark());
 
 #if OPT_3D_BIPARTITION_BOUNDARY_BY_ANGLE
@@ -934,8 +966,12 @@ HRESULT CIsochartMesh::Bipartition3D()
     float* pfVertCombineDistance = nullptr;
     bool bIsPartitionSucceed = false;
 
+    CIsochartMemoryCharge distanceMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_DISTANCE);
+    FAILURE_RETURN(distanceMemory.Add(
+        sizeof(float) * dwLandCount * m_dwVertNumber * (IsIMTSpecified() ? 2 : 1)));
+
     // 1. Calculate Distance (Geodesic & Siganl)  between vertices and landmarks.
-    float* pfVertGeoDistance = new (std::nothrow) float[dwLandCount * m_dwVertNumber];
+    float* pfVertGeoDistance = AllocateArray<float>(m_baseInfo.pBufferPool, dwLandCount * m_dwVertNumber);
     if (!pfVertGeoDistance)
     {
         hr = E_OUTOFMEMORY;
@@ -944,7 +980,7 @@ HRESULT CIsochartMesh::Bipartition3D()
 
     if (IsIMTSpecified())
     {
-        pfVertCombineDistance = new (std::nothrow) float[dwLandCount * m_dwVertNumber];
+        pfVertCombineDistance = AllocateArray<float>(m_baseInfo.pBufferPool, dwLandCount * m_dwVertNumber);
         if (!pfVertCombineDistance)
         {
             hr = E_OUTOFMEMORY;
@@ -1014,12 +1050,12 @@ LEnd:
     if (!IsIMTSpecified())
     {
         assert(pfVertCombineDistance == pfVertGeoDistance);
-        SAFE_DELETE_ARRAY(pfVertGeoDistance)
+        FreeArray(m_baseInfo.pBufferPool, pfVertGeoDistance);
     }
     else
     {
-        SAFE_DELETE_ARRAY(pfVertCombineDistance)
-            SAFE_DELETE_ARRAY(pfVertGeoDistance)
+        FreeArray(m_baseInfo.pBufferPool, pfVertCombineDistance);
+        FreeArray(m_baseInfo.pBufferPool, pfVertGeoDistance);
     }
 
     return hr;
@@ -1040,6 +1076,10 @@ HRESULT CIsochartMesh::Bipartition2D()
     std::vector<uint32_t> keyVerts;
     float* pfVertCombineDistance = nullptr;
 
+    CIsochartMemoryCharge distanceMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_DISTANCE);
+    FAILURE_RETURN(distanceMemory.Add(
+        sizeof(float) * 2 * m_dwVertNumber * (IsIMTSpecified() ? 2 : 1)));
+
     try
     {
         keyVerts.resize(2);
@@ -1067,7 +1107,7 @@ HRESULT CIsochartMesh::Bipartition2D()
 
     // 3. Calculate the goedesic distance from other vertices to these 2
     // vertices
-    float* pfVertGeoDistance = new (std::nothrow) float[2 * m_dwVertNumber];
+    float* pfVertGeoDistance = AllocateArray<float>(m_baseInfo.pBufferPool, 2 * m_dwVertNumber);
     if (!pfVertGeoDistance)
     {
         hr = E_OUTOFMEMORY;
@@ -1076,7 +1116,7 @@ HRESULT CIsochartMesh::Bipartition2D()
 
     if (IsIMTSpecified())
     {
-        pfVertCombineDistance = new (std::nothrow) float[2 * m_dwVertNumber];
+        pfVertCombineDistance = AllocateArray<float>(m_baseInfo.pBufferPool, 2 * m_dwVertNumber);
         if (!pfVertCombineDistance)
         {
             hr = E_OUTOFMEMORY;
@@ -1108,12 +1148,12 @@ LEnd:
     if (!IsIMTSpecified())
     {
         assert(pfVertCombineDistance == pfVertGeoDistance);
-        SAFE_DELETE_ARRAY(pfVertGeoDistance)
+        FreeArray(m_baseInfo.pBufferPool, pfVertGeoDistance);
     }
     else
     {
-        SAFE_DELETE_ARRAY(pfVertCombineDistance)
-            SAFE_DELETE_ARRAY(pfVertGeoDistance)
+        FreeArray(m_baseInfo.pBufferPool, pfVertCombineDistance);
+        FreeArray(m_baseInfo.pBufferPool, pfVertGeoDistance);
     }
     return hr;
 }
@@ -1187,12 +1227,16 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     size_t& dwMaxEigenDimension,
     float** ppfVertGeodesicDistance,
     float** ppfVertCombineDistance,
-    float** ppfVertMappingCoord)
+    float** ppfVertMappingCoord,
+    CIsochartMemoryCharge& distanceMemory,
+    CIsochartMemoryCharge& coordMemory)
 {
     assert(ppfVertGeodesicDistance != nullptr);
     assert(ppfVertCombineDistance != nullptr);
     assert(ppfVertMappingCoord != nullptr);
 
+    CIsochartTraceScope trace(m_IsochartEngine.m_pStats, "IsomapParameterlization", m_dwFaceNumber);
+
     HRESULT hr = S_OK;
     bIsLikePlane = false;
 
@@ -1204,6 +1248,8 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     size_t dwLandmarkNumber = 0;
     size_t dwCalculatedDimension = 0;
 
+    CIsochartMemoryCharge matrixMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_DISTANCE);
+
     // 1. Calculate the landmark vertices
     if (FAILED(hr = CalculateLandmarkVertices(
         MIN_LANDMARK_NUMBER,
@@ -1213,17 +1259,24 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     }
 
     // 2. Calculate the geodesic distance matrix of landmark vertices
-    pfVertGeodesicDistance = new (std::nothrow) float[dwLandmarkNumber * m_dwVertNumber];
+    if (FAILED(hr = distanceMemory.Add(
+        sizeof(float) * dwLandmarkNumber * m_dwVertNumber * (bIsSignalSpecialized ? 2 : 1)))
+        || FAILED(hr = matrixMemory.Add(sizeof(float) * dwLandmarkNumber * dwLandmarkNumber)))
+    {
+        goto LEnd;
+    }
+
+    pfVertGeodesicDistance = AllocateArray<float>(m_baseInfo.pBufferPool, dwLandmarkNumber * m_dwVertNumber);
 
     if (bIsSignalSpecialized)
     {
-        pfVertCombinedDistance = new (std::nothrow) float[dwLandmarkNumber * m_dwVertNumber];
+        pfVertCombinedDistance = AllocateArray<float>(m_baseInfo.pBufferPool, dwLandmarkNumber * m_dwVertNumber);
     }
     else
     {
         pfVertCombinedDistance = pfVertGeodesicDistance;
     }
-    pfGeodesicMatrix = new (std::nothrow) float[dwLandmarkNumber * dwLandmarkNumber];
+    pfGeodesicMatrix = AllocateArray<float>(m_baseInfo.pBufferPool, dwLandmarkNumber * dwLandmarkNumber);
     if (!pfVertGeodesicDistance || !pfGeodesicMatrix || !pfVertCombinedDistance)
     {
         hr = E_OUTOFMEMORY;
@@ -1262,7 +1315,8 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     }
     if (FAILED(hr = m_isoMap.Init(
         dwLandmarkNumber,
-        pfGeodesicMatrix)))
+        pfGeodesicMatrix,
+        m_IsochartEngine.m_pStats)))
     {
         goto LEnd;
     }
@@ -1273,9 +1327,10 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     {
         goto LEnd;
     }
-    SAFE_DELETE_ARRAY(pfGeodesicMatrix)
+    FreeArray(m_baseInfo.pBufferPool, pfGeodesicMatrix);
+    matrixMemory.Release();
 
-        assert(dwMaxEigenDimension >= dwCalculatedDimension);
+    assert(dwMaxEigenDimension >= dwCalculatedDimension);
 
     dwMaxEigenDimension = dwCalculatedDimension;
     dwPrimaryEigenDimension = 0;
@@ -1312,7 +1367,11 @@ HRESULT CIsochartMesh::IsomapParameterlization(
 
     //5. Compute n-dimensional embedding coordinates of each vertex
     //   here, n = dwPrimaryEigenDimension
-    pfVertMappingCoord = new (std::nothrow) float[m_dwVertNumber * dwPrimaryEigenDimension];
+    if (FAILED(hr = coordMemory.Add(sizeof(float) * m_dwVertNumber * dwPrimaryEigenDimension)))
+    {
+        goto LEnd;
+    }
+    pfVertMappingCoord = AllocateArray<float>(m_baseInfo.pBufferPool, m_dwVertNumber * dwPrimaryEigenDimension);
     if (!pfVertMappingCoord)
     {
         hr = E_OUTOFMEMORY;
@@ -1342,22 +1401,24 @@ HRESULT CIsochartMesh::IsomapParameterlization(
 
     m_bIsParameterized = true;
 LEnd:
-    SAFE_DELETE_ARRAY(pfGeodesicMatrix)
-        if (FAILED(hr))
-        {
-            SAFE_DELETE_ARRAY(pfVertGeodesicDistance)
-                if (bIsSignalSpecialized)
-                {
-                    SAFE_DELETE_ARRAY(pfVertCombinedDistance)
-                }
-            SAFE_DELETE_ARRAY(pfVertMappingCoord)
-        }
-        else
+    FreeArray(m_baseInfo.pBufferPool, pfGeodesicMatrix);
+    if (FAILED(hr))
+    {
+        FreeArray(m_baseInfo.pBufferPool, pfVertGeodesicDistance);
+        if (bIsSignalSpecialized)
         {
-            *ppfVertCombineDistance = pfVertCombinedDistance;
-            *ppfVertGeodesicDistance = pfVertGeodesicDistance;
-            *ppfVertMappingCoord = pfVertMappingCoord;
+            FreeArray(m_baseInfo.pBufferPool, pfVertCombinedDistance);
         }
+        FreeArray(m_baseInfo.pBufferPool, pfVertMappingCoord);
+        distanceMemory.Release();
+        coordMemory.Release();
+    }
+    else
+    {
+        *ppfVertCombineDistance = pfVertCombinedDistance;
+        *ppfVertGeodesicDistance = pfVertGeodesicDistance;
+        *ppfVertMappingCoord = pfVertMappingCoord;
+    }
 
     return hr;
 }
@@ -1429,9 +1490,19 @@ HRESULT CIsochartMesh::BuildFullConnection(bool& bIsManifold)
 
     // 6.
     // Decide if the edges can be splitted
-    hr = SetEdgeSplitAttribute();
+    if (FAILED(hr = SetEdgeSplitAttribute()))
+    {
+        return hr;
+    }
 
-    return hr;
+    // 6.1 Allocate the per-vertex arrays of the geodesic sweeps
+    if (FAILED(hr = BuildVertexSweepArrays()))
+    {
+        return hr;
+    }
+
+    // 7. Account for the adjacency just built
+    return m_adjacencyMemory.Resize(sizeof(uint32_t) * m_dwAdjacencySize);
 }
 
 void CIsochartMesh::ClearVerticesAdjacence()
@@ -1444,74 +1515,114 @@ void CIsochartMesh::ClearVerticesAdjacence()
         pVertex->faceAdjacent.clear();
         pVertex++;
     }
-    return;
-}
 
-namespace
-{
-    // Internal structure Used in scanning all edges in a mesh.
-    struct EdgeTableItem
-    {
-        uint32_t dwPeerVert;
-        uint32_t dwEdgeIndex;
-    };
+    FreeArray(m_baseInfo.pBufferPool, m_pdwAdjacency);
+    m_dwAdjacencySize = 0;
+    FreeVertexSweepArrays();
+    return;
 }
 
 //1. Find All Edges, specify the 3 edges of each face
 //.Algorithm:
-//(1) scan each face, check the 3 edges of each face
-//(2) if the edge is not in the edge table, create new edges and put it into edge table.
-//(3) to avoid put one edge twice, only store the edge whoes first vertex id is smaller than second
+//(1) bucket the 3 half edges of each face by their smaller vertex ID, keeping them in face order
+//(2) sort each bucket by the larger vertex ID, so that the half edges of one edge are neighbors,
+//    and link each half edge to the first half edge of its edge
+//(3) scan half edges in face order. The first half edge of an edge creates it, the second one
+//    adds its other face. Edge IDs follow the order edges are first used.
 
 // Note if  More than 2 faces share the same edge, it's a non-manifold mesh
 HRESULT CIsochartMesh::FindAllEdges(
     bool& bIsManifold)
 {
-    ISOCHARTEDGE* pEdge;
     ISOCHARTEDGE tempEdge;
-    EdgeTableItem tempEdgeTableItem;
 
     bIsManifold = false;
 
     m_dwEdgeNumber = 0;
     m_edges.clear();
 
-    std::unique_ptr<std::vector<EdgeTableItem>[]> pVertEdges(new (std::nothrow) std::vector<EdgeTableItem>[m_dwVertNumber]);
-    if (!pVertEdges)
+    // Half edges are numbered with uint32_t, which the API entry points
+    // guarantee by limiting the face count
+    const size_t dwHalfEdgeCount = m_dwFaceNumber * 3;
+    assert(dwHalfEdgeCount < UINT32_MAX);
+
+    std::unique_ptr<uint32_t[]> rgdwBucket(new (std::nothrow) uint32_t[m_dwVertNumber + 1]);
+    std::unique_ptr<uint32_t[]> rgdwHalfEdges(new (std::nothrow) uint32_t[dwHalfEdgeCount]);
+    std::unique_ptr<uint32_t[]> rgdwFirst(new (std::nothrow) uint32_t[dwHalfEdgeCount]);
+    if (!rgdwBucket || !rgdwHalfEdges || !rgdwFirst)
     {
         return E_OUTOFMEMORY;
     }
 
+    // Half edge h is the edge from vertex h % 3 to the next vertex of face h / 3
+    const ISOCHARTFACE* pFaces = m_pFaces;
+    auto GetVertex = [pFaces](uint32_t dwHalfEdge, uint32_t dwStep) -> uint32_t
+    {
+        return pFaces[dwHalfEdge / 3].dwVertexID[(dwHalfEdge % 3 + dwStep) % 3];
+    };
+
+    // 1. Counting sort by smaller vertex ID. Filling from the back keeps
+    // half edges in face order inside each bucket, and leaves
+    // rgdwBucket[v] at the start of bucket v.
+    memset(rgdwBucket.get(), 0, sizeof(uint32_t) * (m_dwVertNumber + 1));
+    for (uint32_t h = 0; h < dwHalfEdgeCount; h++)
+    {
+        rgdwBucket[std::min(GetVertex(h, 0), GetVertex(h, 1))]++;
+    }
+    for (size_t v = 1; v < m_dwVertNumber; v++)
+    {
+        rgdwBucket[v] += rgdwBucket[v - 1];
+    }
+    rgdwBucket[m_dwVertNumber] = static_cast<uint32_t>(dwHalfEdgeCount);
+    for (uint32_t h = static_cast<uint32_t>(dwHalfEdgeCount); h-- > 0;)
+    {
+        rgdwHalfEdges[--rgdwBucket[std::min(GetVertex(h, 0), GetVertex(h, 1))]] = h;
+    }
+
+    // 2. Sort each bucket by larger vertex ID, then by half edge, and point
+    // every half edge to the first one of its edge
+    int nEdgeCount = 0;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(+ : nEdgeCount) if (m_dwFaceNumber >= PARALLEL_PREPROCESS_MIN_FACES)
+    for (int v = 0; v < static_cast<int>(m_dwVertNumber); v++)
+    {
+        uint32_t* pBegin = rgdwHalfEdges.get() + rgdwBucket[v];
+        uint32_t* pEnd = rgdwHalfEdges.get() + rgdwBucket[v + 1];
+        std::sort(pBegin, pEnd, [&GetVertex](uint32_t a, uint32_t b)
+        {
+            uint32_t dwPeerA = std::max(GetVertex(a, 0), GetVertex(a, 1));
+            uint32_t dwPeerB = std::max(GetVertex(b, 0), GetVertex(b, 1));
+            return dwPeerA < dwPeerB || (dwPeerA == dwPeerB && a < b);
+        });
+
+        uint32_t dwFirst = 0;
+        uint32_t dwFirstPeer = INVALID_VERT_ID;
+        for (uint32_t* p = pBegin; p < pEnd; p++)
+        {
+            uint32_t dwPeer = std::max(GetVertex(*p, 0), GetVertex(*p, 1));
+            if (p == pBegin || dwPeer != dwFirstPeer)
+            {
+                dwFirst = *p;
+                dwFirstPeer = dwPeer;
+                nEdgeCount++;
+            }
+            rgdwFirst[*p] = dwFirst;
+        }
+    }
+
+    // 3. Create edges in face order. rgdwFirst of a first half edge is
+    // replaced by the ID of its edge, which is read by the later ones.
     try
     {
+        m_edges.reserve(static_cast<size_t>(nEdgeCount));
+
         ISOCHARTFACE* pTriangle = m_pFaces;
         for (uint32_t i = 0; i < m_dwFaceNumber; i++)
         {
-            uint32_t v1, v2;
-            uint32_t edgeId;
-            for (size_t j = 0; j < 3; j++)
+            for (uint32_t j = 0; j < 3; j++)
             {
-                pEdge = nullptr;
-                v1 = pTriangle->dwVertexID[j];
-                v2 = pTriangle->dwVertexID[(j + 1) % 3];
-
-                m_pVerts[v1].faceAdjacent.push_back(i);
-                if (v1 > v2)
-                {
-                    std::swap(v1, v2);
-                }
-
-                auto& et = pVertEdges[v1];
-                size_t k;
-                for (k = 0; k < et.size(); k++)
-                {
-                    if (et[k].dwPeerVert == v2)
-                    {
-                        pEdge = &(m_edges[et[k].dwEdgeIndex]);
-                        break;
-                    }
-                }
-                if (!pEdge) // find new edge
+                uint32_t h = i * 3 + j;
+                uint32_t edgeId;
+                if (rgdwFirst[h] == h) // find new edge
                 {
                     tempEdge.dwID = static_cast<uint32_t>(m_dwEdgeNumber);
                     tempEdge.dwVertexID[0] = pTriangle->dwVertexID[j];
@@ -1525,17 +1636,18 @@ HRESULT CIsochartMesh::FindAllEdges(
 
                     m_edges.push_back(tempEdge);
 
-                    tempEdgeTableItem.dwPeerVert = v2;
-                    tempEdgeTableItem.dwEdgeIndex = static_cast<uint32_t>(m_dwEdgeNumber);
-                    et.push_back(tempEdgeTableItem);
-
                     m_dwEdgeNumber++;
                     assert(m_dwEdgeNumber == m_edges.size());
                     edgeId = tempEdge.dwID;
-
+                    rgdwFirst[h] = edgeId;
                 }
                 else
-                {	// at least 3 faces have the same edge, non-manifold
+                {
+                    assert(rgdwFirst[h] < h);
+                    edgeId = rgdwFirst[rgdwFirst[h]];
+                    ISOCHARTEDGE* pEdge = &(m_edges[edgeId]);
+
+                    // at least 3 faces have the same edge, non-manifold
                     if (pEdge->dwFaceID[1] != INVALID_FACE_ID)
                     {
                         DPF(3, "Non-manifold: More than 2 faces have the same edge...\n");
@@ -1547,31 +1659,136 @@ HRESULT CIsochartMesh::FindAllEdges(
                     pEdge->dwFaceID[1] = i;
                     pEdge->dwOppositVertID[1] = pTriangle->dwVertexID[(j + 2) % 3];
                     pEdge->bIsBoundary = false;
-
-                    edgeId = pEdge->dwID;
                 }
                 pTriangle->dwEdgeID[j] = edgeId;
 
             }
             pTriangle++;
         }
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    HRESULT hr = BuildVerticesAdjacence();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
 
-        for (uint32_t i = 0; i < m_dwEdgeNumber; i++)
+    bIsManifold = true;
+    return S_OK;
+}
+
+// Lay out the adjacency of all vertices in m_pdwAdjacency, and fill in the
+// adjacent edges and faces of each vertex. Adjacent vertices are filled in
+// later by SortAdjacentVertices.
+HRESULT CIsochartMesh::BuildVerticesAdjacence()
+{
+    assert(!m_pdwAdjacency);
+
+    // 1. Count the adjacent edges and faces of each vertex
+    std::unique_ptr<uint32_t[]> rgdwCount(new (std::nothrow) uint32_t[m_dwVertNumber * 2]);
+    if (!rgdwCount)
+    {
+        return E_OUTOFMEMORY;
+    }
+    memset(rgdwCount.get(), 0, m_dwVertNumber * 2 * sizeof(uint32_t));
+
+    for (size_t i = 0; i < m_dwEdgeNumber; i++)
+    {
+        const ISOCHARTEDGE& edge = m_edges[i];
+        rgdwCount[edge.dwVertexID[0] * 2]++;
+        rgdwCount[edge.dwVertexID[1] * 2]++;
+    }
+    for (size_t i = 0; i < m_dwFaceNumber; i++)
+    {
+        for (size_t j = 0; j < 3; j++)
         {
-            ISOCHARTEDGE& edge = m_edges[i];
-            m_pVerts[edge.dwVertexID[0]].edgeAdjacent.push_back(i);
-            m_pVerts[edge.dwVertexID[1]].edgeAdjacent.push_back(i);
+            rgdwCount[m_pFaces[i].dwVertexID[j] * 2 + 1]++;
         }
     }
-    catch (std::bad_alloc&)
+
+    // 2. Give each vertex its part of the storage. Adjacent vertices take
+    // as much as adjacent edges.
+    m_dwAdjacencySize = m_dwEdgeNumber * 4 + m_dwFaceNumber * 3;
+    m_pdwAdjacency = AllocateArray<uint32_t>(m_baseInfo.pBufferPool, m_dwAdjacencySize);
+    if (!m_pdwAdjacency)
     {
+        m_dwAdjacencySize = 0;
         return E_OUTOFMEMORY;
     }
 
-    bIsManifold = true;
+    uint32_t* pdwNext = m_pdwAdjacency;
+    for (size_t i = 0; i < m_dwVertNumber; i++)
+    {
+        ISOCHARTVERTEX& vert = m_pVerts[i];
+        uint32_t dwEdgeNum = rgdwCount[i * 2];
+        uint32_t dwFaceNum = rgdwCount[i * 2 + 1];
+
+        vert.edgeAdjacent.Attach(pdwNext, dwEdgeNum);
+        pdwNext += dwEdgeNum;
+        vert.vertAdjacent.Attach(pdwNext, dwEdgeNum);
+        pdwNext += dwEdgeNum;
+        vert.faceAdjacent.Attach(pdwNext, dwFaceNum);
+        pdwNext += dwFaceNum;
+    }
+    assert(pdwNext == m_pdwAdjacency + m_dwAdjacencySize);
+
+    // 3. Fill in adjacent edges and faces, in increasing order of ID
+    for (uint32_t i = 0; i < m_dwEdgeNumber; i++)
+    {
+        const ISOCHARTEDGE& edge = m_edges[i];
+        m_pVerts[edge.dwVertexID[0]].edgeAdjacent.push_back(i);
+        m_pVerts[edge.dwVertexID[1]].edgeAdjacent.push_back(i);
+    }
+    for (uint32_t i = 0; i < m_dwFaceNumber; i++)
+    {
+        for (size_t j = 0; j < 3; j++)
+        {
+            m_pVerts[m_pFaces[i].dwVertexID[j]].faceAdjacent.push_back(i);
+        }
+    }
+
     return S_OK;
 }
 
+// Allocate the distance arrays written by the geodesic sweeps, and pack the
+// boundary flags that SortAdjacentVertices just set into a bitset
+HRESULT CIsochartMesh::BuildVertexSweepArrays()
+{
+    FreeVertexSweepArrays();
+
+    size_t dwBoundaryWords = (m_dwVertNumber + 31) / 32;
+    m_pfGeodesicDistance = AllocateArray<float>(m_baseInfo.pBufferPool, m_dwVertNumber);
+    m_pdwNextVertIDOnPath = AllocateArray<uint32_t>(m_baseInfo.pBufferPool, m_dwVertNumber);
+    m_pdwBoundaryBits = AllocateArray<uint32_t>(m_baseInfo.pBufferPool, dwBoundaryWords);
+    if (!m_pfGeodesicDistance || !m_pdwNextVertIDOnPath || !m_pdwBoundaryBits)
+    {
+        FreeVertexSweepArrays();
+        return E_OUTOFMEMORY;
+    }
+
+    memset(m_pdwBoundaryBits, 0, sizeof(uint32_t) * dwBoundaryWords);
+    for (size_t i = 0; i < m_dwVertNumber; i++)
+    {
+        if (m_pVerts[i].bIsBoundary)
+        {
+            m_pdwBoundaryBits[i >> 5] |= 1u << (i & 31);
+        }
+    }
+
+    return S_OK;
+}
+
+void CIsochartMesh::FreeVertexSweepArrays()
+{
+    FreeArray(m_baseInfo.pBufferPool, m_pfGeodesicDistance);
+    FreeArray(m_baseInfo.pBufferPool, m_pdwNextVertIDOnPath);
+    FreeArray(m_baseInfo.pBufferPool, m_pdwBoundaryBits);
+}
+
 class VertFaceIter
 {
 private:
@@ -1581,13 +1798,13 @@ private:
     uint32_t m_dwCurFace;
 
     ISOCHARTFACE* m_pFaces;
-    std::vector<ISOCHARTEDGE>& m_edges;
+    EDGE_LIST& m_edges;
 
 public:
     VertFaceIter(
         uint32_t mainVertID, uint32_t currEdge, uint32_t currFace,
         ISOCHARTFACE* pFaces,
-        std::vector<ISOCHARTEDGE>& edges) :
+        EDGE_LIST& edges) :
         m_dwMainVertID(mainVertID),
         m_dwCurEdge(currEdge),
         m_dwCurFace(currFace),
@@ -1741,7 +1958,7 @@ HRESULT CIsochartMesh::CleanNonmanifoldMesh(bool& bCleaned)
         return hr;
     }
 
-    auto pNewVertList = new (std::nothrow) ISOCHARTVERTEX[dwNewVertID];
+    auto pNewVertList = NewArray<ISOCHARTVERTEX>(m_baseInfo.pBufferPool, dwNewVertID);
     if (!pNewVertList)
     {
         return E_OUTOFMEMORY;
@@ -1772,7 +1989,7 @@ HRESULT CIsochartMesh::CleanNonmanifoldMesh(bool& bCleaned)
         pNewVertex++;
     }
 
-    delete[]m_pVerts;
+    DeleteArray(m_baseInfo.pBufferPool, m_pVerts);
 
     m_pVerts = pNewVertList;
     m_dwVertNumber = dwNewVertID;
@@ -1871,66 +2088,60 @@ HRESULT CIsochartMesh::SortAdjacentVertices(
 {
     bIsManifold = false;
 
-    try
+    // Each vertex only changes its own adjacency, so large charts sort
+    // vertices on several threads
+    std::atomic<bool> bNonManifold(false);
+
+#pragma omp parallel for if (m_dwFaceNumber >= PARALLEL_PREPROCESS_MIN_FACES)
+    for (int i = 0; i < static_cast<int>(m_dwVertNumber); i++)
     {
-        ISOCHARTVERTEX* pVertex = m_pVerts;
-        for (size_t i = 0; i < m_dwVertNumber; i++)
-        {
-            uint32_t dwEdgeNum = static_cast<uint32_t>(pVertex->edgeAdjacent.size());
-            uint32_t dwFaceNum = static_cast<uint32_t>(pVertex->faceAdjacent.size());
+        if (bNonManifold) // 'break' isn't allowed in an OpenMP for loop
+            continue;
 
-            if (0 == dwEdgeNum) //Isolated vertex
-            {
-                pVertex++;
-                continue;
-            }
+        ISOCHARTVERTEX* pVertex = m_pVerts + i;
+        uint32_t dwEdgeNum = static_cast<uint32_t>(pVertex->edgeAdjacent.size());
+        uint32_t dwFaceNum = static_cast<uint32_t>(pVertex->faceAdjacent.size());
 
-            pVertex->vertAdjacent.reserve(dwEdgeNum);
+        if (0 == dwEdgeNum) //Isolated vertex
+        {
+            continue;
+        }
 
-            if (dwEdgeNum == dwFaceNum)// internal vertex
+        if (dwEdgeNum == dwFaceNum)// internal vertex
+        {
+            if (!SortAdjacentVerticesOfInternalVertex(pVertex))
             {
-                bIsManifold =
-                    SortAdjacentVerticesOfInternalVertex(pVertex);
-                if (!bIsManifold)
-                {
-                    return S_OK;
-                }
+                bNonManifold = true;
+                continue;
             }
-            else // boundary vertex
+        }
+        else // boundary vertex
+        {
+            if (!SortAdjacentVerticesOfBoundaryVertex(pVertex))
             {
-                bIsManifold =
-                    SortAdjacentVerticesOfBoundaryVertex(pVertex);
-                if (!bIsManifold)
-                {
-                    return S_OK;
-                }
+                bNonManifold = true;
+                continue;
             }
+        }
 
-            // Sort Adjacent edge according in the same order of adjacent vertex
-            for (size_t j = 0; j < pVertex->vertAdjacent.size(); j++)
+        // Sort Adjacent edge according in the same order of adjacent vertex
+        for (size_t j = 0; j < pVertex->vertAdjacent.size(); j++)
+        {
+            uint32_t dwAdjacentVertID = pVertex->vertAdjacent[j];
+            for (size_t k = j; k < pVertex->edgeAdjacent.size(); k++)
             {
-                uint32_t dwAdjacentVertID = pVertex->vertAdjacent[j];
-                for (size_t k = j; k < pVertex->edgeAdjacent.size(); k++)
+                ISOCHARTEDGE& edge = m_edges[pVertex->edgeAdjacent[k]];
+                if (edge.dwVertexID[0] == dwAdjacentVertID ||
+                    edge.dwVertexID[1] == dwAdjacentVertID)
                 {
-                    ISOCHARTEDGE& edge = m_edges[pVertex->edgeAdjacent[k]];
-                    if (edge.dwVertexID[0] == dwAdjacentVertID ||
-                        edge.dwVertexID[1] == dwAdjacentVertID)
-                    {
-                        std::swap(pVertex->edgeAdjacent[j], pVertex->edgeAdjacent[k]);
-                        break;
-                    }
+                    std::swap(pVertex->edgeAdjacent[j], pVertex->edgeAdjacent[k]);
+                    break;
                 }
             }
-
-            pVertex++;
         }
     }
-    catch (std::bad_alloc&)
-    {
-        return E_OUTOFMEMORY;
-    }
 
-    bIsManifold = true;
+    bIsManifold = !bNonManifold;
     return S_OK;
 }
 
@@ -2037,66 +2248,59 @@ CIsochartMesh::SortAdjacentVerticesOfBoundaryVertex(
         }
     }
 
-    try
+    for (size_t j = 0; j < dwEdgeNum; j++)
     {
-        for (size_t j = 0; j < dwEdgeNum; j++)
+        if (pCurrentEdge == pPreEdge)
         {
-            if (pCurrentEdge == pPreEdge)
-            {
-                DPF(3, "Non-manifold: Vertex has more than 2 adjacent boundary edges. \n");
-                return false;
-            }
+            DPF(3, "Non-manifold: Vertex has more than 2 adjacent boundary edges. \n");
+            return false;
+        }
 
-            pVertex->vertAdjacent.push_back(dwNextV);
+        pVertex->vertAdjacent.push_back(dwNextV);
 
-            if (pPreEdge)
+        if (pPreEdge)
+        {
+            if (pCurrentEdge->bIsBoundary)
             {
-                if (pCurrentEdge->bIsBoundary)
-                {
-                    pPreEdge = pCurrentEdge;
-                    continue;
-                }
+                pPreEdge = pCurrentEdge;
+                continue;
+            }
 
-                if (pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[0]
-                    || pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[1])
-                {
-                    dwNextV = pCurrentEdge->dwOppositVertID[1];
-                }
-                else
-                {
-                    dwNextV = pCurrentEdge->dwOppositVertID[0];
-                }
+            if (pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[0]
+                || pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[1])
+            {
+                dwNextV = pCurrentEdge->dwOppositVertID[1];
             }
             else
             {
                 dwNextV = pCurrentEdge->dwOppositVertID[0];
             }
+        }
+        else
+        {
+            dwNextV = pCurrentEdge->dwOppositVertID[0];
+        }
 
-            pPreEdge = pCurrentEdge;
-            pCurrentEdge = nullptr;
+        pPreEdge = pCurrentEdge;
+        pCurrentEdge = nullptr;
 
-            for (size_t m = 0; m < dwEdgeNum; m++)
+        for (size_t m = 0; m < dwEdgeNum; m++)
+        {
+            pCurrentEdge = &(m_edges[pVertex->edgeAdjacent[m]]);
+            if (pCurrentEdge->dwVertexID[0] == dwNextV
+                || pCurrentEdge->dwVertexID[1] == dwNextV)
             {
-                pCurrentEdge = &(m_edges[pVertex->edgeAdjacent[m]]);
-                if (pCurrentEdge->dwVertexID[0] == dwNextV
-                    || pCurrentEdge->dwVertexID[1] == dwNextV)
-                {
-                    break;
-                }
-                pCurrentEdge = nullptr;
+                break;
             }
+            pCurrentEdge = nullptr;
+        }
 
-            if (!pCurrentEdge && j + 1 < dwEdgeNum)
-            {
-                DPF(3, "Non-manifold: logic error, Need to be investigated...\n");
-                return false;
-            }
+        if (!pCurrentEdge && j + 1 < dwEdgeNum)
+        {
+            DPF(3, "Non-manifold: logic error, Need to be investigated...\n");
+            return false;
         }
     }
-    catch (std::bad_alloc&)
-    {
-        return false;
-    }
     assert(pVertex->vertAdjacent.size() == dwEdgeNum);
     return true;
 }
@@ -2127,88 +2331,81 @@ CIsochartMesh::SortAdjacentVerticesOfInternalVertex(
         dwNextV = pCurrentEdge->dwVertexID[0];
     }
 
-    try
-    {
-        pVertex->vertAdjacent.push_back(dwNextV);
+    pVertex->vertAdjacent.push_back(dwNextV);
 
-        for (size_t j = 1; j < dwEdgeNum; j++)
+    for (size_t j = 1; j < dwEdgeNum; j++)
+    {
+        if (pPreEdge)
         {
-            if (pPreEdge)
+            if (pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[0]
+                || pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[1])
             {
-                if (pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[0]
-                    || pCurrentEdge->dwOppositVertID[0] == pPreEdge->dwVertexID[1])
-                {
-                    dwNextV = pCurrentEdge->dwOppositVertID[1];
-                }
-                else
-                {
-                    dwNextV = pCurrentEdge->dwOppositVertID[0];
-                }
+                dwNextV = pCurrentEdge->dwOppositVertID[1];
             }
             else
             {
-                ISOCHARTFACE* pTriangle = m_pFaces + pCurrentEdge->dwFaceID[0];
-                size_t k;
-                for (k = 0; k < 3; k++)
-                {
-                    if (pTriangle->dwVertexID[k] == pVertex->dwID)
-                    {
-                        break;
-                    }
-                }
-
-                // This step assure that to all vertexes, their adjacent vertexes
-                // ordered in the same round direction!
-                if (pTriangle->dwVertexID[(k + 1) % 3] == dwNextV)
-                {
-                    dwNextV = pCurrentEdge->dwOppositVertID[0];
-                }
-                else
-                {
-                    dwNextV = pCurrentEdge->dwOppositVertID[1];
-                }
+                dwNextV = pCurrentEdge->dwOppositVertID[0];
             }
-
+        }
+        else
+        {
+            ISOCHARTFACE* pTriangle = m_pFaces + pCurrentEdge->dwFaceID[0];
             size_t k;
-            for (k = 0; k < j; k++)
+            for (k = 0; k < 3; k++)
             {
-                if (pVertex->vertAdjacent[k] == dwNextV)
+                if (pTriangle->dwVertexID[k] == pVertex->dwID)
                 {
                     break;
                 }
             }
-            if (k < j)
+
+            // This step assure that to all vertexes, their adjacent vertexes
+            // ordered in the same round direction!
+            if (pTriangle->dwVertexID[(k + 1) % 3] == dwNextV)
             {
-                DPF(3, "Non-manifold: Vertex has two same adjacent vertices.\n");
-                return false;
+                dwNextV = pCurrentEdge->dwOppositVertID[0];
             }
+            else
+            {
+                dwNextV = pCurrentEdge->dwOppositVertID[1];
+            }
+        }
 
-            pPreEdge = pCurrentEdge;
-            pCurrentEdge = nullptr;
-
-            for (k = 0; k < dwEdgeNum; k++)
+        size_t k;
+        for (k = 0; k < j; k++)
+        {
+            if (pVertex->vertAdjacent[k] == dwNextV)
             {
-                ISOCHARTEDGE* pEdge = &(m_edges[pVertex->edgeAdjacent[k]]);
-                if (pEdge->dwVertexID[0] == dwNextV
-                    || pEdge->dwVertexID[1] == dwNextV)
-                {
-                    pCurrentEdge = pEdge;
-                    break;
-                }
+                break;
             }
+        }
+        if (k < j)
+        {
+            DPF(3, "Non-manifold: Vertex has two same adjacent vertices.\n");
+            return false;
+        }
+
+        pPreEdge = pCurrentEdge;
+        pCurrentEdge = nullptr;
 
-            if (!pCurrentEdge)
+        for (k = 0; k < dwEdgeNum; k++)
+        {
+            ISOCHARTEDGE* pEdge = &(m_edges[pVertex->edgeAdjacent[k]]);
+            if (pEdge->dwVertexID[0] == dwNextV
+                || pEdge->dwVertexID[1] == dwNextV)
             {
-                DPF(3, "Non-manifold: logic error, can not find a right edge.\n");
-                return false;
+                pCurrentEdge = pEdge;
+                break;
             }
+        }
 
-            pVertex->vertAdjacent.push_back(dwNextV);
+        if (!pCurrentEdge)
+        {
+            DPF(3, "Non-manifold: logic error, can not find a right edge.\n");
+            return false;
         }
-    }
-    catch (std::bad_alloc&)
-    {
-        return false;
+
+        pVertex->vertAdjacent.push_back(dwNextV);
     }
 
     assert(pVertex->vertAdjacent.size() == dwEdgeNum);
@@ -2224,9 +2421,10 @@ void CIsochartMesh::GetFaceAdjacentArray(
 {
     assert(pdwFaceAdjacentArray != nullptr);
 
-    uint32_t* pFaceAjacence = pdwFaceAdjacentArray;
-    for (size_t i = 0; i < m_dwFaceNumber; i++)
+#pragma omp parallel for if (m_dwFaceNumber >= PARALLEL_PREPROCESS_MIN_FACES)
+    for (int i = 0; i < static_cast<int>(m_dwFaceNumber); i++)
     {
+        uint32_t* pFaceAjacence = pdwFaceAdjacentArray + size_t(i) * 3;
         for (size_t j = 0; j < 3; j++)
         {
             const ISOCHARTEDGE& edge = m_edges[m_pFaces[i].dwEdgeID[j]];
@@ -2236,7 +2434,7 @@ void CIsochartMesh::GetFaceAdjacentArray(
             }
             else
             {
-                if (edge.dwFaceID[0] == i)
+                if (edge.dwFaceID[0] == static_cast<uint32_t>(i))
                 {
                     pFaceAjacence[j] = edge.dwFaceID[1];
                 }
@@ -2246,7 +2444,6 @@ void CIsochartMesh::GetFaceAdjacentArray(
                 }
             }
         }
-        pFaceAjacence += 3;
     }
 }
 
@@ -2262,6 +2459,7 @@ void CIsochartMesh::GetFaceAdjacentArray(
 // (2) Try to pop out a vertex V from Q.If the Q is empty, export
 //     all vertices in A as an new chart and goto (1)
 // (3) Push all adjacent vertices of V into Q. goto (2)
+// The new charts are then extracted and built, on several threads for a large chart.
 
 HRESULT CIsochartMesh::CheckAndDivideMultipleObjects(
     bool& bHasMultiObjects)
@@ -2281,6 +2479,7 @@ HRESULT CIsochartMesh::CheckAndDivideMultipleObjects(
 
     memset(pbVertMark, 0, m_dwVertNumber * sizeof(bool));
 
+    std::vector<VERTEX_ARRAY> objectList;
     try
     {
         for (size_t i = 0; i < m_dwVertNumber; i++)
@@ -2330,32 +2529,64 @@ HRESULT CIsochartMesh::CheckAndDivideMultipleObjects(
                 return S_OK;
             }
             // Must have mulitple object, export the new object as an chart
-            else if (vertList.size() > 0)
-            {
-                bHasMultiObjects = true;
-                CIsochartMesh* pChart = nullptr;
-                //Creat new chart
-                HRESULT hr = ExtractIndependentObject(vertList, &pChart);
-                if (FAILED(hr))
-                {
-                    return hr;
-                }
-
-                m_children.push_back(pChart);
-
-                DPF(3,
-                    "Generate new mesh: %zu vert, %zu face, %zu edge\n",
-                    pChart->m_dwVertNumber, pChart->m_dwFaceNumber, pChart->m_dwEdgeNumber);
-            }
+            objectList.push_back(std::move(vertList));
         }
-        DPF(3, "....Divide into %zu sub-meshes...\n", m_children.size());
+
+        m_children.reserve(m_children.size() + objectList.size());
     }
     catch (std::bad_alloc&)
     {
         return E_OUTOFMEMORY;
     }
 
-    return S_OK;
+    if (objectList.empty())
+    {
+        return S_OK;
+    }
+    bHasMultiObjects = true;
+
+    // Creat new charts. Each one only reads current chart.
+    std::unique_ptr<CIsochartMesh*[]> pChartList(new (std::nothrow) CIsochartMesh*[objectList.size()]);
+    if (!pChartList)
+    {
+        return E_OUTOFMEMORY;
+    }
+    memset(pChartList.get(), 0, sizeof(CIsochartMesh*) * objectList.size());
+
+    std::atomic<HRESULT> hrOut(S_OK);
+
+#pragma omp parallel for schedule(dynamic, 1) if (m_dwFaceNumber >= PARALLEL_PREPROCESS_MIN_FACES)
+    for (int i = 0; i < static_cast<int>(objectList.size()); i++)
+    {
+        if (FAILED(hrOut)) // 'break' isn't allowed in an OpenMP for loop
+            continue;
+
+        HRESULT hr = ExtractIndependentObject(objectList[static_cast<size_t>(i)], &pChartList[static_cast<size_t>(i)]);
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            hrOut.compare_exchange_strong(hrExpected, hr);
+        }
+    }
+
+    // Adopt the new charts in the order their objects were found
+    for (size_t i = 0; i < objectList.size(); i++)
+    {
+        CIsochartMesh* pChart = pChartList[i];
+        if (!pChart)
+        {
+            continue;
+        }
+
+        m_children.push_back(pChart);
+
+        DPF(3,
+            "Generate new mesh: %zu vert, %zu face, %zu edge\n",
+            pChart->m_dwVertNumber, pChart->m_dwFaceNumber, pChart->m_dwEdgeNumber);
+    }
+    DPF(3, "....Divide into %zu sub-meshes...\n", m_children.size());
+
+    return hrOut;
 }
 
 // Use vertex list to creat new chart and build full connection for new chart
@@ -2623,23 +2854,17 @@ HRESULT CIsochartMesh::CalMinPathToOtherBoundary(
     }
 
     // 1. Init the distance to souce of each vertice
-    ISOCHARTVERTEX* pCurrentVertex = m_pVerts;
-    for (size_t i = 0; i < m_dwVertNumber; i++)
-    {
-        pCurrentVertex->fGeodesicDistance = FLT_MAX;
-        pCurrentVertex->dwNextVertIDOnPath = INVALID_VERT_ID;
-        pCurrentVertex++;
-    }
+    std::fill_n(m_pfGeodesicDistance, m_dwVertNumber, FLT_MAX);
+    std::fill_n(m_pdwNextVertIDOnPath, m_dwVertNumber, INVALID_VERT_ID);
 
     // 2. Init the source vertice
     for (size_t i = dwStartIdx; i < dwEndIdx; i++)
     {
-        pCurrentVertex = allBoundaryList[i];
+        ISOCHARTVERTEX* pCurrentVertex = allBoundaryList[i];
         pbVertProcessed[pCurrentVertex->dwID] = true;
-        pCurrentVertex->fGeodesicDistance = 0;
+        m_pfGeodesicDistance[pCurrentVertex->dwID] = 0;
 
-        pHeapItem[pCurrentVertex->dwID].m_weight =
-            -pCurrentVertex->fGeodesicDistance;
+        pHeapItem[pCurrentVertex->dwID].m_weight = 0;
         pHeapItem[pCurrentVertex->dwID].m_data =
             pCurrentVertex->dwID;
 
@@ -2662,7 +2887,7 @@ HRESULT CIsochartMesh::CalMinPathToOtherBoundary(
         }
 
         // 3.1 Get vertices having min-distance to source
-        pCurrentVertex = m_pVerts + pTop->m_data;
+        ISOCHARTVERTEX* pCurrentVertex = m_pVerts + pTop->m_data;
         assert(pCurrentVertex->dwID == pTop->m_data);
         pbVertProcessed[pCurrentVertex->dwID] = true;
 
@@ -2671,8 +2896,8 @@ HRESULT CIsochartMesh::CalMinPathToOtherBoundary(
             dwCurrentBoundaryID)
         {
             dwPeerVertID = pCurrentVertex->dwID;
-            fDistance = pCurrentVertex->fGeodesicDistance;
-            assert(pCurrentVertex->dwNextVertIDOnPath != INVALID_VERT_ID);
+            fDistance = m_pfGeodesicDistance[pCurrentVertex->dwID];
+            assert(m_pdwNextVertIDOnPath[pCurrentVertex->dwID] != INVALID_VERT_ID);
             return S_OK;
         }
 
@@ -2703,13 +2928,11 @@ HRESULT CIsochartMesh::CalMinPathToOtherBoundary(
                 continue;
             }
 
-            ISOCHARTVERTEX* pAdjacentVertex = m_pVerts + dwAdjacentVertID;
-            if (pAdjacentVertex->fGeodesicDistance
-        > pCurrentVertex->fGeodesicDistance + edge.fLength)
+            float fNewDistance = m_pfGeodesicDistance[pCurrentVertex->dwID] + edge.fLength;
+            if (m_pfGeodesicDistance[dwAdjacentVertID] > fNewDistance)
             {
-                pAdjacentVertex->fGeodesicDistance
-                    = pCurrentVertex->fGeodesicDistance + edge.fLength;
-                pAdjacentVertex->dwNextVertIDOnPath = pCurrentVertex->dwID;
+                m_pfGeodesicDistance[dwAdjacentVertID] = fNewDistance;
+                m_pdwNextVertIDOnPath[dwAdjacentVertID] = pCurrentVertex->dwID;
             }
         }
 
@@ -2729,17 +2952,16 @@ HRESULT CIsochartMesh::CalMinPathToOtherBoundary(
                 continue;
             }
 
-            ISOCHARTVERTEX* pAdjacentVertex = m_pVerts + dwAdjacentVertID;
             if (pHeapItem[dwAdjacentVertID].isItemInHeap())
             {
                 heap.update(pHeapItem + dwAdjacentVertID,
-                    -pAdjacentVertex->fGeodesicDistance);
+                    -m_pfGeodesicDistance[dwAdjacentVertID]);
             }
             else
             {
                 pHeapItem[dwAdjacentVertID].m_data = dwAdjacentVertID;
                 pHeapItem[dwAdjacentVertID].m_weight
-                    = -pAdjacentVertex->fGeodesicDistance;
+                    = -m_pfGeodesicDistance[dwAdjacentVertID];
                 if (!heap.insert(pHeapItem + dwAdjacentVertID))
                 {
                     return E_OUTOFMEMORY;
@@ -2770,7 +2992,7 @@ HRESULT CIsochartMesh::RetreiveVertDijkstraPathToSource(
         do
         {
             dijkstraPath.push_back(p->dwID);
-        } while ((p->dwNextVertIDOnPath != INVALID_VERT_ID) && (p = m_pVerts + p->dwNextVertIDOnPath));
+        } while ((m_pdwNextVertIDOnPath[p->dwID] != INVALID_VERT_ID) && (p = m_pVerts + m_pdwNextVertIDOnPath[p->dwID]));
     }
     catch (std::bad_alloc&)
     {
@@ -2874,12 +3096,12 @@ CIsochartMesh::CalVertWithMinDijkstraDistanceToSrc(
 
     for (uint32_t i = 0; i < m_dwVertNumber; i++)
     {
-        if (m_pVerts[i].bIsBoundary &&
+        if (IsBoundaryVertex(i) &&
             pdwVertBoundaryID[i] != pdwVertBoundaryID[dwSourceVertID])
         {
-            if (m_pVerts[i].fGeodesicDistance < fMinDistance)
+            if (m_pfGeodesicDistance[i] < fMinDistance)
             {
-                fMinDistance = m_pVerts[i].fGeodesicDistance;
+                fMinDistance = m_pfGeodesicDistance[i];
                 dwPeerVertID = i;
             }
         }
@@ -3292,7 +3514,7 @@ CIsochartMesh* CIsochartMesh::SplitVertices(
 
     // Creat all vertices for new chart.
     pChart->m_dwVertNumber = dwNewVertNumber;
-    pChart->m_pVerts = new (std::nothrow) ISOCHARTVERTEX[dwNewVertNumber];
+    pChart->m_pVerts = NewArray<ISOCHARTVERTEX>(m_baseInfo.pBufferPool, dwNewVertNumber);
     if (!pChart->m_pVerts)
     {
         delete pChart;
@@ -3354,20 +3576,14 @@ HRESULT CIsochartMesh::CalculateDijkstraPathToVertex(
     }
 
     // 1. Init the distance to souce of each vertice
-    ISOCHARTVERTEX* pCurrentVertex = m_pVerts;
-    for (size_t i = 0; i < m_dwVertNumber; i++)
-    {
-        pCurrentVertex->fGeodesicDistance = FLT_MAX;
-        pCurrentVertex->dwNextVertIDOnPath = INVALID_VERT_ID;
-        pCurrentVertex++;
-    }
+    std::fill_n(m_pfGeodesicDistance, m_dwVertNumber, FLT_MAX);
+    std::fill_n(m_pdwNextVertIDOnPath, m_dwVertNumber, INVALID_VERT_ID);
 
     // 2. Init the source vertice
-    pCurrentVertex = m_pVerts + dwSourceVertID;
     pbVertProcessed[dwSourceVertID] = true;
-    pCurrentVertex->fGeodesicDistance = 0;
+    m_pfGeodesicDistance[dwSourceVertID] = 0;
 
-    pHeapItem[dwSourceVertID].m_weight = -pCurrentVertex->fGeodesicDistance;
+    pHeapItem[dwSourceVertID].m_weight = 0;
     pHeapItem[dwSourceVertID].m_data = dwSourceVertID;
     if (!heap.insert(pHeapItem + dwSourceVertID))
     {
@@ -3385,7 +3601,7 @@ HRESULT CIsochartMesh::CalculateDijkstraPathToVertex(
         }
 
         // 3.1 Get vertices having min-distance to source
-        pCurrentVertex = m_pVerts + pTop->m_data;
+        ISOCHARTVERTEX* pCurrentVertex = m_pVerts + pTop->m_data;
         assert(pCurrentVertex->dwID == pTop->m_data);
         pbVertProcessed[pCurrentVertex->dwID] = true;
         dwFarestPeerVertID = pCurrentVertex->dwID;
@@ -3410,14 +3626,12 @@ HRESULT CIsochartMesh::CalculateDijkstraPathToVertex(
                 continue;
             }
 
-            ISOCHARTVERTEX* pAdjacentVertex = m_pVerts + dwAdjacentVertID;
-            if (pAdjacentVertex->fGeodesicDistance
-        > pCurrentVertex->fGeodesicDistance + edge.fLength)
+            float fNewDistance = m_pfGeodesicDistance[pCurrentVertex->dwID] + edge.fLength;
+            if (m_pfGeodesicDistance[dwAdjacentVertID] > fNewDistance)
             {
-                pAdjacentVertex->fGeodesicDistance
-                    = pCurrentVertex->fGeodesicDistance + edge.fLength;
+                m_pfGeodesicDistance[dwAdjacentVertID] = fNewDistance;
 
-                pAdjacentVertex->dwNextVertIDOnPath = pCurrentVertex->dwID;
+                m_pdwNextVertIDOnPath[dwAdjacentVertID] = pCurrentVertex->dwID;
             }
         }
 
@@ -3430,18 +3644,16 @@ HRESULT CIsochartMesh::CalculateDijkstraPathToVertex(
                 continue;
             }
 
-            ISOCHARTVERTEX* pAdjacentVertex = m_pVerts + dwAdjacentVertID;
-
             if (pHeapItem[dwAdjacentVertID].isItemInHeap())
             {
                 heap.update(pHeapItem + dwAdjacentVertID,
-                    -pAdjacentVertex->fGeodesicDistance);
+                    -m_pfGeodesicDistance[dwAdjacentVertID]);
             }
             else
             {
                 pHeapItem[dwAdjacentVertID].m_data = dwAdjacentVertID;
                 pHeapItem[dwAdjacentVertID].m_weight
-                    = -pAdjacentVertex->fGeodesicDistance;
+                    = -m_pfGeodesicDistance[dwAdjacentVertID];
                 if (!heap.insert(pHeapItem + dwAdjacentVertID))
                 {
                     return E_OUTOFMEMORY;
@@ -19,6 +19,7 @@
 
 #include "ExactOneToAll.h"
 #include "ApproximateOneToAll.h"
+#include "HeatGeodesic.h"
 
 namespace Isochart
 {
@@ -62,6 +63,49 @@ namespace Isochart
     class CIsochartMesh;
     typedef std::vector<CIsochartMesh*> ISOCHARTMESH_ARRAY;
 
+    // CAdjacencyList is a run of IDs inside the adjacency storage of a chart,
+    // which BuildFullConnection lays out as one compressed (CSR) array. It
+    // has a fixed capacity and never owns or allocates memory.
+    class CAdjacencyList
+    {
+    public:
+        CAdjacencyList() noexcept : m_pdwIDs(nullptr), m_dwSize(0), m_dwCapacity(0) {}
+
+        void Attach(uint32_t* pdwIDs, uint32_t dwCapacity)
+        {
+            m_pdwIDs = pdwIDs;
+            m_dwSize = 0;
+            m_dwCapacity = dwCapacity;
+        }
+
+        void clear() { Attach(nullptr, 0); }
+
+        void push_back(uint32_t dwID)
+        {
+            assert(m_dwSize < m_dwCapacity);
+            m_pdwIDs[m_dwSize++] = dwID;
+        }
+
+        size_t size() const { return m_dwSize; }
+        size_t capacity() const { return m_dwCapacity; }
+        bool empty() const { return m_dwSize == 0; }
+
+        uint32_t& operator[](size_t i) { assert(i < m_dwSize); return m_pdwIDs[i]; }
+        uint32_t operator[](size_t i) const { assert(i < m_dwSize); return m_pdwIDs[i]; }
+
+        uint32_t* begin() { return m_pdwIDs; }
+        uint32_t* end() { return m_pdwIDs + m_dwSize; }
+        const uint32_t* begin() const { return m_pdwIDs; }
+        const uint32_t* end() const { return m_pdwIDs + m_dwSize; }
+        const uint32_t* cbegin() const { return m_pdwIDs; }
+        const uint32_t* cend() const { return m_pdwIDs + m_dwSize; }
+
+    private:
+        uint32_t* m_pdwIDs;
+        uint32_t m_dwSize;
+        uint32_t m_dwCapacity;
+    };
+
     ///////////////////////////////////////////////////////////////
     //////////Main Structures in CIsochartMesh/////////////////////////
     ///////////////////////////////////////////////////////////////
@@ -79,14 +123,10 @@ namespace Isochart
         bool bIsBoundary;               // Is this vertex a boundary vertex
 
         int nImportanceOrder;           // Important order of this vertex
-        float fGeodesicDistance;        //Using in Computing distance from this vertex to specified sourc
-        float fDijikstraDistance;
-        float fSignalDistance;          // Signal distance
-
-        std::vector<uint32_t> vertAdjacent;// ID of vertices having edge between this vertex
-        std::vector<uint32_t> faceAdjacent;// ID of faces using this vertex
-        std::vector<uint32_t> edgeAdjacent;// ID of edges using this vertex
-        uint32_t dwNextVertIDOnPath;    // The next vertex on the path to source.
+
+        CAdjacencyList vertAdjacent;    // ID of vertices having edge between this vertex
+        CAdjacencyList faceAdjacent;    // ID of faces using this vertex
+        CAdjacencyList edgeAdjacent;    // ID of edges using this vertex
     };
     typedef std::vector<ISOCHARTVERTEX*> VERTEX_ARRAY;
 
@@ -116,6 +156,9 @@ namespace Isochart
     };
     typedef std::vector<ISOCHARTEDGE*> EDGE_ARRAY;
 
+    // Edges of a chart, allocated from the engine's buffer pool
+    typedef std::vector<ISOCHARTEDGE, CBufferPoolAllocator<ISOCHARTEDGE>> EDGE_LIST;
+
     class CCallbackSchemer;
     class CIsoMap;
 
@@ -127,6 +170,8 @@ namespace Isochart
 
     struct VERTOPTIMIZEINFO;
 
+    struct GEODESICSCRATCH;
+
     class CIsochartMesh
     {
     public:
@@ -154,17 +199,24 @@ namespace Isochart
             CIsochartMesh* pChart,
             bool bIsForPartition);
 
+        // fMeshArea is the 3D area the stretch of chartList is averaged over,
+        // baseInfo.fMeshArea unless chartList covers only part of the mesh.
+        // Without bCountProgress the merge only checks the callback and the
+        // cancellation, for callers whose progress counts other work.
         static HRESULT MergeSmallCharts(
             ISOCHARTMESH_ARRAY& chartList,
             size_t dwExpectChartCount,
             const CBaseMeshInfo& baseInfo,
-            CCallbackSchemer& callbackSchemer);
+            float fMeshArea,
+            CCallbackSchemer& callbackSchemer,
+            bool bCountProgress = true);
 
         static HRESULT CheckMergeResult(
             ISOCHARTMESH_ARRAY& chartList,
             CIsochartMesh* pOldChart1,
             CIsochartMesh* pOldChart2,
             CIsochartMesh* pNewChart,
+            float fMeshArea,
             bool& bCanMerge);
 
         static HRESULT OptimizeAllL2SquaredStretch(
@@ -209,6 +261,10 @@ namespace Isochart
         static float CalOptimalAvgL2SquaredStretch(
             ISOCHARTMESH_ARRAY& chartList); // Scale each chart.
 
+        static float CalOptimalAvgL2SquaredStretch(
+            ISOCHARTMESH_ARRAY& chartList,
+            float fMeshArea);
+
         static uint32_t GetChartWidthLargestGeoAvgStretch(
             ISOCHARTMESH_ARRAY& chartList,
             float& fMaxAvgL2Stretch);
@@ -249,7 +305,7 @@ namespace Isochart
         ISOCHARTFACE* GetFaceBuffer() const { return m_pFaces; }
 
         size_t GetEdgeNumber() { return m_dwEdgeNumber; }
-        std::vector<ISOCHARTEDGE>& GetEdgesList() { return  m_edges; }
+        EDGE_LIST& GetEdgesList() { return  m_edges; }
 
         float GetBoxDiagLen() { return m_fBoxDiagLen; }
         std::vector<uint32_t>& GetAdjacentChartList() { return m_adjacentChart; }
@@ -380,6 +436,18 @@ namespace Isochart
         HRESULT FindAllEdges(
             bool& bIsManifold);
 
+        HRESULT BuildVerticesAdjacence();
+
+        HRESULT BuildVertexSweepArrays();
+
+        void FreeVertexSweepArrays();
+
+        bool IsBoundaryVertex(uint32_t dwVertID) const
+        {
+            assert(dwVertID < m_dwVertNumber);
+            return (m_pdwBoundaryBits[dwVertID >> 5] & (1u << (dwVertID & 31))) != 0;
+        }
+
         HRESULT SetEdgeSplitAttribute();
 
         bool IsAllFaceVertexOrderValid();
@@ -510,7 +578,9 @@ namespace Isochart
             size_t& dwMaxEigenDimension,
             float** ppfVertGeodesicDistance,
             float** ppfVertCombineDistance,
-            float** ppfVertMappingCoord);
+            float** ppfVertMappingCoord,
+            CIsochartMemoryCharge& distanceMemory,
+            CIsochartMemoryCharge& coordMemory);
 
         HRESULT CalculateVertMappingCoord(
             const float* pfVertGeodesicDistance,
@@ -527,7 +597,13 @@ namespace Isochart
             const float* pfVertGeodesicDistance,
             float* pfGeodesicMatrix) const;
 
-        HRESULT InitOneToAllEngine();
+        HRESULT InitOneToAllEngine(GeodesicDist::CExactOneToAll& engine) const;
+
+        bool IsNewGeodesicDistanceUsed(bool bIsSignalDistance) const;
+
+        bool IsHeatGeodesicDistanceUsed(bool bIsSignalDistance) const;
+
+        HRESULT InitHeatGeodesic(GeodesicDist::CHeatGeodesic& heat) const;
 
         HRESULT CalculateGeodesicDistance(
             std::vector<uint32_t>& vertList,
@@ -539,26 +615,45 @@ namespace Isochart
             ISOCHARTVERTEX* pAdjacentVertex,
             const ISOCHARTEDGE& edgeBetweenVertex,
             bool* pbVertProcessed,
-            bool bIsSignalDistance) const;
+            float* pfGeodesicDistance,
+            float* pfSignalDistance) const;
 
         HRESULT CalculateGeodesicDistanceToVertex(
             uint32_t dwSourceVertID,
-            bool bIsSignalDistance,
+            GEODESICSCRATCH& scratch,
+            GeodesicDist::CExactOneToAll* pEngine,
+            const GeodesicDist::CHeatGeodesic* pHeat,
+            CIsochartMemoryCharge& windowMemory,
+            float* pfGeodesicDistance,
+            float* pfSignalDistance,
             uint32_t* pdwFarestPeerVertID = nullptr) const;
 
         HRESULT CalculateGeodesicDistanceToVertexKS98(
             uint32_t dwSourceVertID,
-            bool bIsSignalDistance,
+            GEODESICSCRATCH& scratch,
+            float* pfGeodesicDistance,
+            float* pfSignalDistance,
             uint32_t* pdwFarestPeerVertID = nullptr) const;
 
         HRESULT CalculateGeodesicDistanceToVertexNewGeoDist(
+            GeodesicDist::CExactOneToAll& engine,
+            CIsochartMemoryCharge& windowMemory,
+            uint32_t dwSourceVertID,
+            float* pfGeodesicDistance,
+            uint32_t* pdwFarestPeerVertID = nullptr) const;
+
+        HRESULT CalculateGeodesicDistanceToVertexHeat(
+            const GeodesicDist::CHeatGeodesic& heat,
             uint32_t dwSourceVertID,
-            uint32_t* pdwFarestPeerVertID = nullptr);
+            GEODESICSCRATCH& scratch,
+            float* pfGeodesicDistance,
+            uint32_t* pdwFarestPeerVertID = nullptr) const;
 
         void CalculateGeodesicDistanceABC(
             ISOCHARTVERTEX* pVertexA,
             ISOCHARTVERTEX* pVertexB,
-            ISOCHARTVERTEX* pVertexC) const;
+            ISOCHARTVERTEX* pVertexC,
+            float* pfGeodesicDistance) const;
 
         void CombineGeodesicAndSignalDistance(
             float* pfSignalDistance,
@@ -1061,7 +1156,9 @@ namespace Isochart
             ISOCHARTMESH_ARRAY& children,
             size_t dwExpectChartCount,
             size_t dwFaceNumber,
-            CCallbackSchemer& callbackSchemer);
+            float fMeshArea,
+            CCallbackSchemer& callbackSchemer,
+            bool bCountProgress);
 
         static void ReleaseAllNewCharts(
             ISOCHARTMESH_ARRAY& children);
@@ -1070,6 +1167,7 @@ namespace Isochart
             ISOCHARTMESH_ARRAY& children,
             uint32_t dwMainChartID,
             size_t dwTotalFaceNumber,
+            float fMeshArea,
             bool* pbMergeFlag,
             DirectX::XMFLOAT3* pChartNormal,
             bool& bMerged);
@@ -1275,6 +1373,8 @@ namespace Isochart
         // Mesh information
         const CBaseMeshInfo& m_baseInfo;
 
+        // Topology, allocated from m_baseInfo.pBufferPool with NewArray,
+        // AllocateArray and CBufferPoolAllocator
         size_t m_dwVertNumber;
         ISOCHARTVERTEX* m_pVerts;
 
@@ -1282,7 +1382,19 @@ namespace Isochart
         ISOCHARTFACE* m_pFaces;
 
         size_t m_dwEdgeNumber;
-        std::vector<ISOCHARTEDGE> m_edges;
+        EDGE_LIST m_edges;
+
+        // Adjacency of all vertices. Each vertex has its adjacent edges, then
+        // room for as many adjacent vertices, then its adjacent faces.
+        size_t m_dwAdjacencySize;
+        uint32_t* m_pdwAdjacency;
+
+        // Per-vertex fields of the Dijkstra and geodesic sweeps, one array
+        // per field so a sweep streams only what it touches. They hold the
+        // result of the last sweep and are allocated by BuildFullConnection.
+        float* m_pfGeodesicDistance;        // Distance to the source
+        uint32_t* m_pdwNextVertIDOnPath;    // Next vertex on the path to the source
+        uint32_t* m_pdwBoundaryBits;        // Bit i is bIsBoundary of vertex i
 
         CIsochartMesh* m_pFather;// Indicating where the chart derives from
 
@@ -1327,6 +1439,11 @@ namespace Isochart
 #else
         GeodesicDist::CApproximateOneToAll m_ApproximateOneToAllEngine;
 #endif
+
+        // Size of the vertices' adjacency storage, and of the one-to-all
+        // engine's topology and window lists, as last measured.
+        CIsochartMemoryCharge m_adjacencyMemory;
+        CIsochartMemoryCharge m_windowMemory;
     };
 
 }
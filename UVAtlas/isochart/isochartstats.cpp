@@ -0,0 +1,52 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - isochartstats.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "isochartstats.h"
+
+using namespace Isochart;
+
+namespace
+{
+    // Trace id of the calling thread, assigned on first use. Threads of nested
+    // or serialized parallel regions all report thread number 0, so the OpenMP
+    // thread number can't be used for this.
+    uint32_t GetTraceThreadId() noexcept
+    {
+        static std::atomic<uint32_t> s_dwNextId(0);
+        static thread_local uint32_t s_dwId = s_dwNextId++;
+        return s_dwId;
+    }
+}
+
+void CIsochartStats::AddTraceEvent(const char* szName, size_t dwFaceCount, bool bBegin)
+{
+    assert(m_bTrace);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+
+    DirectX::UVAtlasTraceEvent event;
+    event.name = szName;
+    event.timestamp = elapsed.count();
+    event.threadId = GetTraceThreadId();
+    event.faceCount = dwFaceCount;
+    event.begin = bBegin;
+
+#pragma omp critical (isochart_trace)
+    {
+        try
+        {
+            m_traceEvents.push_back(event);
+        }
+        catch (std::bad_alloc&)
+        {
+            // Tracing is diagnostic only, drop the event rather than fail
+        }
+    }
+}
@@ -0,0 +1,510 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - isochartstats.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "UVAtlas.h"
+
+namespace Isochart
+{
+    // Stages timed by CIsochartStats, one per UVAtlasStageStats member of UVAtlasStats
+    enum ISOCHARTSTATSSTAGE
+    {
+        ISOCHART_STATS_ROOT_CHART = 0,
+        ISOCHART_STATS_PARAMETERIZE,
+        ISOCHART_STATS_OPTIMIZE_STRETCH,
+        ISOCHART_STATS_MERGE_CHARTS,
+        ISOCHART_STATS_PACK_CHARTS,
+        ISOCHART_STATS_VERTEX_REMAP,
+        ISOCHART_STATS_STAGE_COUNT
+    };
+
+    // Allocations tracked by CIsochartStats, one per memory member of UVAtlasStats
+    enum ISOCHARTMEMORYCATEGORY
+    {
+        ISOCHART_MEMORY_GEODESIC_DISTANCE = 0,
+        ISOCHART_MEMORY_VERTEX_ADJACENCY,
+        ISOCHART_MEMORY_ISOMAP,
+        ISOCHART_MEMORY_GEODESIC_WINDOWS,
+        ISOCHART_MEMORY_CATEGORY_COUNT
+    };
+
+    // Time a worker thread spent in one stage. Stage timings are only added
+    // to CIsochartStats from the driving thread, so workers that run whole
+    // stages on their own collect their time here and hand it over.
+    struct ISOCHARTSTAGETIME
+    {
+        double fSeconds;
+        size_t dwCalls;
+    };
+
+    // Number of CIsochartCancelPoll::Poll() calls between two actual checks
+    const uint32_t CANCEL_POLL_INTERVAL = 256;
+
+    // CIsochartStats collects the per-stage timings and counters reported
+    // through DirectX::UVAtlasStats.
+    // -Stage timings are only recorded from the thread driving the engine.
+    // -Counters can be incremented from any thread, including from inside the
+    //  OpenMP regions which process charts in parallel.
+    // -Trace events are only recorded after EnableTrace(), from any thread.
+    // -Memory is charged from any thread. Each charge is also attributed to the
+    //  stage that is active at the time, and fails without being recorded if
+    //  it would push the total over the memory budget.
+    // -Cancellation is checked from any thread. The first failure seen is
+    //  latched, so every thread stops with the same result.
+    class CIsochartStats
+    {
+    public:
+        CIsochartStats() :
+            m_dwChartsCreated(0),
+            m_dwBipartitions(0),
+            m_dwGeodesicSources(0),
+            m_dwRepackIterations(0),
+            m_fAtlasUtilization(0),
+            m_bTrace(false),
+            m_start(std::chrono::steady_clock::now()),
+            m_dwMemoryBudget(0),
+            m_dwTotalBytes(0),
+            m_dwTotalPeakBytes(0),
+            m_activeStage(ISOCHART_STATS_STAGE_COUNT),
+            m_pCancel(nullptr),
+            m_bDeadline(false),
+            m_hrCancel(S_OK)
+        {
+            for (size_t ii = 0; ii < ISOCHART_STATS_STAGE_COUNT; ii++)
+            {
+                m_stages[ii].seconds = 0;
+                m_stages[ii].calls = 0;
+                m_stages[ii].currentBytes = 0;
+                m_stages[ii].peakBytes = 0;
+                m_stagePeakBytes[ii] = 0;
+            }
+            for (size_t ii = 0; ii < ISOCHART_MEMORY_CATEGORY_COUNT; ii++)
+            {
+                m_categoryBytes[ii] = 0;
+                m_categoryPeakBytes[ii] = 0;
+            }
+        }
+
+        CIsochartStats(CIsochartStats const&) = delete;
+        CIsochartStats& operator=(CIsochartStats const&) = delete;
+
+        void AddStageTime(ISOCHARTSTATSSTAGE stage, double fSeconds)
+        {
+            assert(stage < ISOCHART_STATS_STAGE_COUNT);
+            m_stages[stage].seconds += fSeconds;
+            m_stages[stage].calls++;
+        }
+
+        void AddStageTime(ISOCHARTSTATSSTAGE stage, const ISOCHARTSTAGETIME& time)
+        {
+            assert(stage < ISOCHART_STATS_STAGE_COUNT);
+            m_stages[stage].seconds += time.fSeconds;
+            m_stages[stage].calls += time.dwCalls;
+        }
+
+        // Makes stage the one further charges are attributed to, and returns
+        // the previously active stage so nested timers can restore it.
+        ISOCHARTSTATSSTAGE BeginStage(ISOCHARTSTATSSTAGE stage)
+        {
+            assert(stage < ISOCHART_STATS_STAGE_COUNT);
+            UpdatePeak(m_stagePeakBytes[stage], m_dwTotalBytes);
+            return m_activeStage.exchange(stage);
+        }
+
+        void EndStage(ISOCHARTSTATSSTAGE stage, ISOCHARTSTATSSTAGE previous)
+        {
+            assert(stage < ISOCHART_STATS_STAGE_COUNT);
+            m_stages[stage].currentBytes = m_dwTotalBytes;
+            m_activeStage = previous;
+        }
+
+        void SetMemoryBudget(size_t dwBytes) { m_dwMemoryBudget = dwBytes; }
+
+        HRESULT AllocBytes(ISOCHARTMEMORYCATEGORY category, size_t dwBytes)
+        {
+            assert(category < ISOCHART_MEMORY_CATEGORY_COUNT);
+
+            size_t dwTotal = m_dwTotalBytes.fetch_add(dwBytes) + dwBytes;
+            if (m_dwMemoryBudget && dwTotal > m_dwMemoryBudget)
+            {
+                m_dwTotalBytes -= dwBytes;
+                return E_OUTOFMEMORY;
+            }
+
+            size_t dwCategory = m_categoryBytes[category].fetch_add(dwBytes) + dwBytes;
+            UpdatePeak(m_categoryPeakBytes[category], dwCategory);
+            UpdatePeak(m_dwTotalPeakBytes, dwTotal);
+
+            ISOCHARTSTATSSTAGE stage = m_activeStage;
+            if (stage < ISOCHART_STATS_STAGE_COUNT)
+            {
+                UpdatePeak(m_stagePeakBytes[stage], dwTotal);
+            }
+            return S_OK;
+        }
+
+        void FreeBytes(ISOCHARTMEMORYCATEGORY category, size_t dwBytes)
+        {
+            assert(category < ISOCHART_MEMORY_CATEGORY_COUNT);
+            assert(m_categoryBytes[category] >= dwBytes);
+
+            m_categoryBytes[category] -= dwBytes;
+            m_dwTotalBytes -= dwBytes;
+        }
+
+        void SetCancellation(const DirectX::UVAtlasCancellation& cancellation)
+        {
+            m_pCancel = cancellation.cancel;
+            m_deadline = cancellation.deadline;
+            m_bDeadline = (cancellation.deadline != std::chrono::steady_clock::time_point());
+        }
+
+        bool IsCancellable() const { return m_pCancel || m_bDeadline; }
+
+        // Returns E_ABORT once the caller cancelled, HRESULT_E_TIMEOUT once the
+        // deadline passed, S_OK otherwise.
+        HRESULT CheckCancel()
+        {
+            HRESULT hr = m_hrCancel.load(std::memory_order_relaxed);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            if (m_pCancel && m_pCancel->load(std::memory_order_relaxed))
+            {
+                hr = E_ABORT;
+            }
+            else if (m_bDeadline && std::chrono::steady_clock::now() >= m_deadline)
+            {
+                hr = HRESULT_E_TIMEOUT;
+            }
+            else
+            {
+                return S_OK;
+            }
+
+            HRESULT hrExpected = S_OK;
+            if (!m_hrCancel.compare_exchange_strong(hrExpected, hr))
+            {
+                hr = hrExpected;
+            }
+            return hr;
+        }
+
+        void AddChartsCreated(size_t dwCount) { m_dwChartsCreated += dwCount; }
+        void AddBipartitions(size_t dwCount) { m_dwBipartitions += dwCount; }
+        void AddGeodesicSources(size_t dwCount) { m_dwGeodesicSources += dwCount; }
+        void AddRepackIterations(size_t dwCount) { m_dwRepackIterations += dwCount; }
+        void SetAtlasUtilization(double fUtilization) { m_fAtlasUtilization = fUtilization; }
+
+        void EnableTrace() { m_bTrace = true; }
+        bool IsTracing() const { return m_bTrace; }
+
+        // Out of line, so the OpenMP code is always built with the library's settings
+        void AddTraceEvent(const char* szName, size_t dwFaceCount, bool bBegin);
+
+        void Export(DirectX::UVAtlasStats& stats) const
+        {
+            stats.rootChartBuild = m_stages[ISOCHART_STATS_ROOT_CHART];
+            stats.parameterizeCharts = m_stages[ISOCHART_STATS_PARAMETERIZE];
+            stats.optimizeStretch = m_stages[ISOCHART_STATS_OPTIMIZE_STRETCH];
+            stats.mergeCharts = m_stages[ISOCHART_STATS_MERGE_CHARTS];
+            stats.packCharts = m_stages[ISOCHART_STATS_PACK_CHARTS];
+            stats.vertexRemap = m_stages[ISOCHART_STATS_VERTEX_REMAP];
+            stats.chartsCreated = m_dwChartsCreated;
+            stats.bipartitions = m_dwBipartitions;
+            stats.geodesicSources = m_dwGeodesicSources;
+            stats.repackIterations = m_dwRepackIterations;
+            stats.atlasUtilization = m_fAtlasUtilization;
+
+            DirectX::UVAtlasStageStats* stages[ISOCHART_STATS_STAGE_COUNT] =
+            {
+                &stats.rootChartBuild,
+                &stats.parameterizeCharts,
+                &stats.optimizeStretch,
+                &stats.mergeCharts,
+                &stats.packCharts,
+                &stats.vertexRemap
+            };
+            for (size_t ii = 0; ii < ISOCHART_STATS_STAGE_COUNT; ii++)
+            {
+                stages[ii]->peakBytes = m_stagePeakBytes[ii];
+            }
+
+            DirectX::UVAtlasMemoryStats* memory[ISOCHART_MEMORY_CATEGORY_COUNT] =
+            {
+                &stats.geodesicDistanceMemory,
+                &stats.vertexAdjacencyMemory,
+                &stats.isomapMemory,
+                &stats.geodesicWindowMemory
+            };
+            for (size_t ii = 0; ii < ISOCHART_MEMORY_CATEGORY_COUNT; ii++)
+            {
+                memory[ii]->currentBytes = m_categoryBytes[ii];
+                memory[ii]->peakBytes = m_categoryPeakBytes[ii];
+            }
+            stats.totalMemory.currentBytes = m_dwTotalBytes;
+            stats.totalMemory.peakBytes = m_dwTotalPeakBytes;
+
+            if (stats.traceEvents)
+            {
+                stats.traceEvents->insert(stats.traceEvents->end(), m_traceEvents.cbegin(), m_traceEvents.cend());
+            }
+        }
+
+    private:
+        static void UpdatePeak(std::atomic<size_t>& peak, size_t dwValue)
+        {
+            size_t dwPeak = peak;
+            while (dwPeak < dwValue && !peak.compare_exchange_weak(dwPeak, dwValue))
+            {
+            }
+        }
+
+        DirectX::UVAtlasStageStats m_stages[ISOCHART_STATS_STAGE_COUNT];
+
+        std::atomic<size_t> m_dwChartsCreated;
+        std::atomic<size_t> m_dwBipartitions;
+        std::atomic<size_t> m_dwGeodesicSources;
+        std::atomic<size_t> m_dwRepackIterations;
+        double m_fAtlasUtilization;
+
+        bool m_bTrace;
+        std::chrono::steady_clock::time_point m_start;
+        std::vector<DirectX::UVAtlasTraceEvent> m_traceEvents;
+
+        size_t m_dwMemoryBudget;
+        std::atomic<size_t> m_dwTotalBytes;
+        std::atomic<size_t> m_dwTotalPeakBytes;
+        std::atomic<size_t> m_categoryBytes[ISOCHART_MEMORY_CATEGORY_COUNT];
+        std::atomic<size_t> m_categoryPeakBytes[ISOCHART_MEMORY_CATEGORY_COUNT];
+        std::atomic<size_t> m_stagePeakBytes[ISOCHART_STATS_STAGE_COUNT];
+        std::atomic<ISOCHARTSTATSSTAGE> m_activeStage;
+
+        const std::atomic<bool>* m_pCancel;
+        bool m_bDeadline;
+        std::chrono::steady_clock::time_point m_deadline;
+        std::atomic<HRESULT> m_hrCancel;
+    };
+
+    // Checks the cancellation of a CIsochartStats once every dwInterval calls
+    // of Poll(), cheap enough to sit in the inner loop of a kernel. Each
+    // thread needs its own instance. Does nothing if no cancellation was
+    // requested.
+    class CIsochartCancelPoll
+    {
+    public:
+        explicit CIsochartCancelPoll(CIsochartStats* pStats, uint32_t dwInterval = CANCEL_POLL_INTERVAL) :
+            m_pStats((pStats && pStats->IsCancellable()) ? pStats : nullptr),
+            m_dwInterval(dwInterval),
+            m_dwCount(0)
+        {
+        }
+
+        CIsochartCancelPoll(CIsochartCancelPoll const&) = delete;
+        CIsochartCancelPoll& operator=(CIsochartCancelPoll const&) = delete;
+
+        HRESULT Poll()
+        {
+            if (!m_pStats || ++m_dwCount < m_dwInterval)
+            {
+                return S_OK;
+            }
+
+            m_dwCount = 0;
+            return m_pStats->CheckCancel();
+        }
+
+    private:
+        CIsochartStats* m_pStats;
+        uint32_t m_dwInterval;
+        uint32_t m_dwCount;
+    };
+
+    // Adds the wall-clock time of its own lifetime to one stage of a
+    // CIsochartStats. Does nothing if no statistics were requested.
+    class CIsochartStatsTimer
+    {
+    public:
+        CIsochartStatsTimer(CIsochartStats* pStats, ISOCHARTSTATSSTAGE stage) :
+            m_pStats(pStats),
+            m_stage(stage),
+            m_previous(ISOCHART_STATS_STAGE_COUNT)
+        {
+            if (m_pStats)
+            {
+                m_previous = m_pStats->BeginStage(m_stage);
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~CIsochartStatsTimer()
+        {
+            if (m_pStats)
+            {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+                m_pStats->AddStageTime(m_stage, elapsed.count());
+                m_pStats->EndStage(m_stage, m_previous);
+            }
+        }
+
+        CIsochartStatsTimer(CIsochartStatsTimer const&) = delete;
+        CIsochartStatsTimer& operator=(CIsochartStatsTimer const&) = delete;
+
+    private:
+        CIsochartStats* m_pStats;
+        ISOCHARTSTATSSTAGE m_stage;
+        ISOCHARTSTATSSTAGE m_previous;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // Adds the wall-clock time of its own lifetime to an ISOCHARTSTAGETIME.
+    // Does nothing if pTime is nullptr.
+    class CIsochartStageTimeScope
+    {
+    public:
+        explicit CIsochartStageTimeScope(ISOCHARTSTAGETIME* pTime) :
+            m_pTime(pTime)
+        {
+            if (m_pTime)
+            {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~CIsochartStageTimeScope()
+        {
+            if (m_pTime)
+            {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+                m_pTime->fSeconds += elapsed.count();
+                m_pTime->dwCalls++;
+            }
+        }
+
+        CIsochartStageTimeScope(CIsochartStageTimeScope const&) = delete;
+        CIsochartStageTimeScope& operator=(CIsochartStageTimeScope const&) = delete;
+
+    private:
+        ISOCHARTSTAGETIME* m_pTime;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // Records begin/end trace events around its own lifetime. Does nothing
+    // unless tracing was enabled on the CIsochartStats.
+    class CIsochartTraceScope
+    {
+    public:
+        CIsochartTraceScope(CIsochartStats* pStats, const char* szName, size_t dwFaceCount) :
+            m_pStats((pStats && pStats->IsTracing()) ? pStats : nullptr),
+            m_szName(szName),
+            m_dwFaceCount(dwFaceCount)
+        {
+            if (m_pStats)
+            {
+                m_pStats->AddTraceEvent(m_szName, m_dwFaceCount, true);
+            }
+        }
+
+        ~CIsochartTraceScope()
+        {
+            if (m_pStats)
+            {
+                m_pStats->AddTraceEvent(m_szName, m_dwFaceCount, false);
+            }
+        }
+
+        CIsochartTraceScope(CIsochartTraceScope const&) = delete;
+        CIsochartTraceScope& operator=(CIsochartTraceScope const&) = delete;
+
+    private:
+        CIsochartStats* m_pStats;
+        const char* m_szName;
+        size_t m_dwFaceCount;
+    };
+
+    // Holds a number of bytes charged to one memory category of a
+    // CIsochartStats, and returns them when released or destroyed. Charge
+    // before allocating, so a budget failure never leaves work half done.
+    // Does nothing if no statistics were requested.
+    class CIsochartMemoryCharge
+    {
+    public:
+        CIsochartMemoryCharge(CIsochartStats* pStats, ISOCHARTMEMORYCATEGORY category) :
+            m_pStats(pStats),
+            m_category(category),
+            m_dwBytes(0)
+        {
+        }
+
+        ~CIsochartMemoryCharge()
+        {
+            Release();
+        }
+
+        CIsochartMemoryCharge(CIsochartMemoryCharge const&) = delete;
+        CIsochartMemoryCharge& operator=(CIsochartMemoryCharge const&) = delete;
+
+        CIsochartStats* GetStats() const { return m_pStats; }
+
+        // Releases the current charge and charges further bytes to pStats
+        void SetStats(CIsochartStats* pStats)
+        {
+            Release();
+            m_pStats = pStats;
+        }
+
+        HRESULT Add(size_t dwBytes)
+        {
+            if (!m_pStats || !dwBytes)
+            {
+                return S_OK;
+            }
+
+            HRESULT hr = m_pStats->AllocBytes(m_category, dwBytes);
+            if (SUCCEEDED(hr))
+            {
+                m_dwBytes += dwBytes;
+            }
+            return hr;
+        }
+
+        // Adjusts the charge to dwBytes, used for containers measured after growing
+        HRESULT Resize(size_t dwBytes)
+        {
+            if (dwBytes > m_dwBytes)
+            {
+                return Add(dwBytes - m_dwBytes);
+            }
+
+            if (m_pStats && dwBytes < m_dwBytes)
+            {
+                m_pStats->FreeBytes(m_category, m_dwBytes - dwBytes);
+                m_dwBytes = dwBytes;
+            }
+            return S_OK;
+        }
+
+        void Release()
+        {
+            if (m_pStats && m_dwBytes)
+            {
+                m_pStats->FreeBytes(m_category, m_dwBytes);
+            }
+            m_dwBytes = 0;
+        }
+
+    private:
+        CIsochartStats* m_pStats;
+        ISOCHARTMEMORYCATEGORY m_category;
+        size_t m_dwBytes;
+    };
+}
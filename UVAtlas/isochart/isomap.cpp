@@ -23,7 +23,8 @@ CIsoMap::CIsoMap()
     m_pfEigenValue(nullptr),
     m_pfEigenVector(nullptr),
     m_pfAvgSquaredDstColumn(nullptr),
-    m_fSumOfEigenValue(0)
+    m_fSumOfEigenValue(0),
+    m_memory(nullptr, ISOCHART_MEMORY_ISOMAP)
 {
 }
 
@@ -32,9 +33,10 @@ CIsoMap::~CIsoMap()
     Clear();
 }
 
-HRESULT CIsoMap::Init(size_t dwDimension, float* pGeodesicMatrix)
+HRESULT CIsoMap::Init(size_t dwDimension, float* pGeodesicMatrix, CIsochartStats* pStats)
 {
     Clear();
+    m_memory.SetStats(pStats);
     assert(pGeodesicMatrix != nullptr);
     assert(m_dwCalculatedDimension == 0);
     assert(m_fSumOfEigenValue == 0);
@@ -55,6 +57,11 @@ HRESULT CIsoMap::Init(size_t dwDimension, float* pGeodesicMatrix)
         pRow += m_dwMatrixDimension;
     }
 
+    HRESULT hr = S_OK;
+    CIsochartMemoryCharge averageMemory(pStats, ISOCHART_MEMORY_ISOMAP);
+    FAILURE_RETURN(averageMemory.Add(sizeof(float) * m_dwMatrixDimension));
+    FAILURE_RETURN(m_memory.Add(sizeof(float) * m_dwMatrixDimension));
+
     std::unique_ptr<float[]> average(new (std::nothrow) float[m_dwMatrixDimension]);
     if (!average)
     {
@@ -136,6 +143,17 @@ HRESULT CIsoMap::ComputeLargestEigen(
     assert(dwSelectedDimension <= m_dwMatrixDimension);
     _Analysis_assume_(dwSelectedDimension <= m_dwMatrixDimension);
 
+    // Result buffers, plus the workspace CSymmetricMatrix::GetEigen allocates
+    CIsochartMemoryCharge eigenMemory(m_memory.GetStats(), ISOCHART_MEMORY_ISOMAP);
+    HRESULT hr = eigenMemory.Add(
+        sizeof(float) * (2 * m_dwMatrixDimension * m_dwMatrixDimension + 4 * m_dwMatrixDimension)
+        + sizeof(float*) * m_dwMatrixDimension);
+    if (FAILED(hr) || FAILED(hr = m_memory.Add(
+        sizeof(float) * (m_dwMatrixDimension + 1) * dwSelectedDimension)))
+    {
+        return hr;
+    }
+
     std::unique_ptr<float[]> pfEigenValue(new (std::nothrow) float[m_dwMatrixDimension]);
     std::unique_ptr<float[]> pfEigenVector(new (std::nothrow) float[m_dwMatrixDimension * m_dwMatrixDimension]);
     if (!pfEigenValue || !pfEigenVector)
@@ -151,11 +169,16 @@ HRESULT CIsoMap::ComputeLargestEigen(
         return E_OUTOFMEMORY;
     }
 
+    CIsochartStats* pStats = m_memory.GetStats();
     if (!CSymmetricMatrix<float>::GetEigen(
         m_dwMatrixDimension, m_pfMatrixB,
         pfEigenValue.get(), pfEigenVector.get(),
-        dwSelectedDimension))
+        dwSelectedDimension, 1.0e-6f, pStats))
     {
+        if (pStats && FAILED(hr = pStats->CheckCancel()))
+        {
+            return hr;
+        }
         return E_OUTOFMEMORY;
     }
 
@@ -317,6 +340,7 @@ void CIsoMap::Clear()
     m_dwPrimaryDimension = 0;
     m_pfMatrixB = nullptr;
     m_fSumOfEigenValue = 0;
+    m_memory.Release();
 
     return;
 }
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "isochartstats.h"
+
 namespace Isochart
 {
     class CIsoMap
@@ -19,7 +21,8 @@ namespace Isochart
 
         HRESULT Init(
             size_t dwDimension,
-            float* pfGeodesicMatrix);
+            float* pfGeodesicMatrix,
+            CIsochartStats* pStats);
 
         void Clear();
 
@@ -49,5 +52,6 @@ namespace Isochart
         float* m_pfEigenVector;
         float* m_pfAvgSquaredDstColumn;
         float m_fSumOfEigenValue;
+        CIsochartMemoryCharge m_memory;
     };
 }
@@ -17,6 +17,11 @@ using namespace DirectX;
 namespace
 {
     const size_t MAX_FACE_NUMBER = 0xfffffffe;
+
+    HRESULT UpdateMergeProgress(CCallbackSchemer& callbackSchemer, bool bCountProgress, size_t dwDone)
+    {
+        return bCountProgress ? callbackSchemer.UpdateCallbackAdapt(dwDone) : callbackSchemer.CheckPointAdapt();
+    }
 };
 
 
@@ -26,7 +31,9 @@ HRESULT CIsochartMesh::MergeSmallCharts(
     ISOCHARTMESH_ARRAY& chartList,
     size_t dwExpectChartCount,
     const CBaseMeshInfo& baseInfo,
-    CCallbackSchemer& callbackSchemer)
+    float fMeshArea,
+    CCallbackSchemer& callbackSchemer,
+    bool bCountProgress)
 {
     DPF(1, "#<Chart Number Before Merge> : %zu", chartList.size());
     if (chartList.size() < 4)
@@ -54,7 +61,7 @@ HRESULT CIsochartMesh::MergeSmallCharts(
     FAILURE_RETURN(CalAdjacentChartsForEachChart(
         children, baseInfo.pdwOriginalFaceAdjacentArray, dwFaceNumber));
 
-    FAILURE_RETURN(callbackSchemer.UpdateCallbackAdapt(1));
+    FAILURE_RETURN(UpdateMergeProgress(callbackSchemer, bCountProgress, 1));
 
     // 3. Merge charts that can be merged together.
     chartList.clear();
@@ -62,7 +69,9 @@ HRESULT CIsochartMesh::MergeSmallCharts(
         children,
         dwExpectChartCount,
         dwFaceNumber,
-        callbackSchemer);
+        fMeshArea,
+        callbackSchemer,
+        bCountProgress);
     if (FAILED(hr))
     {
         ReleaseAllNewCharts(children);
@@ -187,7 +196,9 @@ HRESULT CIsochartMesh::PerformMerging(
     ISOCHARTMESH_ARRAY& children,
     size_t dwExpectChartCount,
     size_t dwFaceNumber,
-    CCallbackSchemer& callbackSchemer)
+    float fMeshArea,
+    CCallbackSchemer& callbackSchemer,
+    bool bCountProgress)
 {
     HRESULT hr = S_OK;
     CMaxHeap<uint32_t, uint32_t> heap;
@@ -234,7 +245,7 @@ HRESULT CIsochartMesh::PerformMerging(
     }
     memset(pbMergeFlag.get(), 1, sizeof(bool) * children.size());
 
-    FAILURE_RETURN(callbackSchemer.UpdateCallbackAdapt(1));
+    FAILURE_RETURN(UpdateMergeProgress(callbackSchemer, bCountProgress, 1));
 
     size_t dwReservedCharts = heap.size();
     size_t dwLastReservedCharts = dwReservedCharts;
@@ -254,7 +265,7 @@ HRESULT CIsochartMesh::PerformMerging(
         else
         {
             dwLastReservedCharts = heap.size();
-            if (FAILED(hr = callbackSchemer.UpdateCallbackAdapt(dwDoneWork)))
+            if (FAILED(hr = UpdateMergeProgress(callbackSchemer, bCountProgress, dwDoneWork)))
             {
                 return hr;
             }
@@ -277,6 +288,7 @@ HRESULT CIsochartMesh::PerformMerging(
                 children,
                 index,
                 dwFaceNumber,
+                fMeshArea,
                 pbMergeFlag.get(),
                 pChartNormal.get(),
                 bMerged)))
@@ -306,6 +318,7 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
     ISOCHARTMESH_ARRAY& children,
     uint32_t dwMainChartID,
     size_t dwTotalFaceNumber,
+    float fMeshArea,
     bool* pbMergeFlag,
     XMFLOAT3* pChartNormal,
     bool& bMerged)
@@ -419,6 +432,7 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
             pMainChart,
             pAddjacentChart,
             pMergedChart,
+            fMeshArea,
             bCanMerge)))
         {
             delete pMergedChart;
@@ -488,6 +502,7 @@ HRESULT CIsochartMesh::CheckMergeResult(
     CIsochartMesh* pOldChart1,
     CIsochartMesh* pOldChart2,
     CIsochartMesh* pNewChart,
+    float fMeshArea,
     bool& bCanMerge)
 {
     assert(chartList.size() > 1);
@@ -519,7 +534,7 @@ HRESULT CIsochartMesh::CheckMergeResult(
         return E_OUTOFMEMORY;
     }
 
-    float fMergedAvgStretch = CalOptimalAvgL2SquaredStretch(tempChartList);
+    float fMergedAvgStretch = CalOptimalAvgL2SquaredStretch(tempChartList, fMeshArea);
     bCanMerge =
         IsReachExpectedTotalAvgL2SqrStretch(
             fMergedAvgStretch,
@@ -563,6 +578,9 @@ HRESULT CIsochartMesh::CalculateIsoParameterization()
         CalculateLandmarkVertices(MIN_LANDMARK_NUMBER, dwLandmarkNumber));
 
     // 2. Calculate the distance matrix of landmark vertices
+    CIsochartMemoryCharge distanceMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_DISTANCE);
+    FAILURE_RETURN(distanceMemory.Add(
+        sizeof(float) * dwLandmarkNumber * (m_dwVertNumber + dwLandmarkNumber)));
 
     std::unique_ptr<float[]> vertGeodesicDistance(new (std::nothrow) float[dwLandmarkNumber * m_dwVertNumber]);
     std::unique_ptr<float[]> geodesicMatrix(new (std::nothrow) float[dwLandmarkNumber * dwLandmarkNumber]);
@@ -599,7 +617,7 @@ HRESULT CIsochartMesh::CalculateIsoParameterization()
         m_landmarkVerts, pfVertGeodesicDistance, pfGeodesicMatrix);
 
     // 3. Perform Isomap to decrease dimension
-    if (FAILED(hr = m_isoMap.Init(dwLandmarkNumber, pfGeodesicMatrix)))
+    if (FAILED(hr = m_isoMap.Init(dwLandmarkNumber, pfGeodesicMatrix, m_IsochartEngine.m_pStats)))
     {
         goto LEnd;
     }
@@ -788,8 +806,8 @@ CIsochartMesh* CIsochartMesh::MergeTwoCharts(
     pNewChart->m_dwFaceNumber
         = pChart1->m_dwFaceNumber + pChart2->m_dwFaceNumber;
 
-    pNewChart->m_pVerts = new (std::nothrow) ISOCHARTVERTEX[pNewChart->m_dwVertNumber];
-    pNewChart->m_pFaces = new (std::nothrow) ISOCHARTFACE[pNewChart->m_dwFaceNumber];
+    pNewChart->m_pVerts = NewArray<ISOCHARTVERTEX>(pNewChart->m_baseInfo.pBufferPool, pNewChart->m_dwVertNumber);
+    pNewChart->m_pFaces = AllocateArray<ISOCHARTFACE>(pNewChart->m_baseInfo.pBufferPool, pNewChart->m_dwFaceNumber);
     if (!pNewChart->m_pVerts || !pNewChart->m_pFaces)
     {
         delete pNewChart;
@@ -867,6 +885,9 @@ HRESULT CIsochartMesh::TryMergeChart(
     assert(ppFinialChart != nullptr);
     *ppFinialChart = nullptr;
 
+    CIsochartTraceScope trace(pChart1->m_IsochartEngine.m_pStats, "TryMergeChart",
+        pChart1->m_dwFaceNumber + pChart2->m_dwFaceNumber);
+
     std::vector<uint32_t> vertMap;
     std::vector<bool> vertMark;
 
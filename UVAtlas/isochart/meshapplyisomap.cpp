@@ -13,6 +13,7 @@
 #include "ExactOneToAll.h"
 #include "ApproximateOneToAll.h"
 #include "mathutils.h"
+#include "indexedheap.hpp"
 
 using namespace Isochart;
 using namespace GeodesicDist;
@@ -21,8 +22,10 @@ using namespace DirectX;
 // define the macro to use the exact algorithm, otherwise the fast approximate algorithm is employed
 #ifdef _USE_EXACT_ALGORITHM
 #define ONE_TO_ALL_ENGINE m_ExactOneToAllEngine
+#define ONE_TO_ALL_ENGINE_TYPE CExactOneToAll
 #else
 #define ONE_TO_ALL_ENGINE m_ApproximateOneToAllEngine
+#define ONE_TO_ALL_ENGINE_TYPE CApproximateOneToAll
 #endif
 
 namespace
@@ -34,6 +37,47 @@ namespace
     const float SIGNAL_DISTANCE_WEIGHT = 0.30f;
 }
 
+namespace Isochart
+{
+    // Buffers of the KS98 sweep and of the heat method. A thread keeps one
+    // for all the sources it computes, so a source only resets them.
+    struct GEODESICSCRATCH
+    {
+        GEODESICSCRATCH() : dwVertCapacity(0)
+        {
+        }
+
+        HRESULT Reset(size_t dwVertNumber, const float* pfGeodesicDistance)
+        {
+            if (dwVertCapacity < dwVertNumber)
+            {
+                pbVertProcessed.reset(new (std::nothrow) bool[dwVertNumber]);
+                if (!pbVertProcessed)
+                {
+                    dwVertCapacity = 0;
+                    return E_OUTOFMEMORY;
+                }
+                dwVertCapacity = dwVertNumber;
+            }
+
+            if (!heap.reset(dwVertNumber, pfGeodesicDistance))
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            memset(pbVertProcessed.get(), 0, sizeof(bool) * dwVertNumber);
+            return S_OK;
+        }
+
+        std::unique_ptr<bool[]> pbVertProcessed;
+        size_t dwVertCapacity;
+        CIndexedMinHeap<float> heap;
+
+        CHeatGeodesic::Workspace heatWorkspace;
+        std::vector<double> heatDistance;
+    };
+}
+
 /////////////////////////////////////////////////////////////
 ///////////////Isomap Processing Methods/////////////////////
 /////////////////////////////////////////////////////////////
@@ -137,22 +181,23 @@ HRESULT CIsochartMesh::CalculateLandmarkVertices(
 }
 
 // init structures used in CExactOneToAll or CApproximateOneToAll
-HRESULT CIsochartMesh::InitOneToAllEngine()
+HRESULT CIsochartMesh::InitOneToAllEngine(CExactOneToAll& engine) const
 {
-    ONE_TO_ALL_ENGINE.m_VertexList.clear();
-    ONE_TO_ALL_ENGINE.m_EdgeList.clear();
-    ONE_TO_ALL_ENGINE.m_FaceList.clear();
+    engine.m_VertexList.clear();
+    engine.m_EdgeList.clear();
+    engine.m_FaceList.clear();
+    engine.SetCancellation(m_IsochartEngine.m_pStats);
 
     try
     {
-        ONE_TO_ALL_ENGINE.m_VertexList.resize(m_dwVertNumber);
-        ONE_TO_ALL_ENGINE.m_EdgeList.resize(m_dwEdgeNumber);
-        ONE_TO_ALL_ENGINE.m_FaceList.resize(m_dwFaceNumber);
+        engine.m_VertexList.resize(m_dwVertNumber);
+        engine.m_EdgeList.resize(m_dwEdgeNumber);
+        engine.m_FaceList.resize(m_dwFaceNumber);
 
-        // init vertex list in ONE_TO_ALL_ENGINE
+        // init vertex list in the engine
         for (size_t i = 0; i < m_dwVertNumber; ++i)
         {
-            Vertex& thisVertex = ONE_TO_ALL_ENGINE.m_VertexList[i];
+            Vertex& thisVertex = engine.m_VertexList[i];
 
             thisVertex.x = double(m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh].x);
             thisVertex.y = double(m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh].y);
@@ -160,20 +205,20 @@ HRESULT CIsochartMesh::InitOneToAllEngine()
             thisVertex.bBoundary = m_pVerts[i].bIsBoundary;
         }
 
-        // init edge list in ONE_TO_ALL_ENGINE
+        // init edge list in the engine
         for (size_t i = 0; i < m_dwEdgeNumber; ++i)
         {
-            Edge& thisEdge = ONE_TO_ALL_ENGINE.m_EdgeList[i];
+            Edge& thisEdge = engine.m_EdgeList[i];
 
             thisEdge.dwVertexIdx0 = m_edges[i].dwVertexID[0];
-            thisEdge.pVertex0 = &ONE_TO_ALL_ENGINE.m_VertexList[thisEdge.dwVertexIdx0];
+            thisEdge.pVertex0 = &engine.m_VertexList[thisEdge.dwVertexIdx0];
             thisEdge.dwVertexIdx1 = m_edges[i].dwVertexID[1];
-            thisEdge.pVertex1 = &ONE_TO_ALL_ENGINE.m_VertexList[thisEdge.dwVertexIdx1];
+            thisEdge.pVertex1 = &engine.m_VertexList[thisEdge.dwVertexIdx1];
 
             thisEdge.dwAdjFaceIdx0 = m_edges[i].dwFaceID[0];
-            thisEdge.pAdjFace0 = &ONE_TO_ALL_ENGINE.m_FaceList[thisEdge.dwAdjFaceIdx0];
+            thisEdge.pAdjFace0 = &engine.m_FaceList[thisEdge.dwAdjFaceIdx0];
             thisEdge.dwAdjFaceIdx1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? FLAG_INVALIDDWORD : m_edges[i].dwFaceID[1];
-            thisEdge.pAdjFace1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? nullptr : &ONE_TO_ALL_ENGINE.m_FaceList[thisEdge.dwAdjFaceIdx1];
+            thisEdge.pAdjFace1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? nullptr : &engine.m_FaceList[thisEdge.dwAdjFaceIdx1];
 
             thisEdge.dEdgeLength = sqrt(SquredD3Dist(*thisEdge.pVertex0, *thisEdge.pVertex1));
 
@@ -181,24 +226,24 @@ HRESULT CIsochartMesh::InitOneToAllEngine()
             thisEdge.pVertex1->edgesAdj.push_back(&thisEdge);
         }
 
-        // init face list in ONE_TO_ALL_ENGINE
+        // init face list in the engine
         for (size_t i = 0; i < m_dwFaceNumber; ++i)
         {
-            Face& thisFace = ONE_TO_ALL_ENGINE.m_FaceList[i];
+            Face& thisFace = engine.m_FaceList[i];
 
             thisFace.dwEdgeIdx0 = m_pFaces[i].dwEdgeID[0];
-            thisFace.pEdge0 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx0];
+            thisFace.pEdge0 = &engine.m_EdgeList[thisFace.dwEdgeIdx0];
             thisFace.dwEdgeIdx1 = m_pFaces[i].dwEdgeID[1];
-            thisFace.pEdge1 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx1];
+            thisFace.pEdge1 = &engine.m_EdgeList[thisFace.dwEdgeIdx1];
             thisFace.dwEdgeIdx2 = m_pFaces[i].dwEdgeID[2];
-            thisFace.pEdge2 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx2];
+            thisFace.pEdge2 = &engine.m_EdgeList[thisFace.dwEdgeIdx2];
 
             thisFace.dwVertexIdx0 = m_pFaces[i].dwVertexID[0];
-            thisFace.pVertex0 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx0];
+            thisFace.pVertex0 = &engine.m_VertexList[thisFace.dwVertexIdx0];
             thisFace.dwVertexIdx1 = m_pFaces[i].dwVertexID[1];
-            thisFace.pVertex1 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx1];
+            thisFace.pVertex1 = &engine.m_VertexList[thisFace.dwVertexIdx1];
             thisFace.dwVertexIdx2 = m_pFaces[i].dwVertexID[2];
-            thisFace.pVertex2 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx2];
+            thisFace.pVertex2 = &engine.m_VertexList[thisFace.dwVertexIdx2];
 
             thisFace.pVertex2->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex2, *thisFace.pVertex0, *thisFace.pVertex1);
             thisFace.pVertex1->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex1, *thisFace.pVertex0, *thisFace.pVertex2);
@@ -221,25 +266,47 @@ HRESULT CIsochartMesh::InitOneToAllEngine()
     return S_OK;
 }
 
-// For each vertex in landmark list, compute geodesic distance from
-// this vertex to all other vertices in the same chart.
-HRESULT CIsochartMesh::CalculateGeodesicDistance(
-    std::vector<uint32_t>& vertList,
-    float* pfVertCombineDistance,
-    float* pfVertGeodesicDistance) const
+// Build and factor the heat method systems of the chart. Returns S_FALSE,
+// leaving heat unfactored, if the chart needs more than
+// HEAT_GEODESIC_MAX_FACTOR_ENTRIES or is not one connected surface.
+HRESULT CIsochartMesh::InitHeatGeodesic(CHeatGeodesic& heat) const
 {
-    if (vertList.empty())
+    CIsochartTraceScope trace(m_IsochartEngine.m_pStats, "InitHeatGeodesic", m_dwFaceNumber);
+
+    std::unique_ptr<XMFLOAT3[]> positions(new (std::nothrow) XMFLOAT3[m_dwVertNumber]);
+    std::unique_ptr<uint32_t[]> indices(new (std::nothrow) uint32_t[m_dwFaceNumber * 3]);
+    if (!positions || !indices)
     {
-        return S_OK;
+        return E_OUTOFMEMORY;
     }
-    assert(!(!pfVertGeodesicDistance && !pfVertCombineDistance));
 
-    HRESULT hr = S_OK;
-    size_t dwVertLandNumber = static_cast<size_t>(vertList.size());
-    bool bIsSignalDistance = IsIMTSpecified();
+    for (size_t i = 0; i < m_dwVertNumber; ++i)
+    {
+        positions[i] = m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh];
+    }
+
+    for (size_t i = 0; i < m_dwFaceNumber; ++i)
+    {
+        indices[i * 3] = m_pFaces[i].dwVertexID[0];
+        indices[i * 3 + 1] = m_pFaces[i].dwVertexID[1];
+        indices[i * 3 + 2] = m_pFaces[i].dwVertexID[2];
+    }
 
-    if (
+    heat.SetStats(m_IsochartEngine.m_pStats);
+    return heat.Init(
+        positions.get(),
+        m_dwVertNumber,
+        indices.get(),
+        m_dwFaceNumber,
+        HEAT_GEODESIC_MAX_FACTOR_ENTRIES);
+}
+
+// Whether the one-to-all engine refines the distances of the KS98 sweep
+bool CIsochartMesh::IsNewGeodesicDistanceUsed(bool bIsSignalDistance) const
+{
+    return
         (
+            (
             // if the geodesic algorithm selection field of the isochart option is DEFAULT, check whether suitable to apply the new algorithm
         (
             (
@@ -265,14 +332,63 @@ HRESULT CIsochartMesh::CalculateGeodesicDistance(
             m_dwVertNumber > 0 &&
             m_dwFaceNumber > 0
             )
-        )
+        );
+}
+
+// Whether the heat method replaces the KS98 sweep. Like the one-to-all
+// engine, it does not support IMT.
+bool CIsochartMesh::IsHeatGeodesicDistanceUsed(bool bIsSignalDistance) const
+{
+    return
+        (m_IsochartEngine.m_dwOptions & _OPTION_ISOCHART_GEODESIC_HEAT)
+        && !bIsSignalDistance
+        && m_dwVertNumber > 0
+        && m_dwFaceNumber > 0;
+}
+
+// For each vertex in landmark list, compute geodesic distance from
+// this vertex to all other vertices in the same chart.
+// Each source writes only its own rows of the output, so the sources of a big
+// chart run in parallel. The first thread uses the chart's one-to-all engine,
+// the others build their own. The heat method factors its systems once here
+// and shares them between the threads.
+HRESULT CIsochartMesh::CalculateGeodesicDistance(
+    std::vector<uint32_t>& vertList,
+    float* pfVertCombineDistance,
+    float* pfVertGeodesicDistance) const
+{
+    if (vertList.empty())
+    {
+        return S_OK;
+    }
+    assert(!(!pfVertGeodesicDistance && !pfVertCombineDistance));
+
+    CIsochartTraceScope trace(m_IsochartEngine.m_pStats, "CalculateGeodesicDistance", m_dwFaceNumber);
+
+    HRESULT hr = S_OK;
+    size_t dwVertLandNumber = static_cast<size_t>(vertList.size());
+    bool bIsSignalDistance = IsIMTSpecified();
+
+    const bool bNewGeoDist = IsNewGeodesicDistanceUsed(bIsSignalDistance);
+    if (bNewGeoDist)
+    {
+        FAILURE_RETURN(InitOneToAllEngine(const_cast<CIsochartMesh*>(this)->ONE_TO_ALL_ENGINE));
+    }
+
+    CHeatGeodesic heat;
+    if (IsHeatGeodesicDistanceUsed(bIsSignalDistance))
     {
-        const_cast<CIsochartMesh*>(this)->InitOneToAllEngine();
+        // a chart the heat method can not factor, or whose factors the memory budget
+        // refuses, uses the KS98 sweep
+        FAILURE_RETURN(InitHeatGeodesic(heat));
     }
+    const CHeatGeodesic* pHeat = heat.IsFactored() ? &heat : nullptr;
 
+    CIsochartMemoryCharge tempMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_DISTANCE);
     float* pfTempGeodesicDistance = nullptr;
     if (!pfVertGeodesicDistance)
     {
+        FAILURE_RETURN(tempMemory.Add(sizeof(float) * dwVertLandNumber * m_dwVertNumber));
         pfTempGeodesicDistance = new (std::nothrow) float[dwVertLandNumber * m_dwVertNumber];
         if (!pfTempGeodesicDistance)
         {
@@ -284,42 +400,70 @@ HRESULT CIsochartMesh::CalculateGeodesicDistance(
         pfTempGeodesicDistance = pfVertGeodesicDistance;
     }
 
-    float* pCombineDistanceToOneLandmark = pfVertCombineDistance;
-    float* pGeodesicDstanceToOneLandmark = pfTempGeodesicDistance;
-    for (size_t i = 0; i < dwVertLandNumber; i++)
+    const bool bCombineSignal = pfVertCombineDistance && bIsSignalDistance;
+    std::atomic<HRESULT> hrOut(S_OK);
+
+#pragma omp parallel if (m_dwVertNumber >= PARALLEL_GEODESIC_MIN_VERTICES && dwVertLandNumber > 1)
     {
-        if (FAILED(hr = CalculateGeodesicDistanceToVertex(
-            vertList[i],
-            bIsSignalDistance)))
+        CExactOneToAll* pEngine = bNewGeoDist ? &const_cast<CIsochartMesh*>(this)->ONE_TO_ALL_ENGINE : nullptr;
+        CIsochartMemoryCharge* pWindowMemory = &const_cast<CIsochartMesh*>(this)->m_windowMemory;
+
+        GEODESICSCRATCH scratch;
+        std::unique_ptr<ONE_TO_ALL_ENGINE_TYPE> threadEngine;
+        CIsochartMemoryCharge threadWindowMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_WINDOWS);
+#ifdef _OPENMP
+        if (bNewGeoDist && omp_get_thread_num() > 0)
         {
-            if (pfVertGeodesicDistance != pfTempGeodesicDistance)
+            threadEngine.reset(new (std::nothrow) ONE_TO_ALL_ENGINE_TYPE);
+            HRESULT hrInit = threadEngine ? InitOneToAllEngine(*threadEngine) : E_OUTOFMEMORY;
+            if (FAILED(hrInit))
             {
-                delete[]pfTempGeodesicDistance;
+                HRESULT hrExpected = S_OK;
+                hrOut.compare_exchange_strong(hrExpected, hrInit);
             }
-            return hr;
+            pEngine = threadEngine.get();
+            pWindowMemory = &threadWindowMemory;
         }
+#endif
 
-        if (pfVertCombineDistance && bIsSignalDistance)
+#pragma omp for schedule(dynamic, 1)
+        for (int i = 0; i < static_cast<int>(dwVertLandNumber); i++)
         {
-            for (size_t j = 0; j < m_dwVertNumber; j++)
+            if (FAILED(hrOut)) // 'break' isn't allowed in an OpenMP for loop
+                continue;
+
+            const size_t dwRow = static_cast<size_t>(i) * m_dwVertNumber;
+            HRESULT hrSource = CalculateGeodesicDistanceToVertex(
+                vertList[static_cast<size_t>(i)],
+                scratch,
+                pEngine,
+                pHeat,
+                *pWindowMemory,
+                pfTempGeodesicDistance + dwRow,
+                bCombineSignal ? pfVertCombineDistance + dwRow : nullptr);
+            if (FAILED(hrSource))
             {
-                pCombineDistanceToOneLandmark[j] = m_pVerts[j].fSignalDistance;
-                pGeodesicDstanceToOneLandmark[j] = m_pVerts[j].fGeodesicDistance;
+                HRESULT hrExpected = S_OK;
+                hrOut.compare_exchange_strong(hrExpected, hrSource);
             }
-            pCombineDistanceToOneLandmark += m_dwVertNumber;
-            pGeodesicDstanceToOneLandmark += m_dwVertNumber;
         }
-        else
+    }
+
+    if (FAILED(hr = hrOut))
+    {
+        if (pfVertGeodesicDistance != pfTempGeodesicDistance)
         {
-            for (size_t j = 0; j < m_dwVertNumber; j++)
-            {
-                pGeodesicDstanceToOneLandmark[j] = m_pVerts[j].fGeodesicDistance;
-            }
-            pGeodesicDstanceToOneLandmark += m_dwVertNumber;
+            delete[]pfTempGeodesicDistance;
         }
+        return hr;
+    }
+
+    if (m_IsochartEngine.m_pStats)
+    {
+        m_IsochartEngine.m_pStats->AddGeodesicSources(dwVertLandNumber);
     }
 
-    if (pfVertCombineDistance && bIsSignalDistance)
+    if (bCombineSignal)
     {
         CombineGeodesicAndSignalDistance(
             pfVertCombineDistance,
@@ -334,7 +478,7 @@ HRESULT CIsochartMesh::CalculateGeodesicDistance(
             uint32_t dwIndex1 = static_cast<uint32_t>(i * m_dwVertNumber + vertList[j]);
             uint32_t dwIndex2 = static_cast<uint32_t>(j * m_dwVertNumber + vertList[i]);
 
-            if (pfVertCombineDistance && bIsSignalDistance)
+            if (bCombineSignal)
             {
                 pfVertCombineDistance[dwIndex1]
                     = pfVertCombineDistance[dwIndex2]
@@ -410,24 +554,25 @@ void CIsochartMesh::UpdateAdjacentVertexGeodistance(
     ISOCHARTVERTEX* pAdjacentVertex,
     const ISOCHARTEDGE& edgeBetweenVertex,
     bool* pbVertProcessed,
-    bool bIsSignalDistance) const
+    float* pfGeodesicDistance,
+    float* pfSignalDistance) const
 {
     assert(pCurrentVertex != nullptr);
     assert(pAdjacentVertex != nullptr);
     assert(pbVertProcessed != nullptr);
 
-    if (pAdjacentVertex->fGeodesicDistance
-        > (pCurrentVertex->fGeodesicDistance
+    if (pfGeodesicDistance[pAdjacentVertex->dwID]
+        > (pfGeodesicDistance[pCurrentVertex->dwID]
             + edgeBetweenVertex.fLength))
     {
-        pAdjacentVertex->fGeodesicDistance =
-            (pCurrentVertex->fGeodesicDistance
+        pfGeodesicDistance[pAdjacentVertex->dwID] =
+            (pfGeodesicDistance[pCurrentVertex->dwID]
                 + edgeBetweenVertex.fLength);
 
-        if (bIsSignalDistance)
+        if (pfSignalDistance)
         {
-            pAdjacentVertex->fSignalDistance =
-                pCurrentVertex->fSignalDistance
+            pfSignalDistance[pAdjacentVertex->dwID] =
+                pfSignalDistance[pCurrentVertex->dwID]
                 + edgeBetweenVertex.fSignalLength;
         }
 
@@ -447,20 +592,22 @@ void CIsochartMesh::UpdateAdjacentVertexGeodistance(
 
         if (pbVertProcessed[pOppositeVertex->dwID])
         {
-            if (pOppositeVertex->fGeodesicDistance >
-                pCurrentVertex->fGeodesicDistance)
+            if (pfGeodesicDistance[pOppositeVertex->dwID] >
+                pfGeodesicDistance[pCurrentVertex->dwID])
             {
                 CalculateGeodesicDistanceABC(
                     pCurrentVertex,
                     pOppositeVertex,
-                    pAdjacentVertex);
+                    pAdjacentVertex,
+                    pfGeodesicDistance);
             }
             else
             {
                 CalculateGeodesicDistanceABC(
                     pOppositeVertex,
                     pCurrentVertex,
-                    pAdjacentVertex);
+                    pAdjacentVertex,
+                    pfGeodesicDistance);
             }
         }
     }
@@ -468,74 +615,82 @@ void CIsochartMesh::UpdateAdjacentVertexGeodistance(
 
 HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertex(
     uint32_t dwSourceVertID,
-    bool bIsSignalDistance,
+    GEODESICSCRATCH& scratch,
+    CExactOneToAll* pEngine,
+    const CHeatGeodesic* pHeat,
+    CIsochartMemoryCharge& windowMemory,
+    float* pfGeodesicDistance,
+    float* pfSignalDistance,
     uint32_t* pdwFarestPeerVertID) const
 {
+    if (pHeat)
+    {
+        assert(!pfSignalDistance);
+        return CalculateGeodesicDistanceToVertexHeat(*pHeat, dwSourceVertID, scratch, pfGeodesicDistance, pdwFarestPeerVertID);
+    }
+
     HRESULT hr =
-        CalculateGeodesicDistanceToVertexKS98(dwSourceVertID, bIsSignalDistance, pdwFarestPeerVertID);
+        CalculateGeodesicDistanceToVertexKS98(dwSourceVertID, scratch, pfGeodesicDistance, pfSignalDistance, pdwFarestPeerVertID);
     if (FAILED(hr))
         return hr;
 
-    if (
-        (
-            // if the geodesic algorithm selection field of the isochart option is DEFAULT, check whether suitable to apply the new algorithm
-        (
-            (
-            (m_IsochartEngine.m_dwOptions & _OPTIONMASK_ISOCHART_GEODESIC)
-                ==
-                (_OPTION_ISOCHART_DEFAULT & _OPTIONMASK_ISOCHART_GEODESIC)
-                )
-            &&
-            (m_baseInfo.dwFaceCount < LIMIT_FACENUM_USENEWGEODIST)
-            )
-            ||
-
-            // or the user forces to use the new algorithm
-            (
-                m_IsochartEngine.m_dwOptions & _OPTION_ISOCHART_GEODESIC_QUALITY
-                )
-            )
-        &&
-
-        // anyway, if IMT is specified, use the old geodesic distance algorithm, because currently the new geodesic distance algorithm does not support IMT
-        (
-            !bIsSignalDistance &&
-            m_dwVertNumber > 0 &&
-            m_dwFaceNumber > 0
-            )
-        )
+    if (pEngine)
     {
-        hr = const_cast<CIsochartMesh*>(this)->CalculateGeodesicDistanceToVertexNewGeoDist(dwSourceVertID, pdwFarestPeerVertID);
+        hr = CalculateGeodesicDistanceToVertexNewGeoDist(*pEngine, windowMemory, dwSourceVertID, pfGeodesicDistance, pdwFarestPeerVertID);
     }
 
     return hr;
 }
 
 HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexNewGeoDist(
+    CExactOneToAll& engine,
+    CIsochartMemoryCharge& windowMemory,
     uint32_t dwSourceVertID,
-    uint32_t* pdwFarestPeerVertID)
+    float* pfGeodesicDistance,
+    uint32_t* pdwFarestPeerVertID) const
 {
     try
     {
-        ONE_TO_ALL_ENGINE.SetSrcVertexIdx(dwSourceVertID);
-        ONE_TO_ALL_ENGINE.Run();
+        engine.SetSrcVertexIdx(dwSourceVertID);
+        HRESULT hr = engine.Run();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
     }
     catch (std::bad_alloc&)
     {
         return E_OUTOFMEMORY;
     }
 
+    // Window lists are cleared but keep their capacity between sources,
+    // so the capacity after a run is what the engine holds on to.
+    if (m_IsochartEngine.m_pStats)
+    {
+        size_t dwWindowBytes =
+            sizeof(Vertex) * engine.m_VertexList.capacity()
+            + sizeof(Edge) * engine.m_EdgeList.capacity()
+            + sizeof(Face) * engine.m_FaceList.capacity()
+            + engine.GetWindowBytes();
+
+        HRESULT hr = windowMemory.Resize(dwWindowBytes);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
     uint32_t dwFarestVertID = 0;
     double dGeoFarest = 0.0;
     for (uint32_t i = 0; i < m_dwVertNumber; ++i)
     {
-        m_pVerts[i].fGeodesicDistance = m_pVerts[i].fSignalDistance =
-            std::min(m_pVerts[i].fGeodesicDistance,
-                float(ONE_TO_ALL_ENGINE.m_VertexList[i].dGeoDistanceToSrc));
+        pfGeodesicDistance[i] =
+            std::min(pfGeodesicDistance[i],
+                float(engine.m_VertexList[i].dGeoDistanceToSrc));
 
-        if (double(m_pVerts[i].fGeodesicDistance) > dGeoFarest)
+        if (double(pfGeodesicDistance[i]) > dGeoFarest)
         {
-            dGeoFarest = double(m_pVerts[i].fGeodesicDistance);
+            dGeoFarest = double(pfGeodesicDistance[i]);
             dwFarestVertID = i;
         }
     }
@@ -548,68 +703,109 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexNewGeoDist(
     return S_OK;
 }
 
-// See more detail in [KS98]
-HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
+// See more detail in [CWW13]. heat holds the systems factored by InitHeatGeodesic.
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexHeat(
+    const CHeatGeodesic& heat,
     uint32_t dwSourceVertID,
-    bool bIsSignalDistance,
+    GEODESICSCRATCH& scratch,
+    float* pfGeodesicDistance,
     uint32_t* pdwFarestPeerVertID) const
 {
-    uint32_t dwFarestVertID = 0;
-
-    std::unique_ptr<bool[]> pbVertProcessed(new (std::nothrow) bool[m_dwVertNumber]);
-    std::unique_ptr<CMaxHeapItem<float, uint32_t>[]> heapItem(new (std::nothrow) CMaxHeapItem<float, uint32_t>[m_dwVertNumber]);
-    if (!pbVertProcessed || !heapItem)
+    try
+    {
+        scratch.heatDistance.resize(m_dwVertNumber);
+    }
+    catch (std::bad_alloc&)
     {
         return E_OUTOFMEMORY;
     }
-    memset(pbVertProcessed.get(), 0, sizeof(bool) * m_dwVertNumber);
 
-    CMaxHeap<float, uint32_t> heap;
-    if (!heap.resize(m_dwVertNumber))
+    HRESULT hr = heat.Run(dwSourceVertID, scratch.heatWorkspace, scratch.heatDistance.data());
+    if (FAILED(hr))
     {
-        return E_OUTOFMEMORY;
+        return hr;
+    }
+
+    uint32_t dwFarestVertID = dwSourceVertID;
+    float fGeoFarest = 0;
+    for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+    {
+        pfGeodesicDistance[i] = float(scratch.heatDistance[i]);
+
+        if (pfGeodesicDistance[i] > fGeoFarest)
+        {
+            fGeoFarest = pfGeodesicDistance[i];
+            dwFarestVertID = i;
+        }
+    }
+
+    if (pdwFarestPeerVertID)
+    {
+        *pdwFarestPeerVertID = dwFarestVertID;
+    }
+
+    return S_OK;
+}
+
+// See more detail in [KS98]. The signal distance is skipped if
+// pfSignalDistance is nullptr.
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
+    uint32_t dwSourceVertID,
+    GEODESICSCRATCH& scratch,
+    float* pfGeodesicDistance,
+    float* pfSignalDistance,
+    uint32_t* pdwFarestPeerVertID) const
+{
+    uint32_t dwFarestVertID = 0;
+
+    HRESULT hr = scratch.Reset(m_dwVertNumber, pfGeodesicDistance);
+    if (FAILED(hr))
+    {
+        return hr;
     }
 
-    auto pHeapItem = heapItem.get();
+    bool* pbVertProcessed = scratch.pbVertProcessed.get();
+    CIndexedMinHeap<float>& heap = scratch.heap;
 
     // 1. Init the distance to source of each vertex
-    ISOCHARTVERTEX* pCurrentVertex = m_pVerts;
-    for (size_t i = 0; i < m_dwVertNumber; i++)
+    std::fill_n(pfGeodesicDistance, m_dwVertNumber, FLT_MAX);
+    if (pfSignalDistance)
     {
-        pCurrentVertex->fGeodesicDistance = FLT_MAX;
-        pCurrentVertex->fSignalDistance = FLT_MAX;
-        pCurrentVertex++;
+        std::fill_n(pfSignalDistance, m_dwVertNumber, FLT_MAX);
     }
 
     // 2. Init the source vertices
-    pCurrentVertex = m_pVerts + dwSourceVertID;
     pbVertProcessed[dwSourceVertID] = true;
-    pCurrentVertex->fGeodesicDistance = 0;
-    pCurrentVertex->fSignalDistance = 0;
-
-    // 3. Init heap to prepare process of iteration.
-    pHeapItem[dwSourceVertID].m_data = dwSourceVertID;
-    pHeapItem[dwSourceVertID].m_weight = 0;
-
-    if (!heap.insert(pHeapItem + dwSourceVertID))
+    pfGeodesicDistance[dwSourceVertID] = 0;
+    if (pfSignalDistance)
     {
-        return E_OUTOFMEMORY;
+        pfSignalDistance[dwSourceVertID] = 0;
     }
 
+    // 3. Init heap to prepare process of iteration.
+    heap.insert(dwSourceVertID);
+
     dwFarestVertID = dwSourceVertID;
 
+    CIsochartCancelPoll cancel(m_IsochartEngine.m_pStats);
+
     // 4. Dijkstra algorithm to compute geodesic distance from source
     // to other vertices.
     for (size_t i = 0; i < m_dwVertNumber; i++)
     {
-        CMaxHeapItem<float, uint32_t>* pTop;
-        pTop = heap.cutTop();
-        if (!pTop)
+        hr = cancel.Poll();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        uint32_t dwCurrentVertID;
+        if (!heap.cutTop(dwCurrentVertID))
         {
             break;
         }
 
-        pCurrentVertex = m_pVerts + pTop->m_data;
+        ISOCHARTVERTEX* pCurrentVertex = m_pVerts + dwCurrentVertID;
         pbVertProcessed[pCurrentVertex->dwID] = true;
         dwFarestVertID = pCurrentVertex->dwID;
 
@@ -638,7 +834,7 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
 
             UpdateAdjacentVertexGeodistance(
                 pCurrentVertex, pAdjacentVertex,
-                edge, pbVertProcessed.get(), bIsSignalDistance);
+                edge, pbVertProcessed, pfGeodesicDistance, pfSignalDistance);
 
         }
 
@@ -651,21 +847,13 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
                 continue;
             }
 
-            ISOCHARTVERTEX* pAdjacentVertex = m_pVerts + dwAdjacentID;
-            if (pHeapItem[dwAdjacentID].isItemInHeap())
+            if (heap.isInHeap(dwAdjacentID))
             {
-                heap.update(pHeapItem + dwAdjacentID,
-                    -pAdjacentVertex->fGeodesicDistance);
+                heap.decrease(dwAdjacentID);
             }
             else
             {
-                pHeapItem[dwAdjacentID].m_data = dwAdjacentID;
-                pHeapItem[dwAdjacentID].m_weight =
-                    -pAdjacentVertex->fGeodesicDistance;
-                if (!heap.insert(pHeapItem + dwAdjacentID))
-                {
-                    return E_OUTOFMEMORY;
-                }
+                heap.insert(dwAdjacentID);
             }
         }
     }
@@ -681,10 +869,11 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
 void CIsochartMesh::CalculateGeodesicDistanceABC(
     ISOCHARTVERTEX* pVertexA,
     ISOCHARTVERTEX* pVertexB,
-    ISOCHARTVERTEX* pVertexC) const
+    ISOCHARTVERTEX* pVertexC,
+    float* pfGeodesicDistance) const
 {
     XMVECTOR v[3];
-    float u = pVertexB->fGeodesicDistance - pVertexA->fGeodesicDistance;
+    float u = pfGeodesicDistance[pVertexB->dwID] - pfGeodesicDistance[pVertexA->dwID];
     v[0] = XMVectorSubtract(XMLoadFloat3(m_baseInfo.pVertPosition + pVertexB->dwIDInRootMesh),
         XMLoadFloat3(m_baseInfo.pVertPosition + pVertexC->dwIDInRootMesh));
 
@@ -734,9 +923,9 @@ void CIsochartMesh::CalculateGeodesicDistanceABC(
         return;
     }
 
-    if (pVertexC->fGeodesicDistance > pVertexA->fGeodesicDistance + t)
+    if (pfGeodesicDistance[pVertexC->dwID] > pfGeodesicDistance[pVertexA->dwID] + t)
     {
-        pVertexC->fGeodesicDistance = pVertexA->fGeodesicDistance + t;
+        pfGeodesicDistance[pVertexC->dwID] = pfGeodesicDistance[pVertexA->dwID] + t;
     }
 
 
@@ -450,8 +450,8 @@ namespace Isochart
         pChart->m_dwVertNumber = vertList.size();
         pChart->m_dwFaceNumber = faceList.size();
 
-        pChart->m_pVerts = new (std::nothrow) ISOCHARTVERTEX[pChart->m_dwVertNumber];
-        pChart->m_pFaces = new (std::nothrow) ISOCHARTFACE[pChart->m_dwFaceNumber];
+        pChart->m_pVerts = NewArray<ISOCHARTVERTEX>(m_baseInfo.pBufferPool, pChart->m_dwVertNumber);
+        pChart->m_pFaces = AllocateArray<ISOCHARTFACE>(m_baseInfo.pBufferPool, pChart->m_dwFaceNumber);
 
         if (!pChart->m_pVerts || !pChart->m_pFaces)
         {
@@ -1055,6 +1055,9 @@ HRESULT CIsochartMesh::CalculateLandmarkUV(
 
     size_t dwSubLandmarkNumber = m_landmarkVerts.size();
 
+    CIsochartMemoryCharge matrixMemory(m_IsochartEngine.m_pStats, ISOCHART_MEMORY_GEODESIC_DISTANCE);
+    FAILURE_RETURN(matrixMemory.Add(sizeof(float) * dwSubLandmarkNumber * dwSubLandmarkNumber));
+
     std::unique_ptr<float[]> subDistanceMatrix(new (std::nothrow) float[dwSubLandmarkNumber * dwSubLandmarkNumber]);
     if (!subDistanceMatrix)
     {
@@ -1086,7 +1089,7 @@ HRESULT CIsochartMesh::CalculateLandmarkUV(
         }
     }
 
-    hr = m_isoMap.Init(dwSubLandmarkNumber, pfSubDistanceMatrix);
+    hr = m_isoMap.Init(dwSubLandmarkNumber, pfSubDistanceMatrix, m_IsochartEngine.m_pStats);
     if (FAILED(hr))
     {
         return hr;
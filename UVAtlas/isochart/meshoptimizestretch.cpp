@@ -126,6 +126,27 @@ namespace Isochart
         float* pfWorkStretch;
         float fRadius;
     };
+
+    // Largest value returned by CStretchRandom::Next()
+    const uint32_t STRETCH_RAND_MAX = 0x7fff;
+
+    // The sequence of the MSVC CRT rand() after srand(seed). Each call keeps its
+    // own state, so charts optimized on different threads get the same results
+    // as on a single thread.
+    class CStretchRandom
+    {
+    public:
+        explicit CStretchRandom(uint32_t dwSeed) : m_dwState(dwSeed) {}
+
+        uint32_t Next()
+        {
+            m_dwState = m_dwState * 214013u + 2531011u;
+            return (m_dwState >> 16) & STRETCH_RAND_MAX;
+        }
+
+    private:
+        uint32_t m_dwState;
+    };
 }
 
 namespace
@@ -246,12 +267,54 @@ HRESULT CIsochartMesh::OptimizeAllL2SquaredStretch(
     ISOCHARTMESH_ARRAY& chartList,
     bool bOptimizeSignal)
 {
-    HRESULT hr = S_OK;
-    for (size_t ii = 0; ii < chartList.size(); ii++)
+    if (chartList.empty())
     {
-        FAILURE_RETURN(chartList[ii]->OptimizeChartL2Stretch(bOptimizeSignal));
+        return S_OK;
     }
-    return S_OK;
+
+    // Charts are optimized independently. Hand them out largest first, so a
+    // big chart picked up last does not keep one thread busy alone at the end.
+    std::vector<uint32_t> order;
+    try
+    {
+        order.resize(chartList.size());
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    for (size_t ii = 0; ii < order.size(); ii++)
+    {
+        order[ii] = static_cast<uint32_t>(ii);
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&chartList](uint32_t a, uint32_t b) { return chartList[a]->GetFaceNumber() > chartList[b]->GetFaceNumber(); });
+
+    // Optimizing one chart takes long enough to poll before each of them
+    CIsochartStats* pStats = chartList[0]->m_IsochartEngine.m_pStats;
+    std::atomic<HRESULT> hrOut(S_OK);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int ii = 0; ii < static_cast<int>(order.size()); ii++)
+    {
+        if (FAILED(hrOut)) // 'break' isn't allowed in an OpenMP for loop
+            continue;
+
+        CIsochartCancelPoll cancel(pStats, 1);
+        HRESULT hr = cancel.Poll();
+        if (SUCCEEDED(hr))
+        {
+            hr = chartList[order[static_cast<size_t>(ii)]]->OptimizeChartL2Stretch(bOptimizeSignal);
+        }
+
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            hrOut.compare_exchange_strong(hrExpected, hr);
+        }
+    }
+    return hrOut;
 }
 
 float CIsochartMesh::ComputeGeoAvgL2Stretch(
@@ -392,8 +455,20 @@ float CIsochartMesh::CalOptimalAvgL2SquaredStretch(
         return 0;
     }
 
+    return CalOptimalAvgL2SquaredStretch(chartList, chartList[0]->m_baseInfo.fMeshArea);
+}
+
+// Same, but averaged over fMeshArea, the 3D area of the charts in chartList
+float CIsochartMesh::CalOptimalAvgL2SquaredStretch(
+    ISOCHARTMESH_ARRAY& chartList,
+    float fMeshArea)
+{
+    if (chartList.empty())
+    {
+        return 0;
+    }
+
     bool bAllChartSatisfiedStretch = true;
-    const CBaseMeshInfo& baseInfo = chartList[0]->m_baseInfo;
     float fSumSqrtEiiaii = 0;
     for (size_t ii = 0; ii < chartList.size(); ii++)
     {
@@ -409,7 +484,7 @@ float CIsochartMesh::CalOptimalAvgL2SquaredStretch(
         return 1;
     }
 
-    return (fSumSqrtEiiaii / baseInfo.fMeshArea) * (fSumSqrtEiiaii / baseInfo.fMeshArea);
+    return (fSumSqrtEiiaii / fMeshArea) * (fSumSqrtEiiaii / fMeshArea);
 }
 
 //////////////Main Functions////////////////////////////////
@@ -648,6 +723,8 @@ HRESULT CIsochartMesh::OptimizeChartL2Stretch(bool bOptimizeSignal)
         return S_OK;
     }
 
+    CIsochartTraceScope trace(m_IsochartEngine.m_pStats, "OptimizeChartL2Stretch", m_dwFaceNumber);
+
     CHARTOPTIMIZEINFO optimizeInfo;
     HRESULT hr = S_OK;
 
@@ -1813,14 +1890,14 @@ bool CIsochartMesh::OptimizeVertexStretchAroundCenter(
     float fTempStretch = 0;
     XMFLOAT2 middle;
     // As the decription in [SSGH01], randomly moving vertex will have more
-    // chance to find the optimal position. To make consistent results, srand
+    // chance to find the optimal position. To make consistent results, seed
     // with a specified value 2
-    srand(2);
+    CStretchRandom random(2);
     size_t iteration = 0;
     while (iteration < optimizeInfo.dwRandOptOneVertTimes)
     {
         // 1. Get a new random position in the optimizing circle range
-        float fAngle = float(rand()) * 2.f * XM_PI / RAND_MAX;
+        float fAngle = float(random.Next()) * 2.f * XM_PI / STRETCH_RAND_MAX;
         vertInfo.end.x =
             vertInfo.center.x + vertInfo.fRadius * cosf(fAngle);
         vertInfo.end.y =
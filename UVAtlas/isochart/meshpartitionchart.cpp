@@ -1847,25 +1847,24 @@ CaculateDistanceToExtremeVertex(
     fAverageDistance = 0;
 
     size_t dwBoundaryVertexCount = 0;
-    ISOCHARTVERTEX* pVertex = m_pVerts;
-    for (size_t i = 0; i < m_dwVertNumber; i++)
+    for (uint32_t i = 0; i < m_dwVertNumber; i++)
     {
-        if (pVertex->bIsBoundary)
+        if (IsBoundaryVertex(i))
         {
-            fAverageDistance += pVertex->fGeodesicDistance;
+            float fDistance = m_pfGeodesicDistance[i];
+            fAverageDistance += fDistance;
             dwBoundaryVertexCount++;
 
-            if (pVertex->fGeodesicDistance < fMinDistance)
+            if (fDistance < fMinDistance)
             {
-                fMinDistance = pVertex->fGeodesicDistance;
+                fMinDistance = fDistance;
             }
 
-            if (pVertex->fGeodesicDistance > fMaxDistance)
+            if (fDistance > fMaxDistance)
             {
-                fMaxDistance = pVertex->fGeodesicDistance;
+                fMaxDistance = fDistance;
             }
         }
-        pVertex++;
     }
 
     fAverageDistance /= float(dwBoundaryVertexCount);
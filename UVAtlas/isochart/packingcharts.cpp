@@ -103,9 +103,29 @@ namespace
     const float STANDARD_UV_SIZE = 512;
     const float STANDARD_GUTTER = 2;
 
-    // Tables for precomputed triangle values.
-    float g_PackingCosTable[CHART_ROTATION_NUMBER];
-    float g_PackingSinTable[CHART_ROTATION_NUMBER];
+    // Tables for precomputed triangle values. Built on first use and only read
+    // afterwards, so packings running at the same time can share them.
+    struct PACKINGROTATIONS
+    {
+        float fCos[CHART_ROTATION_NUMBER];
+        float fSin[CHART_ROTATION_NUMBER];
+
+        PACKINGROTATIONS()
+        {
+            for (size_t ii = 0; ii < CHART_ROTATION_NUMBER; ii++)
+            {
+                float fAngle = float(ii) * 2.f * XM_PI / float(CHART_ROTATION_NUMBER);
+                fCos[ii] = cosf(fAngle);
+                fSin[ii] = sinf(fAngle);
+            }
+        }
+    };
+
+    const PACKINGROTATIONS& GetPackingRotations()
+    {
+        static const PACKINGROTATIONS s_rotations;
+        return s_rotations;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -2295,7 +2315,7 @@ float CIsochartMesh::GuranteeSmallestChartArea(
 
 // Performed before packing chart.
 // 1. Allocate packing information buffer for each chart
-// 2. Initialize global sin and cos table
+// 2. Initialize shared sin and cos table
 // 3. Align each chart along longest axis
 // 4. Adjust chart UV-area
 // 5. Initialize atlas information structure
@@ -2313,13 +2333,9 @@ HRESULT CIsochartMesh::PreparePacking(
     // 1. Create data structure for each chart needed by Packing Charts.
     FAILURE_RETURN(CreateChartsPackingBuffer(chartList));
 
-    // 2. Initialize global sin and cos table needed in packing process.
-    for (size_t ii = 0; ii < CHART_ROTATION_NUMBER; ii++)
-    {
-        float fAngle = float(ii) * 2.f * XM_PI / float(CHART_ROTATION_NUMBER);
-        g_PackingCosTable[ii] = cosf(fAngle);
-        g_PackingSinTable[ii] = sinf(fAngle);
-    }
+    // 2. Initialize shared sin and cos table needed in packing process,
+    // unless an earlier packing did.
+    GetPackingRotations();
 
     // 3. Gurantee All charts larger than a lower bound.
     float fTotalArea = GuranteeSmallestChartArea(chartList);
@@ -2506,6 +2522,8 @@ HRESULT CIsochartMesh::PackingOneChart(
 {
     HRESULT hr = S_OK;
 
+    CIsochartTraceScope trace(pChart->m_IsochartEngine.m_pStats, "PackingOneChart", pChart->m_dwFaceNumber);
+
     auto pPackingInfo = pChart->GetPackingInfoBuffer();
 
     // 1.  If current chart's area is zero, don't pack it, just put it at (0, 0).
@@ -2925,8 +2943,8 @@ void CIsochartMesh::RotateChartAroundCenter(
     ISOCHARTVERTEX** ppTopMostVertex,
     ISOCHARTVERTEX** ppBottomMostVertex)
 {
-    float fCos = g_PackingCosTable[dwRotationId];
-    float fSin = g_PackingSinTable[dwRotationId];
+    float fCos = GetPackingRotations().fCos[dwRotationId];
+    float fSin = GetPackingRotations().fSin[dwRotationId];
 
     if (bOnlyRotateBoundaries)
     {
@@ -3287,8 +3305,8 @@ HRESULT CIsochartMesh::ScanAlongBoundayEdges(
 void CIsochartMesh::RotateBordersAroundCenter(
     size_t dwRotationId)
 {
-    float fCos = g_PackingCosTable[dwRotationId];
-    float fSin = g_PackingSinTable[dwRotationId];
+    float fCos = GetPackingRotations().fCos[dwRotationId];
+    float fSin = GetPackingRotations().fSin[dwRotationId];
 
     ISOCHARTVERTEX* pVertex;
 
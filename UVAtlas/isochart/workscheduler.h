@@ -0,0 +1,190 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - workscheduler.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _OPENMP
+
+#include <omp.h>
+
+#include <chrono>
+#include <deque>
+#include <thread>
+
+namespace Isochart
+{
+    // An idle worker yields this many times, then sleeps between its attempts
+    // to find work, so it does not take a core from the busy ones
+    const unsigned int WORK_STEALING_SPIN_COUNT = 64;
+    const unsigned int WORK_STEALING_SLEEP_US = 200;
+
+    // CWorkStealingScheduler hands out work items to the threads of an OpenMP
+    // parallel region, where processing an item may produce new items. It only
+    // needs OpenMP 2.0 locks, so it also works where OpenMP tasks are missing.
+    // -Each worker owns a deque. It pushes the items it produces and pops its
+    //  next item at the back, so it goes depth first through its own work.
+    // -A worker whose deque is empty steals from the front of the others, where
+    //  the oldest and usually largest items are.
+    // -An item is outstanding from Push() until the Finish() of the worker that
+    //  popped it. Pop() waits while items are outstanding, because they may
+    //  still produce more, and returns false once all of them are finished.
+    template <typename T>
+    class CWorkStealingScheduler
+    {
+    public:
+        CWorkStealingScheduler() :
+            m_dwWorkers(0),
+            m_dwOutstanding(0)
+        {
+        }
+
+        ~CWorkStealingScheduler()
+        {
+            for (size_t i = 0; i < m_dwWorkers; i++)
+            {
+                omp_destroy_lock(&m_pWorkers[i].lock);
+            }
+        }
+
+        CWorkStealingScheduler(CWorkStealingScheduler const&) = delete;
+        CWorkStealingScheduler& operator=(CWorkStealingScheduler const&) = delete;
+
+        HRESULT Init(size_t dwWorkers)
+        {
+            assert(!m_pWorkers && dwWorkers > 0);
+
+            m_pWorkers.reset(new (std::nothrow) WORKER[dwWorkers]);
+            if (!m_pWorkers)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            m_dwWorkers = dwWorkers;
+            for (size_t i = 0; i < m_dwWorkers; i++)
+            {
+                omp_init_lock(&m_pWorkers[i].lock);
+            }
+            return S_OK;
+        }
+
+        // Adds items to the back of the deque of dwWorker, either all or none
+        // of them
+        HRESULT Push(size_t dwWorker, const T* pItems, size_t dwCount)
+        {
+            WORKER& worker = m_pWorkers[dwWorker % m_dwWorkers];
+
+            // Count the items before any thread can pop them
+            m_dwOutstanding += dwCount;
+
+            HRESULT hr = S_OK;
+            size_t dwPushed = 0;
+            omp_set_lock(&worker.lock);
+            try
+            {
+                for (; dwPushed < dwCount; dwPushed++)
+                {
+                    worker.items.push_back(pItems[dwPushed]);
+                }
+            }
+            catch (std::bad_alloc&)
+            {
+                for (; dwPushed > 0; dwPushed--)
+                {
+                    worker.items.pop_back();
+                }
+                hr = E_OUTOFMEMORY;
+            }
+            omp_unset_lock(&worker.lock);
+
+            if (FAILED(hr))
+            {
+                m_dwOutstanding -= dwCount;
+            }
+            return hr;
+        }
+
+        // Gets the next item for dwWorker. Returns false once every item
+        // pushed so far is finished.
+        bool Pop(size_t dwWorker, T& item)
+        {
+            dwWorker %= m_dwWorkers;
+            for (unsigned int dwSpin = 0;; dwSpin++)
+            {
+                if (TryTake(dwWorker, true, item))
+                {
+                    return true;
+                }
+
+                for (size_t i = 1; i < m_dwWorkers; i++)
+                {
+                    if (TryTake((dwWorker + i) % m_dwWorkers, false, item))
+                    {
+                        return true;
+                    }
+                }
+
+                if (m_dwOutstanding == 0)
+                {
+                    return false;
+                }
+                if (dwSpin < WORK_STEALING_SPIN_COUNT)
+                {
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(WORK_STEALING_SLEEP_US));
+                }
+            }
+        }
+
+        // Marks a popped item as done. Items it produced must be pushed first.
+        void Finish()
+        {
+            assert(m_dwOutstanding > 0);
+            --m_dwOutstanding;
+        }
+
+    private:
+        struct WORKER
+        {
+            omp_lock_t lock;
+            std::deque<T> items;
+        };
+
+        bool TryTake(size_t dwWorker, bool bBack, T& item)
+        {
+            WORKER& worker = m_pWorkers[dwWorker];
+            bool bTaken = false;
+            omp_set_lock(&worker.lock);
+            if (!worker.items.empty())
+            {
+                if (bBack)
+                {
+                    item = worker.items.back();
+                    worker.items.pop_back();
+                }
+                else
+                {
+                    item = worker.items.front();
+                    worker.items.pop_front();
+                }
+                bTaken = true;
+            }
+            omp_unset_lock(&worker.lock);
+            return bTaken;
+        }
+
+        std::unique_ptr<WORKER[]> m_pWorkers;
+        size_t m_dwWorkers;
+        std::atomic<size_t> m_dwOutstanding;
+    };
+}
+
+#endif // _OPENMP
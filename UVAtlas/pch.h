@@ -77,8 +77,10 @@
 #include <cmath>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cfloat>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -92,7 +94,6 @@
 #include <queue>
 
 #ifndef WIN32
-#include <mutex>
 #include <thread>
 #endif
 
@@ -125,3 +126,6 @@ extern void __cdecl UVAtlasDebugPrintf(unsigned int lvl, _In_z_ _Printf_format_s
 
 // HRESULT_FROM_WIN32(ERROR_INVALID_DATA)
 #define HRESULT_E_INVALID_DATA static_cast<HRESULT>(0x8007000DL)
+
+// HRESULT_FROM_WIN32(ERROR_TIMEOUT)
+#define HRESULT_E_TIMEOUT static_cast<HRESULT>(0x800705B4L)
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------------------------
+// File: BenchTimer.h
+//
+// Wall-clock timer shared by the UVAtlas benchmarks
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+
+namespace UVAtlasBench
+{
+    class Timer
+    {
+    public:
+        Timer() noexcept : m_start(std::chrono::steady_clock::now()) {}
+
+        void Reset() noexcept { m_start = std::chrono::steady_clock::now(); }
+
+        double Elapsed() const noexcept
+        {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+            return elapsed.count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
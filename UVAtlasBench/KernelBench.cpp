@@ -0,0 +1,1099 @@
+//--------------------------------------------------------------------------------------
+// File: KernelBench.cpp
+//
+// Microbenchmarks for the isochart numerical kernels, reporting JSON results
+//
+// Each kernel is run on sized, seeded inputs so that optimization work on one
+// kernel can be measured in isolation from the rest of the pipeline.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+
+#include <cstdio>
+#include <map>
+#include <random>
+
+#include "isochartmesh.h"
+#include "progressivemesh.h"
+#include "SymmetricMatrix.hpp"
+#include "UVAtlasRepacker.h"
+#include "Vis_Maxflow.h"
+#include "mathutils.h"
+
+#include "BenchTimer.h"
+#include "ProceduralMesh.h"
+
+using namespace DirectX;
+using namespace Isochart;
+using namespace IsochartRepacker;
+using namespace GeodesicDist;
+using namespace UVAtlasBench;
+
+namespace
+{
+    enum OPTIONS
+    {
+        OPT_KERNELS = 1,
+        OPT_SIZES,
+        OPT_ITERATIONS,
+        OPT_SEED,
+        OPT_OUTPUTFILE,
+        OPT_NOLOGO,
+        OPT_MAX
+    };
+
+    static_assert(OPT_MAX <= 32, "dwOptions is a uint32_t bitfield");
+
+    enum BENCH_KERNEL : unsigned int
+    {
+        KERNEL_EIGEN = 0,
+        KERNEL_CONJUGATE_GRADIENT,
+        KERNEL_MAXFLOW,
+        KERNEL_EXACT_GEODESIC,
+        KERNEL_APPROX_GEODESIC,
+        KERNEL_HEAT_GEODESIC,
+        KERNEL_PROGRESSIVE_MESH,
+        KERNEL_REPACK,
+        KERNEL_IMT_TEXTURE,
+        KERNEL_COUNT
+    };
+
+    enum BENCH_SIZE : unsigned int
+    {
+        SIZE_SMALL = 0,
+        SIZE_MEDIUM,
+        SIZE_LARGE,
+        SIZE_COUNT
+    };
+
+    struct SValue
+    {
+        const char* pName;
+        uint32_t dwValue;
+    };
+
+    const SValue g_pOptions[] =
+    {
+        { "kernel",     OPT_KERNELS },
+        { "size",       OPT_SIZES },
+        { "i",          OPT_ITERATIONS },
+        { "seed",       OPT_SEED },
+        { "o",          OPT_OUTPUTFILE },
+        { "nologo",     OPT_NOLOGO },
+        { nullptr,      0 }
+    };
+
+    const SValue g_pKernels[] =
+    {
+        { "eigen",          KERNEL_EIGEN },
+        { "cg",             KERNEL_CONJUGATE_GRADIENT },
+        { "maxflow",        KERNEL_MAXFLOW },
+        { "exactgeodesic",  KERNEL_EXACT_GEODESIC },
+        { "approxgeodesic", KERNEL_APPROX_GEODESIC },
+        { "heatgeodesic",   KERNEL_HEAT_GEODESIC },
+        { "progressivemesh", KERNEL_PROGRESSIVE_MESH },
+        { "repack",         KERNEL_REPACK },
+        { "imttexture",     KERNEL_IMT_TEXTURE },
+        { nullptr,          0 }
+    };
+
+    const SValue g_pSizes[] =
+    {
+        { "small",      SIZE_SMALL },
+        { "medium",     SIZE_MEDIUM },
+        { "large",      SIZE_LARGE },
+        { nullptr,      0 }
+    };
+
+    // Problem size for each kernel, see the Run* functions for what the number means
+    const size_t g_kernelSizes[KERNEL_COUNT][SIZE_COUNT] =
+    {
+        { 64, 256, 512 },               // eigen: matrix dimension
+        { 32, 128, 512 },               // cg: grid edge length of the Laplacian
+        { 64, 256, 1024 },              // maxflow: grid edge length
+        { 1000, 5000, 20000 },          // exactgeodesic: sphere faces
+        { 1000, 5000, 20000 },          // approxgeodesic: sphere faces
+        { 1000, 5000, 20000 },          // heatgeodesic: sphere faces
+        { 1000, 10000, 100000 },        // progressivemesh: sphere faces
+        { 1000, 10000, 50000 },         // repack: shells faces
+        { 1000, 10000, 100000 },        // imttexture: sphere faces
+    };
+
+    const size_t c_eigenCount = 10;
+    const size_t c_cgMaxIterations = 1000;
+    const size_t c_geodesicSources = 4;
+    const size_t c_textureSize = 256;
+
+    struct KernelResult
+    {
+        BENCH_KERNEL kernel;
+        BENCH_SIZE size;
+        HRESULT hr;
+        double seconds;
+        size_t elements;        // Work items covered by one timed run
+        size_t steps;           // Kernel specific count, e.g. solver iterations
+        double checksum;        // Keeps the result live and catches gross regressions
+    };
+
+
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+
+    uint32_t LookupByName(const char* pName, const SValue* pArray)
+    {
+        while (pArray->pName)
+        {
+            if (!strcmp(pName, pArray->pName))
+                return pArray->dwValue;
+
+            pArray++;
+        }
+
+        return uint32_t(-1);
+    }
+
+    const char* LookupByValue(uint32_t value, const SValue* pArray)
+    {
+        while (pArray->pName)
+        {
+            if (value == pArray->dwValue)
+                return pArray->pName;
+
+            pArray++;
+        }
+
+        return "";
+    }
+
+    // Parses a comma separated list of names into a bitmask
+    bool ParseList(char* pValue, const SValue* pArray, uint32_t& mask)
+    {
+        mask = 0;
+        for (char* pToken = strtok(pValue, ","); pToken; pToken = strtok(nullptr, ","))
+        {
+            if (!strcmp(pToken, "all"))
+            {
+                mask = uint32_t(-1);
+                continue;
+            }
+
+            uint32_t value = LookupByName(pToken, pArray);
+            if (value == uint32_t(-1))
+                return false;
+
+            mask |= (1u << value);
+        }
+        return mask != 0;
+    }
+
+    void PrintUsage()
+    {
+        printf("Usage: uvatlas_kernelbench <options>\n\n");
+        printf("   -kernel <list>      comma separated kernels to time (def: all)\n");
+        printf("                       eigen, cg, maxflow, exactgeodesic, approxgeodesic,\n");
+        printf("                       heatgeodesic, progressivemesh, repack, imttexture\n");
+        printf("   -size <list>        comma separated input sizes (def: all)\n");
+        printf("                       small, medium, large\n");
+        printf("   -i <number>         iterations per measurement, fastest is reported (def: 3)\n");
+        printf("   -seed <number>      seed for the generated inputs (def: 0)\n");
+        printf("   -o <filename>       output JSON filename (def: stdout)\n");
+        printf("   -nologo             suppress copyright message\n");
+    }
+
+    void PrintLogo()
+    {
+        fprintf(stderr, "Microsoft (R) UVAtlas Kernel Benchmark (UVAtlas version %d)\n", UVATLAS_VERSION);
+        fprintf(stderr, "Copyright (C) Microsoft Corp.\n\n");
+    }
+
+    void RecordTime(KernelResult& result, size_t iter, double seconds)
+    {
+        if (!iter || seconds < result.seconds)
+        {
+            result.seconds = seconds;
+        }
+    }
+
+
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+
+    // Dense symmetric matrix shaped like the isomap input: squared distances
+    // between random points, double centered.
+    HRESULT RunEigen(size_t dim, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+        std::vector<XMFLOAT3> points(dim);
+        for (auto& pt : points)
+        {
+            pt = XMFLOAT3(dist(rng), dist(rng), 0.25f * dist(rng));
+        }
+
+        // Geodesic distances are not Euclidean, so perturb the squared distances
+        // symmetrically to get a full rank matrix like the real input
+        std::vector<float> matrix(dim * dim);
+        for (size_t i = 0; i < dim; ++i)
+        {
+            for (size_t j = i; j < dim; ++j)
+            {
+                const float dx = points[i].x - points[j].x;
+                const float dy = points[i].y - points[j].y;
+                const float dz = points[i].z - points[j].z;
+                const float d2 = (i == j) ? 0.f : dx * dx + dy * dy + dz * dz + 0.05f * std::fabs(dist(rng));
+                matrix[i * dim + j] = d2;
+                matrix[j * dim + i] = d2;
+            }
+        }
+
+        std::vector<double> rowMean(dim, 0.0);
+        double totalMean = 0.0;
+        for (size_t i = 0; i < dim; ++i)
+        {
+            for (size_t j = 0; j < dim; ++j)
+            {
+                rowMean[i] += double(matrix[i * dim + j]);
+            }
+            rowMean[i] /= double(dim);
+            totalMean += rowMean[i];
+        }
+        totalMean /= double(dim);
+
+        for (size_t i = 0; i < dim; ++i)
+        {
+            for (size_t j = 0; j < dim; ++j)
+            {
+                matrix[i * dim + j] = -0.5f * float(double(matrix[i * dim + j]) - rowMean[i] - rowMean[j] + totalMean);
+            }
+        }
+
+        // GetEigen uses the output buffers as scratch space, so they are sized
+        // for the full decomposition as in CIsoMap::ComputeLargestEigen
+        const size_t range = std::min(c_eigenCount, dim);
+        std::vector<float> eigenValues(dim);
+        std::vector<float> eigenVectors(dim * dim);
+
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            Timer timer;
+            const bool ok = CSymmetricMatrix<float>::GetEigen(
+                dim, matrix.data(), eigenValues.data(), eigenVectors.data(), range);
+            const double seconds = timer.Elapsed();
+
+            if (!ok)
+                return E_OUTOFMEMORY;
+
+            RecordTime(result, iter, seconds);
+        }
+
+        result.elements = dim * dim;
+        result.steps = range;
+        result.checksum = 0;
+        for (size_t i = 0; i < range; ++i)
+        {
+            result.checksum += double(eigenValues[i]);
+        }
+
+        return S_OK;
+    }
+
+    // (I + L) x = b, L the 5-point Laplacian of an n x n grid
+    HRESULT RunConjugateGradient(size_t n, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+        const size_t count = n * n;
+
+        CSparseMatrix<float> A;
+        CVector<float> B;
+        try
+        {
+            if (!A.resize(count, count))
+                return E_OUTOFMEMORY;
+
+            B.resize(count);
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        for (size_t y = 0; y < n; ++y)
+        {
+            for (size_t x = 0; x < n; ++x)
+            {
+                const size_t row = y * n + x;
+                float diagonal = 1.f;
+
+                const size_t neighbors[4] =
+                {
+                    (x > 0) ? row - 1 : size_t(-1),
+                    (x + 1 < n) ? row + 1 : size_t(-1),
+                    (y > 0) ? row - n : size_t(-1),
+                    (y + 1 < n) ? row + n : size_t(-1),
+                };
+
+                for (const size_t col : neighbors)
+                {
+                    if (col == size_t(-1))
+                        continue;
+
+                    if (!A.setItem(row, col, -1.f))
+                        return E_OUTOFMEMORY;
+
+                    diagonal += 1.f;
+                }
+
+                if (!A.setItem(row, row, diagonal))
+                    return E_OUTOFMEMORY;
+
+                B[row] = dist(rng);
+            }
+        }
+
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            CVector<float> X;
+            size_t solverIterations = 0;
+
+            Timer timer;
+            const bool ok = CSparseMatrix<float>::ConjugateGradient(
+                X, A, B, c_cgMaxIterations, 1e-6f, solverIterations);
+            const double seconds = timer.Elapsed();
+
+            if (!ok)
+                return E_OUTOFMEMORY;
+
+            RecordTime(result, iter, seconds);
+
+            result.steps = solverIterations;
+            result.checksum = double(CVector<float>::dot(X, X));
+        }
+
+        result.elements = count;
+        return S_OK;
+    }
+
+    // 4-connected n x n grid with random n-link and t-link capacities, the
+    // same shape of graph the boundary optimization builds
+    HRESULT RunMaxFlow(size_t n, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        const size_t count = n * n;
+
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+            CMaxFlow graph;
+            graph.Reset();
+            if (!graph.InitGraphCut(count, 0, 6))
+                return E_OUTOFMEMORY;
+
+            try
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    graph.AddNode();
+                }
+
+                for (size_t y = 0; y < n; ++y)
+                {
+                    for (size_t x = 0; x < n; ++x)
+                    {
+                        const auto id = CMaxFlow::node_id(y * n + x);
+                        if (x + 1 < n)
+                        {
+                            graph.AddEdge(id, id + 1, dist(rng), dist(rng));
+                        }
+                        if (y + 1 < n)
+                        {
+                            graph.AddEdge(id, CMaxFlow::node_id(id + CMaxFlow::node_id(n)), dist(rng), dist(rng));
+                        }
+
+                        // Pin the left and right columns to the terminals
+                        const float sw = (x == 0) ? FLT_MAX : 0.5f * dist(rng);
+                        const float tw = (x + 1 == n) ? FLT_MAX : 0.5f * dist(rng);
+                        graph.SetTweights(id, sw, tw);
+                    }
+                }
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            Timer timer;
+            graph.ComputeMaxFlow();
+            const double seconds = timer.Elapsed();
+
+            RecordTime(result, iter, seconds);
+            result.checksum = double(graph.GetFlow());
+        }
+
+        result.elements = count;
+        return S_OK;
+    }
+
+    // Builds the one-to-all engine topology, mirroring CIsochartMesh::InitOneToAllEngine
+    HRESULT InitOneToAllEngine(const ProceduralMesh& mesh, CExactOneToAll& engine)
+    {
+        const size_t nVerts = mesh.GetVertexCount();
+        const size_t nFaces = mesh.GetFaceCount();
+
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeMap;
+        std::vector<uint32_t> faceEdges(nFaces * 3);
+        std::vector<uint32_t> edgeVerts;
+        std::vector<uint32_t> edgeFaces;
+
+        try
+        {
+            for (size_t face = 0; face < nFaces; ++face)
+            {
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t v0 = mesh.indices[face * 3 + k];
+                    const uint32_t v1 = mesh.indices[face * 3 + (k + 1) % 3];
+                    const auto key = std::make_pair(std::min(v0, v1), std::max(v0, v1));
+
+                    auto it = edgeMap.find(key);
+                    if (it == edgeMap.end())
+                    {
+                        const auto edge = static_cast<uint32_t>(edgeFaces.size() / 2);
+                        edgeMap[key] = edge;
+                        edgeVerts.push_back(key.first);
+                        edgeVerts.push_back(key.second);
+                        edgeFaces.push_back(static_cast<uint32_t>(face));
+                        edgeFaces.push_back(FLAG_INVALIDDWORD);
+                        faceEdges[face * 3 + k] = edge;
+                    }
+                    else
+                    {
+                        edgeFaces[it->second * 2 + 1] = static_cast<uint32_t>(face);
+                        faceEdges[face * 3 + k] = it->second;
+                    }
+                }
+            }
+
+            const size_t nEdges = edgeFaces.size() / 2;
+
+            engine.m_VertexList.clear();
+            engine.m_EdgeList.clear();
+            engine.m_FaceList.clear();
+
+            engine.m_VertexList.resize(nVerts);
+            engine.m_EdgeList.resize(nEdges);
+            engine.m_FaceList.resize(nFaces);
+
+            for (size_t i = 0; i < nVerts; ++i)
+            {
+                Vertex& thisVertex = engine.m_VertexList[i];
+
+                thisVertex.x = double(mesh.positions[i].x);
+                thisVertex.y = double(mesh.positions[i].y);
+                thisVertex.z = double(mesh.positions[i].z);
+            }
+
+            for (size_t i = 0; i < nEdges; ++i)
+            {
+                Edge& thisEdge = engine.m_EdgeList[i];
+
+                thisEdge.dwVertexIdx0 = edgeVerts[i * 2];
+                thisEdge.pVertex0 = &engine.m_VertexList[thisEdge.dwVertexIdx0];
+                thisEdge.dwVertexIdx1 = edgeVerts[i * 2 + 1];
+                thisEdge.pVertex1 = &engine.m_VertexList[thisEdge.dwVertexIdx1];
+
+                thisEdge.dwAdjFaceIdx0 = edgeFaces[i * 2];
+                thisEdge.pAdjFace0 = &engine.m_FaceList[thisEdge.dwAdjFaceIdx0];
+                thisEdge.dwAdjFaceIdx1 = edgeFaces[i * 2 + 1];
+                thisEdge.pAdjFace1 = (thisEdge.dwAdjFaceIdx1 == FLAG_INVALIDDWORD) ? nullptr : &engine.m_FaceList[thisEdge.dwAdjFaceIdx1];
+
+                thisEdge.dEdgeLength = sqrt(SquredD3Dist(*thisEdge.pVertex0, *thisEdge.pVertex1));
+
+                if (!thisEdge.pAdjFace1)
+                {
+                    thisEdge.pVertex0->bBoundary = true;
+                    thisEdge.pVertex1->bBoundary = true;
+                }
+
+                thisEdge.pVertex0->edgesAdj.push_back(&thisEdge);
+                thisEdge.pVertex1->edgesAdj.push_back(&thisEdge);
+            }
+
+            for (size_t i = 0; i < nFaces; ++i)
+            {
+                Face& thisFace = engine.m_FaceList[i];
+
+                thisFace.dwEdgeIdx0 = faceEdges[i * 3];
+                thisFace.pEdge0 = &engine.m_EdgeList[thisFace.dwEdgeIdx0];
+                thisFace.dwEdgeIdx1 = faceEdges[i * 3 + 1];
+                thisFace.pEdge1 = &engine.m_EdgeList[thisFace.dwEdgeIdx1];
+                thisFace.dwEdgeIdx2 = faceEdges[i * 3 + 2];
+                thisFace.pEdge2 = &engine.m_EdgeList[thisFace.dwEdgeIdx2];
+
+                thisFace.dwVertexIdx0 = mesh.indices[i * 3];
+                thisFace.pVertex0 = &engine.m_VertexList[thisFace.dwVertexIdx0];
+                thisFace.dwVertexIdx1 = mesh.indices[i * 3 + 1];
+                thisFace.pVertex1 = &engine.m_VertexList[thisFace.dwVertexIdx1];
+                thisFace.dwVertexIdx2 = mesh.indices[i * 3 + 2];
+                thisFace.pVertex2 = &engine.m_VertexList[thisFace.dwVertexIdx2];
+
+                thisFace.pVertex2->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex2, *thisFace.pVertex0, *thisFace.pVertex1);
+                thisFace.pVertex1->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex1, *thisFace.pVertex0, *thisFace.pVertex2);
+                thisFace.pVertex0->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex0, *thisFace.pVertex1, *thisFace.pVertex2);
+
+                thisFace.pVertex0->bUsed = true;
+                thisFace.pVertex1->bUsed = true;
+                thisFace.pVertex2->bUsed = true;
+
+                thisFace.pVertex0->facesAdj.push_back(&thisFace);
+                thisFace.pVertex1->facesAdj.push_back(&thisFace);
+                thisFace.pVertex2->facesAdj.push_back(&thisFace);
+            }
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        return S_OK;
+    }
+
+    // Runs a fixed set of seeded source vertices per timed iteration
+    template<class TEngine>
+    HRESULT RunGeodesic(size_t targetFaces, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        ProceduralMesh mesh;
+        GenerateMesh(SHAPE_SPHERE, targetFaces, seed, mesh);
+
+        TEngine engine;
+        HRESULT hr = InitOneToAllEngine(mesh, engine);
+        if (FAILED(hr))
+            return hr;
+
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(mesh.GetVertexCount() - 1));
+
+        uint32_t sources[c_geodesicSources];
+        for (auto& src : sources)
+        {
+            src = pick(rng);
+        }
+
+        std::vector<double> distances(c_geodesicSources * mesh.GetVertexCount());
+
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            Timer timer;
+            hr = engine.RunMany(sources, c_geodesicSources, distances.data());
+            if (FAILED(hr))
+                return hr;
+            const double seconds = timer.Elapsed();
+
+            RecordTime(result, iter, seconds);
+        }
+
+        result.elements = mesh.GetFaceCount();
+        result.steps = c_geodesicSources;
+        result.checksum = 0;
+        for (const auto& vertex : engine.m_VertexList)
+        {
+            if (vertex.dGeoDistanceToSrc < DBL_MAX)
+            {
+                result.checksum += vertex.dGeoDistanceToSrc;
+            }
+        }
+
+        return S_OK;
+    }
+
+    // Same sources as RunGeodesic, each timed run also factors the systems as a chart does
+    HRESULT RunHeatGeodesic(size_t targetFaces, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        ProceduralMesh mesh;
+        GenerateMesh(SHAPE_SPHERE, targetFaces, seed, mesh);
+
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(mesh.GetVertexCount() - 1));
+
+        uint32_t sources[c_geodesicSources];
+        for (auto& src : sources)
+        {
+            src = pick(rng);
+        }
+
+        const size_t vertexCount = mesh.GetVertexCount();
+        std::vector<double> distances(c_geodesicSources * vertexCount);
+
+        CHeatGeodesic heat;
+        CHeatGeodesic::Workspace workspace;
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            Timer timer;
+            HRESULT hr = heat.Init(mesh.positions.data(), vertexCount, mesh.indices.data(), mesh.GetFaceCount(), HEAT_GEODESIC_MAX_FACTOR_ENTRIES);
+            if (hr != S_OK)
+                return FAILED(hr) ? hr : E_FAIL;
+
+            for (size_t i = 0; i < c_geodesicSources; ++i)
+            {
+                hr = heat.Run(sources[i], workspace, distances.data() + i * vertexCount);
+                if (FAILED(hr))
+                    return hr;
+            }
+            const double seconds = timer.Elapsed();
+
+            RecordTime(result, iter, seconds);
+        }
+
+        result.elements = mesh.GetFaceCount();
+        result.steps = c_geodesicSources;
+        result.checksum = 0;
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            result.checksum += distances[(c_geodesicSources - 1) * vertexCount + i];
+        }
+
+        return S_OK;
+    }
+
+    HRESULT RunProgressiveMesh(size_t targetFaces, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        ProceduralMesh mesh;
+        GenerateMesh(SHAPE_SPHERE, targetFaces, seed, mesh);
+
+        CBaseMeshInfo baseInfo;
+        HRESULT hr = baseInfo.Initialize(
+            mesh.positions.data(), mesh.GetVertexCount(), sizeof(XMFLOAT3),
+            DXGI_FORMAT_R32_UINT, mesh.indices.data(), mesh.GetFaceCount(),
+            nullptr, mesh.adjacency.data(), nullptr);
+        if (FAILED(hr))
+            return hr;
+
+        CIsochartEngine isochartEngine;
+        CCallbackSchemer callbackSchemer;
+        CIsochartMesh rootChart(baseInfo, callbackSchemer, isochartEngine);
+
+        hr = CIsochartMesh::BuildRootChart(baseInfo, mesh.indices.data(), DXGI_FORMAT_R32_UINT, &rootChart, true);
+        if (FAILED(hr))
+            return hr;
+
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            CProgressiveMesh progressiveMesh(baseInfo, callbackSchemer);
+            hr = progressiveMesh.Initialize(rootChart);
+            if (FAILED(hr))
+                return hr;
+
+            Timer timer;
+            hr = progressiveMesh.Simplify();
+            const double seconds = timer.Elapsed();
+
+            if (FAILED(hr))
+                return hr;
+
+            RecordTime(result, iter, seconds);
+
+            result.checksum = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(rootChart.GetVertexNumber()); ++i)
+            {
+                result.checksum += double(progressiveMesh.GetVertexImportance(i));
+            }
+        }
+
+        result.elements = mesh.GetFaceCount();
+        return S_OK;
+    }
+
+    // CUVAtlasRepacker::TryPut and DoTessellation are private, so the whole
+    // Repack pass is timed; it is dominated by those two.
+    HRESULT RunRepack(size_t targetFaces, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        ProceduralMesh mesh;
+        GenerateMesh(SHAPE_SHELLS, targetFaces, seed, mesh);
+
+        std::vector<UVAtlasVertex> vb;
+        std::vector<uint8_t> ib;
+        std::vector<uint32_t> partitionAdjacency;
+        HRESULT hr = UVAtlasPartition(
+            mesh.positions.data(), mesh.GetVertexCount(),
+            mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+            0, 0.16667f, mesh.adjacency.data(), nullptr, nullptr,
+            nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY, UVATLAS_GEODESIC_FAST,
+            vb, ib, nullptr, nullptr, partitionAdjacency,
+            nullptr, nullptr);
+        if (FAILED(hr))
+            return hr;
+
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            // Repack updates the buffers in place
+            std::vector<UVAtlasVertex> packVB(vb);
+            std::vector<uint8_t> packIB(ib);
+            double percentOur = 0;
+            size_t iterationTimes = 0;
+
+            CUVAtlasRepacker repacker(&packVB, packVB.size(), &packIB, mesh.GetFaceCount(),
+                partitionAdjacency.data(), 5, 512, 512, 2.f,
+                &percentOur, nullptr, nullptr, nullptr, &iterationTimes);
+
+            if (!repacker.SetCallback(nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY)
+                || !repacker.SetStage(1, 0))
+                return E_INVALIDARG;
+
+            Timer timer;
+            hr = repacker.Repack();
+            const double seconds = timer.Elapsed();
+
+            if (FAILED(hr))
+                return hr;
+
+            RecordTime(result, iter, seconds);
+
+            result.steps = iterationTimes;
+            result.checksum = percentOur;
+        }
+
+        result.elements = mesh.GetFaceCount();
+        return S_OK;
+    }
+
+    // IMTFromTextureMapEx reads the texture dimensions from the user data, so
+    // this has to match the layout of the IMT texture descriptors in UVAtlas.cpp
+    struct TextureDesc
+    {
+        const float* pTexels;
+        size_t uHeight, uWidth, uStride;
+    };
+
+    // Bilinear, wrapping RGBA sample of a square texture
+    HRESULT __cdecl TextureCallback(const XMFLOAT2* uv, size_t, size_t signalDimension, void* userData, float* signalOut)
+    {
+        auto pDesc = reinterpret_cast<const TextureDesc*>(userData);
+        const auto width = static_cast<int>(pDesc->uWidth);
+        const auto height = static_cast<int>(pDesc->uHeight);
+
+        const float u = (uv->x - std::floor(uv->x)) * float(width);
+        const float v = (uv->y - std::floor(uv->y)) * float(height);
+
+        const int i = std::min(int(u), width - 1);
+        const int j = std::min(int(v), height - 1);
+        const int i2 = (i + 1) % width;
+        const int j2 = (j + 1) % height;
+
+        const float du = u - float(i);
+        const float dv = v - float(j);
+
+        const float* c1 = &pDesc->pTexels[(j * width + i) * 4];
+        const float* c2 = &pDesc->pTexels[(j * width + i2) * 4];
+        const float* c3 = &pDesc->pTexels[(j2 * width + i) * 4];
+        const float* c4 = &pDesc->pTexels[(j2 * width + i2) * 4];
+
+        for (size_t k = 0; k < signalDimension; ++k)
+        {
+            signalOut[k] = (c1[k] * (1.f - du) + c2[k] * du) * (1.f - dv)
+                + (c3[k] * (1.f - du) + c4[k] * du) * dv;
+        }
+
+        return S_OK;
+    }
+
+    HRESULT RunIMTTexture(size_t targetFaces, uint32_t seed, size_t iterations, KernelResult& result)
+    {
+        ProceduralMesh mesh;
+        GenerateMesh(SHAPE_SPHERE, targetFaces, seed, mesh);
+
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+        std::vector<float> texels(c_textureSize * c_textureSize * 4);
+        for (auto& texel : texels)
+        {
+            texel = dist(rng);
+        }
+
+        TextureDesc desc = { texels.data(), c_textureSize, c_textureSize, 4 };
+
+        const size_t nFaces = mesh.GetFaceCount();
+        std::vector<FLOAT3> imt(nFaces);
+
+        for (size_t iter = 0; iter < iterations; ++iter)
+        {
+            Timer timer;
+            for (size_t face = 0; face < nFaces; ++face)
+            {
+                XMFLOAT3 pos[3];
+                XMFLOAT2 uv[3];
+                for (size_t j = 0; j < 3; ++j)
+                {
+                    const uint32_t id = mesh.indices[face * 3 + j];
+                    pos[j] = mesh.positions[id];
+                    uv[j] = mesh.texcoords[id];
+                }
+
+                HRESULT hr = IMTFromTextureMapEx(pos, uv, face, 4, TextureCallback, &desc, &imt[face]);
+                if (FAILED(hr))
+                    return hr;
+            }
+            const double seconds = timer.Elapsed();
+
+            RecordTime(result, iter, seconds);
+        }
+
+        result.elements = nFaces;
+        result.checksum = 0;
+        for (const auto& value : imt)
+        {
+            result.checksum += double(value[0]) + double(value[2]);
+        }
+
+        return S_OK;
+    }
+
+
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+
+    void WriteResult(FILE* fp, const KernelResult& result, size_t problemSize, bool first)
+    {
+        fprintf(fp, "%s    {\n", first ? "" : ",\n");
+        fprintf(fp, "      \"kernel\": \"%s\",\n", LookupByValue(result.kernel, g_pKernels));
+        fprintf(fp, "      \"size\": \"%s\",\n", LookupByValue(result.size, g_pSizes));
+        fprintf(fp, "      \"problemSize\": %zu,\n", problemSize);
+        fprintf(fp, "      \"hr\": \"0x%08X\"", static_cast<unsigned int>(result.hr));
+
+        if (SUCCEEDED(result.hr))
+        {
+            fprintf(fp, ",\n      \"seconds\": %.6f,\n", result.seconds);
+            fprintf(fp, "      \"elements\": %zu,\n", result.elements);
+            fprintf(fp, "      \"elementsPerSec\": %.1f,\n", (result.seconds > 0) ? double(result.elements) / result.seconds : 0.0);
+            fprintf(fp, "      \"steps\": %zu,\n", result.steps);
+            fprintf(fp, "      \"checksum\": %.9g", result.checksum);
+        }
+
+        fprintf(fp, "\n    }");
+        fflush(fp);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    // Parameters and defaults
+    uint32_t kernelMask = uint32_t(-1);
+    uint32_t sizeMask = uint32_t(-1);
+    size_t iterations = 3;
+    uint32_t seed = 0;
+    const char* szOutputFile = nullptr;
+
+    // Process command line
+    uint32_t dwOptions = 0;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        char* pArg = argv[iArg];
+
+        if (('-' != pArg[0]) && ('/' != pArg[0]))
+        {
+            fprintf(stderr, "ERROR: unexpected argument '%s'\n\n", pArg);
+            PrintUsage();
+            return 1;
+        }
+
+        pArg++;
+        char* pValue;
+
+        for (pValue = pArg; *pValue && (':' != *pValue); pValue++);
+
+        if (*pValue)
+            *pValue++ = 0;
+
+        uint32_t dwOption = LookupByName(pArg, g_pOptions);
+
+        if (dwOption == uint32_t(-1) || (dwOptions & (1u << dwOption)))
+        {
+            fprintf(stderr, "ERROR: unknown command-line option '%s'\n\n", pArg);
+            PrintUsage();
+            return 1;
+        }
+
+        dwOptions |= (1u << dwOption);
+
+        // Handle options with additional value parameter
+        if (dwOption != OPT_NOLOGO && !*pValue)
+        {
+            if ((iArg + 1 >= argc))
+            {
+                fprintf(stderr, "ERROR: missing value for command-line option '%s'\n\n", pArg);
+                PrintUsage();
+                return 1;
+            }
+
+            iArg++;
+            pValue = argv[iArg];
+        }
+
+        switch (dwOption)
+        {
+        case OPT_KERNELS:
+            if (!ParseList(pValue, g_pKernels, kernelMask))
+            {
+                fprintf(stderr, "Invalid value specified with -kernel\n");
+                return 1;
+            }
+            break;
+
+        case OPT_SIZES:
+            if (!ParseList(pValue, g_pSizes, sizeMask))
+            {
+                fprintf(stderr, "Invalid value specified with -size\n");
+                return 1;
+            }
+            break;
+
+        case OPT_ITERATIONS:
+            if (sscanf(pValue, "%zu", &iterations) != 1 || !iterations)
+            {
+                fprintf(stderr, "Invalid value specified with -i (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_SEED:
+            if (sscanf(pValue, "%u", &seed) != 1)
+            {
+                fprintf(stderr, "Invalid value specified with -seed (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_OUTPUTFILE:
+            szOutputFile = pValue;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (~dwOptions & (1u << OPT_NOLOGO))
+        PrintLogo();
+
+    FILE* fp = stdout;
+    if (szOutputFile)
+    {
+        fp = fopen(szOutputFile, "w");
+        if (!fp)
+        {
+            fprintf(stderr, "ERROR: failed to open output file '%s'\n", szOutputFile);
+            return 1;
+        }
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"version\": %d,\n", UVATLAS_VERSION);
+    fprintf(fp, "  \"settings\": { \"iterations\": %zu, \"seed\": %u },\n", iterations, seed);
+    fprintf(fp, "  \"results\": [\n");
+
+    bool first = true;
+    int retVal = 0;
+
+    for (uint32_t kernelIndex = 0; kernelIndex < KERNEL_COUNT; ++kernelIndex)
+    {
+        if (!(kernelMask & (1u << kernelIndex)))
+            continue;
+
+        for (uint32_t sizeIndex = 0; sizeIndex < SIZE_COUNT; ++sizeIndex)
+        {
+            if (!(sizeMask & (1u << sizeIndex)))
+                continue;
+
+            const size_t problemSize = g_kernelSizes[kernelIndex][sizeIndex];
+
+            KernelResult result = {};
+            result.kernel = static_cast<BENCH_KERNEL>(kernelIndex);
+            result.size = static_cast<BENCH_SIZE>(sizeIndex);
+
+            switch (result.kernel)
+            {
+            case KERNEL_EIGEN:
+                result.hr = RunEigen(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_CONJUGATE_GRADIENT:
+                result.hr = RunConjugateGradient(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_MAXFLOW:
+                result.hr = RunMaxFlow(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_EXACT_GEODESIC:
+                result.hr = RunGeodesic<CExactOneToAll>(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_APPROX_GEODESIC:
+                result.hr = RunGeodesic<CApproximateOneToAll>(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_HEAT_GEODESIC:
+                result.hr = RunHeatGeodesic(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_PROGRESSIVE_MESH:
+                result.hr = RunProgressiveMesh(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_REPACK:
+                result.hr = RunRepack(problemSize, seed, iterations, result);
+                break;
+
+            case KERNEL_IMT_TEXTURE:
+                result.hr = RunIMTTexture(problemSize, seed, iterations, result);
+                break;
+
+            default:
+                result.hr = E_UNEXPECTED;
+                break;
+            }
+
+            if (FAILED(result.hr))
+            {
+                fprintf(stderr, "ERROR: %s failed on %s input (%08X)\n",
+                    LookupByValue(result.kernel, g_pKernels), LookupByValue(result.size, g_pSizes),
+                    static_cast<unsigned int>(result.hr));
+                retVal = 1;
+            }
+            else
+            {
+                fprintf(stderr, "%-16s %-7s %10.4f s\n",
+                    LookupByValue(result.kernel, g_pKernels), LookupByValue(result.size, g_pSizes), result.seconds);
+            }
+
+            WriteResult(fp, result, problemSize, first);
+            first = false;
+        }
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+
+    if (fp != stdout)
+    {
+        fclose(fp);
+    }
+
+    return retVal;
+}
@@ -0,0 +1,533 @@
+//--------------------------------------------------------------------------------------
+// File: ProceduralMesh.cpp
+//
+// Procedural and file based test meshes for the UVAtlas benchmark
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#include "ProceduralMesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+using namespace UVAtlasBench;
+
+namespace
+{
+    const float c_pi = 3.14159265358979f;
+
+    const char* const g_shapeNames[SHAPE_COUNT] =
+    {
+        "sphere",
+        "torus",
+        "heightfield",
+        "cylinder",
+        "shells",
+        "lattice",
+    };
+
+    //---------------------------------------------------------------------------------
+    // Integer hash based value noise, so the meshes only depend on the seed
+    inline uint32_t Hash(uint32_t x, uint32_t y, uint32_t seed) noexcept
+    {
+        uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u ^ seed * 0xcb1ab31fu;
+        h ^= h >> 13;
+        h *= 0x5bd1e995u;
+        h ^= h >> 15;
+        return h;
+    }
+
+    inline float HashToFloat(uint32_t h) noexcept
+    {
+        return float(h & 0xffffff) / float(0xffffff);
+    }
+
+    float ValueNoise(float x, float y, uint32_t seed) noexcept
+    {
+        const float fx = std::floor(x);
+        const float fy = std::floor(y);
+        const auto ix = static_cast<uint32_t>(static_cast<int32_t>(fx));
+        const auto iy = static_cast<uint32_t>(static_cast<int32_t>(fy));
+        float tx = x - fx;
+        float ty = y - fy;
+        tx = tx * tx * (3.f - 2.f * tx);
+        ty = ty * ty * (3.f - 2.f * ty);
+
+        const float v00 = HashToFloat(Hash(ix, iy, seed));
+        const float v10 = HashToFloat(Hash(ix + 1, iy, seed));
+        const float v01 = HashToFloat(Hash(ix, iy + 1, seed));
+        const float v11 = HashToFloat(Hash(ix + 1, iy + 1, seed));
+
+        const float v0 = v00 + (v10 - v00) * tx;
+        const float v1 = v01 + (v11 - v01) * tx;
+        return v0 + (v1 - v0) * ty;
+    }
+
+    float FractalNoise(float x, float y, uint32_t seed) noexcept
+    {
+        float result = 0.f;
+        float amplitude = 0.5f;
+        for (uint32_t octave = 0; octave < 5; ++octave)
+        {
+            result += amplitude * ValueNoise(x, y, seed + octave);
+            x *= 2.f;
+            y *= 2.f;
+            amplitude *= 0.5f;
+        }
+        return result;
+    }
+
+    //---------------------------------------------------------------------------------
+    inline void AddFace(ProceduralMesh& mesh, uint32_t i0, uint32_t i1, uint32_t i2)
+    {
+        mesh.indices.push_back(i0);
+        mesh.indices.push_back(i1);
+        mesh.indices.push_back(i2);
+    }
+
+    // Adds the two triangles of quad v00, v10, v11, v01 (counter-clockwise)
+    inline void AddQuad(ProceduralMesh& mesh, uint32_t v00, uint32_t v10, uint32_t v11, uint32_t v01)
+    {
+        AddFace(mesh, v00, v10, v11);
+        AddFace(mesh, v00, v11, v01);
+    }
+
+    // Triangulates a rows x cols grid of vertices starting at base. If wrapRows or
+    // wrapCols is set, the last row/column is connected back to the first one.
+    void AddGrid(ProceduralMesh& mesh, uint32_t base, uint32_t rows, uint32_t cols, bool wrapRows, bool wrapCols)
+    {
+        const uint32_t quadRows = wrapRows ? rows : rows - 1;
+        const uint32_t quadCols = wrapCols ? cols : cols - 1;
+        for (uint32_t i = 0; i < quadRows; ++i)
+        {
+            const uint32_t i1 = (i + 1) % rows;
+            for (uint32_t j = 0; j < quadCols; ++j)
+            {
+                const uint32_t j1 = (j + 1) % cols;
+                AddQuad(mesh,
+                    base + i * cols + j,
+                    base + i1 * cols + j,
+                    base + i1 * cols + j1,
+                    base + i * cols + j1);
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------------------
+    void AddSphere(ProceduralMesh& mesh, uint32_t stacks, const XMFLOAT3& center, float radius)
+    {
+        const uint32_t slices = stacks * 2;
+        const auto base = static_cast<uint32_t>(mesh.positions.size());
+
+        // North pole, stacks - 1 rings, south pole
+        mesh.positions.emplace_back(center.x, center.y + radius, center.z);
+        mesh.texcoords.emplace_back(0.5f, 0.f);
+        for (uint32_t i = 1; i < stacks; ++i)
+        {
+            const float theta = c_pi * float(i) / float(stacks);
+            for (uint32_t j = 0; j < slices; ++j)
+            {
+                const float phi = 2.f * c_pi * float(j) / float(slices);
+                mesh.positions.emplace_back(
+                    center.x + radius * std::sin(theta) * std::cos(phi),
+                    center.y + radius * std::cos(theta),
+                    center.z + radius * std::sin(theta) * std::sin(phi));
+                mesh.texcoords.emplace_back(float(j) / float(slices), float(i) / float(stacks));
+            }
+        }
+        mesh.positions.emplace_back(center.x, center.y - radius, center.z);
+        mesh.texcoords.emplace_back(0.5f, 1.f);
+
+        const uint32_t firstRing = base + 1;
+        const uint32_t lastRing = firstRing + (stacks - 2) * slices;
+        const uint32_t southPole = lastRing + slices;
+
+        for (uint32_t j = 0; j < slices; ++j)
+        {
+            AddFace(mesh, base, firstRing + (j + 1) % slices, firstRing + j);
+        }
+
+        for (uint32_t i = 0; i + 2 < stacks; ++i)
+        {
+            const uint32_t ring0 = firstRing + i * slices;
+            const uint32_t ring1 = ring0 + slices;
+            for (uint32_t j = 0; j < slices; ++j)
+            {
+                const uint32_t j1 = (j + 1) % slices;
+                AddFace(mesh, ring0 + j, ring0 + j1, ring1 + j);
+                AddFace(mesh, ring0 + j1, ring1 + j1, ring1 + j);
+            }
+        }
+
+        for (uint32_t j = 0; j < slices; ++j)
+        {
+            AddFace(mesh, southPole, lastRing + j, lastRing + (j + 1) % slices);
+        }
+    }
+
+    // 4 * stacks * (stacks - 1) faces
+    void GenerateSphere(size_t targetFaces, ProceduralMesh& mesh)
+    {
+        const auto stacks = std::max<uint32_t>(3u, static_cast<uint32_t>(std::sqrt(double(targetFaces) / 4.0) + 0.5));
+        AddSphere(mesh, stacks, XMFLOAT3(0.f, 0.f, 0.f), 1.f);
+    }
+
+    // 4 * minor^2 faces
+    void GenerateTorus(size_t targetFaces, ProceduralMesh& mesh)
+    {
+        const auto minor = std::max<uint32_t>(3u, static_cast<uint32_t>(std::sqrt(double(targetFaces) / 4.0) + 0.5));
+        const uint32_t major = minor * 2;
+
+        for (uint32_t i = 0; i < major; ++i)
+        {
+            const float u = 2.f * c_pi * float(i) / float(major);
+            for (uint32_t j = 0; j < minor; ++j)
+            {
+                const float v = 2.f * c_pi * float(j) / float(minor);
+                const float r = 1.f + 0.35f * std::cos(v);
+                mesh.positions.emplace_back(r * std::cos(u), 0.35f * std::sin(v), r * std::sin(u));
+                mesh.texcoords.emplace_back(float(i) / float(major), float(j) / float(minor));
+            }
+        }
+
+        AddGrid(mesh, 0, major, minor, true, true);
+    }
+
+    // 2 * n^2 faces
+    void GenerateHeightfield(size_t targetFaces, uint32_t seed, ProceduralMesh& mesh)
+    {
+        const auto n = std::max<uint32_t>(2u, static_cast<uint32_t>(std::sqrt(double(targetFaces) / 2.0) + 0.5));
+
+        for (uint32_t i = 0; i <= n; ++i)
+        {
+            const float x = float(i) / float(n);
+            for (uint32_t j = 0; j <= n; ++j)
+            {
+                const float z = float(j) / float(n);
+                const float h = 0.3f * FractalNoise(x * 8.f, z * 8.f, seed);
+                mesh.positions.emplace_back(x, h, z);
+                mesh.texcoords.emplace_back(x, z);
+            }
+        }
+
+        AddGrid(mesh, 0, n + 1, n + 1, false, false);
+    }
+
+    // 2 * 24 * rings faces
+    void GenerateCylinder(size_t targetFaces, ProceduralMesh& mesh)
+    {
+        const uint32_t segments = 24;
+        const auto rings = std::max<uint32_t>(2u, static_cast<uint32_t>(targetFaces / (2 * segments)) + 1);
+        const float length = 20.f;
+        const float radius = 0.1f;
+
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            const float t = float(i) / float(rings - 1);
+            for (uint32_t j = 0; j < segments; ++j)
+            {
+                const float phi = 2.f * c_pi * float(j) / float(segments);
+                mesh.positions.emplace_back(radius * std::cos(phi), length * t, radius * std::sin(phi));
+                mesh.texcoords.emplace_back(float(j) / float(segments), t);
+            }
+        }
+
+        AddGrid(mesh, 0, rings, segments, false, true);
+    }
+
+    // Disconnected spheres of 120 faces each, randomly sized on a jittered grid
+    void GenerateShells(size_t targetFaces, uint32_t seed, ProceduralMesh& mesh)
+    {
+        const uint32_t stacks = 6;
+        const size_t facesPerShell = 4 * stacks * (stacks - 1);
+        const auto count = static_cast<uint32_t>(std::max<size_t>(1, targetFaces / facesPerShell));
+        const auto side = static_cast<uint32_t>(std::ceil(std::cbrt(double(count))));
+
+        for (uint32_t shell = 0; shell < count; ++shell)
+        {
+            const uint32_t x = shell % side;
+            const uint32_t y = (shell / side) % side;
+            const uint32_t z = shell / (side * side);
+            const float jitter = HashToFloat(Hash(shell, 0, seed)) - 0.5f;
+            const float radius = 0.15f + 0.3f * HashToFloat(Hash(shell, 1, seed));
+
+            AddSphere(mesh, stacks, XMFLOAT3(float(x) + 0.1f * jitter, float(y), float(z) - 0.1f * jitter), radius);
+        }
+    }
+
+    // Closed plate with a 2x2 cell hole in every 4x4 block of cells, about 4 * n^2 faces
+    void GenerateLattice(size_t targetFaces, ProceduralMesh& mesh)
+    {
+        const uint32_t blocks = std::max<uint32_t>(1u, static_cast<uint32_t>(std::sqrt(double(targetFaces) / 4.0) / 4.0 + 0.5));
+        const uint32_t n = blocks * 4 + 1;
+        const uint32_t stride = n + 1;
+        const uint32_t bottom = stride * stride;
+        const float thickness = 0.5f / float(n);
+
+        auto solid = [n](int32_t i, int32_t j) -> bool
+        {
+            if (i < 0 || j < 0 || i >= int32_t(n) || j >= int32_t(n))
+                return false;
+            return !((i % 4 == 1 || i % 4 == 2) && (j % 4 == 1 || j % 4 == 2));
+        };
+
+        // The two layers get diagonally offset texcoords so the walls have non-zero uv area
+        for (uint32_t layer = 0; layer < 2; ++layer)
+        {
+            const float y = layer ? -thickness : thickness;
+            const float offset = layer ? 0.5f : 0.f;
+            for (uint32_t i = 0; i <= n; ++i)
+            {
+                for (uint32_t j = 0; j <= n; ++j)
+                {
+                    mesh.positions.emplace_back(float(i) / float(n), y, float(j) / float(n));
+                    mesh.texcoords.emplace_back(offset + 0.5f * float(i) / float(n), offset + 0.5f * float(j) / float(n));
+                }
+            }
+        }
+
+        auto vert = [stride](uint32_t i, uint32_t j) -> uint32_t { return i * stride + j; };
+
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            for (uint32_t j = 0; j < n; ++j)
+            {
+                if (!solid(int32_t(i), int32_t(j)))
+                    continue;
+
+                const uint32_t c[4] = { vert(i, j), vert(i + 1, j), vert(i + 1, j + 1), vert(i, j + 1) };
+                AddQuad(mesh, c[0], c[1], c[2], c[3]);
+                AddQuad(mesh, bottom + c[0], bottom + c[3], bottom + c[2], bottom + c[1]);
+
+                // Side k runs from corner k to corner k + 1, with the neighboring cell across it
+                const int32_t neighbor[4][2] =
+                {
+                    { int32_t(i), int32_t(j) - 1 },
+                    { int32_t(i) + 1, int32_t(j) },
+                    { int32_t(i), int32_t(j) + 1 },
+                    { int32_t(i) - 1, int32_t(j) },
+                };
+                for (uint32_t k = 0; k < 4; ++k)
+                {
+                    if (solid(neighbor[k][0], neighbor[k][1]))
+                        continue;
+
+                    const uint32_t a = c[k];
+                    const uint32_t b = c[(k + 1) % 4];
+                    AddFace(mesh, b, a, bottom + a);
+                    AddFace(mesh, b, bottom + a, bottom + b);
+                }
+            }
+        }
+    }
+
+    // Removes vertices not referenced by any face
+    void CompactVertices(ProceduralMesh& mesh)
+    {
+        std::vector<uint32_t> remap(mesh.positions.size(), uint32_t(-1));
+        std::vector<XMFLOAT3> positions;
+        std::vector<XMFLOAT2> texcoords;
+        positions.reserve(mesh.positions.size());
+        texcoords.reserve(mesh.texcoords.size());
+
+        for (auto& index : mesh.indices)
+        {
+            if (remap[index] == uint32_t(-1))
+            {
+                remap[index] = static_cast<uint32_t>(positions.size());
+                positions.push_back(mesh.positions[index]);
+                texcoords.push_back(mesh.texcoords[index]);
+            }
+            index = remap[index];
+        }
+
+        mesh.positions.swap(positions);
+        mesh.texcoords.swap(texcoords);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+const char* UVAtlasBench::GetShapeName(MESH_SHAPE shape) noexcept
+{
+    return (shape < SHAPE_COUNT) ? g_shapeNames[shape] : "unknown";
+}
+
+
+bool UVAtlasBench::LookupShape(const char* name, MESH_SHAPE& shape) noexcept
+{
+    for (unsigned int i = 0; i < SHAPE_COUNT; ++i)
+    {
+        if (!strcmp(name, g_shapeNames[i]))
+        {
+            shape = static_cast<MESH_SHAPE>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//-------------------------------------------------------------------------------------
+void UVAtlasBench::GenerateMesh(MESH_SHAPE shape, size_t targetFaces, uint32_t seed, ProceduralMesh& mesh)
+{
+    mesh.positions.clear();
+    mesh.texcoords.clear();
+    mesh.indices.clear();
+    mesh.adjacency.clear();
+
+    mesh.indices.reserve(targetFaces * 3 + 1024);
+
+    switch (shape)
+    {
+    case SHAPE_SPHERE:      GenerateSphere(targetFaces, mesh); break;
+    case SHAPE_TORUS:       GenerateTorus(targetFaces, mesh); break;
+    case SHAPE_HEIGHTFIELD: GenerateHeightfield(targetFaces, seed, mesh); break;
+    case SHAPE_CYLINDER:    GenerateCylinder(targetFaces, mesh); break;
+    case SHAPE_SHELLS:      GenerateShells(targetFaces, seed, mesh); break;
+    case SHAPE_LATTICE:     GenerateLattice(targetFaces, mesh); break;
+    default:                break;
+    }
+
+    CompactVertices(mesh);
+    GenerateAdjacency(mesh);
+}
+
+
+//-------------------------------------------------------------------------------------
+bool UVAtlasBench::LoadMeshOBJ(const char* fileName, ProceduralMesh& mesh)
+{
+    mesh.positions.clear();
+    mesh.texcoords.clear();
+    mesh.indices.clear();
+    mesh.adjacency.clear();
+
+    FILE* fp = fopen(fileName, "r");
+    if (!fp)
+        return false;
+
+    bool ok = true;
+    char line[4096];
+    std::vector<uint32_t> polygon;
+    while (ok && fgets(line, sizeof(line), fp))
+    {
+        if (line[0] == 'v' && line[1] == ' ')
+        {
+            XMFLOAT3 pos = {};
+            if (sscanf(line + 2, "%f %f %f", &pos.x, &pos.y, &pos.z) != 3)
+            {
+                ok = false;
+                break;
+            }
+            mesh.positions.push_back(pos);
+        }
+        else if (line[0] == 'f' && line[1] == ' ')
+        {
+            // Each corner is v, v/vt, v//vn or v/vt/vn, only v is used
+            polygon.clear();
+            char* pCorner = line + 2;
+            for (;;)
+            {
+                char* pEnd = nullptr;
+                const long index = strtol(pCorner, &pEnd, 10);
+                if (pEnd == pCorner)
+                    break;
+
+                const long count = static_cast<long>(mesh.positions.size());
+                const long vertex = (index < 0) ? count + index : index - 1;
+                if (!index || vertex < 0 || vertex >= count)
+                {
+                    ok = false;
+                    break;
+                }
+                polygon.push_back(static_cast<uint32_t>(vertex));
+
+                pCorner = pEnd;
+                while (*pCorner && *pCorner != ' ' && *pCorner != '\t')
+                    ++pCorner;
+            }
+
+            for (size_t k = 2; ok && k < polygon.size(); ++k)
+            {
+                // Skip degenerate triangles, UVAtlas rejects them
+                if (polygon[0] != polygon[k - 1] && polygon[0] != polygon[k] && polygon[k - 1] != polygon[k])
+                {
+                    AddFace(mesh, polygon[0], polygon[k - 1], polygon[k]);
+                }
+            }
+        }
+    }
+    fclose(fp);
+
+    if (!ok || mesh.indices.empty())
+        return false;
+
+    // Planar projection onto the two largest extents of the bounding box
+    XMFLOAT3 bmin = { FLT_MAX, FLT_MAX, FLT_MAX };
+    XMFLOAT3 bmax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (const auto& pos : mesh.positions)
+    {
+        bmin.x = std::min(bmin.x, pos.x); bmax.x = std::max(bmax.x, pos.x);
+        bmin.y = std::min(bmin.y, pos.y); bmax.y = std::max(bmax.y, pos.y);
+        bmin.z = std::min(bmin.z, pos.z); bmax.z = std::max(bmax.z, pos.z);
+    }
+    const float extent[3] = { bmax.x - bmin.x, bmax.y - bmin.y, bmax.z - bmin.z };
+    const size_t drop = (extent[0] <= extent[1] && extent[0] <= extent[2]) ? 0 : (extent[1] <= extent[2]) ? 1 : 2;
+    const size_t axisU = (drop == 0) ? 1 : 0;
+    const size_t axisV = (drop == 2) ? 1 : 2;
+
+    mesh.texcoords.resize(mesh.positions.size());
+    for (size_t i = 0; i < mesh.positions.size(); ++i)
+    {
+        const float* pos = &mesh.positions[i].x;
+        const float* lo = &bmin.x;
+        mesh.texcoords[i].x = (extent[axisU] > 0) ? (pos[axisU] - lo[axisU]) / extent[axisU] : 0.f;
+        mesh.texcoords[i].y = (extent[axisV] > 0) ? (pos[axisV] - lo[axisV]) / extent[axisV] : 0.f;
+    }
+
+    CompactVertices(mesh);
+    GenerateAdjacency(mesh);
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------
+void UVAtlasBench::GenerateAdjacency(ProceduralMesh& mesh)
+{
+    const size_t nFaces = mesh.GetFaceCount();
+
+    // Directed edge (v0, v1) -> face
+    std::unordered_map<uint64_t, uint32_t> edges;
+    edges.reserve(nFaces * 3);
+    for (size_t face = 0; face < nFaces; ++face)
+    {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const uint64_t v0 = mesh.indices[face * 3 + k];
+            const uint64_t v1 = mesh.indices[face * 3 + (k + 1) % 3];
+            edges[(v0 << 32) | v1] = static_cast<uint32_t>(face);
+        }
+    }
+
+    mesh.adjacency.resize(nFaces * 3);
+    for (size_t face = 0; face < nFaces; ++face)
+    {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const uint64_t v0 = mesh.indices[face * 3 + k];
+            const uint64_t v1 = mesh.indices[face * 3 + (k + 1) % 3];
+            auto it = edges.find((v1 << 32) | v0);
+            mesh.adjacency[face * 3 + k] = (it != edges.end()) ? it->second : uint32_t(-1);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+//--------------------------------------------------------------------------------------
+// File: ProceduralMesh.h
+//
+// Procedural and file based test meshes for the UVAtlas benchmark
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "UVAtlas.h"
+
+namespace UVAtlasBench
+{
+    enum MESH_SHAPE : unsigned int
+    {
+        SHAPE_SPHERE = 0,       // UV sphere
+        SHAPE_TORUS,            // Torus, genus 1
+        SHAPE_HEIGHTFIELD,      // Noisy open heightfield
+        SHAPE_CYLINDER,         // Long, thin open cylinder
+        SHAPE_SHELLS,           // Many disconnected spheres
+        SHAPE_LATTICE,          // Closed plate with a grid of holes, high genus
+        SHAPE_COUNT
+    };
+
+    struct ProceduralMesh
+    {
+        std::vector<DirectX::XMFLOAT3>  positions;
+        std::vector<DirectX::XMFLOAT2>  texcoords;      // Procedural parameterization, used for the IMT entry points
+        std::vector<uint32_t>           indices;
+        std::vector<uint32_t>           adjacency;      // 3 per face, uint32_t(-1) for boundary edges
+
+        size_t GetVertexCount() const noexcept { return positions.size(); }
+        size_t GetFaceCount() const noexcept { return indices.size() / 3; }
+    };
+
+    const char* GetShapeName(MESH_SHAPE shape) noexcept;
+
+    bool LookupShape(const char* name, MESH_SHAPE& shape) noexcept;
+
+    // Builds a mesh of the given shape with approximately targetFaces faces. The
+    // seed makes the noisy shapes repeatable between runs.
+    void GenerateMesh(MESH_SHAPE shape, size_t targetFaces, uint32_t seed, ProceduralMesh& mesh);
+
+    // Loads the positions and faces of a Wavefront OBJ file. Polygons are fan
+    // triangulated, and the texture coordinates are replaced by a planar
+    // projection so every vertex has exactly one.
+    bool LoadMeshOBJ(const char* fileName, ProceduralMesh& mesh);
+
+    // Generates topological adjacency from the index buffer
+    void GenerateAdjacency(ProceduralMesh& mesh);
+}
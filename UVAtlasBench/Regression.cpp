@@ -0,0 +1,205 @@
+//--------------------------------------------------------------------------------------
+// File: Regression.cpp
+//
+// Golden baselines of quality and time for the UVAtlas benchmark
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#include "Regression.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace UVAtlasBench;
+
+namespace
+{
+    const double c_timeFloor = 0.01;
+
+    // Finds "key": and returns a pointer just past the colon
+    const char* FindKey(const char* line, const char* key)
+    {
+        char pattern[64] = {};
+        snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+        const char* p = strstr(line, pattern);
+        return p ? p + strlen(pattern) : nullptr;
+    }
+
+    bool ReadString(const char* line, const char* key, std::string& value)
+    {
+        const char* p = FindKey(line, key);
+        if (!p)
+            return false;
+
+        p = strchr(p, '"');
+        if (!p)
+            return false;
+
+        const char* end = strchr(++p, '"');
+        if (!end)
+            return false;
+
+        value.assign(p, end);
+        return true;
+    }
+
+    double ReadNumber(const char* line, const char* key)
+    {
+        const char* p = FindKey(line, key);
+        double value = -1.0;
+        if (!p || sscanf(p, "%lf", &value) != 1)
+            return -1.0;
+        return value;
+    }
+
+    void ReportFailure(const RegressionRecord& record, const char* metric, double value, double base, double limit)
+    {
+        fprintf(stderr, "    REGRESSION %s %s %s: %.6f (baseline %.6f, limit %.6f)\n",
+            record.mesh.c_str(), record.api.c_str(), metric, value, base, limit);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+bool UVAtlasBench::LoadBaseline(const char* fileName, RegressionBaseline& baseline)
+{
+    baseline.settings.clear();
+    baseline.records.clear();
+
+    FILE* fp = fopen(fileName, "r");
+    if (!fp)
+        return false;
+
+    bool ok = true;
+    char line[1024];
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (line[0] != '{')
+            continue;
+
+        if (FindKey(line, "settings"))
+        {
+            ok = ReadString(line, "settings", baseline.settings) && ok;
+            continue;
+        }
+
+        RegressionRecord record;
+        if (!ReadString(line, "mesh", record.mesh) || !ReadString(line, "api", record.api))
+        {
+            ok = false;
+            continue;
+        }
+
+        const double faces = ReadNumber(line, "faces");
+        record.faces = (faces > 0) ? static_cast<size_t>(faces) : 0;
+        record.seconds = ReadNumber(line, "seconds");
+        record.charts = ReadNumber(line, "charts");
+        record.maxStretch = ReadNumber(line, "maxStretch");
+        record.utilization = ReadNumber(line, "utilization");
+        baseline.records.push_back(record);
+    }
+
+    fclose(fp);
+    return ok;
+}
+
+
+//-------------------------------------------------------------------------------------
+bool UVAtlasBench::SaveBaseline(const char* fileName, const RegressionBaseline& baseline)
+{
+    FILE* fp = fopen(fileName, "w");
+    if (!fp)
+        return false;
+
+    fprintf(fp, "{ \"settings\": \"%s\" }\n", baseline.settings.c_str());
+
+    for (const auto& record : baseline.records)
+    {
+        fprintf(fp, "{ \"mesh\": \"%s\", \"faces\": %zu, \"api\": \"%s\", \"seconds\": %.6f",
+            record.mesh.c_str(), record.faces, record.api.c_str(), record.seconds);
+        if (record.charts >= 0)
+            fprintf(fp, ", \"charts\": %.0f", record.charts);
+        if (record.maxStretch >= 0)
+            fprintf(fp, ", \"maxStretch\": %.6f", record.maxStretch);
+        if (record.utilization >= 0)
+            fprintf(fp, ", \"utilization\": %.6f", record.utilization);
+        fprintf(fp, " }\n");
+    }
+
+    const bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+
+//-------------------------------------------------------------------------------------
+REGRESSION_RESULT UVAtlasBench::CompareToBaseline(
+    const RegressionRecord& record,
+    const RegressionBaseline& baseline,
+    const RegressionTolerance& tolerance)
+{
+    const RegressionRecord* base = nullptr;
+    for (const auto& it : baseline.records)
+    {
+        if (it.faces == record.faces && it.mesh == record.mesh && it.api == record.api)
+        {
+            base = &it;
+            break;
+        }
+    }
+
+    if (!base)
+    {
+        fprintf(stderr, "    MISSING %s %zu %s: no baseline record\n",
+            record.mesh.c_str(), record.faces, record.api.c_str());
+        return REGRESSION_MISSING;
+    }
+
+    REGRESSION_RESULT result = REGRESSION_PASS;
+
+    if (base->maxStretch >= 0 && record.maxStretch >= 0)
+    {
+        const double limit = base->maxStretch + tolerance.maxStretch;
+        if (record.maxStretch > limit)
+        {
+            ReportFailure(record, "maxStretch", record.maxStretch, base->maxStretch, limit);
+            result = REGRESSION_FAIL;
+        }
+    }
+
+    if (base->charts >= 0 && record.charts >= 0)
+    {
+        const double limit = base->charts * (1.0 + tolerance.charts);
+        if (record.charts > limit)
+        {
+            ReportFailure(record, "charts", record.charts, base->charts, limit);
+            result = REGRESSION_FAIL;
+        }
+    }
+
+    if (base->utilization >= 0 && record.utilization >= 0)
+    {
+        const double limit = base->utilization - tolerance.utilization;
+        if (record.utilization < limit)
+        {
+            ReportFailure(record, "utilization", record.utilization, base->utilization, limit);
+            result = REGRESSION_FAIL;
+        }
+    }
+
+    if (base->seconds >= 0 && record.seconds >= 0)
+    {
+        const double limit = base->seconds * (1.0 + tolerance.seconds) + c_timeFloor;
+        if (record.seconds > limit)
+        {
+            ReportFailure(record, "seconds", record.seconds, base->seconds, limit);
+            result = REGRESSION_FAIL;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,69 @@
+//--------------------------------------------------------------------------------------
+// File: Regression.h
+//
+// Golden baselines of quality and time for the UVAtlas benchmark
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace UVAtlasBench
+{
+    // Metrics of one run, keyed by mesh name, face count and entry point. Metrics
+    // an entry point does not produce are left negative.
+    struct RegressionRecord
+    {
+        std::string mesh;
+        size_t      faces;
+        std::string api;
+        double      seconds;
+        double      charts;         // numChartsOut
+        double      maxStretch;     // maxStretchOut
+        double      utilization;    // UVAtlasStats::atlasUtilization
+    };
+
+    // How much worse than the baseline a run may be before it counts as a
+    // regression. Improvements never fail.
+    struct RegressionTolerance
+    {
+        double maxStretch;      // Absolute increase
+        double charts;          // Relative increase, 0.1 is 10%
+        double utilization;     // Absolute decrease
+        double seconds;         // Relative increase, on top of a 10 ms floor for timer noise
+    };
+
+    struct RegressionBaseline
+    {
+        std::string                     settings;   // Settings the baseline was recorded with
+        std::vector<RegressionRecord>   records;
+    };
+
+    // Baselines are stored as JSON Lines: a settings object followed by one
+    // object per record, so they diff cleanly when checked in. A metric missing
+    // from a record is not checked; the checked-in baselines leave out seconds,
+    // since wall time only compares between runs on the same machine.
+    bool LoadBaseline(const char* fileName, RegressionBaseline& baseline);
+
+    bool SaveBaseline(const char* fileName, const RegressionBaseline& baseline);
+
+    enum REGRESSION_RESULT
+    {
+        REGRESSION_PASS = 0,
+        REGRESSION_FAIL,
+        REGRESSION_MISSING,     // No baseline record for this run
+    };
+
+    // Compares one run to its baseline record, reporting each failing metric to stderr
+    REGRESSION_RESULT CompareToBaseline(
+        const RegressionRecord& record,
+        const RegressionBaseline& baseline,
+        const RegressionTolerance& tolerance);
+}
@@ -0,0 +1,1374 @@
+//--------------------------------------------------------------------------------------
+// File: UVAtlasBench.cpp
+//
+// UVAtlas benchmark over procedurally generated and OBJ meshes, reporting JSON
+// results and optionally checking them against golden baselines
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UVAtlas.h"
+
+#include "BenchTimer.h"
+#include "ProceduralMesh.h"
+#include "Regression.h"
+
+using namespace DirectX;
+using namespace UVAtlasBench;
+
+namespace
+{
+    enum OPTIONS
+    {
+        OPT_SHAPES = 1,
+        OPT_APIS,
+        OPT_MINFACES,
+        OPT_MAXFACES,
+        OPT_ITERATIONS,
+        OPT_SEED,
+        OPT_QUALITY,
+        OPT_MAXCHARTS,
+        OPT_MAXSTRETCH,
+        OPT_GUTTER,
+        OPT_WIDTH,
+        OPT_HEIGHT,
+        OPT_OUTPUTFILE,
+        OPT_TRACE,
+        OPT_BUDGET,
+        OPT_DEADLINE,
+        OPT_BATCH,
+        OPT_STRESS,
+        OPT_CONTEXT,
+        OPT_COMPONENTS,
+        OPT_SEGMENT,
+        OPT_MESHES,
+        OPT_BASELINE,
+        OPT_SAVE_BASELINE,
+        OPT_TOL_STRETCH,
+        OPT_TOL_CHARTS,
+        OPT_TOL_UTILIZATION,
+        OPT_TOL_TIME,
+        OPT_NOLOGO,
+        OPT_MAX
+    };
+
+    static_assert(OPT_MAX <= 32, "dwOptions is a uint32_t bitfield");
+
+    enum BENCH_API : unsigned int
+    {
+        API_PARTITION = 0,
+        API_PACK,
+        API_CREATE,
+        API_CREATE_BATCH,
+        API_IMT_VERTEX,
+        API_IMT_SIGNAL,
+        API_IMT_TEXTURE,
+        API_IMT_TEXEL,
+        API_STRESS,
+        API_COUNT
+    };
+
+    struct SValue
+    {
+        const char* pName;
+        uint32_t dwValue;
+    };
+
+    const SValue g_pOptions[] =
+    {
+        { "shape",      OPT_SHAPES },
+        { "api",        OPT_APIS },
+        { "minfaces",   OPT_MINFACES },
+        { "maxfaces",   OPT_MAXFACES },
+        { "i",          OPT_ITERATIONS },
+        { "seed",       OPT_SEED },
+        { "q",          OPT_QUALITY },
+        { "n",          OPT_MAXCHARTS },
+        { "st",         OPT_MAXSTRETCH },
+        { "g",          OPT_GUTTER },
+        { "w",          OPT_WIDTH },
+        { "h",          OPT_HEIGHT },
+        { "o",          OPT_OUTPUTFILE },
+        { "trace",      OPT_TRACE },
+        { "budget",     OPT_BUDGET },
+        { "deadline",   OPT_DEADLINE },
+        { "batch",      OPT_BATCH },
+        { "stress",     OPT_STRESS },
+        { "context",    OPT_CONTEXT },
+        { "components", OPT_COMPONENTS },
+        { "segment",    OPT_SEGMENT },
+        { "mesh",       OPT_MESHES },
+        { "baseline",   OPT_BASELINE },
+        { "savebaseline", OPT_SAVE_BASELINE },
+        { "tolstretch", OPT_TOL_STRETCH },
+        { "tolcharts",  OPT_TOL_CHARTS },
+        { "tolutil",    OPT_TOL_UTILIZATION },
+        { "toltime",    OPT_TOL_TIME },
+        { "nologo",     OPT_NOLOGO },
+        { nullptr,      0 }
+    };
+
+    const SValue g_pApis[] =
+    {
+        { "partition",  API_PARTITION },
+        { "pack",       API_PACK },
+        { "create",     API_CREATE },
+        { "createbatch", API_CREATE_BATCH },
+        { "imtvertex",  API_IMT_VERTEX },
+        { "imtsignal",  API_IMT_SIGNAL },
+        { "imttexture", API_IMT_TEXTURE },
+        { "imttexel",   API_IMT_TEXEL },
+        { "stress",     API_STRESS },
+        { nullptr,      0 }
+    };
+
+    // Target face counts, filtered by -minfaces/-maxfaces
+    const size_t g_faceCounts[] =
+    {
+        1000, 10000, 100000, 500000, 1000000, 2000000
+    };
+
+    const size_t c_textureSize = 256;
+
+    struct BenchSettings
+    {
+        size_t maxCharts;
+        float maxStretch;
+        float gutter;
+        size_t width;
+        size_t height;
+        UVATLAS options;
+        size_t iterations;
+        bool trace;
+        size_t memoryBudget;
+        double deadline;            // Seconds each call may run, 0 for none
+        size_t batchSize;           // Copies of the mesh passed to UVAtlasCreateBatch
+        size_t stressThreads;       // Threads calling UVAtlasCreate at once for stress
+        UVAtlasContext* context;    // Passed to UVAtlasPartition and UVAtlasCreate, nullptr for none
+        size_t segmentFaces;        // Partition with UVAtlasPartitionSegmented if not 0
+    };
+
+    struct BenchResult
+    {
+        BENCH_API api;
+        HRESULT hr;
+        double seconds;
+        size_t charts;
+        float maxStretch;
+        UVAtlasStats stats;
+        std::vector<UVAtlasTraceEvent> traceEvents;     // Of the fastest iteration
+    };
+
+
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+
+    uint32_t LookupByName(const char* pName, const SValue* pArray)
+    {
+        while (pArray->pName)
+        {
+            if (!strcmp(pName, pArray->pName))
+                return pArray->dwValue;
+
+            pArray++;
+        }
+
+        return uint32_t(-1);
+    }
+
+    const char* LookupByValue(uint32_t value, const SValue* pArray)
+    {
+        while (pArray->pName)
+        {
+            if (value == pArray->dwValue)
+                return pArray->pName;
+
+            pArray++;
+        }
+
+        return "";
+    }
+
+    // Parses a comma separated list of names into a bitmask
+    bool ParseList(char* pValue, const SValue* pArray, uint32_t& mask)
+    {
+        mask = 0;
+        for (char* pToken = strtok(pValue, ","); pToken; pToken = strtok(nullptr, ","))
+        {
+            if (!strcmp(pToken, "all"))
+            {
+                mask = uint32_t(-1);
+                continue;
+            }
+
+            uint32_t value = LookupByName(pToken, pArray);
+            if (value == uint32_t(-1))
+                return false;
+
+            mask |= (1u << value);
+        }
+        return mask != 0;
+    }
+
+    void PrintUsage()
+    {
+        printf("Usage: uvatlas_bench <options>\n\n");
+        printf("   -shape <list>       comma separated shapes to run (def: all)\n");
+        printf("                       sphere, torus, heightfield, cylinder, shells, lattice\n");
+        printf("   -api <list>         comma separated entry points to time (def: all)\n");
+        printf("                       partition, pack, create, createbatch, imtvertex,\n");
+        printf("                       imtsignal, imttexture, imttexel, stress\n");
+        printf("   -minfaces <number>  smallest mesh size to run (def: 1000)\n");
+        printf("   -maxfaces <number>  largest mesh size to run (def: 2000000)\n");
+        printf("   -i <number>         iterations per measurement, fastest is reported (def: 1)\n");
+        printf("   -seed <number>      seed for the noisy shapes (def: 0)\n");
+        printf("   -q <level>          sets quality level to DEFAULT, FAST, QUALITY or HEAT\n");
+        printf("   -n <number>         maximum number of charts to generate (def: 0)\n");
+        printf("   -st <float>         maximum amount of stretch 0.0 to 1.0 (def: 0.16667)\n");
+        printf("   -g <float>          the gutter width betwen charts in texels (def: 2.0)\n");
+        printf("   -w <number>         texture width (def: 512)\n");
+        printf("   -h <number>         texture height (def: 512)\n");
+        printf("   -o <filename>       output JSON filename (def: stdout)\n");
+        printf("   -trace <prefix>     write a Chrome trace of the per-chart work for each run\n");
+        printf("                       to <prefix>-<shape>-<faces>-<api>.json\n");
+        printf("   -budget <MB>        fail runs whose tracked memory exceeds this (def: 0, none)\n");
+        printf("   -deadline <ms>      cancel calls still running after this long (def: 0, none)\n");
+        printf("   -batch <number>     copies of the mesh run by createbatch at once (def: 16)\n");
+        printf("   -stress <number>    threads running create at once for stress, each must\n");
+        printf("                       match a run made alone bit for bit (def: 4)\n");
+        printf("   -context            reuse one UVAtlasContext for all partition and create calls\n");
+        printf("   -components         partition each connected component independently\n");
+        printf("   -segment <faces>    partition out of core in segments of at most this many faces\n");
+        printf("   -mesh <list>        comma separated Wavefront OBJ files to run after the shapes;\n");
+        printf("                       only these are run unless -shape is also given\n");
+        printf("   -baseline <file>    compare stretch, charts, utilization and time to a baseline\n");
+        printf("                       and fail on any regression beyond the tolerances\n");
+        printf("   -savebaseline <file>\n");
+        printf("                       record this run as a baseline\n");
+        printf("   -tolstretch <float> allowed max stretch increase (def: 0.01)\n");
+        printf("   -tolcharts <pct>    allowed chart count increase (def: 10)\n");
+        printf("   -tolutil <float>    allowed atlas utilization decrease (def: 0.02)\n");
+        printf("   -toltime <pct>      allowed wall time increase (def: 25)\n");
+        printf("   -nologo             suppress copyright message\n");
+    }
+
+    void PrintLogo()
+    {
+        fprintf(stderr, "Microsoft (R) UVAtlas Benchmark (UVAtlas version %d)\n", UVATLAS_VERSION);
+        fprintf(stderr, "Copyright (C) Microsoft Corp.\n\n");
+    }
+
+
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+
+    void GenerateTexture(size_t size, std::vector<float>& texture)
+    {
+        texture.resize(size * size * 4);
+        for (size_t y = 0; y < size; ++y)
+        {
+            for (size_t x = 0; x < size; ++x)
+            {
+                const float u = float(x) / float(size);
+                const float v = float(y) / float(size);
+                float* texel = &texture[(y * size + x) * 4];
+                texel[0] = 0.5f + 0.5f * std::sin(u * 40.f);
+                texel[1] = 0.5f + 0.5f * std::cos(v * 25.f);
+                texel[2] = (((x / 16) + (y / 16)) & 1) ? 1.f : 0.f;
+                texel[3] = 1.f;
+            }
+        }
+    }
+
+    HRESULT __cdecl SignalCallback(const XMFLOAT2* uv, size_t, size_t signalDimension, void*, float* signalOut)
+    {
+        for (size_t i = 0; i < signalDimension; ++i)
+        {
+            signalOut[i] = std::sin(uv->x * float(10 + 7 * i)) * std::cos(uv->y * float(13 + 5 * i));
+        }
+        return S_OK;
+    }
+
+    // Cancellation for one call starting now, nullptr if no deadline was set
+    const UVAtlasCancellation* StartDeadline(const BenchSettings& settings, UVAtlasCancellation& cancellation)
+    {
+        if (settings.deadline <= 0)
+            return nullptr;
+
+        cancellation = {};
+        cancellation.deadline = std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(settings.deadline));
+        return &cancellation;
+    }
+
+    void RunPartition(
+        const ProceduralMesh& mesh,
+        const BenchSettings& settings,
+        BenchResult& result,
+        std::vector<UVAtlasVertex>& vb,
+        std::vector<uint8_t>& ib,
+        std::vector<uint32_t>& partitionAdjacency)
+    {
+        for (size_t iter = 0; iter < settings.iterations; ++iter)
+        {
+            std::vector<uint32_t> facePartitioning;
+            std::vector<uint32_t> vertexRemap;
+            float maxStretch = 0.f;
+            size_t charts = 0;
+            std::vector<UVAtlasTraceEvent> traceEvents;
+            UVAtlasStats stats = {};
+            stats.traceEvents = settings.trace ? &traceEvents : nullptr;
+            stats.memoryBudget = settings.memoryBudget;
+
+            UVAtlasCancellation cancellation;
+            Timer timer;
+            HRESULT hr;
+            if (settings.segmentFaces)
+            {
+                hr = UVAtlasPartitionSegmented(
+                    mesh.positions.data(), mesh.GetVertexCount(),
+                    mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                    settings.segmentFaces, settings.maxStretch,
+                    mesh.adjacency.data(), nullptr, nullptr,
+                    nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                    settings.options,
+                    vb, ib, &facePartitioning, &vertexRemap, partitionAdjacency,
+                    &maxStretch, &charts, &stats, StartDeadline(settings, cancellation),
+                    settings.context);
+            }
+            else
+            {
+                hr = UVAtlasPartition(
+                    mesh.positions.data(), mesh.GetVertexCount(),
+                    mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                    settings.maxCharts, settings.maxStretch,
+                    mesh.adjacency.data(), nullptr, nullptr,
+                    nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                    settings.options,
+                    vb, ib, &facePartitioning, &vertexRemap, partitionAdjacency,
+                    &maxStretch, &charts, &stats, StartDeadline(settings, cancellation),
+                    settings.context);
+            }
+            const double seconds = timer.Elapsed();
+
+            result.hr = hr;
+            if (FAILED(hr))
+                return;
+
+            if (!iter || seconds < result.seconds)
+            {
+                result.seconds = seconds;
+                result.charts = charts;
+                result.maxStretch = maxStretch;
+                result.stats = stats;
+                result.traceEvents = std::move(traceEvents);
+            }
+        }
+    }
+
+    void RunPack(
+        const BenchSettings& settings,
+        const std::vector<UVAtlasVertex>& vb,
+        const std::vector<uint8_t>& ib,
+        const std::vector<uint32_t>& partitionAdjacency,
+        size_t charts,
+        BenchResult& result)
+    {
+        for (size_t iter = 0; iter < settings.iterations; ++iter)
+        {
+            // UVAtlasPack updates the buffers in place
+            std::vector<UVAtlasVertex> packVB(vb);
+            std::vector<uint8_t> packIB(ib);
+            std::vector<UVAtlasTraceEvent> traceEvents;
+            UVAtlasStats stats = {};
+            stats.traceEvents = settings.trace ? &traceEvents : nullptr;
+            stats.memoryBudget = settings.memoryBudget;
+
+            UVAtlasCancellation cancellation;
+            Timer timer;
+            HRESULT hr = UVAtlasPack(packVB, packIB, DXGI_FORMAT_R32_UINT,
+                settings.width, settings.height, settings.gutter,
+                partitionAdjacency, nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY, &stats,
+                StartDeadline(settings, cancellation));
+            const double seconds = timer.Elapsed();
+
+            result.hr = hr;
+            if (FAILED(hr))
+                return;
+
+            if (!iter || seconds < result.seconds)
+            {
+                result.seconds = seconds;
+                result.charts = charts;
+                result.stats = stats;
+                result.traceEvents = std::move(traceEvents);
+            }
+        }
+    }
+
+    void RunCreate(const ProceduralMesh& mesh, const BenchSettings& settings, BenchResult& result)
+    {
+        for (size_t iter = 0; iter < settings.iterations; ++iter)
+        {
+            std::vector<UVAtlasVertex> vb;
+            std::vector<uint8_t> ib;
+            std::vector<uint32_t> vertexRemap;
+            float maxStretch = 0.f;
+            size_t charts = 0;
+            std::vector<UVAtlasTraceEvent> traceEvents;
+            UVAtlasStats stats = {};
+            stats.traceEvents = settings.trace ? &traceEvents : nullptr;
+            stats.memoryBudget = settings.memoryBudget;
+
+            UVAtlasCancellation cancellation;
+            Timer timer;
+            HRESULT hr = UVAtlasCreate(
+                mesh.positions.data(), mesh.GetVertexCount(),
+                mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                settings.maxCharts, settings.maxStretch,
+                settings.width, settings.height, settings.gutter,
+                mesh.adjacency.data(), nullptr, nullptr,
+                nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                settings.options,
+                vb, ib, nullptr, &vertexRemap,
+                &maxStretch, &charts, &stats, StartDeadline(settings, cancellation),
+                settings.context);
+            const double seconds = timer.Elapsed();
+
+            result.hr = hr;
+            if (FAILED(hr))
+                return;
+
+            if (!iter || seconds < result.seconds)
+            {
+                result.seconds = seconds;
+                result.charts = charts;
+                result.maxStretch = maxStretch;
+                result.stats = stats;
+                result.traceEvents = std::move(traceEvents);
+            }
+        }
+    }
+
+    // Times UVAtlasCreateBatch on copies of the mesh. Quality is reported from the
+    // first copy; every copy must give the same charts.
+    void RunCreateBatch(const ProceduralMesh& mesh, const BenchSettings& settings, BenchResult& result)
+    {
+        for (size_t iter = 0; iter < settings.iterations; ++iter)
+        {
+            std::vector<UVAtlasBatchMesh> batch(settings.batchSize);
+            std::vector<UVAtlasTraceEvent> traceEvents;
+            UVAtlasStats stats = {};
+            stats.traceEvents = settings.trace ? &traceEvents : nullptr;
+            stats.memoryBudget = settings.memoryBudget;
+
+            for (auto& item : batch)
+            {
+                item.positions = mesh.positions.data();
+                item.nVerts = mesh.GetVertexCount();
+                item.indices = mesh.indices.data();
+                item.indexFormat = DXGI_FORMAT_R32_UINT;
+                item.nFaces = mesh.GetFaceCount();
+                item.maxChartNumber = settings.maxCharts;
+                item.maxStretch = settings.maxStretch;
+                item.width = settings.width;
+                item.height = settings.height;
+                item.gutter = settings.gutter;
+                item.adjacency = mesh.adjacency.data();
+                item.falseEdgeAdjacency = nullptr;
+                item.pIMTArray = nullptr;
+                item.options = settings.options;
+                item.statsOut = nullptr;
+            }
+            batch[0].statsOut = &stats;
+
+            UVAtlasCancellation cancellation;
+            Timer timer;
+            HRESULT hr = UVAtlasCreateBatch(batch.data(), batch.size(),
+                nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                StartDeadline(settings, cancellation));
+            const double seconds = timer.Elapsed();
+
+            for (const auto& item : batch)
+            {
+                if (SUCCEEDED(hr) && item.numChartsOut != batch[0].numChartsOut)
+                {
+                    fprintf(stderr, "ERROR: batch copies of the mesh gave %zu and %zu charts\n",
+                        batch[0].numChartsOut, item.numChartsOut);
+                    hr = E_FAIL;
+                }
+            }
+
+            result.hr = hr;
+            if (FAILED(hr))
+                return;
+
+            if (!iter || seconds < result.seconds)
+            {
+                result.seconds = seconds;
+                result.charts = batch[0].numChartsOut;
+                result.maxStretch = batch[0].maxStretchOut;
+                result.stats = stats;
+                result.traceEvents = std::move(traceEvents);
+            }
+        }
+    }
+
+    // Runs UVAtlasCreate from settings.stressThreads threads at once, each with
+    // its own engine. Engines share no state, so every thread must match a run
+    // made alone beforehand bit for bit. Run it under a thread sanitizer to also
+    // check for data races.
+    void RunStress(const ProceduralMesh& mesh, const BenchSettings& settings, BenchResult& result)
+    {
+        struct StressRun
+        {
+            HRESULT hr;
+            std::vector<UVAtlasVertex> vb;
+            std::vector<uint8_t> ib;
+            std::vector<uint32_t> vertexRemap;
+            float maxStretch;
+            size_t charts;
+        };
+
+        auto create = [&](StressRun& run)
+        {
+            UVAtlasCancellation cancellation;
+            run.maxStretch = 0.f;
+            run.charts = 0;
+            run.hr = UVAtlasCreate(
+                mesh.positions.data(), mesh.GetVertexCount(),
+                mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                settings.maxCharts, settings.maxStretch,
+                settings.width, settings.height, settings.gutter,
+                mesh.adjacency.data(), nullptr, nullptr,
+                nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                settings.options,
+                run.vb, run.ib, nullptr, &run.vertexRemap,
+                &run.maxStretch, &run.charts, nullptr, StartDeadline(settings, cancellation));
+        };
+
+        StressRun reference;
+        create(reference);
+        result.hr = reference.hr;
+        if (FAILED(reference.hr))
+            return;
+
+        for (size_t iter = 0; iter < settings.iterations; ++iter)
+        {
+            std::vector<StressRun> runs(settings.stressThreads);
+            std::vector<std::thread> threads;
+            threads.reserve(runs.size());
+
+            Timer timer;
+            for (auto& run : runs)
+            {
+                threads.emplace_back(create, std::ref(run));
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            const double seconds = timer.Elapsed();
+
+            for (const auto& run : runs)
+            {
+                if (FAILED(run.hr))
+                {
+                    result.hr = run.hr;
+                    return;
+                }
+
+                if (run.charts != reference.charts
+                    || memcmp(&run.maxStretch, &reference.maxStretch, sizeof(float)) != 0
+                    || run.vb.size() != reference.vb.size()
+                    || (!run.vb.empty() && memcmp(run.vb.data(), reference.vb.data(), run.vb.size() * sizeof(UVAtlasVertex)) != 0)
+                    || run.ib != reference.ib
+                    || run.vertexRemap != reference.vertexRemap)
+                {
+                    fprintf(stderr, "ERROR: concurrent runs of create differ from a run made alone\n");
+                    result.hr = E_FAIL;
+                    return;
+                }
+            }
+
+            if (!iter || seconds < result.seconds)
+            {
+                result.seconds = seconds;
+                result.charts = reference.charts;
+                result.maxStretch = reference.maxStretch;
+            }
+        }
+    }
+
+    void RunIMT(
+        BENCH_API api,
+        const ProceduralMesh& mesh,
+        const std::vector<float>& texture,
+        const BenchSettings& settings,
+        BenchResult& result)
+    {
+        std::vector<float> imt(mesh.GetFaceCount() * 3);
+
+        for (size_t iter = 0; iter < settings.iterations; ++iter)
+        {
+            HRESULT hr = E_UNEXPECTED;
+
+            Timer timer;
+            switch (api)
+            {
+            case API_IMT_VERTEX:
+                hr = UVAtlasComputeIMTFromPerVertexSignal(
+                    mesh.positions.data(), mesh.GetVertexCount(),
+                    mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                    reinterpret_cast<const float*>(mesh.positions.data()), 3, sizeof(XMFLOAT3),
+                    nullptr, imt.data());
+                break;
+
+            case API_IMT_SIGNAL:
+                hr = UVAtlasComputeIMTFromSignal(
+                    mesh.positions.data(), mesh.texcoords.data(), mesh.GetVertexCount(),
+                    mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                    2, 1.f / float(c_textureSize),
+                    SignalCallback, nullptr,
+                    nullptr, imt.data());
+                break;
+
+            case API_IMT_TEXTURE:
+                hr = UVAtlasComputeIMTFromTexture(
+                    mesh.positions.data(), mesh.texcoords.data(), mesh.GetVertexCount(),
+                    mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                    texture.data(), c_textureSize, c_textureSize,
+                    UVATLAS_IMT_DEFAULT, nullptr, imt.data());
+                break;
+
+            case API_IMT_TEXEL:
+                hr = UVAtlasComputeIMTFromPerTexelSignal(
+                    mesh.positions.data(), mesh.texcoords.data(), mesh.GetVertexCount(),
+                    mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.GetFaceCount(),
+                    texture.data(), c_textureSize, c_textureSize, 4, 4,
+                    UVATLAS_IMT_WRAP_UV, nullptr, imt.data());
+                break;
+
+            default:
+                break;
+            }
+            const double seconds = timer.Elapsed();
+
+            result.hr = hr;
+            if (FAILED(hr))
+                return;
+
+            if (!iter || seconds < result.seconds)
+            {
+                result.seconds = seconds;
+            }
+        }
+    }
+
+
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////
+
+    // Which metrics each entry point produces
+    bool HasCharts(BENCH_API api) { return api <= API_CREATE_BATCH; }
+    bool HasStretch(BENCH_API api) { return api == API_PARTITION || api == API_CREATE || api == API_CREATE_BATCH; }
+    bool HasAtlas(BENCH_API api) { return api == API_PACK || api == API_CREATE || api == API_CREATE_BATCH; }
+
+    RegressionRecord MakeRecord(const char* szMesh, const ProceduralMesh& mesh, const BenchResult& result)
+    {
+        RegressionRecord record;
+        record.mesh = szMesh;
+        record.faces = mesh.GetFaceCount();
+        record.api = LookupByValue(result.api, g_pApis);
+        record.seconds = result.seconds;
+        record.charts = HasCharts(result.api) ? double(result.charts) : -1.0;
+        record.maxStretch = HasStretch(result.api) ? double(result.maxStretch) : -1.0;
+        record.utilization = HasAtlas(result.api) ? result.stats.atlasUtilization : -1.0;
+        return record;
+    }
+
+    bool WriteTrace(const char* szPrefix, const char* szMesh, size_t targetFaces, const BenchResult& result)
+    {
+        std::string json;
+        if (FAILED(UVAtlasFormatChromeTrace(result.traceEvents.data(), result.traceEvents.size(), json)))
+            return false;
+
+        char szFile[1024] = {};
+        snprintf(szFile, sizeof(szFile), "%s-%s-%zu-%s.json",
+            szPrefix, szMesh, targetFaces, LookupByValue(result.api, g_pApis));
+
+        FILE* fp = fopen(szFile, "w");
+        if (!fp)
+            return false;
+
+        const bool ok = fwrite(json.data(), 1, json.size(), fp) == json.size();
+        fclose(fp);
+        return ok;
+    }
+
+    void WriteStage(FILE* fp, const char* name, const UVAtlasStageStats& stage, bool last)
+    {
+        fprintf(fp, "          \"%s\": { \"seconds\": %.6f, \"calls\": %zu, \"currentBytes\": %zu, \"peakBytes\": %zu }%s\n",
+            name, stage.seconds, stage.calls, stage.currentBytes, stage.peakBytes, last ? "" : ",");
+    }
+
+    void WriteMemory(FILE* fp, const char* name, const UVAtlasMemoryStats& memory, bool last)
+    {
+        fprintf(fp, "          \"%s\": { \"currentBytes\": %zu, \"peakBytes\": %zu }%s\n",
+            name, memory.currentBytes, memory.peakBytes, last ? "" : ",");
+    }
+
+    void WriteResult(FILE* fp, const char* szMesh, size_t targetFaces, const ProceduralMesh& mesh, const BenchResult& result, bool first)
+    {
+        const size_t nFaces = mesh.GetFaceCount();
+        const bool hasCharts = HasCharts(result.api);
+        const bool hasStretch = HasStretch(result.api);
+        const bool hasAtlas = HasAtlas(result.api);
+
+        fprintf(fp, "%s    {\n", first ? "" : ",\n");
+        fprintf(fp, "      \"shape\": \"%s\",\n", szMesh);
+        fprintf(fp, "      \"targetFaces\": %zu,\n", targetFaces);
+        fprintf(fp, "      \"faces\": %zu,\n", nFaces);
+        fprintf(fp, "      \"vertices\": %zu,\n", mesh.GetVertexCount());
+        fprintf(fp, "      \"api\": \"%s\",\n", LookupByValue(result.api, g_pApis));
+        fprintf(fp, "      \"hr\": \"0x%08X\"", static_cast<unsigned int>(result.hr));
+
+        if (SUCCEEDED(result.hr))
+        {
+            fprintf(fp, ",\n      \"seconds\": %.6f,\n", result.seconds);
+            fprintf(fp, "      \"facesPerSec\": %.1f", (result.seconds > 0) ? double(nFaces) / result.seconds : 0.0);
+
+            if (hasCharts)
+            {
+                fprintf(fp, ",\n      \"charts\": %zu", result.charts);
+            }
+
+            if (hasStretch)
+            {
+                fprintf(fp, ",\n      \"maxStretch\": %.6f", double(result.maxStretch));
+            }
+
+            if (hasAtlas)
+            {
+                fprintf(fp, ",\n      \"utilization\": %.6f", result.stats.atlasUtilization);
+            }
+
+            if (hasCharts)
+            {
+                const UVAtlasStats& stats = result.stats;
+                fprintf(fp, ",\n      \"stats\": {\n");
+                fprintf(fp, "        \"stages\": {\n");
+                WriteStage(fp, "rootChartBuild", stats.rootChartBuild, false);
+                WriteStage(fp, "parameterizeCharts", stats.parameterizeCharts, false);
+                WriteStage(fp, "optimizeStretch", stats.optimizeStretch, false);
+                WriteStage(fp, "mergeCharts", stats.mergeCharts, false);
+                WriteStage(fp, "packCharts", stats.packCharts, false);
+                WriteStage(fp, "vertexRemap", stats.vertexRemap, true);
+                fprintf(fp, "        },\n");
+                fprintf(fp, "        \"memory\": {\n");
+                WriteMemory(fp, "geodesicDistance", stats.geodesicDistanceMemory, false);
+                WriteMemory(fp, "vertexAdjacency", stats.vertexAdjacencyMemory, false);
+                WriteMemory(fp, "isomap", stats.isomapMemory, false);
+                WriteMemory(fp, "geodesicWindows", stats.geodesicWindowMemory, false);
+                WriteMemory(fp, "total", stats.totalMemory, true);
+                fprintf(fp, "        },\n");
+                fprintf(fp, "        \"chartsCreated\": %zu,\n", stats.chartsCreated);
+                fprintf(fp, "        \"bipartitions\": %zu,\n", stats.bipartitions);
+                fprintf(fp, "        \"geodesicSources\": %zu,\n", stats.geodesicSources);
+                fprintf(fp, "        \"repackIterations\": %zu\n", stats.repackIterations);
+                fprintf(fp, "      }");
+            }
+        }
+
+        fprintf(fp, "\n    }");
+        fflush(fp);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    // Parameters and defaults
+    uint32_t shapeMask = uint32_t(-1);
+    uint32_t apiMask = uint32_t(-1);
+    size_t minFaces = 0;
+    size_t maxFaces = size_t(-1);
+    uint32_t seed = 0;
+    const char* szOutputFile = nullptr;
+    const char* szTracePrefix = nullptr;
+    const char* szBaselineFile = nullptr;
+    const char* szSaveBaselineFile = nullptr;
+    std::vector<std::string> meshFiles;
+
+    RegressionTolerance tolerance = {};
+    tolerance.maxStretch = 0.01;
+    tolerance.charts = 0.1;
+    tolerance.utilization = 0.02;
+    tolerance.seconds = 0.25;
+
+    BenchSettings settings = {};
+    settings.maxCharts = 0;
+    settings.maxStretch = 0.16667f;
+    settings.gutter = 2.f;
+    settings.width = 512;
+    settings.height = 512;
+    settings.options = UVATLAS_DEFAULT;
+    settings.iterations = 1;
+    settings.trace = false;
+    settings.memoryBudget = 0;
+    settings.deadline = 0;
+    settings.batchSize = 16;
+    settings.stressThreads = 4;
+    settings.context = nullptr;
+    settings.segmentFaces = 0;
+
+    // Process command line
+    uint32_t dwOptions = 0;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        char* pArg = argv[iArg];
+
+        if (('-' != pArg[0]) && ('/' != pArg[0]))
+        {
+            fprintf(stderr, "ERROR: unexpected argument '%s'\n\n", pArg);
+            PrintUsage();
+            return 1;
+        }
+
+        pArg++;
+        char* pValue;
+
+        for (pValue = pArg; *pValue && (':' != *pValue); pValue++);
+
+        if (*pValue)
+            *pValue++ = 0;
+
+        uint32_t dwOption = LookupByName(pArg, g_pOptions);
+
+        if (dwOption == uint32_t(-1) || (dwOptions & (1u << dwOption)))
+        {
+            fprintf(stderr, "ERROR: unknown command-line option '%s'\n\n", pArg);
+            PrintUsage();
+            return 1;
+        }
+
+        dwOptions |= (1u << dwOption);
+
+        // Handle options with additional value parameter
+        if (dwOption != OPT_NOLOGO && dwOption != OPT_CONTEXT && dwOption != OPT_COMPONENTS && !*pValue)
+        {
+            if ((iArg + 1 >= argc))
+            {
+                fprintf(stderr, "ERROR: missing value for command-line option '%s'\n\n", pArg);
+                PrintUsage();
+                return 1;
+            }
+
+            iArg++;
+            pValue = argv[iArg];
+        }
+
+        switch (dwOption)
+        {
+        case OPT_SHAPES:
+            {
+                SValue shapes[SHAPE_COUNT + 1] = {};
+                for (uint32_t i = 0; i < SHAPE_COUNT; ++i)
+                {
+                    shapes[i].pName = GetShapeName(static_cast<MESH_SHAPE>(i));
+                    shapes[i].dwValue = i;
+                }
+
+                if (!ParseList(pValue, shapes, shapeMask))
+                {
+                    fprintf(stderr, "Invalid value specified with -shape\n");
+                    return 1;
+                }
+            }
+            break;
+
+        case OPT_APIS:
+            if (!ParseList(pValue, g_pApis, apiMask))
+            {
+                fprintf(stderr, "Invalid value specified with -api\n");
+                return 1;
+            }
+            break;
+
+        case OPT_MINFACES:
+            if (sscanf(pValue, "%zu", &minFaces) != 1)
+            {
+                fprintf(stderr, "Invalid value specified with -minfaces (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_MAXFACES:
+            if (sscanf(pValue, "%zu", &maxFaces) != 1)
+            {
+                fprintf(stderr, "Invalid value specified with -maxfaces (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_ITERATIONS:
+            if (sscanf(pValue, "%zu", &settings.iterations) != 1 || !settings.iterations)
+            {
+                fprintf(stderr, "Invalid value specified with -i (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_SEED:
+            if (sscanf(pValue, "%u", &seed) != 1)
+            {
+                fprintf(stderr, "Invalid value specified with -seed (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_QUALITY:
+            if (!strcmp(pValue, "DEFAULT"))
+            {
+                settings.options = UVATLAS_DEFAULT;
+            }
+            else if (!strcmp(pValue, "FAST"))
+            {
+                settings.options = UVATLAS_GEODESIC_FAST;
+            }
+            else if (!strcmp(pValue, "QUALITY"))
+            {
+                settings.options = UVATLAS_GEODESIC_QUALITY;
+            }
+            else if (!strcmp(pValue, "HEAT"))
+            {
+                settings.options = UVATLAS_GEODESIC_HEAT;
+            }
+            else
+            {
+                fprintf(stderr, "Invalid value specified with -q (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_MAXCHARTS:
+            if (sscanf(pValue, "%zu", &settings.maxCharts) != 1)
+            {
+                fprintf(stderr, "Invalid value specified with -n (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_MAXSTRETCH:
+            if (sscanf(pValue, "%f", &settings.maxStretch) != 1
+                || settings.maxStretch < 0.f
+                || settings.maxStretch > 1.f)
+            {
+                fprintf(stderr, "Invalid value specified with -st (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_GUTTER:
+            if (sscanf(pValue, "%f", &settings.gutter) != 1
+                || settings.gutter < 0.f)
+            {
+                fprintf(stderr, "Invalid value specified with -g (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_WIDTH:
+            if (sscanf(pValue, "%zu", &settings.width) != 1)
+            {
+                fprintf(stderr, "Invalid value specified with -w (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_HEIGHT:
+            if (sscanf(pValue, "%zu", &settings.height) != 1)
+            {
+                fprintf(stderr, "Invalid value specified with -h (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_OUTPUTFILE:
+            szOutputFile = pValue;
+            break;
+
+        case OPT_TRACE:
+            szTracePrefix = pValue;
+            settings.trace = true;
+            break;
+
+        case OPT_BUDGET:
+            {
+                double budgetMB = 0;
+                if (sscanf(pValue, "%lf", &budgetMB) != 1 || budgetMB < 0)
+                {
+                    fprintf(stderr, "Invalid value specified with -budget (%s)\n", pValue);
+                    return 1;
+                }
+                settings.memoryBudget = static_cast<size_t>(budgetMB * 1024. * 1024.);
+            }
+            break;
+
+        case OPT_DEADLINE:
+            {
+                double deadlineMS = 0;
+                if (sscanf(pValue, "%lf", &deadlineMS) != 1 || deadlineMS < 0)
+                {
+                    fprintf(stderr, "Invalid value specified with -deadline (%s)\n", pValue);
+                    return 1;
+                }
+                settings.deadline = deadlineMS / 1000.;
+            }
+            break;
+
+        case OPT_BATCH:
+            if (sscanf(pValue, "%zu", &settings.batchSize) != 1 || !settings.batchSize)
+            {
+                fprintf(stderr, "Invalid value specified with -batch (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_STRESS:
+            if (sscanf(pValue, "%zu", &settings.stressThreads) != 1 || !settings.stressThreads)
+            {
+                fprintf(stderr, "Invalid value specified with -stress (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_SEGMENT:
+            if (sscanf(pValue, "%zu", &settings.segmentFaces) != 1 || !settings.segmentFaces)
+            {
+                fprintf(stderr, "Invalid value specified with -segment (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_MESHES:
+            for (char* pToken = strtok(pValue, ","); pToken; pToken = strtok(nullptr, ","))
+            {
+                meshFiles.emplace_back(pToken);
+            }
+            if (meshFiles.empty())
+            {
+                fprintf(stderr, "Invalid value specified with -mesh\n");
+                return 1;
+            }
+            break;
+
+        case OPT_BASELINE:
+            szBaselineFile = pValue;
+            break;
+
+        case OPT_SAVE_BASELINE:
+            szSaveBaselineFile = pValue;
+            break;
+
+        case OPT_TOL_STRETCH:
+            if (sscanf(pValue, "%lf", &tolerance.maxStretch) != 1 || tolerance.maxStretch < 0)
+            {
+                fprintf(stderr, "Invalid value specified with -tolstretch (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_TOL_CHARTS:
+            if (sscanf(pValue, "%lf", &tolerance.charts) != 1 || tolerance.charts < 0)
+            {
+                fprintf(stderr, "Invalid value specified with -tolcharts (%s)\n", pValue);
+                return 1;
+            }
+            tolerance.charts /= 100.0;
+            break;
+
+        case OPT_TOL_UTILIZATION:
+            if (sscanf(pValue, "%lf", &tolerance.utilization) != 1 || tolerance.utilization < 0)
+            {
+                fprintf(stderr, "Invalid value specified with -tolutil (%s)\n", pValue);
+                return 1;
+            }
+            break;
+
+        case OPT_TOL_TIME:
+            if (sscanf(pValue, "%lf", &tolerance.seconds) != 1 || tolerance.seconds < 0)
+            {
+                fprintf(stderr, "Invalid value specified with -toltime (%s)\n", pValue);
+                return 1;
+            }
+            tolerance.seconds /= 100.0;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (~dwOptions & (1u << OPT_NOLOGO))
+        PrintLogo();
+
+    if (dwOptions & (1u << OPT_COMPONENTS))
+    {
+        settings.options |= UVATLAS_INDEPENDENT_COMPONENTS;
+    }
+
+    std::unique_ptr<UVAtlasContext> context;
+    if (dwOptions & (1u << OPT_CONTEXT))
+    {
+        context = std::make_unique<UVAtlasContext>();
+        settings.context = context.get();
+    }
+
+    // OBJ files replace the procedural corpus unless shapes were asked for too
+    if (!meshFiles.empty() && (~dwOptions & (1u << OPT_SHAPES)))
+    {
+        shapeMask = 0;
+    }
+
+    // Quality depends on these, so a baseline only applies to runs made with the same ones
+    RegressionBaseline recorded;
+    {
+        char szSettings[256] = {};
+        snprintf(szSettings, sizeof(szSettings), "maxCharts=%zu maxStretch=%.6f gutter=%.3f width=%zu height=%zu options=%u seed=%u",
+            settings.maxCharts, double(settings.maxStretch), double(settings.gutter), settings.width, settings.height,
+            static_cast<unsigned int>(settings.options), seed);
+        recorded.settings = szSettings;
+        if (settings.segmentFaces)
+        {
+            recorded.settings += " segmentFaces=" + std::to_string(settings.segmentFaces);
+        }
+    }
+
+    RegressionBaseline baseline;
+    if (szBaselineFile)
+    {
+        if (!LoadBaseline(szBaselineFile, baseline))
+        {
+            fprintf(stderr, "ERROR: failed to read baseline '%s'\n", szBaselineFile);
+            return 1;
+        }
+
+        if (baseline.settings != recorded.settings)
+        {
+            fprintf(stderr, "WARNING: baseline was recorded with different settings\n    baseline: %s\n    this run: %s\n",
+                baseline.settings.c_str(), recorded.settings.c_str());
+        }
+    }
+
+    FILE* fp = stdout;
+    if (szOutputFile)
+    {
+        fp = fopen(szOutputFile, "w");
+        if (!fp)
+        {
+            fprintf(stderr, "ERROR: failed to open output file '%s'\n", szOutputFile);
+            return 1;
+        }
+    }
+
+    std::vector<float> texture;
+    GenerateTexture(c_textureSize, texture);
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"version\": %d,\n", UVATLAS_VERSION);
+    fprintf(fp, "  \"settings\": { \"maxCharts\": %zu, \"maxStretch\": %.6f, \"gutter\": %.3f, \"width\": %zu, \"height\": %zu, \"options\": %u, \"iterations\": %zu, \"seed\": %u },\n",
+        settings.maxCharts, double(settings.maxStretch), double(settings.gutter), settings.width, settings.height,
+        static_cast<unsigned int>(settings.options), settings.iterations, seed);
+    fprintf(fp, "  \"results\": [\n");
+
+    bool first = true;
+    int retVal = 0;
+    size_t regressions = 0;
+    size_t missing = 0;
+
+    auto runMesh = [&](const char* szMesh, size_t targetFaces, const ProceduralMesh& mesh)
+    {
+        fprintf(stderr, "%s: %zu faces, %zu vertices\n", szMesh, mesh.GetFaceCount(), mesh.GetVertexCount());
+
+        std::vector<UVAtlasVertex> vb;
+        std::vector<uint8_t> ib;
+        std::vector<uint32_t> partitionAdjacency;
+        size_t partitionCharts = 0;
+        bool partitioned = false;
+
+        for (uint32_t apiIndex = 0; apiIndex < API_COUNT; ++apiIndex)
+        {
+            if (!(apiMask & (1u << apiIndex)))
+                continue;
+
+            BenchResult result = {};
+            result.api = static_cast<BENCH_API>(apiIndex);
+
+            switch (result.api)
+            {
+            case API_PARTITION:
+                RunPartition(mesh, settings, result, vb, ib, partitionAdjacency);
+                partitioned = SUCCEEDED(result.hr);
+                partitionCharts = result.charts;
+                break;
+
+            case API_PACK:
+                if (!partitioned)
+                {
+                    // Packing needs a partition result to start from
+                    BenchSettings once = settings;
+                    once.iterations = 1;
+
+                    BenchResult partition = {};
+                    RunPartition(mesh, once, partition, vb, ib, partitionAdjacency);
+                    result.hr = partition.hr;
+                    partitioned = SUCCEEDED(partition.hr);
+                    partitionCharts = partition.charts;
+                }
+
+                if (partitioned)
+                {
+                    RunPack(settings, vb, ib, partitionAdjacency, partitionCharts, result);
+                }
+                break;
+
+            case API_CREATE:
+                RunCreate(mesh, settings, result);
+                break;
+
+            case API_CREATE_BATCH:
+                RunCreateBatch(mesh, settings, result);
+                break;
+
+            case API_STRESS:
+                RunStress(mesh, settings, result);
+                break;
+
+            default:
+                RunIMT(result.api, mesh, texture, settings, result);
+                break;
+            }
+
+            if (FAILED(result.hr))
+            {
+                fprintf(stderr, "ERROR: %s failed on %s (%08X)\n",
+                    LookupByValue(result.api, g_pApis), szMesh, static_cast<unsigned int>(result.hr));
+                retVal = 1;
+            }
+            else
+            {
+                fprintf(stderr, "    %-12s %10.4f s\n", LookupByValue(result.api, g_pApis), result.seconds);
+
+                if (szTracePrefix && !result.traceEvents.empty()
+                    && !WriteTrace(szTracePrefix, szMesh, targetFaces, result))
+                {
+                    fprintf(stderr, "ERROR: failed to write trace for %s on %s\n",
+                        LookupByValue(result.api, g_pApis), szMesh);
+                    retVal = 1;
+                }
+
+                const RegressionRecord record = MakeRecord(szMesh, mesh, result);
+                if (szBaselineFile)
+                {
+                    switch (CompareToBaseline(record, baseline, tolerance))
+                    {
+                    case REGRESSION_FAIL:       ++regressions; retVal = 1; break;
+                    case REGRESSION_MISSING:    ++missing; break;
+                    default:                    break;
+                    }
+                }
+                recorded.records.push_back(record);
+            }
+
+            WriteResult(fp, szMesh, targetFaces, mesh, result, first);
+            first = false;
+        }
+    };
+
+    for (uint32_t shapeIndex = 0; shapeIndex < SHAPE_COUNT; ++shapeIndex)
+    {
+        if (!(shapeMask & (1u << shapeIndex)))
+            continue;
+
+        const auto shape = static_cast<MESH_SHAPE>(shapeIndex);
+
+        for (const size_t targetFaces : g_faceCounts)
+        {
+            if (targetFaces < minFaces || targetFaces > maxFaces)
+                continue;
+
+            ProceduralMesh mesh;
+            GenerateMesh(shape, targetFaces, seed, mesh);
+
+            runMesh(GetShapeName(shape), targetFaces, mesh);
+        }
+    }
+
+    for (const auto& fileName : meshFiles)
+    {
+        ProceduralMesh mesh;
+        if (!LoadMeshOBJ(fileName.c_str(), mesh))
+        {
+            fprintf(stderr, "ERROR: failed to load mesh '%s'\n", fileName.c_str());
+            retVal = 1;
+            continue;
+        }
+
+        // Results are keyed by the file name without its directory
+        const size_t slash = fileName.find_last_of("/\\");
+        const std::string name = (slash == std::string::npos) ? fileName : fileName.substr(slash + 1);
+
+        runMesh(name.c_str(), mesh.GetFaceCount(), mesh);
+    }
+
+    if (context)
+    {
+        fprintf(stderr, "Context retains %zu bytes\n", context->GetRetainedBytes());
+    }
+
+    if (szBaselineFile)
+    {
+        fprintf(stderr, "Baseline comparison: %zu runs, %zu regressions, %zu without a baseline\n",
+            recorded.records.size(), regressions, missing);
+    }
+
+    if (szSaveBaselineFile && !SaveBaseline(szSaveBaselineFile, recorded))
+    {
+        fprintf(stderr, "ERROR: failed to write baseline '%s'\n", szSaveBaselineFile);
+        retVal = 1;
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+
+    if (fp != stdout)
+    {
+        fclose(fp);
+    }
+
+    return retVal;
+}
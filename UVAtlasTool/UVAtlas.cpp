@@ -61,6 +61,7 @@ namespace
         OPT_MAXSTRETCH,
         OPT_LIMIT_MERGE_STRETCH,
         OPT_LIMIT_FACE_STRETCH,
+        OPT_INDEPENDENT_COMPONENTS,
         OPT_GUTTER,
         OPT_WIDTH,
         OPT_HEIGHT,
@@ -144,6 +145,7 @@ namespace
         { L"st",        OPT_MAXSTRETCH },
         { L"lms",       OPT_LIMIT_MERGE_STRETCH },
         { L"lfs",       OPT_LIMIT_FACE_STRETCH },
+        { L"ic",        OPT_INDEPENDENT_COMPONENTS },
         { L"g",         OPT_GUTTER },
         { L"w",         OPT_WIDTH },
         { L"h",         OPT_HEIGHT },
@@ -391,11 +393,12 @@ namespace
         wprintf(L"       -vbo            Vertex Buffer Object (.vbo) format\n");
         wprintf(L"       -wf             WaveFront Object (.obj) format\n\n");
         wprintf(L"   -r                  wildcard filename search is recursive\n");
-        wprintf(L"   -q <level>          sets quality level to DEFAULT, FAST or QUALITY\n");
+        wprintf(L"   -q <level>          sets quality level to DEFAULT, FAST, QUALITY or HEAT\n");
         wprintf(L"   -n <number>         maximum number of charts to generate (def: 0)\n");
         wprintf(L"   -st <float>         maximum amount of stretch 0.0 to 1.0 (def: 0.16667)\n");
         wprintf(L"   -lms                enable limit merge stretch option\n");
         wprintf(L"   -lfs                enable limit face stretch option\n");
+        wprintf(L"   -ic                 partition each connected component independently\n");
         wprintf(L"   -g <float>          the gutter width betwen charts in texels (def: 2.0)\n");
         wprintf(L"   -w <number>         texture width (def: 512)\n");
         wprintf(L"   -h <number>         texture height (def: 512)\n");
@@ -571,6 +574,10 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
                 {
                     uvOptions = UVATLAS_GEODESIC_QUALITY;
                 }
+                else if (!_wcsicmp(pValue, L"HEAT"))
+                {
+                    uvOptions = UVATLAS_GEODESIC_HEAT;
+                }
                 else
                 {
                     wprintf(L"Invalid value specified with -q (%ls)\n", pValue);
@@ -586,6 +593,10 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
                 uvOptionsEx |= UVATLAS_LIMIT_FACE_STRETCH;
                 break;
 
+            case OPT_INDEPENDENT_COMPONENTS:
+                uvOptionsEx |= UVATLAS_INDEPENDENT_COMPONENTS;
+                break;
+
             case OPT_MAXCHARTS:
                 if (swscanf_s(pValue, L"%zu", &maxCharts) != 1)
                 {